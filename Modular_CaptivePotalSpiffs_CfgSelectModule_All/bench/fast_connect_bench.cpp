@@ -0,0 +1,62 @@
+// Boot-to-IP benchmark: RTC fast reconnect vs the full connect path.
+//
+// Deep-sleeps through CYCLES wake-ups. Even cycles keep the RTC link cache
+// (fast path: cached BSSID, channel and lease), odd cycles invalidate it
+// (full path: scan/ranking, WiFi.begin() and DHCP). Provision the device with
+// the main firmware first; this uses the same preferences namespace.
+//
+//   pio run -e bench_fast_connect -t upload -t monitor
+
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include "ESP32ConfigPortal.h"
+
+static const int CYCLES = 20;
+static const uint64_t SLEEP_US = 1000000;
+
+ESP32ConfigPortal configPortal(0, "Bench-Config", "my_device_config");
+
+RTC_DATA_ATTR static int cycle = 0;
+RTC_DATA_ATTR static uint32_t fast_total_ms = 0;
+RTC_DATA_ATTR static uint32_t fast_runs = 0;
+RTC_DATA_ATTR static uint32_t full_total_ms = 0;
+RTC_DATA_ATTR static uint32_t full_runs = 0;
+
+void setup() {
+    if (cycle % 2 == 1) {
+        ESP32ConfigPortal::invalidateFastConnect();
+    }
+
+    configPortal.begin(PortalMode::ASYNC);
+    bool online = configPortal.waitForSetup(30000);
+    const ConnectTiming& timing = configPortal.getConnectTiming();
+
+    if (online && timing.path == ConnectPath::FAST) {
+        fast_total_ms += timing.boot_to_ip_ms;
+        fast_runs++;
+    } else if (online) {
+        full_total_ms += timing.boot_to_ip_ms;
+        full_runs++;
+    }
+    Serial.printf("cycle %d: %s, boot-to-IP %lu ms\n", cycle,
+                  !online ? "no connection" : timing.path == ConnectPath::FAST ? "fast" : "full",
+                  (unsigned long)timing.boot_to_ip_ms);
+
+    if (++cycle < CYCLES) {
+        Serial.flush();
+        esp_deep_sleep(SLEEP_US);
+    }
+
+    Serial.println("\n=== Boot-to-IP ===");
+    Serial.printf("fast path: %lu runs, avg %lu ms\n", (unsigned long)fast_runs,
+                  (unsigned long)(fast_runs ? fast_total_ms / fast_runs : 0));
+    Serial.printf("full path: %lu runs, avg %lu ms\n", (unsigned long)full_runs,
+                  (unsigned long)(full_runs ? full_total_ms / full_runs : 0));
+    cycle = 0;
+    fast_total_ms = fast_runs = full_total_ms = full_runs = 0;
+}
+
+void loop() {
+    configPortal.handle();
+    delay(100);
+}
@@ -0,0 +1,170 @@
+// Web host upload benchmark, run on the host against the fakes in
+// test/fakes.
+//
+// Records sensor readings at a steady rate through WebHostModule to a host
+// stand-in over links of a given round trip and speed, optionally with an
+// outage of the WiFi link or of the host in the middle. Per scenario it
+// reports records per second delivered, requests made, compression ratio
+// (record bytes over body bytes), flash write amplification (bytes written
+// over record bytes), sector erases, records dropped, and how long the
+// backlog took to drain once the outage ended. Scenarios are fixed and
+// seeded, so runs before and after a change to the uploader compare
+// directly.
+//
+//   pio run -e bench_host_upload -t exec
+
+#include <FakeDevice.h>
+#include "ESP32ConfigPortal.h"
+#include "WebHostModule.h"
+#include <stdio.h>
+
+#define BENCH_NS "bench_host"
+#define BENCH_HOST "logs.example.com"
+#define TICK_MS 10
+
+enum class Outage : uint8_t { NONE, LINK, HOST };
+
+struct Scenario {
+    const char* name;
+    uint16_t records_per_s;
+    uint32_t rtt_ms;
+    uint32_t link_speed;    // Bytes per second, 0: instant
+    Outage outage;
+    uint32_t outage_ms;     // From 10 s in
+    uint32_t duration_ms;   // Of recording; the backlog drains after it
+};
+
+static const Scenario SCENARIOS[] = {
+    { "1/s",                    1,   30,  50000, Outage::NONE, 0,      120000 },
+    { "10/s",                   10,  30,  50000, Outage::NONE, 0,      120000 },
+    { "100/s",                  100, 30,  50000, Outage::NONE, 0,      60000 },
+    { "10/s, slow link",        10,  300, 5000,  Outage::NONE, 0,      120000 },
+    { "10/s, 1 min link down",  10,  30,  50000, Outage::LINK, 60000,  120000 },
+    { "10/s, 10 min link down", 10,  30,  50000, Outage::LINK, 600000, 660000 },
+    { "10/s, 2 min host down",  10,  30,  50000, Outage::HOST, 120000, 180000 },
+};
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+static uint32_t requests;
+
+static void serveHost() {
+    fake::serveHttp(BENCH_HOST, 80, [](const fake::ServerRequest&) {
+        requests++;
+        return fake::ServerReply(204);
+    });
+}
+
+static void runScenario(const Scenario& scenario) {
+    fake::reset();
+    ESP32ConfigPortal::invalidateFastConnect();
+    randomSeed(1);
+    requests = 0;
+
+    fake::addNetwork("home", "password1");
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    config.host_active = true;
+    strlcpy(config.host_url, "http://" BENCH_HOST "/ingest", sizeof(config.host_url));
+    ConfigStore(BENCH_NS).save(config, true);
+    ESP32ConfigPortal* portal = new ESP32ConfigPortal(0, "Bench-Config", BENCH_NS);
+    portal->addModule<WebHostModule>(ConfigSection::host);
+    portal->begin();
+    serveHost();
+    fake::setClientLink(scenario.rtt_ms, scenario.link_speed);
+    for (int i = 0; i < 100; i++) {
+        portal->handle();
+        fake::advance(TICK_MS);
+    }
+
+    MetricsSnapshot before;
+    Metrics::capture(before);
+    fake::FlashStats flash_before = fake::flashStats();
+    uint64_t start = fake::now();
+    uint64_t outage_start = start + 10000;
+    uint64_t outage_end = outage_start + scenario.outage_ms;
+    bool down = false;
+    uint64_t recovered = 0;
+    uint64_t drained = 0;
+    uint32_t interval_ms = 1000 / scenario.records_per_s;
+    uint64_t next_record = start;
+    uint32_t recorded = 0;
+    char text[96];
+
+    for (;;) {
+        uint64_t now = fake::now();
+        bool recording = now - start < scenario.duration_ms;
+        if (scenario.outage != Outage::NONE && !down && recovered == 0 && now >= outage_start) {
+            down = true;
+            if (scenario.outage == Outage::LINK) {
+                fake::removeNetwork("home");
+            } else {
+                fake::serveHttp(BENCH_HOST, 80, fake::ServerHandler());
+            }
+        }
+        if (down && now >= outage_end) {
+            down = false;
+            recovered = now;
+            if (scenario.outage == Outage::LINK) {
+                fake::addNetwork("home", "password1");
+            } else {
+                serveHost();
+            }
+        }
+        if (recovered != 0 && drained == 0 && WebHostModule::backlog() == 0) {
+            drained = now;
+        }
+        while (recording && next_record <= now) {
+            snprintf(text, sizeof(text), "{\"t\":%lu,\"sensor\":\"env-%u\",\"temp\":%.2f,\"rh\":%u}",
+                     (unsigned long)(next_record / 1000), recorded % 4, 18 + random(1000) / 100.0,
+                     40 + (unsigned)random(20));
+            WebHostModule::record(text);
+            recorded++;
+            next_record += interval_ms;
+        }
+        if (!recording && !down && WebHostModule::backlog() == 0) {
+            break;
+        }
+        if (now - start > scenario.duration_ms + 3600000) {
+            break;  // Never drained
+        }
+        portal->handle();
+        fake::advance(TICK_MS);
+    }
+
+    MetricsSnapshot after;
+    Metrics::capture(after);
+    fake::FlashStats flash_after = fake::flashStats();
+    uint32_t delivered = after.counters[(size_t)MetricCounter::UPLOAD_DELIVERED] -
+                         before.counters[(size_t)MetricCounter::UPLOAD_DELIVERED];
+    uint32_t dropped = after.counters[(size_t)MetricCounter::UPLOAD_DROPPED] -
+                       before.counters[(size_t)MetricCounter::UPLOAD_DROPPED];
+    uint64_t record_bytes = after.counters[(size_t)MetricCounter::UPLOAD_RECORD_BYTES] -
+                            before.counters[(size_t)MetricCounter::UPLOAD_RECORD_BYTES];
+    uint64_t body_bytes = after.counters[(size_t)MetricCounter::UPLOAD_BODY_BYTES] -
+                          before.counters[(size_t)MetricCounter::UPLOAD_BODY_BYTES];
+    uint64_t flash_bytes = flash_after.bytes_written - flash_before.bytes_written;
+    double seconds = (fake::now() - start) / 1000.0;
+    printf("%-24s %8u %8.1f %6u %7.1f %5.2f %5.2f %6u %7u", scenario.name, (unsigned)recorded, delivered / seconds,
+           (unsigned)requests, (double)delivered / max(requests, (uint32_t)1),
+           body_bytes ? (double)record_bytes / body_bytes : 0.0, record_bytes ? (double)flash_bytes / record_bytes : 0.0,
+           (unsigned)(flash_after.erases - flash_before.erases), (unsigned)dropped);
+    if (recovered != 0 && drained != 0) {
+        printf(" %8u ms\n", (unsigned)(drained - recovered));
+    } else {
+        printf(" %11s\n", "-");
+    }
+
+    Log::end();
+    delete portal;
+    fake::stopTasks();
+}
+
+int main() {
+    printf("%-24s %8s %8s %6s %7s %5s %5s %6s %7s %11s\n", "scenario", "records", "recs/s", "posts", "recs/po",
+           "gzip", "write", "erases", "dropped", "drain");
+    for (size_t i = 0; i < COUNT_OF(SCENARIOS); i++) {
+        runScenario(SCENARIOS[i]);
+    }
+    return 0;
+}
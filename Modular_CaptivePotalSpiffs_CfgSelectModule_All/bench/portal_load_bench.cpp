@@ -0,0 +1,362 @@
+// Captive-portal load benchmark, run on the host against the fakes in
+// test/fakes.
+//
+// Replays what phones and laptops do when they join the portal AP: DNS
+// lookups, OS connectivity probes, the portal page load and the page's own
+// polling, for several clients at once, and clients retrying probes in a
+// tight loop. Client behavior follows captures of Android, iOS and Windows
+// joining an open captive network. Per scenario it reports requests per
+// second, handler latency p50/p99 (host time), failed and shed requests,
+// DNS answers/drops, peak heap use and the smallest largest free block
+// (device heap model). Scenarios are fixed and seeded, so runs before and
+// after a change to setupServer() or startCaptivePortal() compare directly.
+//
+// A second table reports time to popup per OS: join to the portal page shown
+// in the OS's sign-in UI, at a few link speeds.
+//
+//   pio run -e bench_portal_load -t exec
+
+#include <FakeDevice.h>
+#include "ESP32ConfigPortal.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <vector>
+
+struct ClientStep {
+    uint32_t at_ms;    // After joining
+    uint8_t dns;       // Queries sent at this point
+    const char* url;   // nullptr: DNS only
+};
+
+struct ClientPeriodic {
+    uint32_t start_ms;
+    uint32_t period_ms;
+    const char* url;
+};
+
+struct ClientBehavior {
+    const char* name;
+    const ClientStep* steps;
+    size_t step_count;
+    const ClientPeriodic* periodic;
+    size_t periodic_count;
+    uint16_t dns_per_s;  // Background lookups from apps once associated
+};
+
+// Android: probes over HTTP, opens the sign-in webview, which loads the page
+// and starts polling scan results
+static const ClientStep ANDROID_STEPS[] = {
+    { 0, 4, nullptr },
+    { 40, 0, "/generate_204" },
+    { 60, 0, "/gen_204" },
+    { 700, 1, "/" },
+    { 950, 0, "/wifi/profiles.json" },
+    { 960, 0, "/api/schema" },
+    { 970, 0, "/scan.json" },
+};
+static const ClientPeriodic ANDROID_PERIODIC[] = {
+    { 2970, 2000, "/scan.json" },
+    { 10040, 10000, "/generate_204" },
+};
+
+// iOS: probes three times before raising the captive network sheet
+static const ClientStep IOS_STEPS[] = {
+    { 0, 2, nullptr },
+    { 30, 0, "/hotspot-detect.html" },
+    { 330, 0, "/hotspot-detect.html" },
+    { 630, 0, "/hotspot-detect.html" },
+    { 900, 1, "/" },
+    { 1200, 0, "/wifi/profiles.json" },
+    { 1210, 0, "/api/schema" },
+    { 1220, 0, "/scan.json" },
+};
+static const ClientPeriodic IOS_PERIODIC[] = {
+    { 3220, 2000, "/scan.json" },
+    { 15030, 15000, "/hotspot-detect.html" },
+};
+
+// Windows: NCSI probe and redirect check, then the browser opens the portal
+static const ClientStep WINDOWS_STEPS[] = {
+    { 0, 3, nullptr },
+    { 40, 0, "/connecttest.txt" },
+    { 80, 0, "/redirect" },
+    { 1500, 2, "/" },
+    { 1700, 0, "/favicon.ico" },
+    { 1750, 0, "/wifi/profiles.json" },
+    { 1760, 0, "/api/schema" },
+    { 1770, 0, "/scan.json" },
+};
+static const ClientPeriodic WINDOWS_PERIODIC[] = {
+    { 3770, 2000, "/scan.json" },
+    { 30040, 30000, "/connecttest.txt" },
+};
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+static const ClientBehavior ANDROID = { "android", ANDROID_STEPS, COUNT_OF(ANDROID_STEPS),
+                                        ANDROID_PERIODIC, COUNT_OF(ANDROID_PERIODIC), 2 };
+static const ClientBehavior IOS = { "ios", IOS_STEPS, COUNT_OF(IOS_STEPS),
+                                    IOS_PERIODIC, COUNT_OF(IOS_PERIODIC), 3 };
+static const ClientBehavior WINDOWS = { "windows", WINDOWS_STEPS, COUNT_OF(WINDOWS_STEPS),
+                                        WINDOWS_PERIODIC, COUNT_OF(WINDOWS_PERIODIC), 5 };
+
+struct Scenario {
+    const char* name;
+    uint8_t android;
+    uint8_t ios;
+    uint8_t windows;
+    uint32_t join_spacing_ms;
+    uint16_t extra_dns_per_s;   // Per client, on top of the behavior's own
+    uint32_t link_speed;        // Bytes per second per client, 0: instant
+    uint32_t duration_ms;
+    uint16_t storm_ms;          // Per client, a probe this often on top, 0: none
+};
+
+static const Scenario SCENARIOS[] = {
+    { "1 android",           1, 0, 0, 0,   0,  0,     30000, 0 },
+    { "5 mixed",             2, 2, 1, 300, 0,  0,     60000, 0 },
+    { "10 mixed",            4, 4, 2, 200, 0,  0,     60000, 0 },
+    { "5 mixed, dns flood",  2, 2, 1, 300, 40, 0,     60000, 0 },
+    { "5 mixed, slow link",  2, 2, 1, 300, 0,  20000, 60000, 0 },
+    { "10 mixed, slow link", 4, 4, 2, 200, 0,  20000, 60000, 0 },
+    { "10 mixed, storm",     4, 4, 2, 200, 0,  5000,  60000, 20 },
+};
+
+struct Results {
+    std::vector<uint32_t> latency_us;
+    uint32_t failed;  // No answer or 5xx, shed ones aside
+    uint32_t shed;    // Refused by admission control, 429 or 503
+};
+
+static Results results;
+
+static void request(const char* url, uint8_t client) {
+    fake::setHttpClient(client);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    fake::HttpResponse response = fake::get(url);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    fake::HeapPause pause;
+    results.latency_us.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    if (response.code == 429 || (response.code == 503 && response.hasHeader("Retry-After"))) {
+        results.shed++;
+    } else if (response.code == 0 || response.code >= 500) {
+        results.failed++;
+    }
+}
+
+static void dnsBurst(uint8_t count, uint8_t client) {
+    for (uint8_t i = 0; i < count; i++) {
+        fake::dnsQuery(client);
+    }
+}
+
+// Re-arms itself, so only the next occurrence is queued
+static void every(uint64_t first, uint32_t periodMs, uint64_t endMs, std::function<void()> action) {
+    if (first >= endMs) {
+        return;
+    }
+    fake::HeapPause pause;
+    fake::at(first, [=]() {
+        action();
+        every(first + periodMs, periodMs, endMs, action);
+    });
+}
+
+// address is the last byte of the client's IP on the AP subnet
+static void scheduleClient(const ClientBehavior& client, uint8_t address, uint32_t joinMs, uint16_t extraDns,
+                           uint16_t stormMs, uint32_t endMs) {
+    fake::HeapPause pause;
+    for (size_t i = 0; i < client.step_count; i++) {
+        const ClientStep step = client.steps[i];
+        fake::at(joinMs + step.at_ms, [step, address]() {
+            dnsBurst(step.dns, address);
+            if (step.url) {
+                request(step.url, address);
+            }
+        });
+    }
+    for (size_t i = 0; i < client.periodic_count; i++) {
+        const char* url = client.periodic[i].url;
+        every(joinMs + client.periodic[i].start_ms, client.periodic[i].period_ms, endMs,
+              [url, address]() { request(url, address); });
+    }
+    if (stormMs > 0) {
+        every(joinMs + client.steps[0].at_ms, stormMs, endMs, [address]() { request("/generate_204", address); });
+    }
+    uint32_t dns_per_s = client.dns_per_s + extraDns;
+    if (dns_per_s > 0) {
+        uint32_t interval = max(1000 / dns_per_s, (uint32_t)1);
+        every(joinMs + (uint32_t)random(interval), interval, endMs, [address]() { fake::dnsQuery(address); });
+    }
+}
+
+static uint32_t percentile(std::vector<uint32_t>& values, uint32_t pct) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[min((size_t)(values.size() * pct / 100), values.size() - 1)];
+}
+
+static void runScenario(const Scenario& scenario) {
+    fake::reset();
+    ESP32ConfigPortal::invalidateFastConnect();
+    randomSeed(1);
+    results.latency_us.clear();
+    results.failed = 0;
+    results.shed = 0;
+
+    // First boot: nothing stored, portal up
+    ESP32ConfigPortal* portal = new ESP32ConfigPortal(0, "Bench-Config", "bench_portal");
+    portal->begin(PortalMode::ASYNC);
+    fake::setLinkSpeed(scenario.link_speed);
+    fake::advance(100);
+    fake::resetHeapPeaks();
+    size_t idle_used = fake::heapModel().used;
+
+    uint32_t start = (uint32_t)fake::now();
+    const ClientBehavior* behaviors[] = { &ANDROID, &IOS, &WINDOWS };
+    uint8_t counts[] = { scenario.android, scenario.ios, scenario.windows };
+    uint32_t joined = 0;
+    for (uint8_t round = 0; round < 255; round++) {
+        bool any = false;
+        for (size_t b = 0; b < 3; b++) {
+            if (round < counts[b]) {
+                uint32_t join = start + joined * scenario.join_spacing_ms + (uint32_t)random(100);
+                scheduleClient(*behaviors[b], (uint8_t)(2 + joined), join, scenario.extra_dns_per_s,
+                               scenario.storm_ms, start + scenario.duration_ms);
+                joined++;
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+    }
+    fake::advance(scenario.duration_ms);
+
+    fake::HeapModel heap = fake::heapModel();
+    fake::DnsStats dns = fake::dnsStats();
+    size_t requests = results.latency_us.size();
+    printf("%-20s %6u %7.1f %7u %7u %5u %5u %6u/%-5u %9u %9u\n", scenario.name, (unsigned)requests,
+           requests * 1000.0 / scenario.duration_ms, (unsigned)percentile(results.latency_us, 50),
+           (unsigned)percentile(results.latency_us, 99), (unsigned)results.failed, (unsigned)results.shed,
+           (unsigned)dns.answered,
+           (unsigned)dns.dropped, (unsigned)(heap.peak_used - idle_used), (unsigned)heap.min_largest_free);
+
+    Log::end();
+    fake::stopTasks();
+    delete portal;
+}
+
+// Time to popup. An OS probes, decides the network is captive when the answer
+// is not the one it expects, and its sign-in UI then loads a URL and follows
+// redirects to the page. Each hop costs a round trip plus its response bytes
+// at the link speed.
+#define POPUP_RTT_MS 10
+#define POPUP_MAX_HOPS 5
+
+struct PopupCheck {
+    const char* os;
+    uint32_t probe_ms;  // After joining, as in the behaviors above
+    const char* probe;
+    bool (*online)(const fake::HttpResponse& response);
+    const char* opens;  // Loaded by the sign-in UI
+};
+
+static bool androidOnline(const fake::HttpResponse& response) {
+    return response.code == 204;
+}
+
+static bool appleOnline(const fake::HttpResponse& response) {
+    return response.code == 200 && response.body.find("Success") != std::string::npos;
+}
+
+static bool windowsOnline(const fake::HttpResponse& response) {
+    return response.code == 200 && response.body == "Microsoft Connect Test";
+}
+
+static const PopupCheck POPUP_CHECKS[] = {
+    { "android", 40, "/generate_204", androidOnline, "/generate_204" },
+    { "ios", 30, "/hotspot-detect.html", appleOnline, "/hotspot-detect.html" },
+    { "windows", 40, "/connecttest.txt", windowsOnline, "/redirect" },
+};
+
+static const uint32_t POPUP_LINK_SPEEDS[] = { 250000, 20000, 5000 };
+
+// Status line, headers and body
+static size_t responseBytes(const fake::HttpResponse& response) {
+    size_t bytes = 64 + response.content_type.size();
+    for (size_t i = 0; i < response.headers.size(); i++) {
+        bytes += response.headers[i].first.size() + response.headers[i].second.size() + 4;
+    }
+    return bytes + response.body.size();
+}
+
+// Loads url like a browser, following redirects. Returns the requests
+// made, 0 when no page came back; adds the bytes received.
+static uint32_t loadPage(const char* url, size_t& bytes) {
+    std::string path = url;
+    for (uint32_t hop = 1; hop <= POPUP_MAX_HOPS; hop++) {
+        fake::HttpResponse response = fake::get(path.c_str());
+        bytes += responseBytes(response);
+        if (response.code < 300 || response.code >= 400) {
+            return response.code == 200 ? hop : 0;
+        }
+        path = response.header("Location");
+        size_t host = path.find("://");
+        if (host != std::string::npos) {
+            size_t slash = path.find('/', host + 3);
+            path = slash == std::string::npos ? "/" : path.substr(slash);
+        }
+    }
+    return 0;
+}
+
+static void reportPopup() {
+    fake::reset();
+    ESP32ConfigPortal::invalidateFastConnect();
+    ESP32ConfigPortal* portal = new ESP32ConfigPortal(0, "Bench-Config", "bench_portal");
+    portal->begin(PortalMode::ASYNC);
+    fake::advance(100);
+
+    printf("\n%-8s %5s %11s %11s", "os", "probe", "probe bytes", "popup bytes");
+    for (size_t i = 0; i < COUNT_OF(POPUP_LINK_SPEEDS); i++) {
+        printf(" %6u B/s", (unsigned)POPUP_LINK_SPEEDS[i]);
+    }
+    printf("\n");
+    for (size_t c = 0; c < COUNT_OF(POPUP_CHECKS); c++) {
+        const PopupCheck& check = POPUP_CHECKS[c];
+        fake::HttpResponse probe = fake::get(check.probe);
+        size_t probe_bytes = responseBytes(probe);
+        size_t popup_bytes = 0;
+        uint32_t hops = check.online(probe) ? 0 : loadPage(check.opens, popup_bytes);
+        printf("%-8s %5d %11u %11u", check.os, probe.code, (unsigned)probe_bytes, (unsigned)popup_bytes);
+        for (size_t i = 0; i < COUNT_OF(POPUP_LINK_SPEEDS); i++) {
+            if (hops == 0) {
+                printf(" %10s", "-");
+                continue;
+            }
+            uint64_t ms = check.probe_ms + (1 + hops) * POPUP_RTT_MS +
+                          (uint64_t)(probe_bytes + popup_bytes) * 1000 / POPUP_LINK_SPEEDS[i];
+            printf(" %7u ms", (unsigned)ms);
+        }
+        printf("\n");
+    }
+
+    Log::end();
+    fake::stopTasks();
+    delete portal;
+}
+
+int main() {
+    printf("%-20s %6s %7s %7s %7s %5s %5s %12s %9s %9s\n", "scenario", "reqs", "req/s", "p50 us", "p99 us",
+           "fail", "shed", "dns ok/drop", "peak heap", "min block");
+    for (size_t i = 0; i < COUNT_OF(SCENARIOS); i++) {
+        runScenario(SCENARIOS[i]);
+    }
+    reportPopup();
+    return 0;
+}
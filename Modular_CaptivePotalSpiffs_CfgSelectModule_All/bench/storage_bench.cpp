@@ -0,0 +1,131 @@
+// Configuration storage benchmark: key-per-field layout vs ConfigStore blob.
+//
+// Reports boot-to-config-ready time (open namespace + read everything) and
+// NVS bytes written per save, for an unchanged save and a one-field change.
+// Bytes written are taken from the drop in free NVS entries (32 bytes each).
+//
+//   pio run -e bench_storage -t upload -t monitor
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <nvs.h>
+#include "ConfigStore.h"
+
+static const char* LEGACY_NS = "bench_legacy";
+static const char* BLOB_NS = "bench_blob";
+static const int ITERATIONS = 20;
+static const size_t NVS_ENTRY_SIZE = 32;
+
+static Preferences legacy;
+
+static ConfigData sampleConfig(int variant) {
+    ConfigData config;
+    config.addWiFiProfile("Workshop-2.4GHz", "correct horse battery staple");
+    strlcpy(config.tg_token, "1234567890:ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghi", sizeof(config.tg_token));
+    config.tg_active = true;
+    snprintf(config.host_url, sizeof(config.host_url), "https://telemetry.example.com/api/v1/ingest?device=%d", variant);
+    config.host_active = true;
+    return config;
+}
+
+static long nvsFreeEntries() {
+    nvs_stats_t stats;
+    if (nvs_get_stats(NULL, &stats) != ESP_OK) {
+        return -1;
+    }
+    return stats.free_entries;
+}
+
+// The layout ESP32ConfigPortal used before ConfigStore
+static void legacySave(const ConfigData& config) {
+    legacy.begin(LEGACY_NS, false);
+    legacy.putBool("is_setup_done", true);
+    legacy.putString("wifi_ssid", config.wifi_profiles[0].ssid);
+    legacy.putString("wifi_password", config.wifi_profiles[0].password);
+    legacy.putString("tg_token", config.tg_token);
+    legacy.putBool("tg_active", config.tg_active);
+    legacy.putString("host_url", config.host_url);
+    legacy.putBool("host_active", config.host_active);
+    legacy.end();
+}
+
+static void legacyLoad(ConfigData& config, bool& setupDone) {
+    legacy.begin(LEGACY_NS, false);
+    setupDone = legacy.getBool("is_setup_done", false);
+    config.addWiFiProfile(legacy.getString("wifi_ssid", "").c_str(), legacy.getString("wifi_password", "").c_str());
+    strlcpy(config.tg_token, legacy.getString("tg_token", "").c_str(), sizeof(config.tg_token));
+    config.tg_active = legacy.getBool("tg_active", false);
+    strlcpy(config.host_url, legacy.getString("host_url", "").c_str(), sizeof(config.host_url));
+    config.host_active = legacy.getBool("host_active", false);
+    legacy.end();
+}
+
+// Runs save() ITERATIONS times and returns the average NVS bytes written
+template <typename SaveFn>
+static long bytesPerSave(SaveFn save, bool changeEachTime) {
+    long before = nvsFreeEntries();
+    for (int i = 0; i < ITERATIONS; i++) {
+        save(sampleConfig(changeEachTime ? i : 0));
+    }
+    long after = nvsFreeEntries();
+    if (before < 0 || after > before) {
+        return -1; // Stats unavailable or a page was reclaimed mid-run
+    }
+    return (before - after) * NVS_ENTRY_SIZE / ITERATIONS;
+}
+
+template <typename LoadFn>
+static unsigned long loadMicros(LoadFn load) {
+    unsigned long start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        load();
+    }
+    return (micros() - start) / ITERATIONS;
+}
+
+static void printRow(const char* name, unsigned long loadUs, long unchanged, long changed) {
+    Serial.printf("%-18s %10lu us %12ld B %12ld B\n", name, loadUs, unchanged, changed);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+    Serial.println("\n=== Config storage benchmark ===");
+
+    ConfigStore store(BLOB_NS);
+    legacy.begin(LEGACY_NS, false);
+    legacy.clear();
+    legacy.end();
+    store.clear();
+
+    // Seed both layouts with the same content
+    legacySave(sampleConfig(0));
+    store.save(sampleConfig(0), true);
+
+    ConfigData config;
+    bool setupDone;
+    unsigned long legacyLoadUs = loadMicros([&]() { legacyLoad(config, setupDone); });
+    unsigned long blobLoadUs = loadMicros([&]() { store.load(config, setupDone); });
+
+    long legacyUnchanged = bytesPerSave([](const ConfigData& c) { legacySave(c); }, false);
+    long blobUnchanged = bytesPerSave([&](const ConfigData& c) { store.save(c, true); }, false);
+    long legacyChanged = bytesPerSave([](const ConfigData& c) { legacySave(c); }, true);
+    long blobChanged = bytesPerSave([&](const ConfigData& c) { store.save(c, true); }, true);
+
+    Serial.printf("%-18s %13s %14s %14s\n", "layout", "config-ready", "unchanged save", "changed save");
+    printRow("key-per-field", legacyLoadUs, legacyUnchanged, legacyChanged);
+    printRow("blob", blobLoadUs, blobUnchanged, blobChanged);
+    Serial.printf("blob writes: %lu of %lu saves, %lu payload bytes\n",
+                  (unsigned long)store.writeCount(), (unsigned long)store.saveCount(),
+                  (unsigned long)store.bytesWritten());
+    Serial.println("(-1 B: NVS page reclaimed during the run, rerun for a figure)");
+
+    legacy.begin(LEGACY_NS, false);
+    legacy.clear();
+    legacy.end();
+    store.clear();
+}
+
+void loop() {
+    delay(1000);
+}
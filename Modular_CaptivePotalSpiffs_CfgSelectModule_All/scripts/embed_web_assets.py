@@ -0,0 +1,97 @@
+"""
+Embed the portal web assets into the firmware.
+
+Every file in web/ is minified (leading/trailing whitespace per line),
+gzipped and written to src/PortalAssets.h as a PROGMEM byte array together
+with a strong ETag derived from the uncompressed content. The portal serves
+these arrays directly with "Content-Encoding: gzip", so pages never touch
+the heap.
+
+Runs automatically as a PlatformIO pre-build script, or by hand:
+    python scripts/embed_web_assets.py
+The header is only rewritten when its content changes, so unchanged assets
+do not trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUTPUT = os.path.join(PROJECT_DIR, "src", "PortalAssets.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".txt": "text/plain",
+}
+
+TEXT_TYPES = (".html", ".css", ".js", ".json", ".svg", ".txt")
+
+
+def minify(name, raw):
+    if not name.endswith(TEXT_TYPES):
+        return raw
+    lines = (line.strip() for line in raw.decode("utf-8").splitlines())
+    return "\n".join(line for line in lines if line).encode("utf-8")
+
+
+def symbol_for(name):
+    return "PORTAL_ASSET_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def render_asset(name, raw):
+    body = minify(name, raw)
+    packed = gzip.compress(body, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(body).hexdigest()[:16]
+    content_type = CONTENT_TYPES.get(os.path.splitext(name)[1], "application/octet-stream")
+    symbol = symbol_for(name)
+
+    out = ["// %s: %d bytes, %d gzipped" % (name, len(body), len(packed))]
+    out.append("static const uint8_t %s_DATA[] PROGMEM = {" % symbol)
+    for i in range(0, len(packed), 16):
+        out.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+    out.append("};")
+    out.append("static const PortalAsset %s = {" % symbol)
+    out.append("    %s_DATA, sizeof(%s_DATA), \"\\\"%s\\\"\", \"%s\", true" % (symbol, symbol, etag, content_type))
+    out.append("};")
+    return "\n".join(out)
+
+
+def generate():
+    names = sorted(n for n in os.listdir(WEB_DIR) if os.path.isfile(os.path.join(WEB_DIR, n)))
+    parts = [
+        "// Generated by scripts/embed_web_assets.py from web/ - do not edit.",
+        "#ifndef PORTAL_ASSETS_H",
+        "#define PORTAL_ASSETS_H",
+        "",
+        "#include \"PortalAsset.h\"",
+        "",
+    ]
+    for name in names:
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            parts.append(render_asset(name, f.read()))
+        parts.append("")
+    parts.append("#endif // PORTAL_ASSETS_H")
+    text = "\n".join(parts) + "\n"
+
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, "r") as f:
+            if f.read() == text:
+                return
+    with open(OUTPUT, "w") as f:
+        f.write(text)
+    print("embed_web_assets: wrote %s (%d assets)" % (os.path.relpath(OUTPUT, PROJECT_DIR), len(names)))
+
+
+generate()
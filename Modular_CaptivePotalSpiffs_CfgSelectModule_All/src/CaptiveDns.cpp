@@ -0,0 +1,136 @@
+#include "CaptiveDns.h"
+#include "Metrics.h"
+
+#define DNS_TYPE_A 1
+#define DNS_TYPE_ANY 255
+#define DNS_CLASS_IN 1
+
+// Header flags of a reply: QR and AA set, RD copied from the query
+#define DNS_FLAGS_REPLY 0x84
+#define DNS_FLAG_RD 0x01
+
+CaptiveDns::CaptiveDns() : running(false) {
+    memset(answer_template, 0, sizeof(answer_template));
+    memset(clients, 0, sizeof(clients));
+}
+
+bool CaptiveDns::start(const IPAddress& address) {
+    stop();
+    if ((uint32_t)address == 0) {
+        return false;
+    }
+
+    // Pointer to the question name, type A, class IN, TTL, 4-byte address
+    static const uint8_t record[] = { 0xC0, DNS_HEADER_SIZE, 0x00, DNS_TYPE_A, 0x00, DNS_CLASS_IN };
+    memcpy(answer_template, record, sizeof(record));
+    answer_template[6] = (uint8_t)(DNS_TTL_S >> 24);
+    answer_template[7] = (uint8_t)(DNS_TTL_S >> 16);
+    answer_template[8] = (uint8_t)(DNS_TTL_S >> 8);
+    answer_template[9] = (uint8_t)DNS_TTL_S;
+    answer_template[10] = 0x00;
+    answer_template[11] = 4;
+    for (int i = 0; i < 4; i++) {
+        answer_template[12 + i] = address[i];
+    }
+    memset(clients, 0, sizeof(clients));
+
+    if (!udp.listen(DNS_PORT)) {
+        return false;
+    }
+    udp.onPacket([this](AsyncUDPPacket& packet) {
+        answer(packet);
+    });
+    running = true;
+    return true;
+}
+
+void CaptiveDns::stop() {
+    if (running) {
+        udp.close();
+        running = false;
+    }
+}
+
+// Token bucket of the sending client
+bool CaptiveDns::admit(uint32_t address) {
+    uint32_t now = millis();
+    ClientSlot* slot = nullptr;
+    ClientSlot* oldest = &clients[0];
+    for (size_t i = 0; i < DNS_CLIENT_SLOTS; i++) {
+        if (clients[i].address == address) {
+            slot = &clients[i];
+            break;
+        }
+        if (clients[i].address == 0 ||
+            (oldest->address != 0 && now - clients[i].refilled_ms > now - oldest->refilled_ms)) {
+            oldest = &clients[i];
+        }
+    }
+    if (!slot) {
+        slot = oldest;
+        slot->address = address;
+        slot->refilled_ms = now;
+        slot->tokens = DNS_RATE_BURST;
+    }
+
+    // Whole tokens only, the remainder keeps accruing
+    uint32_t earned = (now - slot->refilled_ms) * DNS_RATE_PER_S / 1000;
+    if (earned > 0) {
+        slot->tokens = min((uint32_t)DNS_RATE_BURST, slot->tokens + earned);
+        slot->refilled_ms = slot->tokens == DNS_RATE_BURST ? now : slot->refilled_ms + earned * 1000 / DNS_RATE_PER_S;
+    }
+    if (slot->tokens == 0) {
+        return false;
+    }
+    slot->tokens--;
+    return true;
+}
+
+void CaptiveDns::answer(AsyncUDPPacket& packet) {
+    const uint8_t* query = packet.data();
+    size_t length = packet.length();
+
+    // A standard query with exactly one question, nothing else is answered
+    if (length < DNS_HEADER_SIZE + 5 || (query[2] & 0xF8) != 0 || query[4] != 0 || query[5] != 1) {
+        Metrics::count(MetricCounter::DNS_DROPPED);
+        return;
+    }
+    size_t end = DNS_HEADER_SIZE;
+    while (end < length && query[end] != 0) {
+        if ((query[end] & 0xC0) != 0) {
+            Metrics::count(MetricCounter::DNS_DROPPED);
+            return;
+        }
+        end += query[end] + 1;
+    }
+    end += 5;  // Terminating label, type, class
+    if (end > length || end - DNS_HEADER_SIZE > DNS_NAME_MAX + 5) {
+        Metrics::count(MetricCounter::DNS_DROPPED);
+        return;
+    }
+    if (!admit((uint32_t)packet.remoteIP())) {
+        Metrics::count(MetricCounter::DNS_DROPPED);
+        return;
+    }
+
+    uint16_t type = (query[end - 4] << 8) | query[end - 3];
+    uint16_t qclass = (query[end - 2] << 8) | query[end - 1];
+    bool address = (type == DNS_TYPE_A || type == DNS_TYPE_ANY) && qclass == DNS_CLASS_IN;
+
+    // Header with the query's ID, the question echoed, then the A record
+    uint8_t reply[DNS_HEADER_SIZE + DNS_NAME_MAX + 5 + DNS_ANSWER_SIZE];
+    memset(reply, 0, DNS_HEADER_SIZE);
+    reply[0] = query[0];
+    reply[1] = query[1];
+    reply[2] = DNS_FLAGS_REPLY | (query[2] & DNS_FLAG_RD);
+    reply[5] = 1;
+    reply[7] = address ? 1 : 0;
+    memcpy(reply + DNS_HEADER_SIZE, query + DNS_HEADER_SIZE, end - DNS_HEADER_SIZE);
+    size_t size = end;
+    if (address) {
+        memcpy(reply + size, answer_template, DNS_ANSWER_SIZE);
+        size += DNS_ANSWER_SIZE;
+    }
+    packet.write(reply, size);
+    Metrics::count(MetricCounter::DNS_QUERIES);
+}
@@ -0,0 +1,61 @@
+#ifndef CAPTIVE_DNS_H
+#define CAPTIVE_DNS_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+
+// Answer lifetime; clients re-ask soon after leaving the portal network
+#ifndef DNS_TTL_S
+#define DNS_TTL_S 60
+#endif
+
+// Per-client token bucket: sustained queries per second and burst size.
+// Queries over the limit are dropped, clients retry on their own.
+#ifndef DNS_RATE_PER_S
+#define DNS_RATE_PER_S 20
+#endif
+#ifndef DNS_RATE_BURST
+#define DNS_RATE_BURST 30
+#endif
+
+// Clients tracked for rate limiting, least recently seen is replaced
+#ifndef DNS_CLIENT_SLOTS
+#define DNS_CLIENT_SLOTS 8
+#endif
+
+#define DNS_PORT 53
+#define DNS_HEADER_SIZE 12
+#define DNS_ANSWER_SIZE 16
+#define DNS_NAME_MAX 255
+
+// Wildcard responder for the captive portal. Every A query is answered with
+// the AP address, any other type with an empty answer (NOERROR, no records),
+// so clients asking for AAAA or HTTPS records move on instead of waiting for
+// a timeout. Runs in the AsyncUDP task on packet arrival: answers do not
+// depend on how often anything is polled, and keep coming while the
+// connection task is busy. Nothing is allocated per query beyond the reply
+// packet.
+class CaptiveDns {
+    struct ClientSlot {
+        uint32_t address;  // 0: free
+        uint32_t refilled_ms;
+        uint16_t tokens;
+    };
+
+    AsyncUDP udp;
+    bool running;
+    uint8_t answer_template[DNS_ANSWER_SIZE];  // A record for the question name
+    ClientSlot clients[DNS_CLIENT_SLOTS];      // Only touched by the AsyncUDP task
+
+    bool admit(uint32_t address);
+    void answer(AsyncUDPPacket& packet);
+
+public:
+    CaptiveDns();
+
+    bool start(const IPAddress& address);
+    void stop();
+    bool isRunning() const { return running; }
+};
+
+#endif // CAPTIVE_DNS_H
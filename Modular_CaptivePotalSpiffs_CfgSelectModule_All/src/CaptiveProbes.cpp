@@ -0,0 +1,14 @@
+#include "CaptiveProbes.h"
+
+#define CAPTIVE_PROBE_ENTRY(path, answer, client) { path, ProbeAnswer::answer, client },
+
+static const CaptiveProbe CAPTIVE_PROBE_TABLE[] = { CAPTIVE_PROBES(CAPTIVE_PROBE_ENTRY) };
+
+const CaptiveProbe* findCaptiveProbe(const char* path) {
+    for (size_t i = 0; i < sizeof(CAPTIVE_PROBE_TABLE) / sizeof(CAPTIVE_PROBE_TABLE[0]); i++) {
+        if (strcmp(CAPTIVE_PROBE_TABLE[i].path, path) == 0) {
+            return &CAPTIVE_PROBE_TABLE[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,43 @@
+#ifndef CAPTIVE_PROBES_H
+#define CAPTIVE_PROBES_H
+
+#include <Arduino.h>
+
+// What the portal answers a request for a path it does not serve
+enum class ProbeAnswer : uint8_t {
+    REDIRECT,    // 302 to the portal root: the OS raises its sign-in UI
+    NO_CONTENT,  // 204, empty: icons and other page noise
+    NOT_FOUND    // 404, empty: lookups that should give up quietly
+};
+
+// Known paths: X(path, answer, who asks). Connectivity checks expect an exact
+// answer (a 204, "Success", "Microsoft Connect Test"...) and treat anything
+// else as captive; a bodiless redirect is the smallest such answer and hands
+// the sign-in UI the portal URL directly. Paths not listed are redirected too.
+#define CAPTIVE_PROBES(X) \
+    X("/generate_204",                     REDIRECT,   "Android, ChromeOS") \
+    X("/gen_204",                          REDIRECT,   "Android") \
+    X("/hotspot-detect.html",              REDIRECT,   "iOS, macOS") \
+    X("/library/test/success.html",        REDIRECT,   "Older iOS") \
+    X("/connecttest.txt",                  REDIRECT,   "Windows 10 and later") \
+    X("/ncsi.txt",                         REDIRECT,   "Windows 7, 8") \
+    X("/redirect",                         REDIRECT,   "Windows, opened once captive") \
+    X("/canonical.html",                   REDIRECT,   "Firefox") \
+    X("/success.txt",                      REDIRECT,   "Firefox") \
+    X("/check_network_status.txt",         REDIRECT,   "NetworkManager") \
+    X("/kindle-wifi/wifistub.html",        REDIRECT,   "Kindle") \
+    X("/favicon.ico",                      NO_CONTENT, "Browsers") \
+    X("/apple-touch-icon.png",             NO_CONTENT, "iOS") \
+    X("/apple-touch-icon-precomposed.png", NO_CONTENT, "iOS") \
+    X("/wpad.dat",                         NOT_FOUND,  "Proxy auto-discovery")
+
+struct CaptiveProbe {
+    const char* path;
+    ProbeAnswer answer;
+    const char* client;
+};
+
+// Table entry for a request path (without query), nullptr when not listed
+const CaptiveProbe* findCaptiveProbe(const char* path);
+
+#endif // CAPTIVE_PROBES_H
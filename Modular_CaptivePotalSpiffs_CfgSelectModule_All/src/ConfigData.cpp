@@ -0,0 +1,79 @@
+#include "ConfigData.h"
+
+#define CONFIG_SECTION_ENTRY(key, title) { #key, title },
+const ConfigSectionInfo CONFIG_SECTION_TABLE[CONFIG_SECTION_COUNT] = { CONFIG_SECTIONS(CONFIG_SECTION_ENTRY) };
+
+#define CONFIG_FIELD_ENTRY(member, section, key, label, type, len, secret, def) \
+    { #member, ConfigSection::section, #key, label, ConfigFieldType::type, len, secret, def, offsetof(ConfigData, member) },
+const ConfigField CONFIG_FIELD_TABLE[CONFIG_FIELD_COUNT] = { CONFIG_FIELDS(CONFIG_FIELD_ENTRY) };
+
+ConfigData::ConfigData() : wifi_profile_count(0) {
+    forEachConfigField([this](const ConfigField& field) {
+        setConfigField(*this, field, field.default_value);
+    });
+}
+
+bool ConfigData::addWiFiProfile(const char* ssid, const char* password, uint8_t priority) {
+    if (strlen(ssid) > WIFI_SSID_MAX_LEN || strlen(password) > WIFI_PASSWORD_MAX_LEN) {
+        return false;
+    }
+    WiFiProfile* profile = findWiFiProfile(ssid);
+    if (!profile) {
+        if (ssid[0] == '\0' || wifi_profile_count >= MAX_WIFI_PROFILES) {
+            return false;
+        }
+        profile = &wifi_profiles[wifi_profile_count++];
+        *profile = WiFiProfile();
+        strlcpy(profile->ssid, ssid, sizeof(profile->ssid));
+    }
+    strlcpy(profile->password, password, sizeof(profile->password));
+    profile->priority = priority;
+    return true;
+}
+
+WiFiProfile* ConfigData::findWiFiProfile(const char* ssid) {
+    for (uint8_t i = 0; i < wifi_profile_count; i++) {
+        if (strcmp(wifi_profiles[i].ssid, ssid) == 0) {
+            return &wifi_profiles[i];
+        }
+    }
+    return nullptr;
+}
+
+const WiFiProfile* ConfigData::findWiFiProfile(const char* ssid) const {
+    return const_cast<ConfigData*>(this)->findWiFiProfile(ssid);
+}
+
+const WiFiProfile* ConfigData::primaryWiFiProfile() const {
+    if (wifi_profile_count == 0) {
+        return nullptr;
+    }
+    const WiFiProfile* best = &wifi_profiles[0];
+    for (uint8_t i = 1; i < wifi_profile_count; i++) {
+        if (wifi_profiles[i].last_success > best->last_success) {
+            best = &wifi_profiles[i];
+        }
+    }
+    return best;
+}
+
+const ConfigField* findConfigField(const char* name) {
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        if (strcmp(CONFIG_FIELD_TABLE[i].name, name) == 0) {
+            return &CONFIG_FIELD_TABLE[i];
+        }
+    }
+    return nullptr;
+}
+
+bool setConfigField(ConfigData& config, const ConfigField& field, const char* value) {
+    if (field.type == ConfigFieldType::BOOL) {
+        configField<bool>(config, field) = strcmp(value, "1") == 0 || strcmp(value, "true") == 0 || strcmp(value, "on") == 0;
+        return true;
+    }
+    if (strlen(value) > field.max_length) {
+        return false;
+    }
+    strlcpy(configString(config, field), value, field.max_length + 1);
+    return true;
+}
@@ -0,0 +1,144 @@
+#ifndef CONFIG_DATA_H
+#define CONFIG_DATA_H
+
+#include <Arduino.h>
+#include <stddef.h>
+
+#ifndef MAX_WIFI_PROFILES
+#define MAX_WIFI_PROFILES 4
+#endif
+
+#define WIFI_SSID_MAX_LEN 32
+#define WIFI_PASSWORD_MAX_LEN 64
+
+// Shown in place of stored secrets
+#define CONFIG_SECRET_MASK "********"
+
+// Sections of the portal form and the JSON API, in display order
+//   X(key, title)
+#define CONFIG_SECTIONS(X) \
+    X(telegram, "Telegram Configuration") \
+    X(host,     "Web Host Configuration")
+
+// Module settings. Storage, the portal form, form and JSON parsing and the
+// status printout are all generated from this list, so a new setting is one
+// line here. Append only: stored blobs are decoded in this order.
+//   X(member, section, json key, label, type, max length, secret, default)
+// Types: BOOL, STRING, URL (a STRING that must be http:// or https://).
+#define CONFIG_FIELDS(X) \
+    X(tg_active,   telegram, active, "Enable Telegram", BOOL,   0,   false, "false") \
+    X(tg_token,    telegram, token,  "Bot Token",       STRING, 128, true,  "") \
+    X(host_active, host,     active, "Enable Web Host", BOOL,   0,   false, "false") \
+    X(host_url,    host,     url,    "Host URL",        URL,    256, false, "") \
+    X(tg_chat,     telegram, chat,   "Chat ID",         STRING, 32,  false, "")
+
+// One known network
+struct WiFiProfile {
+    char ssid[WIFI_SSID_MAX_LEN + 1];
+    char password[WIFI_PASSWORD_MAX_LEN + 1];
+    uint8_t priority;       // Higher is preferred when ranking
+    uint32_t last_success;  // Connection counter value at the last successful connect, 0 = never
+
+    WiFiProfile() : priority(0), last_success(0) {
+        ssid[0] = '\0';
+        password[0] = '\0';
+    }
+};
+
+#define CONFIG_MEMBER_BOOL(member, len)   bool member;
+#define CONFIG_MEMBER_STRING(member, len) char member[len + 1];
+#define CONFIG_MEMBER_URL(member, len)    char member[len + 1];
+#define CONFIG_DECLARE_MEMBER(member, section, key, label, type, len, secret, def) CONFIG_MEMBER_##type(member, len)
+
+// Configuration structure to hold all settings. Fixed-size and heap free:
+// every string lives in an inline buffer sized from CONFIG_FIELDS.
+struct ConfigData {
+    WiFiProfile wifi_profiles[MAX_WIFI_PROFILES];
+    uint8_t wifi_profile_count;
+    CONFIG_FIELDS(CONFIG_DECLARE_MEMBER)
+
+    // Constructor with the defaults from CONFIG_FIELDS
+    ConfigData();
+
+    // Adds a profile or updates the one with the same SSID; false when full or too long
+    bool addWiFiProfile(const char* ssid, const char* password, uint8_t priority = 0);
+
+    WiFiProfile* findWiFiProfile(const char* ssid);
+    const WiFiProfile* findWiFiProfile(const char* ssid) const;
+
+    // Most recently successful profile, or the first one
+    const WiFiProfile* primaryWiFiProfile() const;
+};
+
+// Field registry generated from CONFIG_FIELDS
+
+enum class ConfigFieldType : uint8_t { BOOL, STRING, URL };
+
+#define CONFIG_SECTION_ENUM(key, title) key,
+enum class ConfigSection : uint8_t { CONFIG_SECTIONS(CONFIG_SECTION_ENUM) };
+
+struct ConfigSectionInfo {
+    const char* key;
+    const char* title;
+};
+
+struct ConfigField {
+    const char* name;           // Member, form and legacy storage name
+    ConfigSection section;
+    const char* key;            // Key inside the JSON section
+    const char* label;
+    ConfigFieldType type;
+    uint16_t max_length;        // Strings only, excluding the terminator
+    bool secret;                // Masked in JSON and status output
+    const char* default_value;  // "true"/"false" for BOOL
+    uint16_t offset;            // Of the member in ConfigData
+};
+
+#define CONFIG_COUNT_ENTRY(...) + 1
+static constexpr size_t CONFIG_FIELD_COUNT = 0 CONFIG_FIELDS(CONFIG_COUNT_ENTRY);
+static constexpr size_t CONFIG_SECTION_COUNT = 0 CONFIG_SECTIONS(CONFIG_COUNT_ENTRY);
+
+// Defined once in ConfigData.cpp, so a field pointer is the same object in
+// every translation unit and can index per-field arrays
+extern const ConfigSectionInfo CONFIG_SECTION_TABLE[CONFIG_SECTION_COUNT];
+extern const ConfigField CONFIG_FIELD_TABLE[CONFIG_FIELD_COUNT];
+
+// Typed access to a registry field of a config, e.g. configField<bool>(config, field)
+template <typename T>
+inline T& configField(ConfigData& config, const ConfigField& field) {
+    return *reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(&config) + field.offset);
+}
+
+template <typename T>
+inline const T& configField(const ConfigData& config, const ConfigField& field) {
+    return *reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(&config) + field.offset);
+}
+
+// String fields as their inline buffer
+inline char* configString(ConfigData& config, const ConfigField& field) {
+    return &configField<char>(config, field);
+}
+
+inline const char* configString(const ConfigData& config, const ConfigField& field) {
+    return &configField<char>(config, field);
+}
+
+template <typename Fn>
+inline void forEachConfigField(Fn fn) {
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        fn(CONFIG_FIELD_TABLE[i]);
+    }
+}
+
+inline const ConfigSectionInfo& configSection(const ConfigField& field) {
+    return CONFIG_SECTION_TABLE[(size_t)field.section];
+}
+
+// Lookup by member/form name, nullptr when unknown
+const ConfigField* findConfigField(const char* name);
+
+// Sets a field from text (form posts, legacy storage). Booleans accept
+// "1", "true" and "on"; false when the value is too long for the field.
+bool setConfigField(ConfigData& config, const ConfigField& field, const char* value);
+
+#endif // CONFIG_DATA_H
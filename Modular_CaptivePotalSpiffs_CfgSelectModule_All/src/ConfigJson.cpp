@@ -0,0 +1,181 @@
+#include "ConfigJson.h"
+
+static const char* maskSecret(const char* secret) {
+    return secret[0] != '\0' ? CONFIG_SECRET_MASK : "";
+}
+
+static bool isMask(const char* value) {
+    return strcmp(value, CONFIG_SECRET_MASK) == 0;
+}
+
+// Optional string member; absent is fine, wrong type or length is not
+static bool readString(JsonObject obj, const char* key, size_t maxLen, const char*& out) {
+    JsonVariant value = obj[key];
+    if (value.isNull()) {
+        out = nullptr;
+        return true;
+    }
+    if (!value.is<const char*>()) {
+        return false;
+    }
+    out = value.as<const char*>();
+    return strlen(out) <= maxLen;
+}
+
+bool validConfigValue(const ConfigField& field, const char* value) {
+    if (field.type == ConfigFieldType::BOOL) {
+        return true;
+    }
+    if (strlen(value) > field.max_length) {
+        return false;
+    }
+    if (field.type == ConfigFieldType::URL && value[0] != '\0') {
+        return strncmp(value, "http://", 7) == 0 || strncmp(value, "https://", 8) == 0;
+    }
+    return true;
+}
+
+void configToJson(const ConfigData& config, JsonObject obj) {
+    JsonArray wifi = obj["wifi"].to<JsonArray>();
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        const WiFiProfile& profile = config.wifi_profiles[i];
+        JsonObject entry = wifi.add<JsonObject>();
+        entry["ssid"] = (const char*)profile.ssid;
+        entry["password"] = maskSecret(profile.password);
+        entry["priority"] = profile.priority;
+    }
+
+    forEachConfigField([&](const ConfigField& field) {
+        JsonObject section = obj[configSection(field).key].as<JsonObject>();
+        if (section.isNull()) {
+            section = obj[configSection(field).key].to<JsonObject>();
+        }
+        if (field.type == ConfigFieldType::BOOL) {
+            section[field.key] = configField<bool>(config, field);
+        } else if (field.secret) {
+            section[field.key] = maskSecret(configString(config, field));
+        } else {
+            section[field.key] = configString(config, field);
+        }
+    });
+}
+
+static bool wifiFromJson(JsonArray list, const ConfigData& current, ConfigData& next, String& error) {
+    if (list.size() > MAX_WIFI_PROFILES) {
+        error = "wifi: at most " + String(MAX_WIFI_PROFILES) + " networks";
+        return false;
+    }
+    next.wifi_profile_count = 0;
+    for (uint8_t i = 0; i < MAX_WIFI_PROFILES; i++) {
+        next.wifi_profiles[i] = WiFiProfile();
+    }
+
+    uint8_t index = 0;
+    for (JsonVariant item : list) {
+        String field = "wifi[" + String(index++) + "]";
+        JsonObject entry = item.as<JsonObject>();
+        if (entry.isNull()) {
+            error = field + ": expected an object";
+            return false;
+        }
+
+        const char* ssid;
+        if (!readString(entry, "ssid", WIFI_SSID_MAX_LEN, ssid) || !ssid || !*ssid) {
+            error = field + ".ssid: 1-" + String(WIFI_SSID_MAX_LEN) + " characters required";
+            return false;
+        }
+        const char* password;
+        if (!readString(entry, "password", WIFI_PASSWORD_MAX_LEN, password)) {
+            error = field + ".password: too long";
+            return false;
+        }
+        if (password && *password && !isMask(password) && strlen(password) < CONFIG_PASSWORD_MIN_LEN) {
+            error = field + ".password: at least " + String(CONFIG_PASSWORD_MIN_LEN) + " characters";
+            return false;
+        }
+        JsonVariant priority = entry["priority"];
+        if (!priority.isNull() && (!priority.is<int>() || priority.as<int>() < 0 || priority.as<int>() > CONFIG_PRIORITY_MAX)) {
+            error = field + ".priority: 0-" + String(CONFIG_PRIORITY_MAX);
+            return false;
+        }
+        if (next.findWiFiProfile(ssid)) {
+            error = field + ".ssid: duplicate";
+            return false;
+        }
+
+        WiFiProfile& profile = next.wifi_profiles[next.wifi_profile_count++];
+        strlcpy(profile.ssid, ssid, sizeof(profile.ssid));
+        profile.priority = priority.isNull() ? 0 : priority.as<int>();
+
+        // Known network: keep its history, and its password unless a new one was sent
+        bool keepPassword = !password || isMask(password);
+        const WiFiProfile* known = current.findWiFiProfile(ssid);
+        if (known) {
+            profile.last_success = known->last_success;
+        }
+        if (!keepPassword) {
+            strlcpy(profile.password, password, sizeof(profile.password));
+        } else if (known) {
+            strlcpy(profile.password, known->password, sizeof(profile.password));
+        }
+    }
+    return true;
+}
+
+bool configFromJson(JsonObject obj, ConfigData& config, String& error) {
+    if (obj.isNull()) {
+        error = "expected a JSON object";
+        return false;
+    }
+    ConfigData next = config;
+
+    JsonVariant wifi = obj["wifi"];
+    if (!wifi.isNull()) {
+        if (!wifi.is<JsonArray>()) {
+            error = "wifi: expected an array";
+            return false;
+        }
+        if (!wifiFromJson(wifi.as<JsonArray>(), config, next, error)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        const ConfigField& field = CONFIG_FIELD_TABLE[i];
+        const char* sectionKey = configSection(field).key;
+        JsonVariant section = obj[sectionKey];
+        if (section.isNull()) {
+            continue;
+        }
+        if (!section.is<JsonObject>()) {
+            error = String(sectionKey) + ": expected an object";
+            return false;
+        }
+        JsonVariant value = section[field.key];
+        if (value.isNull()) {
+            continue;
+        }
+        String name = String(sectionKey) + "." + field.key;
+
+        if (field.type == ConfigFieldType::BOOL) {
+            if (!value.is<bool>()) {
+                error = name + ": expected a boolean";
+                return false;
+            }
+            configField<bool>(next, field) = value.as<bool>();
+            continue;
+        }
+        const char* text = value.as<const char*>();
+        if (!value.is<const char*>() || !validConfigValue(field, text)) {
+            error = name + (field.type == ConfigFieldType::URL ? ": http(s) URL of at most " : ": string of at most ") +
+                    String(field.max_length) + " characters";
+            return false;
+        }
+        if (!(field.secret && isMask(text))) {
+            setConfigField(next, field, text);
+        }
+    }
+
+    config = next;
+    return true;
+}
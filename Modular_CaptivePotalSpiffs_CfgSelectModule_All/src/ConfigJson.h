@@ -0,0 +1,29 @@
+#ifndef CONFIG_JSON_H
+#define CONFIG_JSON_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "ConfigData.h"
+
+// WiFi limits enforced on input; module fields use CONFIG_FIELDS
+#define CONFIG_PASSWORD_MIN_LEN 8
+#define CONFIG_PRIORITY_MAX 9
+
+// JSON form of ConfigData used by the REST API: a "wifi" array plus one
+// object per CONFIG_SECTIONS entry holding its fields by json key, e.g.
+//   {"wifi":[{"ssid":"...","password":"...","priority":0}],
+//    "telegram":{"active":false,"token":"...","chat":"..."},
+//    "host":{"active":false,"url":"..."}}
+// Sending CONFIG_SECRET_MASK back for a secret keeps the stored value.
+
+// Writes config into obj with passwords and secret fields masked
+void configToJson(const ConfigData& config, JsonObject obj);
+
+// Validates obj and applies it on top of config in one pass. Missing
+// sections and fields keep their current values, as does a masked secret. On failure config is left untouched and error names the field.
+bool configFromJson(JsonObject obj, ConfigData& config, String& error);
+
+// Validation shared with the form handler: length, type and URL scheme
+bool validConfigValue(const ConfigField& field, const char* value);
+
+#endif // CONFIG_JSON_H
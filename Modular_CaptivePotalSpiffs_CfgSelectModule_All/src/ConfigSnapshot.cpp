@@ -0,0 +1,48 @@
+#include "ConfigSnapshot.h"
+#include <freertos/task.h>
+
+ConfigSnapshot::ConfigSnapshot() : active(0), current_version(0) {
+    versions[0] = versions[1] = 0;
+    readers[0] = 0;
+    readers[1] = 0;
+    portMUX_INITIALIZE(&write_lock);
+}
+
+// Registers as a reader of the current buffer. Rechecking after the
+// increment catches a flip in between, in which case the writer may already
+// be refilling the buffer we picked.
+uint8_t ConfigSnapshot::acquire() const {
+    for (;;) {
+        uint8_t index = active;
+        readers[index]++;
+        if (index == active) {
+            return index;
+        }
+        readers[index]--;
+    }
+}
+
+void ConfigSnapshot::publish(const ConfigData& next) {
+    // One writer at a time; readers are waited out before reusing a buffer
+    for (;;) {
+        portENTER_CRITICAL(&write_lock);
+        uint8_t spare = active ^ 1;
+        if (readers[spare] == 0) {
+            buffers[spare] = next;
+            versions[spare] = ++current_version;
+            active = spare;
+            portEXIT_CRITICAL(&write_lock);
+            return;
+        }
+        portEXIT_CRITICAL(&write_lock);
+        vTaskDelay(1);
+    }
+}
+
+uint32_t ConfigSnapshot::read(ConfigData& out) const {
+    uint8_t index = acquire();
+    out = buffers[index];
+    uint32_t version = versions[index];
+    release(index);
+    return version;
+}
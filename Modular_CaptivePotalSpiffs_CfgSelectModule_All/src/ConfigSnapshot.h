@@ -0,0 +1,46 @@
+#ifndef CONFIG_SNAPSHOT_H
+#define CONFIG_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include "ConfigData.h"
+
+// Published configuration shared between tasks. Two buffers: publish()
+// fills the one readers are not on and then flips, so readers never block,
+// never copy and never see a half-written config. A writer only waits if a
+// reader is still on the buffer it is about to reuse, so keep visitors short.
+class ConfigSnapshot {
+private:
+    ConfigData buffers[2];
+    uint32_t versions[2];
+    std::atomic<uint8_t> active;
+    mutable std::atomic<uint32_t> readers[2];
+    std::atomic<uint32_t> current_version;
+    portMUX_TYPE write_lock;
+
+    uint8_t acquire() const;
+    void release(uint8_t index) const { readers[index]--; }
+
+public:
+    ConfigSnapshot();
+
+    // Copies next into the spare buffer and makes it current; any task
+    void publish(const ConfigData& next);
+
+    // Bumped by every publish(), 0 before the first one
+    uint32_t version() const { return current_version; }
+
+    // Runs fn on the current config without copying it; any task
+    template <typename Fn>
+    void visit(Fn fn) const {
+        uint8_t index = acquire();
+        fn(static_cast<const ConfigData&>(buffers[index]));
+        release(index);
+    }
+
+    // Copy for callers that keep a config of their own; returns its version
+    uint32_t read(ConfigData& out) const;
+};
+
+#endif // CONFIG_SNAPSHOT_H
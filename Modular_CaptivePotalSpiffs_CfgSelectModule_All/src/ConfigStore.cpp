@@ -0,0 +1,341 @@
+#include "ConfigStore.h"
+#include "Log.h"
+#include "Metrics.h"
+
+// Blob layout (little endian):
+//   u32 magic | u16 version | u16 payload length | u32 payload CRC32 | payload
+// Payload v3:
+//   u8 flags (bit0 setup done)
+//   u8 profile count, then per profile:
+//     str ssid | str password | u8 priority | u32 last_success
+//   each CONFIG_FIELDS entry in order: BOOL as u8, strings as str.
+//   A blob that ends early leaves the remaining fields at their defaults.
+// Payload v2:
+//   u8 flags (bit0 setup done, bit1 tg_active, bit2 host_active)
+//   profiles as in v3 | str tg_token | str host_url
+// Payload v1 (single network):
+//   u8 flags | str wifi_ssid | str wifi_password | str tg_token | str host_url
+// where str is a u16 length followed by the bytes.
+
+static const char* BLOB_KEY = "cfg";
+static const uint32_t BLOB_MAGIC = 0x42474643; // "CFGB"
+static const size_t HEADER_SIZE = 12;
+
+static const uint8_t FLAG_SETUP_DONE = 0x01;
+static const uint8_t FLAG_TG_ACTIVE = 0x02;
+static const uint8_t FLAG_HOST_ACTIVE = 0x04;
+
+// Keys of the key-per-field layout used before the blob (schema version 0)
+static const char* LEGACY_KEYS[] = {
+    "is_setup_done", "wifi_ssid", "wifi_password", "tg_token", "tg_active", "host_url", "host_active"
+};
+
+namespace {
+
+struct BlobWriter {
+    uint8_t* buf;
+    size_t capacity;
+    size_t pos;
+    bool ok;
+
+    BlobWriter(uint8_t* b, size_t cap) : buf(b), capacity(cap), pos(0), ok(true) {}
+
+    void u8(uint8_t v) {
+        if (pos + 1 > capacity) { ok = false; return; }
+        buf[pos++] = v;
+    }
+    void u16(uint16_t v) {
+        u8(v & 0xff);
+        u8(v >> 8);
+    }
+    void u32(uint32_t v) {
+        u16(v & 0xffff);
+        u16(v >> 16);
+    }
+    void str(const char* s) {
+        size_t n = strlen(s);
+        if (n > 0xffff || pos + 2 + n > capacity) { ok = false; return; }
+        u16(n);
+        memcpy(buf + pos, s, n);
+        pos += n;
+    }
+};
+
+struct BlobReader {
+    const uint8_t* buf;
+    size_t length;
+    size_t pos;
+    bool ok;
+
+    BlobReader(const uint8_t* b, size_t len) : buf(b), length(len), pos(0), ok(true) {}
+
+    uint8_t u8() {
+        if (pos + 1 > length) { ok = false; return 0; }
+        return buf[pos++];
+    }
+    uint16_t u16() {
+        uint16_t lo = u8();
+        return lo | (uint16_t)u8() << 8;
+    }
+    uint32_t u32() {
+        uint32_t lo = u16();
+        return lo | (uint32_t)u16() << 16;
+    }
+    // A string too long for out is skipped and read as empty
+    void str(char* out, size_t capacity) {
+        uint16_t n = u16();
+        if (!ok || pos + n > length) { ok = false; out[0] = '\0'; return; }
+        size_t copied = n < capacity ? n : 0;
+        memcpy(out, buf + pos, copied);
+        out[copied] = '\0';
+        pos += n;
+    }
+    bool atEnd() const { return pos >= length; }
+};
+
+} // namespace
+
+ConfigStore::ConfigStore(const String& prefsNamespace)
+    : ns(prefsNamespace), stored_crc(0), stored_length(0), stored_valid(false),
+      save_count(0), write_count(0), bytes_written(0) {
+}
+
+uint32_t ConfigStore::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+size_t ConfigStore::encode(const ConfigData& config, bool setupDone, uint8_t* buf, size_t capacity) const {
+    if (capacity < HEADER_SIZE) {
+        return 0;
+    }
+    BlobWriter payload(buf + HEADER_SIZE, capacity - HEADER_SIZE);
+    payload.u8(setupDone ? FLAG_SETUP_DONE : 0);
+    payload.u8(config.wifi_profile_count);
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        const WiFiProfile& profile = config.wifi_profiles[i];
+        payload.str(profile.ssid);
+        payload.str(profile.password);
+        payload.u8(profile.priority);
+        payload.u32(profile.last_success);
+    }
+    forEachConfigField([&](const ConfigField& field) {
+        if (field.type == ConfigFieldType::BOOL) {
+            payload.u8(configField<bool>(config, field));
+        } else {
+            payload.str(configString(config, field));
+        }
+    });
+    if (!payload.ok) {
+        return 0;
+    }
+
+    BlobWriter header(buf, HEADER_SIZE);
+    header.u32(BLOB_MAGIC);
+    header.u16(CONFIG_SCHEMA_VERSION);
+    header.u16(payload.pos);
+    header.u32(crc32(buf + HEADER_SIZE, payload.pos));
+    return HEADER_SIZE + payload.pos;
+}
+
+bool ConfigStore::decode(const uint8_t* payload, size_t length, uint16_t version, ConfigData& config, bool& setupDone) const {
+    BlobReader in(payload, length);
+
+    uint8_t flags = in.u8();
+    setupDone = flags & FLAG_SETUP_DONE;
+
+    if (version == 1) {
+        char ssid[WIFI_SSID_MAX_LEN + 1];
+        char password[WIFI_PASSWORD_MAX_LEN + 1];
+        in.str(ssid, sizeof(ssid));
+        in.str(password, sizeof(password));
+        config.addWiFiProfile(ssid, password);
+    } else if (version == 2 || version == 3) {
+        uint8_t count = in.u8();
+        if (count > MAX_WIFI_PROFILES) {
+            return false;
+        }
+        for (uint8_t i = 0; i < count && in.ok; i++) {
+            WiFiProfile& profile = config.wifi_profiles[i];
+            in.str(profile.ssid, sizeof(profile.ssid));
+            in.str(profile.password, sizeof(profile.password));
+            profile.priority = in.u8();
+            profile.last_success = in.u32();
+        }
+        config.wifi_profile_count = count;
+    } else {
+        return false;
+    }
+
+    if (version < 3) {
+        // Fixed module fields of the older layouts
+        config.tg_active = flags & FLAG_TG_ACTIVE;
+        config.host_active = flags & FLAG_HOST_ACTIVE;
+        in.str(config.tg_token, sizeof(config.tg_token));
+        in.str(config.host_url, sizeof(config.host_url));
+        return in.ok;
+    }
+
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT && in.ok && !in.atEnd(); i++) {
+        const ConfigField& field = CONFIG_FIELD_TABLE[i];
+        if (field.type == ConfigFieldType::BOOL) {
+            configField<bool>(config, field) = in.u8() != 0;
+        } else {
+            in.str(configString(config, field), field.max_length + 1);
+        }
+    }
+    return in.ok;
+}
+
+bool ConfigStore::loadLegacy(ConfigData& config, bool& setupDone) {
+    if (!preferences.begin(ns.c_str(), true)) {
+        return false;
+    }
+    bool found = preferences.isKey("is_setup_done") || preferences.isKey("wifi_ssid");
+    if (found) {
+        setupDone = preferences.getBool("is_setup_done", false);
+        config.addWiFiProfile(preferences.getString("wifi_ssid", "").c_str(), preferences.getString("wifi_password", "").c_str());
+        // Module fields were stored under their own names
+        forEachConfigField([&](const ConfigField& field) {
+            if (!preferences.isKey(field.name)) {
+                return;
+            }
+            if (field.type == ConfigFieldType::BOOL) {
+                configField<bool>(config, field) = preferences.getBool(field.name, false);
+            } else {
+                setConfigField(config, field, preferences.getString(field.name, "").c_str());
+            }
+        });
+    }
+    preferences.end();
+    return found;
+}
+
+void ConfigStore::removeLegacyKeys() {
+    preferences.begin(ns.c_str(), false);
+    for (const char* key : LEGACY_KEYS) {
+        if (preferences.isKey(key)) {
+            preferences.remove(key);
+        }
+    }
+    preferences.end();
+}
+
+bool ConfigStore::load(ConfigData& config, bool& setupDone) {
+    config = ConfigData();
+    setupDone = false;
+    stored_valid = false;
+
+    uint8_t image[CONFIG_BLOB_MAX_SIZE];
+    size_t length = 0;
+    if (preferences.begin(ns.c_str(), true)) {
+        if (preferences.isKey(BLOB_KEY)) {
+            length = preferences.getBytes(BLOB_KEY, image, sizeof(image));
+        }
+        preferences.end();
+    }
+
+    if (length == 0) {
+        if (!loadLegacy(config, setupDone)) {
+            return false;
+        }
+        LOG_I("Migrating configuration from key-per-field layout");
+        if (onMigrateCallback) {
+            onMigrateCallback(0, config);
+        }
+        if (save(config, setupDone)) {
+            removeLegacyKeys();
+        }
+        return true;
+    }
+
+    BlobReader header(image, length);
+    uint32_t magic = header.u32();
+    uint16_t version = header.u16();
+    uint16_t payload_length = header.u16();
+    uint32_t crc = header.u32();
+
+    if (!header.ok || magic != BLOB_MAGIC || HEADER_SIZE + payload_length != length ||
+        crc32(image + HEADER_SIZE, payload_length) != crc) {
+        LOG_W("Stored configuration is corrupt, ignoring it");
+        return false;
+    }
+    if (version > CONFIG_SCHEMA_VERSION) {
+        LOG_W("Stored configuration is from a newer firmware, ignoring it");
+        return false;
+    }
+    if (!decode(image + HEADER_SIZE, payload_length, version, config, setupDone)) {
+        LOG_W("Stored configuration could not be decoded, ignoring it");
+        config = ConfigData();
+        setupDone = false;
+        return false;
+    }
+
+    if (version < CONFIG_SCHEMA_VERSION) {
+        LOG_I("Migrating configuration from schema version %u", (unsigned)version);
+        if (onMigrateCallback) {
+            onMigrateCallback(version, config);
+        }
+        save(config, setupDone);
+    } else {
+        stored_crc = crc32(image, length);
+        stored_length = length;
+        stored_valid = true;
+    }
+    return true;
+}
+
+bool ConfigStore::writeImage(const uint8_t* image, size_t length) {
+    if (!preferences.begin(ns.c_str(), false)) {
+        return false;
+    }
+    size_t written;
+    {
+        MetricTimer timer(MetricHistogram::NVS_WRITE);
+        written = preferences.putBytes(BLOB_KEY, image, length);
+        preferences.end();
+    }
+
+    if (written != length) {
+        LOG_E("Failed to write configuration");
+        return false;
+    }
+    write_count++;
+    bytes_written += length;
+    return true;
+}
+
+bool ConfigStore::save(const ConfigData& config, bool setupDone) {
+    uint8_t image[CONFIG_BLOB_MAX_SIZE];
+    size_t length = encode(config, setupDone, image, sizeof(image));
+    if (length == 0) {
+        LOG_E("Configuration too large to store");
+        return false;
+    }
+    save_count++;
+
+    uint32_t crc = crc32(image, length);
+    if (stored_valid && crc == stored_crc && length == stored_length) {
+        return true; // Identical image already in flash
+    }
+    if (!writeImage(image, length)) {
+        return false;
+    }
+    stored_crc = crc;
+    stored_length = length;
+    stored_valid = true;
+    return true;
+}
+
+void ConfigStore::clear() {
+    preferences.begin(ns.c_str(), false);
+    preferences.clear();
+    preferences.end();
+    stored_valid = false;
+}
@@ -0,0 +1,68 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <functional>
+#include "ConfigData.h"
+
+// Current blob layout. Fields appended to CONFIG_FIELDS need no bump (older
+// blobs just end early); bump for any other change and teach
+// ConfigStore::decode() to read the previous version.
+#define CONFIG_SCHEMA_VERSION 3
+
+#ifndef CONFIG_BLOB_MAX_SIZE
+#define CONFIG_BLOB_MAX_SIZE 1024
+#endif
+
+// Called after an older image (or the legacy key-per-field layout, version 0)
+// has been decoded, before it is rewritten in the current format.
+typedef std::function<void(uint16_t fromVersion, ConfigData& config)> ConfigMigrationCallback;
+
+// Persists ConfigData as a single versioned, CRC-checked blob in one NVS key.
+// Loading is one read; saving only writes when the serialized image differs
+// from what is already stored.
+class ConfigStore {
+private:
+    Preferences preferences;
+    String ns;
+    ConfigMigrationCallback onMigrateCallback;
+
+    // Image currently in flash, used to skip identical writes
+    uint32_t stored_crc;
+    size_t stored_length;
+    bool stored_valid;
+
+    // Write statistics
+    uint32_t save_count;
+    uint32_t write_count;
+    uint32_t bytes_written;
+
+    size_t encode(const ConfigData& config, bool setupDone, uint8_t* buf, size_t capacity) const;
+    bool decode(const uint8_t* payload, size_t length, uint16_t version, ConfigData& config, bool& setupDone) const;
+    bool loadLegacy(ConfigData& config, bool& setupDone);
+    void removeLegacyKeys();
+    bool writeImage(const uint8_t* image, size_t length);
+
+public:
+    explicit ConfigStore(const String& prefsNamespace);
+
+    // Returns false when nothing valid is stored; config is left at defaults
+    bool load(ConfigData& config, bool& setupDone);
+
+    // Returns false only on a failed write; an unchanged image is not written
+    bool save(const ConfigData& config, bool setupDone);
+
+    void clear();
+
+    void onMigrate(ConfigMigrationCallback callback) { onMigrateCallback = callback; }
+
+    uint32_t saveCount() const { return save_count; }
+    uint32_t writeCount() const { return write_count; }
+    uint32_t bytesWritten() const { return bytes_written; }
+
+    // CRC-32 as in zlib and gzip; pass the previous result as crc to continue
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+};
+
+#endif // CONFIG_STORE_H
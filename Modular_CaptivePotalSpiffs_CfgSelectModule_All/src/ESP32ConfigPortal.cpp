@@ -1,397 +1,1493 @@
 #include "ESP32ConfigPortal.h"
+#include "PortalAssets.h"
+#include "ConfigJson.h"
+#include <ArduinoJson.h>
+#include <esp_pm.h>
+#include <esp_idf_version.h>
+
+#if ESP_IDF_VERSION_MAJOR < 5
+#include <esp32/pm.h>
+typedef esp_pm_config_esp32_t esp_pm_config_t;
+#endif
+
+// Event group bit set once the device is configured and connected
+#define SETUP_DONE_BIT BIT0
+
+// /events data: state, escaped SSID and a few numbers
+#define PORTAL_EVENT_SIZE 320
+// Browsers reconnect this soon when the stream drops
+#define PORTAL_EVENTS_RETRY_MS 2000
+// Event source route; its streams do not count against the connection caps
+#define PORTAL_EVENTS_URL "/events"
 
 // Constructor
 ESP32ConfigPortal::ESP32ConfigPortal(int resetPin, const String& apName, const String& prefsNamespace)
-    : server(80), reset_button_pin(resetPin), ap_name(apName), preferences_namespace(prefsNamespace),
-      is_setup_done(false), config_received(false), wifi_timeout(false),
-      wifi_timeout_ms(20000), reset_hold_time_ms(3000), status_print_interval_ms(30000),
-      lastStatusPrint(0) {
-}
-
-String ESP32ConfigPortal::getDefaultHTML() {
-    return R"rawliteral(
-<!DOCTYPE HTML><html><head>
-  <title>ESP32 Configuration Portal</title>
-  <meta name="viewport" content="width=device-width, initial-scale=1">
-  <style>
-    body { font-family: Arial, sans-serif; margin: 20px; background-color: #f0f0f0; }
-    .container { background-color: white; padding: 20px; border-radius: 10px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }
-    .section { margin-bottom: 25px; padding: 15px; border: 1px solid #ddd; border-radius: 5px; }
-    .section h4 { margin-top: 0; color: #333; }
-    input[type="text"], input[type="password"], input[type="url"] { width: 100%; padding: 8px; margin: 5px 0; border: 1px solid #ddd; border-radius: 4px; }
-    input[type="checkbox"] { margin-right: 10px; }
-    .wifi-profile { background-color: #f9f9f9; margin: 10px 0; padding: 10px; border-radius: 5px; }
-    .submit-btn { background-color: #4CAF50; color: white; padding: 12px 20px; border: none; border-radius: 4px; cursor: pointer; font-size: 16px; }
-    .submit-btn:hover { background-color: #45a049; }
-  </style>
-</head><body>
-  <div class="container">
-    <h2>ESP32 Configuration Portal</h2>
-    <form action="/save" method="POST">
-      
-      <div class="section">
-        <h4>WiFi Configuration</h4>
-        <div class="wifi-profile">
-          SSID: <input type="text" name="wifi_ssid" placeholder="Network Name" required><br>
-          Password: <input type="password" name="wifi_password" placeholder="Network Password">
-        </div>
-      </div>
-      
-      <div class="section">
-        <h4>Telegram Configuration</h4>
-        <input type="checkbox" name="tg_active" value="1"> Enable Telegram<br>
-        Bot Token: <input type="text" name="tg_token" placeholder="1234567890:ABCDEF...">
-      </div>
-      
-      <div class="section">
-        <h4>Web Host Configuration</h4>
-        <input type="checkbox" name="host_active" value="1"> Enable Web Host<br>
-        Host URL: <input type="url" name="host_url" placeholder="https://example.com/api">
-      </div>
-      
-      <input type="submit" value="Save Configuration" class="submit-btn">
-    </form>
-  </div>
-</body></html>)rawliteral";
-}
-
-String ESP32ConfigPortal::getSuccessHTML() {
-    return R"rawliteral(
-<!DOCTYPE HTML><html><head>
-  <meta http-equiv="refresh" content="15">
-  <style>
-    body { font-family: Arial, sans-serif; margin: 20px; background-color: #f0f0f0; text-align: center; }
-    .container { background-color: white; padding: 30px; border-radius: 10px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); display: inline-block; }
-  </style>
-</head><body>
-  <div class="container">
-    <h3>Configuration Saved!</h3>
-    <p>Connecting to WiFi network...<br>
-    Please wait while the device connects.<br><br>
-    This page will refresh automatically in 15 seconds.</p>
-  </div>
-</body></html>)rawliteral";
+    : store(prefsNamespace), server(80), button(resetPin),
+      config_inbox(nullptr), config_view_version(0), is_setup_done(false), config_save_pending(false), portal_running(false), wifi_timeout(false),
+      reset_button_pin(resetPin), ap_name(apName), preferences_namespace(prefsNamespace),
+      wifi_timeout_ms(20000), reset_hold_time_ms(3000), long_press_time_ms(1000), status_print_interval_ms(30000),
+      lastStatusPrint(0), wifi_state(WiFiState::IDLE), wifi_state_since(0), wifi_backoff_ms(0),
+      wifi_got_ip(false), wifi_lost(false), wifi_disconnect_reason(0), wifi_events_registered(false), wifi_event_id(0),
+      wifi_candidate_count(0), wifi_candidate_index(0), wifi_profile_index(-1), profile_history_dirty(false),
+      fast_connect_enabled(true), fast_attempt(false), fast_profile_hash(0), connect_cycle_started(0), power_save(false), power_saving(-1),
+      modules_version(0), metrics_busy(false), events(nullptr), events_id(0), firmware_boot_pending(false),
+      setup_events(nullptr), setup_task(nullptr), setup_task_running(false), portal_requested(false),
+      page_asset(&PORTAL_ASSET_INDEX_HTML), success_asset(&PORTAL_ASSET_SUCCESS_HTML) {
+    wifi_target_ssid[0] = '\0';
+    portal_url[0] = '\0';
+    connect_timing = { ConnectPath::NONE, 0, 0 };
+}
+
+ESP32ConfigPortal::~ESP32ConfigPortal() {
+    modules.stopAll();
+    if (wifi_events_registered) {
+        WiFi.removeEvent(wifi_event_id);
+    }
+    if (portal_running) {
+        stopCaptivePortal();
+    }
+    server.end();
+    Metrics::unwatchTask(setup_task);
+    if (config_inbox) {
+        vQueueDelete(config_inbox);
+    }
+    if (setup_events) {
+        vEventGroupDelete(setup_events);
+    }
+}
+
+const PortalAsset& ESP32ConfigPortal::getDefaultPage() {
+    return PORTAL_ASSET_INDEX_HTML;
+}
+
+const PortalAsset& ESP32ConfigPortal::getSuccessPage() {
+    return PORTAL_ASSET_SUCCESS_HTML;
+}
+
+// FNV-1a based strong ETag for pages that are not generated at build time
+static String makeETag(const String& content) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < content.length(); i++) {
+        hash ^= (uint8_t)content[i];
+        hash *= 16777619u;
+    }
+    char etag[16];
+    snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)hash);
+    return String(etag);
+}
+
+void ESP32ConfigPortal::setCustomHTML(const PortalAsset& page, const PortalAsset* successPage) {
+    page_asset = &page;
+    success_asset = successPage ? successPage : &getSuccessPage();
 }
 
 void ESP32ConfigPortal::setCustomHTML(const String& html, const String& successHtml) {
+    // Keep a single copy; requests are served from it without further copies
     custom_html = html;
-    custom_success_html = successHtml.length() > 0 ? successHtml : getSuccessHTML();
+    custom_html_etag = makeETag(custom_html);
+    custom_page = { (const uint8_t*)custom_html.c_str(), custom_html.length(),
+                    custom_html_etag.c_str(), "text/html", false };
+    page_asset = &custom_page;
+    
+    if (successHtml.length() > 0) {
+        custom_success_html = successHtml;
+        custom_success_etag = makeETag(custom_success_html);
+        custom_success_page = { (const uint8_t*)custom_success_html.c_str(), custom_success_html.length(),
+                                custom_success_etag.c_str(), "text/html", false };
+        success_asset = &custom_success_page;
+    } else {
+        success_asset = &getSuccessPage();
+    }
+}
+
+// Module fields, one line each; secrets are redacted
+static void logConfigFields(const ConfigData& config) {
+    forEachConfigField([&](const ConfigField& field) {
+        if (field.type == ConfigFieldType::BOOL) {
+            LOG_I("%s: %s", field.label, configField<bool>(config, field) ? "ON" : "OFF");
+            return;
+        }
+        const char* value = configString(config, field);
+        LOG_I("%s: %s", field.label, value[0] == '\0' ? "NOT SET" : field.secret ? Log::redact(value) : value);
+    });
+}
+
+void ESP32ConfigPortal::sendAsset(AsyncWebServerRequest *request, const PortalAsset& asset) {
+    // Revalidation from a client that already has the page
+    if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == asset.etag) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", asset.etag);
+        request->send(response);
+        return;
+    }
+    
+    // Streamed straight from flash, no heap copy of the body
+    AsyncWebServerResponse *response = request->beginResponse(200, asset.content_type, asset.data, asset.length);
+    if (asset.gzipped) {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+}
+
+// Paths the portal does not serve, answered per CaptiveProbes.h. Misses not
+// in the table are redirected like probes.
+void ESP32ConfigPortal::sendCaptiveAnswer(AsyncWebServerRequest *request) {
+    const CaptiveProbe* probe = findCaptiveProbe(request->url().c_str());
+    if (probe) {
+        Metrics::count(MetricCounter::CAPTIVE_PROBES);
+        LOG_D("Probe %s (%s)", probe->path, probe->client);
+    }
+    switch (probe ? probe->answer : ProbeAnswer::REDIRECT) {
+        case ProbeAnswer::REDIRECT:
+            request->redirect(portal_url);
+            break;
+        case ProbeAnswer::NO_CONTENT:
+            request->send(204);
+            break;
+        case ProbeAnswer::NOT_FOUND:
+            request->send(404);
+            break;
+    }
+}
+
+void ESP32ConfigPortal::sendProfiles(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    doc["max"] = MAX_WIFI_PROFILES;
+    JsonArray profiles = doc["profiles"].to<JsonArray>();
+    config_snapshot.visit([&](const ConfigData& current) {
+        for (uint8_t i = 0; i < current.wifi_profile_count; i++) {
+            JsonObject profile = profiles.add<JsonObject>();
+            profile["ssid"] = (const char*)current.wifi_profiles[i].ssid;
+            profile["priority"] = current.wifi_profiles[i].priority;
+            profile["has_password"] = current.wifi_profiles[i].password[0] != '\0';
+        }
+    });
+    
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Nearby networks for the portal, strongest first. Stale or missing results
+// start a background scan and answer 202 with whatever is cached; every
+// client polling meanwhile shares that one scan.
+void ESP32ConfigPortal::sendScan(AsyncWebServerRequest *request) {
+    ScanResult networks[SCAN_CACHE_MAX_RESULTS];
+    unsigned long age;
+    bool fresh;
+    uint8_t count = scan_cache.copyResults(networks, SCAN_CACHE_MAX_RESULTS, age, fresh);
+    bool scanning = !fresh && scan_cache.start();
+    
+    for (uint8_t i = 1; i < count; i++) {
+        ScanResult entry = networks[i];
+        uint8_t j = i;
+        while (j > 0 && networks[j - 1].rssi < entry.rssi) {
+            networks[j] = networks[j - 1];
+            j--;
+        }
+        networks[j] = entry;
+    }
+    
+    JsonDocument doc;
+    doc["scanning"] = scanning;
+    doc["age_ms"] = count ? age : 0;
+    JsonArray list = doc["networks"].to<JsonArray>();
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject network = list.add<JsonObject>();
+        network["ssid"] = (const char*)networks[i].ssid;
+        network["rssi"] = networks[i].rssi;
+        network["channel"] = networks[i].channel;
+        network["secure"] = networks[i].secure;
+    }
+    
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->setCode(scanning ? 202 : 200);
+    response->addHeader("Cache-Control", "no-store");
+    if (scanning) {
+        response->addHeader("Retry-After", "1");
+    }
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Module fields for the portal form, generated from CONFIG_FIELDS.
+// Secrets are never sent, only whether one is stored.
+void ESP32ConfigPortal::sendFormSchema(AsyncWebServerRequest *request) {
+    api_pool.reset();
+    JsonDocument doc(&api_pool);
+    JsonArray sections = doc["sections"].to<JsonArray>();
+    config_snapshot.visit([&](const ConfigData& current) {
+        for (size_t i = 0; i < CONFIG_SECTION_COUNT; i++) {
+            if (modules.size() > 0 && !modules.hasSection((ConfigSection)i)) {
+                continue;
+            }
+            JsonObject section = sections.add<JsonObject>();
+            section["title"] = CONFIG_SECTION_TABLE[i].title;
+            JsonArray fields = section["fields"].to<JsonArray>();
+            forEachConfigField([&](const ConfigField& field) {
+                if ((size_t)field.section != i) {
+                    return;
+                }
+                JsonObject entry = fields.add<JsonObject>();
+                entry["name"] = field.name;
+                entry["label"] = field.label;
+                if (field.type == ConfigFieldType::BOOL) {
+                    entry["type"] = "bool";
+                    entry["value"] = configField<bool>(current, field);
+                    return;
+                }
+                entry["type"] = field.type == ConfigFieldType::URL ? "url" : "text";
+                entry["max"] = field.max_length;
+                if (field.secret) {
+                    entry["secret"] = true;
+                    entry["stored"] = configString(current, field)[0] != '\0';
+                } else {
+                    entry["value"] = configString(current, field);
+                }
+            });
+        }
+    });
+    
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Request body being collected in request->_tempObject (freed by the server)
+struct ApiBody {
+    size_t received;
+    char* data() { return (char*)(this + 1); }
+};
+
+// Messages are our own and never contain quotes, no document needed
+void ESP32ConfigPortal::sendApiError(AsyncWebServerRequest *request, int code, const String& message) {
+    request->send(code, "application/json", "{\"error\":\"" + message + "\"}");
+}
+
+void ESP32ConfigPortal::sendApiConfig(AsyncWebServerRequest *request) {
+    api_pool.reset();
+    JsonDocument doc(&api_pool);
+    config_snapshot.visit([&](const ConfigData& current) {
+        configToJson(current, doc.to<JsonObject>());
+    });
+    if (doc.overflowed()) {
+        sendApiError(request, 500, "configuration does not fit API_JSON_POOL_SIZE");
+        return;
+    }
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+void ESP32ConfigPortal::sendApiStatus(AsyncWebServerRequest *request) {
+    bool connected = wifi_state == WiFiState::CONNECTED;
+    
+    api_pool.reset();
+    JsonDocument doc(&api_pool);
+    doc["state"] = wifiStateName(wifi_state);
+    doc["state_ms"] = getTimeInState();
+    doc["setup_done"] = is_setup_done.load();
+    doc["portal"] = portal_running;
+    doc["config_pending"] = config_inbox && uxQueueMessagesWaiting(config_inbox) > 0;
+    doc["config_version"] = config_snapshot.version();
+    if (connected) {
+        doc["ssid"] = WiFi.SSID();
+        doc["ip"] = WiFi.localIP().toString();
+        doc["rssi"] = WiFi.RSSI();
+    }
+    doc["update"] = FirmwareUpdate::stateName(firmware.getState());
+    if (firmware.getState() == FirmwareState::RECEIVING) {
+        doc["update_bytes"] = firmware.bytesWritten();
+    }
+    doc["uptime_ms"] = millis();
+    doc["free_heap"] = ESP.getFreeHeap();
+    
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->addHeader("Cache-Control", "no-store");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Body chunks arrive in order; oversized bodies are never buffered
+void ESP32ConfigPortal::receiveApiBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (total > API_BODY_MAX_SIZE) {
+        return;
+    }
+    if (index == 0 && !request->_tempObject) {
+        request->_tempObject = malloc(sizeof(ApiBody) + total);
+        if (request->_tempObject) {
+            ((ApiBody*)request->_tempObject)->received = 0;
+        }
+    }
+    ApiBody* body = (ApiBody*)request->_tempObject;
+    if (!body || index != body->received || index + len > total) {
+        return;
+    }
+    memcpy(body->data() + index, data, len);
+    body->received += len;
+}
+
+void ESP32ConfigPortal::handleApiConfigPut(AsyncWebServerRequest *request) {
+    if (request->contentLength() > API_BODY_MAX_SIZE) {
+        sendApiError(request, 413, "body larger than " + String(API_BODY_MAX_SIZE) + " bytes");
+        return;
+    }
+    ApiBody* body = (ApiBody*)request->_tempObject;
+    if (!body || body->received != request->contentLength()) {
+        sendApiError(request, 400, "missing or incomplete body");
+        return;
+    }
+    
+    api_pool.reset();
+    JsonDocument doc(&api_pool);
+    DeserializationError err = deserializeJson(doc, body->data(), body->received,
+                                               DeserializationOption::NestingLimit(4));
+    if (err == DeserializationError::NoMemory) {
+        sendApiError(request, 413, "document too complex");
+        return;
+    }
+    if (err) {
+        sendApiError(request, 400, String("invalid JSON: ") + err.c_str());
+        return;
+    }
+    
+    ConfigData next;
+    config_snapshot.read(next);
+    String error;
+    if (!configFromJson(doc.as<JsonObject>(), next, error)) {
+        sendApiError(request, 422, error);
+        return;
+    }
+    LOG_I("Configuration received via API, processing...");
+    submitConfig(next);
+    request->send(200, "application/json", "{\"status\":\"applied\"}");
+}
+
+// Prometheus text exposition, rendered chunk by chunk from one snapshot.
+// The snapshot is a member, so one scrape is served at a time.
+void ESP32ConfigPortal::sendMetrics(AsyncWebServerRequest *request) {
+    if (metrics_busy.exchange(true)) {
+        AsyncWebServerResponse *response = request->beginResponse(503);
+        response->addHeader("Retry-After", "1");
+        request->send(response);
+        return;
+    }
+    
+    // Handlers run in the web server's task, watch its stack too
+    Metrics::watchTask(xTaskGetCurrentTaskHandle());
+    Metrics::set(MetricGauge::WIFI_RSSI, wifi_state == WiFiState::CONNECTED ? WiFi.RSSI() : 0);
+    Metrics::set(MetricGauge::CONFIG_VERSION, config_snapshot.version());
+    Metrics::capture(metrics_snapshot);
+    
+    // Replaces admission's hook, the library keeps one per request
+    request->onDisconnect([this, request]() {
+        metrics_busy = false;
+        admission.release(request->client()->remoteIP());
+    });
+    AsyncWebServerResponse *response = request->beginChunkedResponse(METRICS_CONTENT_TYPE,
+        [this](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return Metrics::render(metrics_snapshot, (char*)buffer, maxLen, index);
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+// Recent log output, oldest first, straight from the log tail. Chunked: if
+// new lines overwrite the rest of the window before it is sent, the
+// response just ends there instead of falling short of a declared length.
+void ESP32ConfigPortal::sendLog(AsyncWebServerRequest *request) {
+    uint32_t start;
+    uint32_t length;
+    Log::tail(start, length);
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain; charset=utf-8",
+        [start, length](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            if (index >= length) {
+                return 0;
+            }
+            return Log::readTail(start + index, (char*)buffer, min(maxLen, (size_t)(length - index)));
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+void ESP32ConfigPortal::addDiagnosticRoutes() {
+    server.on("/metrics", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        sendMetrics(request);
+    });
+    server.on("/log", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        sendLog(request);
+    });
+}
+
+// Times a route handler into the HTTP handler histogram
+static ArRequestHandlerFunction timed(ArRequestHandlerFunction handler) {
+    return [handler](AsyncWebServerRequest *request) {
+        MetricTimer timer(MetricHistogram::HTTP_HANDLER);
+        handler(request);
+    };
+}
+
+bool ESP32ConfigPortal::updateAllowed(AsyncWebServerRequest *request) {
+#ifdef FIRMWARE_UPDATE_PASSWORD
+    return request->authenticate("admin", FIRMWARE_UPDATE_PASSWORD);
+#else
+    (void)request;
+    return true;
+#endif
+}
+
+// File part of the multipart body, in the pieces it arrives in. Nothing is
+// buffered here; each piece goes to flash before the next is read.
+void ESP32ConfigPortal::receiveFirmware(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final) {
+    if (index == 0) {
+        if (!updateAllowed(request)) {
+            return;
+        }
+        // Replaces admission's hook. Set before begin(): a refused start keeps
+        // the upload for its error response, and a client gone before that
+        // must still let it go.
+        request->onDisconnect([this, request]() {
+            firmware.abort(request);
+            admission.release(request->client()->remoteIP());
+        });
+        const String& sha = request->hasHeader("X-Firmware-SHA256") ? request->header("X-Firmware-SHA256")
+                                                                     : request->arg("sha256");
+        if (!firmware.begin(request, request->contentLength(), sha.c_str())) {
+            return;
+        }
+    }
+    if (!firmware.owns(request) || (len > 0 && !firmware.write(request, data, len))) {
+        return;
+    }
+    if (final) {
+        firmware.finish(request);
+    }
+}
+
+void ESP32ConfigPortal::handleFirmwareUpload(AsyncWebServerRequest *request) {
+    if (!updateAllowed(request)) {
+        request->requestAuthentication(nullptr, false);
+        return;
+    }
+    if (!firmware.owns(request)) {
+        if (firmware.busy()) {
+            sendApiError(request, 409, "another update is in progress");
+        } else {
+            sendApiError(request, 400, "no firmware in request");
+        }
+        return;
+    }
+    switch (firmware.getState()) {
+        case FirmwareState::DONE:
+            request->send(200, "application/json", "{\"status\":\"restarting\"}");
+            scheduler.notify(PORTAL_WAKE_WEB);  // Restart deadline
+            break;
+        case FirmwareState::FAILED:
+            sendApiError(request, 400, firmware.error());
+            break;
+        default:
+            sendApiError(request, 400, "incomplete upload");
+            break;
+    }
+    firmware.release(request);
+}
+
+void ESP32ConfigPortal::addUpdateRoutes() {
+    server.on("/update", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        if (!updateAllowed(request)) {
+            request->requestAuthentication(nullptr, false);
+            return;
+        }
+        sendAsset(request, PORTAL_ASSET_UPDATE_HTML);
+    }));
+    server.on("/update", HTTP_POST, timed([this](AsyncWebServerRequest *request) {
+        handleFirmwareUpload(request);
+    }), [this](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+        (void)filename;
+        receiveFirmware(request, index, data, len, final);
+    });
+}
+
+// Connected mode: the portal routes are gone, /metrics and /log stay
+// reachable, /update too when it has a password
+void ESP32ConfigPortal::serveConnected() {
+#if METRICS_SERVE_CONNECTED || FIRMWARE_SERVE_CONNECTED
+    server.reset();
+    events = nullptr;
+    server.addHandler(new AdmissionHandler(admission));
+#if METRICS_SERVE_CONNECTED
+    addDiagnosticRoutes();
+#endif
+#if FIRMWARE_SERVE_CONNECTED
+    addUpdateRoutes();
+#endif
+    server.begin();
+#endif
 }
 
 void ESP32ConfigPortal::setupServer() {
-    // Clear any existing handlers
+    // Clear any existing handlers; admission sees every request first
     server.reset();
-    
-    String htmlContent = custom_html.length() > 0 ? custom_html : getDefaultHTML();
-    String successContent = custom_success_html.length() > 0 ? custom_success_html : getSuccessHTML();
+    server.addHandler(new AdmissionHandler(admission, PORTAL_EVENTS_URL));
+    addDiagnosticRoutes();
+    addUpdateRoutes();
+
+    // Connection progress for the success page, current state first
+    events = new AsyncEventSource(PORTAL_EVENTS_URL);
+    events->onConnect([this](AsyncEventSourceClient *client) {
+        char data[PORTAL_EVENT_SIZE];
+        formatWiFiState(data, sizeof(data));
+        client->send(data, "state", events_id, PORTAL_EVENTS_RETRY_MS);
+    });
+    server.addHandler(events);
 
     // Root route
-    server.on("/", HTTP_GET, [this, htmlContent](AsyncWebServerRequest *request) {
-        request->send(200, "text/html", htmlContent);
-        Serial.println("Configuration portal accessed");
+    server.on("/", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendAsset(request, *page_asset);
+        LOG_D("Configuration portal accessed");
+    }));
+
+    // Stored networks for the profile editor, passwords are never sent
+    server.on("/wifi/profiles.json", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendProfiles(request);
+    }));
+
+    // Cached scan results for the SSID picker
+    server.on("/scan.json", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendScan(request);
+    }));
+
+    // Module fields of the portal form
+    server.on("/api/schema", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendFormSchema(request);
+    }));
+
+    // REST API for provisioning tools
+    server.on("/api/config", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendApiConfig(request);
+    }));
+    server.on("/api/config", HTTP_PUT, timed([this](AsyncWebServerRequest *request) {
+        handleApiConfigPut(request);
+    }), nullptr, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        receiveApiBody(request, data, len, index, total);
     });
+    server.on("/api/status", HTTP_GET, timed([this](AsyncWebServerRequest *request) {
+        sendApiStatus(request);
+    }));
 
     // Configuration saving route
-    server.on("/save", HTTP_POST, [this, successContent](AsyncWebServerRequest *request) {
-        Serial.println("Configuration received, processing...");
+    server.on("/save", HTTP_POST, timed([this](AsyncWebServerRequest *request) {
+        LOG_I("Configuration received, processing...");
+        ConfigData next;
+        config_snapshot.read(next);
         
-        // Process WiFi credentials
-        if (request->hasParam("wifi_ssid", true)) {
-            config.wifi_ssid = request->getParam("wifi_ssid", true)->value();
-            Serial.println("WiFi SSID: " + config.wifi_ssid);
-        }
-        if (request->hasParam("wifi_password", true)) {
-            config.wifi_password = request->getParam("wifi_password", true)->value();
-            Serial.println("WiFi password received");
+        // Process WiFi profiles: the portal submits the whole list
+        if (request->hasParam("wifi_ssid_0", true)) {
+            WiFiProfile profiles[MAX_WIFI_PROFILES];
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < MAX_WIFI_PROFILES; i++) {
+                String index(i);
+                const AsyncWebParameter* ssid = request->getParam("wifi_ssid_" + index, true);
+                if (!ssid || ssid->value().length() == 0 || ssid->value().length() > WIFI_SSID_MAX_LEN) {
+                    continue;
+                }
+                WiFiProfile& profile = profiles[count++];
+                strlcpy(profile.ssid, ssid->value().c_str(), sizeof(profile.ssid));
+                const AsyncWebParameter* password = request->getParam("wifi_password_" + index, true);
+                if (password) {
+                    strlcpy(profile.password, password->value().c_str(), sizeof(profile.password));
+                }
+                const AsyncWebParameter* priority = request->getParam("wifi_priority_" + index, true);
+                profile.priority = priority ? constrain(priority->value().toInt(), 0, 9) : 0;
+                
+                // Known network: keep its history, and its password when left blank
+                const WiFiProfile* known = next.findWiFiProfile(profile.ssid);
+                if (known) {
+                    profile.last_success = known->last_success;
+                    if (profile.password[0] == '\0') {
+                        strlcpy(profile.password, known->password, sizeof(profile.password));
+                    }
+                }
+                LOG_I("WiFi SSID: %s, password %s", profile.ssid, Log::redact(profile.password));
+            }
+            for (uint8_t i = 0; i < MAX_WIFI_PROFILES; i++) {
+                next.wifi_profiles[i] = profiles[i];
+            }
+            next.wifi_profile_count = count;
+        } else if (request->hasParam("wifi_ssid", true)) {
+            // Single-network form, e.g. from an older custom page
+            String password = request->hasParam("wifi_password", true) ? request->getParam("wifi_password", true)->value() : String();
+            next.addWiFiProfile(request->getParam("wifi_ssid", true)->value().c_str(), password.c_str());
+            LOG_I("WiFi SSID: %s, password %s", request->getParam("wifi_ssid", true)->value().c_str(), Log::redact(password.c_str()));
         }
         
-        // Process Telegram settings
-        config.tg_active = request->hasParam("tg_active", true);
-        if (request->hasParam("tg_token", true)) {
-            config.tg_token = request->getParam("tg_token", true)->value();
-            Serial.println("Telegram " + String(config.tg_active ? "enabled" : "disabled"));
+        // Module fields in one pass over the parameters. Unchecked boxes are
+        // not posted, so booleans of a section that was posted default to
+        // off; blank secrets keep the stored value.
+        bool posted[CONFIG_FIELD_COUNT] = {};
+        bool section_posted[CONFIG_SECTION_COUNT] = {};
+        for (size_t i = 0; i < request->params(); i++) {
+            const AsyncWebParameter* param = request->getParam(i);
+            const ConfigField* field = param->isPost() ? findConfigField(param->name().c_str()) : nullptr;
+            if (!field) {
+                continue;
+            }
+            posted[field - CONFIG_FIELD_TABLE] = true;
+            section_posted[(size_t)field->section] = true;
+            if (field->secret && param->value().length() == 0) {
+                continue;
+            }
+            if (!validConfigValue(*field, param->value().c_str())) {
+                LOG_W("Ignoring invalid value for %s", field->label);
+                continue;
+            }
+            setConfigField(next, *field, field->type == ConfigFieldType::BOOL ? "1" : param->value().c_str());
         }
-        
-        // Process Host settings
-        config.host_active = request->hasParam("host_active", true);
-        if (request->hasParam("host_url", true)) {
-            config.host_url = request->getParam("host_url", true)->value();
-            Serial.println("Web Host " + String(config.host_active ? "enabled" : "disabled"));
+        for (size_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+            const ConfigField& field = CONFIG_FIELD_TABLE[i];
+            if (field.type == ConfigFieldType::BOOL && !posted[i] && section_posted[(size_t)field.section]) {
+                configField<bool>(next, field) = false;
+            }
         }
+        logConfigFields(next);
         
-        config_received = true;
-        request->send(200, "text/html", successContent);
-    });
+        submitConfig(next);
+        sendAsset(request, *success_asset);
+    }));
 
-    // Wildcard route for captive portal
-    server.onNotFound([this, htmlContent](AsyncWebServerRequest *request) {
-        request->send(200, "text/html", htmlContent);
-    });
+    // Everything else, OS connectivity checks included: a bodiless answer,
+    // never the page itself
+    server.onNotFound(timed([this](AsyncWebServerRequest *request) {
+        sendCaptiveAnswer(request);
+    }));
 }
 
 void ESP32ConfigPortal::WiFiSoftAPSetup() {
-    WiFi.mode(WIFI_AP);
+    // Station interface stays up so the portal can scan
+    WiFi.mode(WIFI_AP_STA);
     if (!WiFi.softAP(ap_name.c_str())) {
-        Serial.println("Failed to start AP");
+        LOG_E("Failed to start AP");
+        Log::flush();
         delay(1000);
         ESP.restart();
     }
-    Serial.print("AP IP address: ");
-    Serial.println(WiFi.softAPIP());
+    IPAddress ip = WiFi.softAPIP();
+    LOG_I("AP IP address: " LOG_IP_FMT, LOG_IP_ARGS(ip));
 }
 
+const char* ESP32ConfigPortal::wifiStateName(WiFiState state) {
+    switch (state) {
+        case WiFiState::IDLE:       return "IDLE";
+        case WiFiState::SCANNING:   return "SCANNING";
+        case WiFiState::CONNECTING: return "CONNECTING";
+        case WiFiState::CONNECTED:  return "CONNECTED";
+        case WiFiState::BACKOFF:    return "BACKOFF";
+        case WiFiState::PORTAL:     return "PORTAL";
+    }
+    return "UNKNOWN";
+}
+
+// Why an attempt failed, for people; 0 is no disconnect, only the timeout
+static const char* disconnectReasonText(uint8_t reason) {
+    switch (reason) {
+        case 0:                                  return "timed out";
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_AUTH_FAIL:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:      return "wrong password";
+        case WIFI_REASON_NO_AP_FOUND:            return "network not found";
+        case WIFI_REASON_BEACON_TIMEOUT:         return "signal lost";
+        case WIFI_REASON_ASSOC_FAIL:             return "association refused";
+        default:                                 return "disconnected";
+    }
+}
+
+// SSID as a quoted JSON string; out must hold 6 bytes per character plus 3
+static void quoteJson(const char* text, char* out, size_t size) {
+    size_t length = 0;
+    out[length++] = '"';
+    for (; *text && length + 8 < size; text++) {
+        char c = *text;
+        if (c == '"' || c == '\\') {
+            out[length++] = '\\';
+            out[length++] = c;
+        } else if ((uint8_t)c < 0x20) {
+            length += snprintf(out + length, size - length, "\\u%04x", (uint8_t)c);
+        } else {
+            out[length++] = c;
+        }
+    }
+    out[length++] = '"';
+    out[length] = '\0';
+}
+
+// Runs in the WiFi event task: only record what happened, handle() acts on it
+void ESP32ConfigPortal::onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            wifi_got_ip = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            // Ignore late disconnects from a previous candidate
+            if (info.wifi_sta_disconnected.ssid_len != strlen(wifi_target_ssid) ||
+                memcmp(info.wifi_sta_disconnected.ssid, wifi_target_ssid, info.wifi_sta_disconnected.ssid_len) != 0) {
+                return;
+            }
+            wifi_disconnect_reason = info.wifi_sta_disconnected.reason;
+            wifi_lost = true;
+            break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+            wifi_lost = true;
+            break;
+        case ARDUINO_EVENT_WIFI_SCAN_DONE:
+            break;
+        default:
+            return;
+    }
+    // Whoever drives the connection picks it up
+    scheduler.notify(PORTAL_WAKE_WIFI);
+}
+
+void ESP32ConfigPortal::setWiFiState(WiFiState next) {
+    WiFiState prev = wifi_state;
+    wifi_state = next;
+    wifi_state_since = millis();
+    Metrics::set(MetricGauge::WIFI_CONNECTED, next == WiFiState::CONNECTED);
+    
+    if (next == WiFiState::CONNECTED) {
+        if (onWiFiConnected) {
+            onWiFiConnected();
+        }
+    } else if (prev == WiFiState::CONNECTED) {
+        if (onWiFiDisconnected) {
+            onWiFiDisconnected();
+        }
+    }
+    publishWiFiState();
+}
+
+// Someone follows /events; nothing is formatted otherwise
+bool ESP32ConfigPortal::eventsWatched() const {
+    return events && events->count() > 0;
+}
+
+// Current connection state as /events data, e.g.
+// {"state":"CONNECTED","ssid":"home","ip":"192.168.1.20","rssi":-58,"ms":2310}
+void ESP32ConfigPortal::formatWiFiState(char* buffer, size_t size) const {
+    char ssid[6 * 32 + 3];
+    quoteJson(wifi_target_ssid, ssid, sizeof(ssid));
+    int length = snprintf(buffer, size, "{\"state\":\"%s\",\"ssid\":%s", wifiStateName(wifi_state), ssid);
+    switch (wifi_state) {
+        case WiFiState::CONNECTING:
+            length += snprintf(buffer + length, size - length, ",\"attempt\":%u,\"of\":%u",
+                               (unsigned)(fast_attempt ? 1 : wifi_candidate_index + 1),
+                               (unsigned)(fast_attempt ? 1 : wifi_candidate_count));
+            break;
+        case WiFiState::CONNECTED: {
+            IPAddress ip = WiFi.localIP();
+            length += snprintf(buffer + length, size - length, ",\"ip\":\"" LOG_IP_FMT "\",\"rssi\":%d,\"ms\":%lu",
+                               LOG_IP_ARGS(ip), (int)WiFi.RSSI(), (unsigned long)connect_timing.attempt_ms);
+            break;
+        }
+        case WiFiState::BACKOFF: {
+            unsigned long waited = getTimeInState();
+            length += snprintf(buffer + length, size - length, ",\"reason\":\"%s\",\"retry_ms\":%lu",
+                               disconnectReasonText(wifi_disconnect_reason),
+                               waited < wifi_backoff_ms ? wifi_backoff_ms - waited : 0UL);
+            break;
+        }
+        default:
+            break;
+    }
+    snprintf(buffer + length, size - length, "}");
+}
+
+void ESP32ConfigPortal::publishWiFiState() {
+    if (!eventsWatched()) {
+        return;
+    }
+    char data[PORTAL_EVENT_SIZE];
+    formatWiFiState(data, sizeof(data));
+    events->send(data, "state", ++events_id);
+}
+
+// One candidate failed; the state event that follows says what happens next
+void ESP32ConfigPortal::publishWiFiFailure() {
+    if (!eventsWatched()) {
+        return;
+    }
+    char ssid[6 * 32 + 3];
+    char data[PORTAL_EVENT_SIZE];
+    quoteJson(wifi_target_ssid, ssid, sizeof(ssid));
+    uint8_t reason = wifi_disconnect_reason;
+    snprintf(data, sizeof(data), "{\"ssid\":%s,\"reason\":\"%s\",\"code\":%u}", ssid,
+             disconnectReasonText(reason), (unsigned)reason);
+    events->send(data, "failed", ++events_id);
+}
+
+// Starts a connection cycle over the stored profiles and returns immediately, see advanceWiFi()
 bool ESP32ConfigPortal::connectToWiFi() {
     wifi_timeout = false;
-    WiFi.mode(WIFI_STA);
     
-    if (config.wifi_ssid.length() == 0) {
-        Serial.println("No WiFi SSID configured");
+    // With the portal up the AP stays on, it goes only once the link is verified
+    WiFi.mode(portal_running ? WIFI_AP_STA : WIFI_STA);
+    if (wifi_state != WiFiState::CONNECTING) {
+        connect_cycle_started = millis();
+    }
+    
+    if (config.wifi_profile_count == 0) {
+        LOG_W("No WiFi SSID configured");
+        setWiFiState(WiFiState::IDLE);
         return false;
     }
     
-    Serial.println("Connecting to WiFi: " + config.wifi_ssid);
+    // A single profile needs no ranking, several are ranked from one cached scan
+    if (config.wifi_profile_count == 1 || scan_cache.isFresh()) {
+        rankProfiles();
+        connectCandidate(0);
+        return true;
+    }
     
-    WiFi.begin(config.wifi_ssid.c_str(), config.wifi_password.c_str());
+    LOG_I("Scanning for known networks...");
+    scan_cache.start();
+    setWiFiState(WiFiState::SCANNING);
+    return true;
+}
+
+// Reachable profiles rank by signal, priority and history; profiles missing
+// from the scan (possibly hidden) are still tried, after all reachable ones.
+int32_t ESP32ConfigPortal::profileScore(uint8_t index, uint32_t latestSuccess) const {
+    const WiFiProfile& profile = config.wifi_profiles[index];
+    const ScanResult* seen = scan_cache.isFresh() ? scan_cache.find(profile.ssid) : nullptr;
     
-    uint32_t t1 = millis();
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
-        Serial.print(".");
-        if (millis() - t1 > wifi_timeout_ms) {
-            Serial.println("\nTimeout connecting to " + config.wifi_ssid);
-            return false;
+    int32_t score = seen ? seen->rssi : -1000;
+    score += profile.priority * 5;
+    if (profile.last_success > 0) {
+        score += profile.last_success == latestSuccess ? 15 : 5;
+    }
+    return score;
+}
+
+void ESP32ConfigPortal::rankProfiles() {
+    uint32_t latest = 0;
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        latest = max(latest, config.wifi_profiles[i].last_success);
+    }
+    
+    int32_t scores[MAX_WIFI_PROFILES];
+    wifi_candidate_count = 0;
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        int32_t score = profileScore(i, latest);
+        uint8_t pos = wifi_candidate_count++;
+        while (pos > 0 && scores[pos - 1] < score) {
+            scores[pos] = scores[pos - 1];
+            wifi_candidates[pos] = wifi_candidates[pos - 1];
+            pos--;
         }
+        scores[pos] = score;
+        wifi_candidates[pos] = i;
     }
+}
+
+void ESP32ConfigPortal::connectCandidate(uint8_t position) {
+    wifi_candidate_index = position;
+    wifi_profile_index = wifi_candidates[position];
+    const WiFiProfile& profile = config.wifi_profiles[wifi_profile_index];
     
-    Serial.println("\nConnected to: " + config.wifi_ssid);
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
+    LOG_I("Connecting to WiFi: %s", profile.ssid);
     
-    if (onWiFiConnected) {
-        onWiFiConnected();
+    strlcpy(wifi_target_ssid, profile.ssid, sizeof(wifi_target_ssid));
+    wifi_got_ip = false;
+    wifi_lost = false;
+    wifi_disconnect_reason = 0;
+    WiFi.begin(profile.ssid, profile.password);
+    setWiFiState(WiFiState::CONNECTING);
+}
+
+// Marks the connected profile as the most recent success; only dirties the
+// configuration when a different profile than last time connected
+void ESP32ConfigPortal::recordProfileSuccess() {
+    uint32_t latest = 0;
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        latest = max(latest, config.wifi_profiles[i].last_success);
+    }
+    WiFiProfile& profile = config.wifi_profiles[wifi_profile_index];
+    if (latest == 0 || profile.last_success != latest) {
+        profile.last_success = latest + 1;
+        profile_history_dirty = true;
+        config_snapshot.publish(config);
+    }
+}
+
+// Wake-up path: connect with the link cached in RTC memory before NVS is read
+bool ESP32ConfigPortal::startFastConnect() {
+    FastConnectRecord record;
+    if (!fast_connect_enabled || !FastConnect::load(record)) {
+        return false;
     }
     
+    LOG_I("Fast reconnect to %s on channel %u", record.ssid, (unsigned)record.channel);
+    connect_cycle_started = millis();
+    WiFi.mode(WIFI_STA);
+    WiFi.config(IPAddress(record.ip), IPAddress(record.gateway), IPAddress(record.subnet),
+                IPAddress(record.dns1), IPAddress(record.dns2));
+    
+    strlcpy(wifi_target_ssid, record.ssid, sizeof(wifi_target_ssid));
+    wifi_got_ip = false;
+    wifi_lost = false;
+    wifi_disconnect_reason = 0;
+    fast_attempt = true;
+    fast_profile_hash = record.profile_hash;
+    wifi_profile_index = -1;
+    WiFi.begin(record.ssid, record.password, record.channel, record.bssid);
+    setWiFiState(WiFiState::CONNECTING);
     return true;
 }
 
+// Once the configuration is loaded, the cached link must belong to a stored profile
+bool ESP32ConfigPortal::adoptFastConnect() {
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        if (FastConnect::profileHash(config.wifi_profiles[i]) == fast_profile_hash) {
+            wifi_profile_index = i;
+            wifi_candidates[0] = i;
+            wifi_candidate_count = 1;
+            wifi_candidate_index = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ESP32ConfigPortal::abortFastConnect() {
+    fast_attempt = false;
+    FastConnect::invalidate();
+    WiFi.disconnect();
+    
+    // Back to DHCP for the full path
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+}
+
+// Read from the snapshot: config belongs to the setup task while it runs,
+// and so does the choice of profile
+const WiFiProfile* ESP32ConfigPortal::getActiveProfile() {
+    if (setup_task_running) {
+        return nullptr;
+    }
+    const ConfigData& current = getConfig();
+    if (wifi_profile_index < 0 || wifi_profile_index >= current.wifi_profile_count) {
+        return nullptr;
+    }
+    return &current.wifi_profiles[wifi_profile_index];
+}
+
+void ESP32ConfigPortal::advanceWiFi() {
+    switch (wifi_state) {
+        case WiFiState::SCANNING:
+            scan_cache.poll();
+            if (!scan_cache.isScanning() || getTimeInState() > WIFI_SCAN_TIMEOUT_MS) {
+                rankProfiles();
+                connectCandidate(0);
+            }
+            break;
+            
+        case WiFiState::CONNECTING:
+            if (wifi_got_ip.exchange(false)) {
+                wifi_backoff_ms = 0;
+                connect_timing.path = fast_attempt ? ConnectPath::FAST : ConnectPath::FULL;
+                connect_timing.attempt_ms = millis() - connect_cycle_started;
+                Metrics::count(MetricCounter::WIFI_CONNECTS);
+                Metrics::observe(MetricHistogram::WIFI_CONNECT, connect_timing.attempt_ms * 1000);
+                if (connect_timing.boot_to_ip_ms == 0) {
+                    connect_timing.boot_to_ip_ms = millis();
+                }
+                if (wifi_profile_index >= 0) {
+                    recordProfileSuccess();
+                    if (!fast_attempt && fast_connect_enabled) {
+                        FastConnect::save(config.wifi_profiles[wifi_profile_index]);
+                    }
+                }
+                fast_attempt = false;
+                
+                LOG_I("Connected to: %s via %s path in %lu ms (boot-to-IP %lu ms)", wifi_target_ssid,
+                      connect_timing.path == ConnectPath::FAST ? "fast" : "full",
+                      (unsigned long)connect_timing.attempt_ms, (unsigned long)connect_timing.boot_to_ip_ms);
+                IPAddress ip = WiFi.localIP();
+                LOG_I("IP address: " LOG_IP_FMT, LOG_IP_ARGS(ip));
+                setWiFiState(WiFiState::CONNECTED);
+            } else if (wifi_lost.exchange(false) || getTimeInState() > (fast_attempt ? FAST_CONNECT_TIMEOUT_MS : (unsigned long)wifi_timeout_ms)) {
+                wifi_timeout = getTimeInState() > (unsigned long)wifi_timeout_ms;
+                Metrics::count(MetricCounter::WIFI_CONNECT_FAILURES);
+                LOG_W("Failed to connect to %s (reason %u)", wifi_target_ssid, (unsigned)wifi_disconnect_reason.load());
+                WiFi.disconnect();
+                publishWiFiFailure();
+                
+                if (fast_attempt) {
+                    LOG_W("Fast reconnect failed, falling back to full connect");
+                    abortFastConnect();
+                    connectToWiFi();
+                    break;
+                }
+                
+                // Fall through the ranked list before backing off
+                if (wifi_candidate_index + 1 < wifi_candidate_count) {
+                    connectCandidate(wifi_candidate_index + 1);
+                    break;
+                }
+                wifi_backoff_ms = wifi_backoff_ms == 0 ? WIFI_BACKOFF_MIN_MS
+                                                       : min(wifi_backoff_ms * 2, (unsigned long)WIFI_BACKOFF_MAX_MS);
+                if (portal_running) {
+                    wifi_backoff_ms = max(wifi_backoff_ms, (unsigned long)WIFI_PORTAL_RETRY_MS);
+                    LOG_W("Failed to connect to WiFi network. Portal remains active.");
+                }
+                LOG_W("No known network reachable, retrying in %lus", wifi_backoff_ms / 1000);
+                setWiFiState(WiFiState::BACKOFF);
+            }
+            break;
+            
+        case WiFiState::CONNECTED:
+            if (wifi_lost.exchange(false)) {
+                LOG_W("WiFi disconnected, attempting reconnection...");
+                Metrics::count(MetricCounter::WIFI_RECONNECTS);
+                connectToWiFi();
+            }
+            break;
+            
+        case WiFiState::BACKOFF:
+            if (getTimeInState() >= wifi_backoff_ms) {
+                connectToWiFi();
+            }
+            break;
+            
+        case WiFiState::IDLE:
+        case WiFiState::PORTAL:
+            break;
+    }
+}
+
+// Milliseconds until the task driving the connection has something to do
+// that no event announces: timeouts, the end of a backoff, the success page
+// linger and firmware deadlines
+uint32_t ESP32ConfigPortal::connectionDeadline() const {
+    uint32_t next = PORTAL_NEVER;
+    switch (wifi_state) {
+        case WiFiState::SCANNING:
+            next = PortalScheduler::remaining(wifi_state_since, WIFI_SCAN_TIMEOUT_MS + 1);
+            break;
+        case WiFiState::CONNECTING:
+            next = PortalScheduler::remaining(wifi_state_since,
+                (fast_attempt ? FAST_CONNECT_TIMEOUT_MS : (unsigned long)wifi_timeout_ms) + 1);
+            break;
+        case WiFiState::BACKOFF:
+            next = PortalScheduler::remaining(wifi_state_since, wifi_backoff_ms);
+            break;
+        case WiFiState::CONNECTED:
+            if (portal_running && eventsWatched()) {
+                next = PortalScheduler::remaining(wifi_state_since, PORTAL_EVENTS_LINGER_MS);
+            }
+            break;
+        default:
+            break;
+    }
+    if (firmware_boot_pending) {
+        next = min(next, PortalScheduler::remaining(0, FIRMWARE_VERIFY_TIMEOUT_MS));
+    }
+    return min(next, firmware.restartIn());
+}
+
+// Power save while the portal is down: the CPU clock scales with load and
+// idle time goes to automatic light-sleep, the station to modem sleep. AP
+// clients get full speed. Light-sleep needs a core built with tickless
+// idle; without it only the clock scales.
+void ESP32ConfigPortal::applyPowerMode() {
+    int8_t saving = portal_running ? 0 : 1;
+    if (!power_save || power_saving == saving) {
+        return;
+    }
+    power_saving = saving;
+    
+    esp_pm_config_t pm = {};
+    pm.max_freq_mhz = PORTAL_CPU_MAX_MHZ;
+    pm.min_freq_mhz = saving ? PORTAL_CPU_MIN_MHZ : PORTAL_CPU_MAX_MHZ;
+    pm.light_sleep_enable = saving;
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err == ESP_ERR_NOT_SUPPORTED && pm.light_sleep_enable) {
+        pm.light_sleep_enable = false;
+        err = esp_pm_configure(&pm);
+    }
+    if (err != ESP_OK) {
+        LOG_W("Power management not available (error %d)", err);
+    } else {
+        LOG_I("CPU %d-%d MHz, light-sleep %s", pm.min_freq_mhz, pm.max_freq_mhz,
+              pm.light_sleep_enable ? "on" : "off");
+    }
+    // Modem sleep delays the portal's access point beacons and replies
+    WiFi.setSleep(saving ? PORTAL_WIFI_PS : WIFI_PS_NONE);
+}
+
 void ESP32ConfigPortal::startCaptivePortal() {
-    Serial.println("\nStarting Configuration Portal");
+    LOG_I("Starting Configuration Portal");
     
     WiFiSoftAPSetup();
+    IPAddress ip = WiFi.softAPIP();
+    snprintf(portal_url, sizeof(portal_url), "http://" LOG_IP_FMT "/", LOG_IP_ARGS(ip));
     setupServer();
     
-    if (!dnsServer.start(53, "*", WiFi.softAPIP())) {
-        Serial.println("Failed to start DNS server");
+    if (!dnsServer.start(ip)) {
+        LOG_E("Failed to start DNS server");
     }
     
     server.begin();
-    Serial.println("Configuration Portal Ready");
-    Serial.println("Connect to '" + ap_name + "' WiFi network and navigate to any website");
+    portal_running = true;
+    Metrics::set(MetricGauge::PORTAL_ACTIVE, 1);
+    applyPowerMode();
+    
+    // After a failed cycle the station keeps retrying underneath
+    if (wifi_state != WiFiState::BACKOFF) {
+        setWiFiState(WiFiState::PORTAL);
+    }
+    LOG_I("Configuration Portal Ready");
+    LOG_I("Connect to '%s' WiFi network and navigate to any website", ap_name.c_str());
+}
+
+void ESP32ConfigPortal::stopCaptivePortal() {
+    WiFi.softAPdisconnect(true);
+    server.end();
+    dnsServer.stop();
+    portal_running = false;
+    Metrics::set(MetricGauge::PORTAL_ACTIVE, 0);
+    applyPowerMode();
 }
 
 void ESP32ConfigPortal::loadConfiguration() {
-    preferences.begin(preferences_namespace.c_str(), false);
-    
-    is_setup_done = preferences.getBool("is_setup_done", false);
-    config.wifi_ssid = preferences.getString("wifi_ssid", "");
-    config.wifi_password = preferences.getString("wifi_password", "");
-    config.tg_token = preferences.getString("tg_token", "");
-    config.tg_active = preferences.getBool("tg_active", false);
-    config.host_url = preferences.getString("host_url", "");
-    config.host_active = preferences.getBool("host_active", false);
-    
-    preferences.end();
+    bool setup_done = false;
+    store.load(config, setup_done);
+    is_setup_done = setup_done;
+    config_snapshot.publish(config);
+}
+
+// Web handler side: hand a complete new configuration to the connection task
+void ESP32ConfigPortal::submitConfig(const ConfigData& next) {
+    if (config_inbox) {
+        xQueueOverwrite(config_inbox, &next);
+        scheduler.notify(PORTAL_WAKE_WEB);
+    }
+}
+
+// Connection task side: take over a submitted configuration, if any. History
+// recorded since the handler read its snapshot is kept.
+bool ESP32ConfigPortal::adoptSubmittedConfig() {
+    ConfigData next;
+    if (!config_inbox || xQueueReceive(config_inbox, &next, 0) != pdTRUE) {
+        return false;
+    }
+    for (uint8_t i = 0; i < next.wifi_profile_count; i++) {
+        const WiFiProfile* known = config.findWiFiProfile(next.wifi_profiles[i].ssid);
+        if (known) {
+            next.wifi_profiles[i].last_success = max(next.wifi_profiles[i].last_success, known->last_success);
+        }
+    }
+    config = next;
+    config_snapshot.publish(config);
+    if (setup_task_running) {
+        // handle() follows with the modules
+        scheduler.notify(PORTAL_WAKE_SETUP);
+    }
+    return true;
+}
+
+const ConfigData& ESP32ConfigPortal::getConfig() {
+    if (config_view_version != config_snapshot.version()) {
+        config_view_version = config_snapshot.read(config_view);
+    }
+    return config_view;
 }
 
 void ESP32ConfigPortal::saveConfiguration() {
-    preferences.begin(preferences_namespace.c_str(), false);
-    
-    preferences.putBool("is_setup_done", true);
-    preferences.putString("wifi_ssid", config.wifi_ssid);
-    preferences.putString("wifi_password", config.wifi_password);
-    preferences.putString("tg_token", config.tg_token);
-    preferences.putBool("tg_active", config.tg_active);
-    preferences.putString("host_url", config.host_url);
-    preferences.putBool("host_active", config.host_active);
-    
-    preferences.end();
-    Serial.println("Configuration saved to preferences");
+    uint32_t writes = store.writeCount();
+    if (!store.save(config, true)) {
+        LOG_E("Failed to save configuration");
+    } else if (store.writeCount() != writes) {
+        LOG_I("Configuration saved to preferences");
+    } else {
+        LOG_I("Configuration unchanged, nothing written");
+    }
 }
 
 void ESP32ConfigPortal::clearConfiguration() {
-    preferences.begin(preferences_namespace.c_str(), false);
-    preferences.clear();
-    preferences.end();
-    Serial.println("All configuration cleared");
+    store.clear();
+    FastConnect::invalidate();
+    if (setup_task_running) {
+        // The setup task owns the working copy, it adopts the empty one
+        submitConfig(ConfigData());
+    } else {
+        config = ConfigData();
+        config_snapshot.publish(config);
+    }
+    LOG_I("All configuration cleared");
     
     if (onConfigReset) {
         onConfigReset();
     }
 }
 
-bool ESP32ConfigPortal::checkResetButton() {
-    if (digitalRead(reset_button_pin) == LOW) {
-        delay(50); // Debounce
-        
-        if (digitalRead(reset_button_pin) == LOW) {
-            unsigned long pressStartTime = millis();
-            bool heldLongEnough = false;
-            int progressCount = 0;
-            
-            Serial.println("\nReset button detected - HOLD for " + String(reset_hold_time_ms/1000) + " seconds to reset...");
-            
-            while (digitalRead(reset_button_pin) == LOW) {
-                unsigned long holdDuration = millis() - pressStartTime;
-                
-                if (holdDuration >= (progressCount * 500)) {
-                    Serial.print(".");
-                    progressCount++;
-                }
-                
-                if (holdDuration >= reset_hold_time_ms) {
-                    heldLongEnough = true;
-                    break;
-                }
-                
-                delay(10);
-            }
-
-            if (heldLongEnough) {
-                Serial.println("\n\nResetting configuration...");
-                clearConfiguration();
-                
-                // Wait for button release
-                while (digitalRead(reset_button_pin) == LOW) {
-                    delay(10);
-                }
-                
-                Serial.println("Restarting device...");
-                delay(500);
-                ESP.restart();
-                return true;
-            } else {
-                Serial.println("\nButton released - reset cancelled");
-            }
-        }
+void ESP32ConfigPortal::handleButtonEvent(ButtonEvent event) {
+    if (onButtonEvent) {
+        onButtonEvent(event);
+    }
+    
+    if (event == ButtonEvent::FACTORY_RESET) {
+        LOG_W("Reset button held - resetting configuration...");
+        resetConfig();
     }
-    return false;
 }
 
+// Runs on the task calling handle(); skipped while the setup task owns the
+// connection state
 void ESP32ConfigPortal::printStatus() {
+    if (setup_task_running) {
+        return;
+    }
     if (millis() - lastStatusPrint > status_print_interval_ms) {
         lastStatusPrint = millis();
-        Serial.println("=== Device Status ===");
-        Serial.println("WiFi: " + WiFi.SSID() + " (" + WiFi.localIP().toString() + ")");
-        Serial.println("Telegram: " + String(config.tg_active ? "ON" : "OFF") + 
-                      (config.tg_active && config.tg_token.length() > 0 ? " | Token: " + config.tg_token.substring(0, 10) + "..." : 
-                        (config.tg_active ? " | Token: NOT SET" : "")));
-        Serial.println("Web Host: " + String(config.host_active ? "ON" : "OFF") + 
-                      (config.host_active && config.host_url.length() > 0 ? " | URL: " + config.host_url : 
-                        (config.host_active ? " | URL: NOT SET" : "")));
-        Serial.println("====================");
+        IPAddress ip = WiFi.localIP();
+        LOG_I("=== Device Status ===");
+        LOG_I("WiFi: %s (" LOG_IP_FMT ")", wifi_target_ssid, LOG_IP_ARGS(ip));
+        logConfigFields(getConfig());
+        LOG_I("====================");
     }
 }
 
 bool ESP32ConfigPortal::begin() {
+    return begin(PortalMode::BLOCKING) == PortalStatus::CONNECTED;
+}
+
+PortalStatus ESP32ConfigPortal::begin(PortalMode mode) {
     Serial.begin(115200);
-    Serial.println("Starting ESP32 Configuration Portal");
+    if (!Log::begin()) {
+        Serial.println("Failed to start log task");
+    }
+    LOG_I("Starting ESP32 Configuration Portal");
     
-    // Initialize button pin with internal pull-up
-    pinMode(reset_button_pin, INPUT_PULLUP);
+    // Written through /update and not yet confirmed
+    firmware_boot_pending = FirmwareUpdate::bootPending();
+    if (firmware_boot_pending) {
+        LOG_I("First boot of new firmware, keeping it once online");
+    }
     
-    // Check for reset button press with debounce
-    delay(50);
-    if (digitalRead(reset_button_pin) == LOW) {
-        delay(50);
+    // Connection handling is driven by events, retries are ours
+    if (!wifi_events_registered) {
+        wifi_event_id = WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) { onWiFiEvent(event, info); });
+        wifi_events_registered = true;
+    }
+    WiFi.setAutoReconnect(false);
+    
+    // The application task that drives handle()
+    Metrics::watchTask(xTaskGetCurrentTaskHandle());
+    
+    // Everything handle() reacts to wakes waitForWork()
+    if (!scheduler.begin()) {
+        LOG_E("Failed to create the wake event group");
+    }
+    modules.wakeOnRequest(scheduler.events(), PORTAL_WAKE_MODULE);
+    
+    // Button is interrupt driven from here on, handle() drains its events
+    button.wakeOnEvent(scheduler.events(), PORTAL_WAKE_BUTTON);
+    if (!button.begin(long_press_time_ms, reset_hold_time_ms)) {
+        LOG_E("Failed to start reset button handling");
+    }
+    
+    // Held at startup: clear saved configuration and go straight to the portal
+    if (button.isPressed()) {
+        delay(BUTTON_DEBOUNCE_MS);
         if (digitalRead(reset_button_pin) == LOW) {
-            Serial.println("Reset button pressed at startup - clearing saved configuration");
+            LOG_W("Reset button pressed at startup - clearing saved configuration");
             clearConfiguration();
-            
-            // Wait for button release
-            while (digitalRead(reset_button_pin) == LOW) {
-                delay(10);
-            }
-            
-            Serial.println("Restarting device...");
-            delay(500);
-            ESP.restart();
         }
     }
 
+    if (!setup_events) {
+        setup_events = xEventGroupCreate();
+    }
+    if (!config_inbox) {
+        config_inbox = xQueueCreate(1, sizeof(ConfigData));
+    }
+    xEventGroupClearBits(setup_events, SETUP_DONE_BIT);
+    
+    // Woken from deep sleep or reset: start on the cached link while NVS loads
+    bool fast_started = startFastConnect();
+    
     // Load saved configuration
     loadConfiguration();
     
+    if (fast_started && !(is_setup_done && adoptFastConnect())) {
+        LOG_I("Cached link does not match the saved configuration");
+        abortFastConnect();
+        fast_started = false;
+    }
+    
     if (is_setup_done) {
-        Serial.println("Using saved configuration");
-        if (connectToWiFi()) {
-            is_setup_done = true;
-            return true;
-        } else {
-            Serial.println("Failed to connect with saved settings, starting config portal");
+        LOG_I("Using saved configuration");
+        if (!fast_started && !connectToWiFi()) {
             is_setup_done = false;
             startCaptivePortal();
         }
     } else {
         startCaptivePortal();
     }
+    applyPowerMode();
+    
+    if (mode == PortalMode::ASYNC) {
+        startSetupTask();
+        return getPortalStatus();
+    }
+
+    // Main configuration loop, asleep between events and deadlines
+    while (!setupStep()) {
+        scheduler.wait(PORTAL_WAKE_WIFI | PORTAL_WAKE_WEB, connectionDeadline(), true);
+    }
+
+    LOG_I("Device setup completed successfully!");
+    printStatus();
+    return PortalStatus::CONNECTED;
+}
 
-    // Main configuration loop
-    while (!is_setup_done) {
-        dnsServer.processNextRequest();
+// One pass of the setup loop, shared by the blocking loop and the setup task.
+// Returns true once the device is configured and connected.
+bool ESP32ConfigPortal::setupStep() {
+    if (portal_requested.exchange(false)) {
+        enterConfigMode();
+    }
+    if (portal_running) {
+        scan_cache.poll();
+    }
+    
+    if (adoptSubmittedConfig()) {
+        config_save_pending = true;
         
-        if (config_received) {
-            config_received = false;
-            
-            // Trigger callback if set
-            if (onConfigReceived) {
-                onConfigReceived(config);
-            }
-            
-            // Try to connect to WiFi
-            if (connectToWiFi()) {
-                is_setup_done = true;
-                saveConfiguration();
-                
-                // Cleanup captive portal
-                WiFi.softAPdisconnect(true);
-                server.end();
-                dnsServer.stop();
-                
-                Serial.println("Setup complete! WiFi connected and configuration saved.");
-                return true;
-            } else {
-                Serial.println("Failed to connect to WiFi network. Portal remains active.");
-                wifi_timeout = true;
-                startCaptivePortal();
+        // Trigger callback if set
+        if (onConfigReceived) {
+            onConfigReceived(config);
+        }
+        
+        // Try to connect to WiFi
+        connectToWiFi();
+    }
+    
+    advanceWiFi();
+    
+    // Brought up once; retries and new configurations are applied under it
+    if (!portal_running && (wifi_state == WiFiState::BACKOFF || wifi_state == WiFiState::IDLE)) {
+        LOG_W("Failed to connect with saved settings, starting config portal");
+        is_setup_done = false;
+        startCaptivePortal();
+    }
+    checkFirmware(false);
+    
+    if (wifi_state == WiFiState::CONNECTED) {
+        is_setup_done = true;
+        if (config_save_pending || profile_history_dirty) {
+            config_save_pending = false;
+            profile_history_dirty = false;
+            saveConfiguration();
+        }
+        
+        // Cleanup captive portal, once subscribed success pages had the result
+        if (portal_running) {
+            if (eventsWatched() && getTimeInState() < PORTAL_EVENTS_LINGER_MS) {
+                return false;
             }
+            stopCaptivePortal();
         }
+        serveConnected();
         
-        delay(10);
+        LOG_I("Setup complete! WiFi connected and configuration saved.");
+        xEventGroupSetBits(setup_events, SETUP_DONE_BIT);
+        return true;
     }
 
-    Serial.println("Device setup completed successfully!");
-    printStatus();
-    return true;
+    return false;
+}
+
+void ESP32ConfigPortal::startSetupTask() {
+    if (setup_task_running) {
+        return;
+    }
+    setup_task_running = true;
+    if (xTaskCreatePinnedToCore(setupTaskMain, "config_portal", PORTAL_TASK_STACK, this,
+                                PORTAL_TASK_PRIORITY, &setup_task, PORTAL_TASK_CORE) != pdPASS) {
+        LOG_E("Failed to start portal task");
+        setup_task_running = false;
+        return;
+    }
+    Metrics::watchTask(setup_task);
+}
+
+void ESP32ConfigPortal::setupTaskMain(void* arg) {
+    ESP32ConfigPortal* self = static_cast<ESP32ConfigPortal*>(arg);
+    while (!self->setupStep()) {
+        self->scheduler.wait(PORTAL_WAKE_WIFI | PORTAL_WAKE_WEB, self->connectionDeadline(), false);
+    }
+    Metrics::unwatchTask(xTaskGetCurrentTaskHandle());
+    self->setup_task = nullptr;
+    self->setup_task_running = false;
+    self->scheduler.notify(PORTAL_WAKE_SETUP);
+    vTaskDelete(nullptr);
+}
+
+bool ESP32ConfigPortal::waitForSetup(uint32_t timeoutMs) {
+    if (!setup_events) {
+        return false;
+    }
+    TickType_t ticks = timeoutMs == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    return xEventGroupWaitBits(setup_events, SETUP_DONE_BIT, pdFALSE, pdTRUE, ticks) & SETUP_DONE_BIT;
+}
+
+PortalStatus ESP32ConfigPortal::getPortalStatus() const {
+    if (portal_running) {
+        return PortalStatus::PORTAL_ACTIVE;
+    }
+    return wifi_state == WiFiState::CONNECTED && is_setup_done ? PortalStatus::CONNECTED : PortalStatus::CONNECTING;
 }
 
 void ESP32ConfigPortal::handle() {
-    // Check WiFi connection status
-    if (WiFi.status() != WL_CONNECTED && is_setup_done) {
-        Serial.println("WiFi disconnected, attempting reconnection...");
-        
-        if (onWiFiDisconnected) {
-            onWiFiDisconnected();
+    // Advance the connection state machine, never blocks.
+    // While the setup task runs it owns the radio.
+    if (!setup_task_running) {
+        // Requested just as the setup task finished
+        if (portal_requested.exchange(false)) {
+            forceConfigMode();
         }
+        advanceWiFi();
         
-        if (!connectToWiFi()) {
-            Serial.println("Failed to reconnect, restarting device...");
-            delay(5000);
-            ESP.restart();
+        // A different profile connected than last time: persist the history
+        if (profile_history_dirty && is_setup_done) {
+            profile_history_dirty = false;
+            saveConfiguration();
+        }
+        checkFirmware(true);
+    }
+
+    // Modules follow the config: disabled ones are deleted at once, enabled
+    // ones start once setup is done and run while online
+    if (modules_version != config_snapshot.version()) {
+        modules.update(getConfig(), is_setup_done);
+        if (is_setup_done) {
+            modules_version = config_view_version;
         }
     }
+    if (is_setup_done && wifi_state == WiFiState::CONNECTED) {
+        modules.run();
+    }
 
-    // Check reset button
-    checkResetButton();
+    // Drain button events queued by the interrupt/timer engine
+    ButtonEvent event;
+    while (button.poll(event)) {
+        handleButtonEvent(event);
+    }
     
     // Print status periodically
     if (is_setup_done) {
@@ -399,13 +1495,79 @@ void ESP32ConfigPortal::handle() {
     }
 }
 
+void ESP32ConfigPortal::waitForWork(uint32_t maxMs) {
+    EventBits_t bits = PORTAL_WAKE_BUTTON | PORTAL_WAKE_MODULE | PORTAL_WAKE_SETUP;
+    uint32_t next = maxMs;
+    // While the setup task runs its wakes are its own
+    if (!setup_task_running) {
+        bits |= PORTAL_WAKE_WIFI | PORTAL_WAKE_WEB;
+        next = min(next, connectionDeadline());
+        if (is_setup_done) {
+            next = min(next, PortalScheduler::remaining(lastStatusPrint, status_print_interval_ms + 1));
+        }
+    }
+#if PORTAL_LOOP_STATS_MS > 0
+    if (scheduler.loopStats().window_ms >= PORTAL_LOOP_STATS_MS) {
+        scheduler.logLoopStats();
+        scheduler.resetLoopStats();
+    }
+    next = min(next, (uint32_t)PORTAL_LOOP_STATS_MS - scheduler.loopStats().window_ms);
+#endif
+    scheduler.wait(bits, next, true);
+}
+
+// First boot of a new image: keep it once it has started, i.e. is online,
+// serves the portal or runs the application loop. A saved network that is
+// out of reach says nothing about the image. Go back to the previous one if
+// it never gets that far. Restarts into a freshly written one.
+// Runs where the connection is driven; inLoop from handle().
+void ESP32ConfigPortal::checkFirmware(bool inLoop) {
+    if (firmware_boot_pending) {
+        bool started = inLoop || wifi_state == WiFiState::CONNECTED || portal_running;
+        if (started) {
+            firmware_boot_pending = !FirmwareUpdate::confirmBoot();
+        } else if (millis() >= FIRMWARE_VERIFY_TIMEOUT_MS) {
+            firmware_boot_pending = false;
+            FirmwareUpdate::rollBack();
+        }
+    }
+    if (firmware.restartDue()) {
+        LOG_I("Restarting into the new firmware");
+        Log::flush();
+        ESP.restart();
+    }
+}
+
+// Applied live: the portal comes up (or stays up) without a restart
 void ESP32ConfigPortal::resetConfig() {
     clearConfiguration();
-    ESP.restart();
+    forceConfigMode();
 }
 
 void ESP32ConfigPortal::forceConfigMode() {
+    if (setup_task_running) {
+        // The setup task owns the radio and may be mid-connect without the
+        // portal: it brings the portal up on its next pass
+        portal_requested = true;
+        scheduler.notify(PORTAL_WAKE_WEB);
+        return;
+    }
+    enterConfigMode();
+    
+    // Serve the portal in the background so handle() keeps returning
+    startSetupTask();
+}
+
+// Runs where the connection is driven
+void ESP32ConfigPortal::enterConfigMode() {
+    LOG_I("Entering config mode");
     is_setup_done = false;
+    if (setup_events) {
+        xEventGroupClearBits(setup_events, SETUP_DONE_BIT);
+    }
+    if (portal_running) {
+        return;
+    }
     WiFi.disconnect(true);
     startCaptivePortal();
 }
\ No newline at end of file
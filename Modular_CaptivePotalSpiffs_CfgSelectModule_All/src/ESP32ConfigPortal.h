@@ -1,24 +1,126 @@
 #ifndef ESP32_CONFIG_PORTAL_H
 #define ESP32_CONFIG_PORTAL_H
 
-#include <DNSServer.h>
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include "ESPAsyncWebServer.h"
 #include <Preferences.h>
 #include <functional>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include "PortalAsset.h"
+#include "CaptiveProbes.h"
+#include "CaptiveDns.h"
+#include "PortalAdmission.h"
+#include "PortalScheduler.h"
+#include "PortalButton.h"
+#include "ConfigData.h"
+#include "ConfigStore.h"
+#include "ConfigSnapshot.h"
+#include "ModuleRegistry.h"
+#include "WiFiScanCache.h"
+#include "FastConnect.h"
+#include "FirmwareUpdate.h"
+#include "JsonPool.h"
+#include "Metrics.h"
+#include "Log.h"
 
-// Configuration structure to hold all settings
-struct ConfigData {
-    String wifi_ssid;
-    String wifi_password;
-    String tg_token;
-    bool tg_active;
-    String host_url;
-    bool host_active;
-    
-    // Constructor with defaults
-    ConfigData() : tg_active(false), host_active(false) {}
+// Reconnect backoff bounds, override with build flags if needed
+#ifndef WIFI_BACKOFF_MIN_MS
+#define WIFI_BACKOFF_MIN_MS 1000
+#endif
+#ifndef WIFI_BACKOFF_MAX_MS
+#define WIFI_BACKOFF_MAX_MS 60000
+#endif
+#ifndef WIFI_SCAN_TIMEOUT_MS
+#define WIFI_SCAN_TIMEOUT_MS 15000
+#endif
+
+// Shortest retry interval while the portal is up. Station attempts scan
+// across channels and disturb the AP, so portal clients see them rarely.
+#ifndef WIFI_PORTAL_RETRY_MS
+#define WIFI_PORTAL_RETRY_MS 30000
+#endif
+
+// Largest accepted REST API request body
+#ifndef API_BODY_MAX_SIZE
+#define API_BODY_MAX_SIZE 2048
+#endif
+
+// Once connected, the AP stays up this long while success pages follow
+// /events, so they receive the result before their network goes away
+#ifndef PORTAL_EVENTS_LINGER_MS
+#define PORTAL_EVENTS_LINGER_MS 3000
+#endif
+
+// Keep serving /metrics and /log once connected and the portal is down
+#ifndef METRICS_SERVE_CONNECTED
+#define METRICS_SERVE_CONNECTED 1
+#endif
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+// Power save (setPowerSave): CPU clock range and station sleep while the
+// portal is down. WiFi keeps the APB at 80 MHz whenever it is active.
+#ifndef PORTAL_CPU_MAX_MHZ
+#define PORTAL_CPU_MAX_MHZ 240
+#endif
+#ifndef PORTAL_CPU_MIN_MHZ
+#define PORTAL_CPU_MIN_MHZ 80
+#endif
+// WIFI_PS_MIN_MODEM wakes the radio for every DTIM beacon, WIFI_PS_MAX_MODEM
+// once per listen interval: less power, more latency
+#ifndef PORTAL_WIFI_PS
+#define PORTAL_WIFI_PS WIFI_PS_MIN_MODEM
+#endif
+
+// Background setup task used by PortalMode::ASYNC and forceConfigMode()
+#ifndef PORTAL_TASK_STACK
+#define PORTAL_TASK_STACK 4096
+#endif
+#ifndef PORTAL_TASK_PRIORITY
+#define PORTAL_TASK_PRIORITY 1
+#endif
+#ifndef PORTAL_TASK_CORE
+#define PORTAL_TASK_CORE 0
+#endif
+
+// Station connection states, advanced by handle()
+enum class WiFiState : uint8_t {
+    IDLE,        // Nothing to connect to
+    SCANNING,    // Scanning to rank the stored profiles
+    CONNECTING,  // WiFi.begin() issued, waiting for an IP
+    CONNECTED,   // Station has an IP
+    BACKOFF,     // Last attempt failed, waiting before the next one
+    PORTAL       // Captive portal is up, no station attempt pending
+};
+
+// How begin() runs the portal
+enum class PortalMode : uint8_t {
+    BLOCKING,  // begin() returns once configured and connected
+    ASYNC      // begin() returns at once, setup runs in a pinned task
+};
+
+// Setup progress as reported by begin(PortalMode) and getPortalStatus()
+enum class PortalStatus : uint8_t {
+    CONNECTED,      // Configured and connected
+    CONNECTING,     // Connecting with saved settings
+    PORTAL_ACTIVE   // Waiting for configuration through the portal
+};
+
+// How the last connection was made
+enum class ConnectPath : uint8_t {
+    NONE,
+    FAST,  // Cached BSSID, channel and lease from RTC memory
+    FULL   // Scan/ranking, WiFi.begin() and DHCP
+};
+
+struct ConnectTiming {
+    ConnectPath path;
+    uint32_t boot_to_ip_ms;  // millis() at the first IP since boot, 0 until then
+    uint32_t attempt_ms;     // Duration of the last connection cycle
 };
 
 // Callback function types
@@ -28,15 +130,27 @@ typedef std::function<void()> StatusCallback;
 class ESP32ConfigPortal {
 private:
     // Core components
-    Preferences preferences;
-    DNSServer dnsServer;
+    PortalScheduler scheduler;  // Outlives the button and modules that wake it
+    ConfigStore store;
+    CaptiveDns dnsServer;
+    PortalAdmission admission;  // Outlives the server and its requests
     AsyncWebServer server;
+    PortalButton button;
     
-    // Configuration data
+    // Configuration data. config is the working copy, owned by whichever
+    // task runs the connection (setup task or handle()); everyone else reads
+    // the published snapshot. Web handlers hand new configs over through
+    // config_inbox instead of writing config.
     ConfigData config;
-    bool is_setup_done;
-    bool config_received;
+    ConfigSnapshot config_snapshot;
+    QueueHandle_t config_inbox;
+    ConfigData config_view;
+    uint32_t config_view_version;
+    std::atomic<bool> is_setup_done;
+    bool config_save_pending;
+    bool portal_running;
     bool wifi_timeout;
+    char portal_url[24];  // Redirect target, "http://<AP IP>/"
     
     // Settings
     int reset_button_pin;
@@ -44,6 +158,7 @@ private:
     String preferences_namespace;
     int wifi_timeout_ms;
     int reset_hold_time_ms;
+    int long_press_time_ms;
     int status_print_interval_ms;
     
     // Callbacks
@@ -51,20 +166,119 @@ private:
     StatusCallback onWiFiConnected;
     StatusCallback onWiFiDisconnected;
     StatusCallback onConfigReset;
+    ButtonCallback onButtonEvent;
     
     // Internal state
     unsigned long lastStatusPrint;
     
+    // WiFi state machine, fed by WiFi.onEvent from the event task
+    WiFiState wifi_state;
+    unsigned long wifi_state_since;
+    unsigned long wifi_backoff_ms;
+    std::atomic<bool> wifi_got_ip;
+    std::atomic<bool> wifi_lost;
+    std::atomic<uint8_t> wifi_disconnect_reason;
+    bool wifi_events_registered;
+    wifi_event_id_t wifi_event_id;
+    char wifi_target_ssid[33];
+    
+    // Profiles to try this cycle, best first
+    WiFiScanCache scan_cache;
+    uint8_t wifi_candidates[MAX_WIFI_PROFILES];
+    uint8_t wifi_candidate_count;
+    uint8_t wifi_candidate_index;
+    int8_t wifi_profile_index;
+    bool profile_history_dirty;
+    
+    // RTC fast reconnect
+    bool fast_connect_enabled;
+    bool fast_attempt;
+    uint32_t fast_profile_hash;
+    unsigned long connect_cycle_started;
+    ConnectTiming connect_timing;
+    
+    // Power save while the portal is down
+    bool power_save;
+    int8_t power_saving;  // Applied: 1 saving, 0 full speed, -1 not yet
+    
+    // Integrations, constructed only while enabled
+    ModuleRegistry modules;
+    uint32_t modules_version;
+    
+    // REST API documents, only used from the web server task
+    JsonPool api_pool;
+    
+    // Values of the /metrics scrape being sent
+    MetricsSnapshot metrics_snapshot;
+    std::atomic<bool> metrics_busy;
+    
+    // Connection progress pushed to success pages over /events. Owned by
+    // server, which deletes it on reset(); set again by setupServer().
+    AsyncEventSource* events;
+    uint32_t events_id;
+    
+    // OTA upload through /update, and the first boot of a new image
+    FirmwareUpdate firmware;
+    bool firmware_boot_pending;
+    
+    // Setup completion, signalled for both portal modes
+    EventGroupHandle_t setup_events;
+    TaskHandle_t setup_task;
+    std::atomic<bool> setup_task_running;
+    std::atomic<bool> portal_requested;  // forceConfigMode() while the setup task runs
+    
     // Private methods
     void setupServer();
     void WiFiSoftAPSetup();
     bool connectToWiFi();
+    void advanceWiFi();
+    void rankProfiles();
+    int32_t profileScore(uint8_t index, uint32_t latestSuccess) const;
+    void connectCandidate(uint8_t position);
+    void recordProfileSuccess();
+    bool startFastConnect();
+    bool adoptFastConnect();
+    void abortFastConnect();
+    void sendProfiles(AsyncWebServerRequest *request);
+    void sendScan(AsyncWebServerRequest *request);
+    void sendFormSchema(AsyncWebServerRequest *request);
+    void sendApiConfig(AsyncWebServerRequest *request);
+    void sendApiStatus(AsyncWebServerRequest *request);
+    void receiveApiBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    void handleApiConfigPut(AsyncWebServerRequest *request);
+    void sendApiError(AsyncWebServerRequest *request, int code, const String& message);
+    void sendMetrics(AsyncWebServerRequest *request);
+    void sendLog(AsyncWebServerRequest *request);
+    void addDiagnosticRoutes();
+    bool updateAllowed(AsyncWebServerRequest *request);
+    void receiveFirmware(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final);
+    void handleFirmwareUpload(AsyncWebServerRequest *request);
+    void addUpdateRoutes();
+    void checkFirmware(bool inLoop);
+    void serveConnected();
+    void setWiFiState(WiFiState next);
+    uint32_t connectionDeadline() const;
+    void applyPowerMode();
+    bool eventsWatched() const;
+    void formatWiFiState(char* buffer, size_t size) const;
+    void publishWiFiState();
+    void publishWiFiFailure();
+    void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info);
     void startCaptivePortal();
+    void stopCaptivePortal();
+    bool setupStep();
+    void startSetupTask();
+    void enterConfigMode();
+    static void setupTaskMain(void* arg);
+    void submitConfig(const ConfigData& next);
+    bool adoptSubmittedConfig();
     void loadConfiguration();
     void saveConfiguration();
     void clearConfiguration();
-    bool checkResetButton();
+    void handleButtonEvent(ButtonEvent event);
     void printStatus();
+    void sendAsset(AsyncWebServerRequest *request, const PortalAsset& asset);
+    void sendCaptiveAnswer(AsyncWebServerRequest *request);
     
 public:
     // Constructor
@@ -72,36 +286,101 @@ public:
                      const String& apName = "ESP32-Config",
                      const String& prefsNamespace = "esp32_config");
     
+    // Normally a global; a scoped instance (tests, benchmarks) releases what
+    // begin() created. Not while the setup task is still running.
+    ~ESP32ConfigPortal();
+    
     // Configuration methods
     void setWiFiTimeout(int timeoutMs) { wifi_timeout_ms = timeoutMs; }
     void setResetHoldTime(int holdTimeMs) { reset_hold_time_ms = holdTimeMs; }
+    void setLongPressTime(int pressTimeMs) { long_press_time_ms = pressTimeMs; }
     void setStatusPrintInterval(int intervalMs) { status_print_interval_ms = intervalMs; }
+    void setFastReconnect(bool enabled) { fast_connect_enabled = enabled; }
+    // Before begin(): automatic light-sleep, CPU frequency scaling and modem
+    // sleep while the portal is down; see PORTAL_CPU_*_MHZ and PORTAL_WIFI_PS
+    void setPowerSave(bool enabled) { power_save = enabled; }
     
     // Callback setters
     void onConfig(ConfigCallback callback) { onConfigReceived = callback; }
     void onWiFiConnect(StatusCallback callback) { onWiFiConnected = callback; }
     void onWiFiDisconnect(StatusCallback callback) { onWiFiDisconnected = callback; }
     void onReset(StatusCallback callback) { onConfigReset = callback; }
+    void onButton(ButtonCallback callback) { onButtonEvent = callback; }
+    void onConfigMigrate(ConfigMigrationCallback callback) { store.onMigrate(callback); }
+    // Called from the web server task while an upload is written
+    void onUpdateProgress(FirmwareProgressCallback callback) { firmware.onProgress(callback); }
+    
+    // Integrations, registered before begin(). A module is constructed once
+    // its section's "active" flag is set and deleted when it is cleared;
+    // the portal form only shows sections with a module registered (all of
+    // them while none is).
+    bool addModule(ConfigSection section, PortalModuleFactory create) { return modules.add(section, create); }
+    template <typename T>
+    bool addModule(ConfigSection section) { return modules.add(section, createPortalModule<T>); }
+    uint8_t runningModules() const { return modules.running(); }
     
     // Main methods
     bool begin();
+    PortalStatus begin(PortalMode mode);
     void handle();
     
+    // Sleeps until handle() has work: a WiFi event, a button press, a module
+    // or web request, or the next deadline (connection timeouts, status
+    // print). maxMs bounds it for the application's own deadlines. Returns
+    // at once when something happened since the last call.
+    void waitForWork(uint32_t maxMs = PORTAL_NEVER);
+    
+    // Wakeups and idle time of the task calling waitForWork() since the last
+    // reset; logged every PORTAL_LOOP_STATS_MS when that is set
+    const LoopStats& getLoopStats() { return scheduler.loopStats(); }
+    void resetLoopStats() { scheduler.resetLoopStats(); }
+    
+    // Wait for setup to complete (configured and connected) instead of polling
+    bool waitForSetup(uint32_t timeoutMs = portMAX_DELAY);
+    PortalStatus getPortalStatus() const;
+    
     // Utility methods
     bool isConfigured() const { return is_setup_done; }
-    bool isWiFiConnected() const { return WiFi.status() == WL_CONNECTED; }
-    ConfigData getConfig() const { return config; }
+    bool isWiFiConnected() const { return wifi_state == WiFiState::CONNECTED; }
+    WiFiState getWiFiState() const { return wifi_state; }
+    unsigned long getTimeInState() const { return millis() - wifi_state_since; }
+    static const char* wifiStateName(WiFiState state);
+    // Profile in use, nullptr while the setup task is connecting. Same task
+    // and lifetime rules as getConfig().
+    const WiFiProfile* getActiveProfile();
+    const ConnectTiming& getConnectTiming() const { return connect_timing; }
+    static void invalidateFastConnect() { FastConnect::invalidate(); }
+    FirmwareState getUpdateState() const { return firmware.getState(); }
+    
+    // Configuration access. getConfig() is for the task calling handle(): the
+    // reference stays valid and is refreshed (one copy) only after a change.
+    // withConfig() runs a callback on the current config from any task.
+    const ConfigData& getConfig();
+    uint32_t configVersion() const { return config_snapshot.version(); }
+    template <typename Fn>
+    void withConfig(Fn fn) const { config_snapshot.visit(fn); }
+    
     void resetConfig();
     void forceConfigMode();
     
-    // Static HTML content (can be customized)
-    static String getDefaultHTML();
-    static String getSuccessHTML();
+    // Built-in pages, gzipped into flash by scripts/embed_web_assets.py
+    static const PortalAsset& getDefaultPage();
+    static const PortalAsset& getSuccessPage();
+    
+    // Custom pages. Prefer the PortalAsset overload with an asset generated
+    // from web/; the String overload keeps one copy and serves it uncompressed.
+    void setCustomHTML(const PortalAsset& page, const PortalAsset* successPage = nullptr);
     void setCustomHTML(const String& html, const String& successHtml = "");
     
 private:
     String custom_html;
     String custom_success_html;
+    String custom_html_etag;
+    String custom_success_etag;
+    PortalAsset custom_page;
+    PortalAsset custom_success_page;
+    const PortalAsset* page_asset;
+    const PortalAsset* success_asset;
 };
 
 #endif // ESP32_CONFIG_PORTAL_H
\ No newline at end of file
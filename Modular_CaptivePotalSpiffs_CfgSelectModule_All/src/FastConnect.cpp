@@ -0,0 +1,59 @@
+#include "FastConnect.h"
+#include <WiFi.h>
+#include "ConfigStore.h"
+
+static const uint32_t RECORD_MAGIC = 0x46434331; // "FCC1"
+
+RTC_DATA_ATTR static FastConnectRecord rtc_record;
+
+static uint32_t recordCrc(const FastConnectRecord& record) {
+    return ConfigStore::crc32((const uint8_t*)&record, offsetof(FastConnectRecord, crc));
+}
+
+namespace FastConnect {
+
+uint32_t profileHash(const WiFiProfile& profile) {
+    uint8_t buf[33 + 65];
+    size_t ssid_len = strlen(profile.ssid);
+    size_t pass_len = strlen(profile.password);
+    memcpy(buf, profile.ssid, ssid_len);
+    buf[ssid_len] = 0;
+    memcpy(buf + ssid_len + 1, profile.password, pass_len);
+    return ConfigStore::crc32(buf, ssid_len + 1 + pass_len);
+}
+
+bool load(FastConnectRecord& record) {
+    if (rtc_record.magic != RECORD_MAGIC || rtc_record.crc != recordCrc(rtc_record)) {
+        return false;
+    }
+    memcpy(&record, &rtc_record, sizeof(record));
+    return true;
+}
+
+void save(const WiFiProfile& profile) {
+    FastConnectRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = RECORD_MAGIC;
+    record.profile_hash = profileHash(profile);
+    strlcpy(record.ssid, profile.ssid, sizeof(record.ssid));
+    strlcpy(record.password, profile.password, sizeof(record.password));
+    uint8_t* bssid = WiFi.BSSID();
+    if (!bssid) {
+        return;
+    }
+    memcpy(record.bssid, bssid, sizeof(record.bssid));
+    record.channel = WiFi.channel();
+    record.ip = WiFi.localIP();
+    record.gateway = WiFi.gatewayIP();
+    record.subnet = WiFi.subnetMask();
+    record.dns1 = WiFi.dnsIP(0);
+    record.dns2 = WiFi.dnsIP(1);
+    record.crc = recordCrc(record);
+    memcpy(&rtc_record, &record, sizeof(record)); // Padding included, it is covered by the CRC
+}
+
+void invalidate() {
+    rtc_record.magic = 0;
+}
+
+} // namespace FastConnect
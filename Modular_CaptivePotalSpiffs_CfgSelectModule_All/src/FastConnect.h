@@ -0,0 +1,42 @@
+#ifndef FAST_CONNECT_H
+#define FAST_CONNECT_H
+
+#include <Arduino.h>
+#include "ConfigData.h"
+
+#ifndef FAST_CONNECT_TIMEOUT_MS
+#define FAST_CONNECT_TIMEOUT_MS 3000
+#endif
+
+// Last good link, kept in RTC slow memory so it survives deep sleep and
+// software resets. Lets a wake-up connect straight to a known BSSID and
+// channel with the previous lease, skipping the scan and DHCP.
+struct FastConnectRecord {
+    uint32_t magic;
+    uint32_t profile_hash;   // FastConnect::profileHash() of the profile used
+    char ssid[33];
+    char password[65];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+    uint32_t crc;
+};
+
+namespace FastConnect {
+    // Identifies a profile's credentials without storing them twice in NVS
+    uint32_t profileHash(const WiFiProfile& profile);
+
+    // Copies the record out if it is intact
+    bool load(FastConnectRecord& record);
+
+    // Captures the current station link for the given profile
+    void save(const WiFiProfile& profile);
+
+    void invalidate();
+}
+
+#endif // FAST_CONNECT_H
@@ -0,0 +1,206 @@
+#include "FirmwareUpdate.h"
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include "Metrics.h"
+#include "Log.h"
+
+// The core confirms every image at startup unless this says otherwise; the
+// portal does it once the new image has proven it can get back online.
+// Needs a bootloader built with CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE.
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+FirmwareUpdate::FirmwareUpdate()
+    : check_sha(false), owner(nullptr), state(FirmwareState::IDLE), written(0), total(0), reported_step(0),
+      started_ms(0), done_ms(0) {
+    error_text[0] = '\0';
+    mbedtls_sha256_init(&sha);
+}
+
+FirmwareUpdate::~FirmwareUpdate() {
+    if (state == FirmwareState::RECEIVING) {
+        Update.abort();
+    }
+    mbedtls_sha256_free(&sha);
+}
+
+const char* FirmwareUpdate::stateName(FirmwareState state) {
+    switch (state) {
+        case FirmwareState::IDLE:      return "idle";
+        case FirmwareState::RECEIVING: return "receiving";
+        case FirmwareState::DONE:      return "done";
+        case FirmwareState::FAILED:    return "failed";
+    }
+    return "unknown";
+}
+
+void FirmwareUpdate::fail(const char* reason) {
+    strlcpy(error_text, reason, sizeof(error_text));
+    state = FirmwareState::FAILED;
+    mbedtls_sha256_free(&sha);
+    Metrics::count(MetricCounter::FIRMWARE_FAILURES);
+    LOG_W("Firmware update failed after %u bytes: %s", (unsigned)written.load(), reason);
+}
+
+bool FirmwareUpdate::begin(const void* request, size_t expectedSize, const char* sha256Hex) {
+    if (state == FirmwareState::DONE) {
+        return false;  // Restarting into the new image
+    }
+    const void* none = nullptr;
+    if (!owner.compare_exchange_strong(none, request)) {
+        return false;
+    }
+
+    written = 0;
+    total = expectedSize;
+    reported_step = 0;
+    error_text[0] = '\0';
+    check_sha = sha256Hex && *sha256Hex;
+    state = FirmwareState::RECEIVING;
+    if (check_sha) {
+        if (strlen(sha256Hex) != 2 * sizeof(expected_sha)) {
+            fail("SHA-256 must be 64 hex digits");
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(expected_sha); i++) {
+            int high = hexDigit(sha256Hex[2 * i]);
+            int low = hexDigit(sha256Hex[2 * i + 1]);
+            if (high < 0 || low < 0) {
+                fail("SHA-256 must be 64 hex digits");
+                return false;
+            }
+            expected_sha[i] = (uint8_t)(high << 4 | low);
+        }
+    }
+
+    // Size unknown: the multipart body is larger than the image
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+        fail(Update.errorString());
+        return false;
+    }
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    started_ms = millis();
+    LOG_I("Firmware update started%s", check_sha ? ", SHA-256 given" : "");
+    return true;
+}
+
+void FirmwareUpdate::reportProgress() {
+    if (total == 0) {
+        return;
+    }
+    uint8_t step = (uint8_t)min((uint32_t)(100 / FIRMWARE_PROGRESS_STEP), (uint32_t)((uint64_t)written * 100 / total / FIRMWARE_PROGRESS_STEP));
+    if (step <= reported_step) {
+        return;
+    }
+    reported_step = step;
+    LOG_I("Firmware update %u%%", (unsigned)(step * FIRMWARE_PROGRESS_STEP));
+    if (on_progress) {
+        on_progress(written, total);
+    }
+}
+
+bool FirmwareUpdate::write(const void* request, const uint8_t* data, size_t len) {
+    if (!owns(request) || state != FirmwareState::RECEIVING) {
+        return false;
+    }
+    mbedtls_sha256_update(&sha, data, len);
+    if (Update.write(const_cast<uint8_t*>(data), len) != len) {
+        fail(Update.errorString());
+        Update.abort();
+        return false;
+    }
+    written += len;
+    reportProgress();
+    return true;
+}
+
+bool FirmwareUpdate::finish(const void* request) {
+    if (!owns(request) || state != FirmwareState::RECEIVING) {
+        return false;
+    }
+    uint8_t actual[32];
+    mbedtls_sha256_finish(&sha, actual);
+    mbedtls_sha256_free(&sha);
+    if (check_sha && memcmp(actual, expected_sha, sizeof(actual)) != 0) {
+        Update.abort();
+        fail("SHA-256 mismatch");
+        return false;
+    }
+
+    // Flushes the last sector, verifies the image and makes it the boot one
+    if (!Update.end(true)) {
+        fail(Update.errorString());
+        return false;
+    }
+    done_ms = millis();
+    state = FirmwareState::DONE;
+    Metrics::count(MetricCounter::FIRMWARE_UPDATES);
+    uint32_t elapsed = max(done_ms - started_ms, 1UL);
+    LOG_I("Firmware update written: %u bytes in %u ms (%u KB/s)", (unsigned)written.load(), (unsigned)elapsed,
+          (unsigned)((uint64_t)written * 1000 / 1024 / elapsed));
+    if (on_progress) {
+        on_progress(written, written);
+    }
+    return true;
+}
+
+void FirmwareUpdate::abort(const void* request) {
+    if (!owns(request)) {
+        return;
+    }
+    if (state == FirmwareState::RECEIVING) {
+        Update.abort();
+        fail("upload interrupted");
+    }
+    owner = nullptr;
+}
+
+void FirmwareUpdate::release(const void* request) {
+    if (owns(request) && state == FirmwareState::RECEIVING) {
+        abort(request);  // Request ended without its last chunk
+        return;
+    }
+    const void* expected = request;
+    owner.compare_exchange_strong(expected, nullptr);
+}
+
+bool FirmwareUpdate::restartDue() const {
+    return state == FirmwareState::DONE && millis() - done_ms >= FIRMWARE_RESTART_DELAY_MS;
+}
+
+uint32_t FirmwareUpdate::restartIn() const {
+    if (state != FirmwareState::DONE) {
+        return UINT32_MAX;
+    }
+    unsigned long elapsed = millis() - done_ms;
+    return elapsed >= FIRMWARE_RESTART_DELAY_MS ? 0 : FIRMWARE_RESTART_DELAY_MS - elapsed;
+}
+
+bool FirmwareUpdate::bootPending() {
+    esp_ota_img_states_t ota_state;
+    return esp_ota_get_state_partition(esp_ota_get_running_partition(), &ota_state) == ESP_OK &&
+           ota_state == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+bool FirmwareUpdate::confirmBoot() {
+    if (esp_ota_mark_app_valid_cancel_rollback() != ESP_OK) {
+        return false;
+    }
+    LOG_I("New firmware confirmed");
+    return true;
+}
+
+bool FirmwareUpdate::rollBack() {
+    LOG_E("New firmware did not come online, rolling back");
+    Log::flush();
+    return esp_ota_mark_app_invalid_rollback_and_reboot() == ESP_OK;
+}
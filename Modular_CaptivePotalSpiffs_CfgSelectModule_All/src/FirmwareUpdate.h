@@ -0,0 +1,120 @@
+#ifndef FIRMWARE_UPDATE_H
+#define FIRMWARE_UPDATE_H
+
+#include <Arduino.h>
+#include <functional>
+#include <atomic>
+#include <mbedtls/sha256.h>
+
+// A new image must confirm itself (WiFi up, the portal serving or the
+// application loop running) within this long after its first boot,
+// otherwise the previous one is booted again
+#ifndef FIRMWARE_VERIFY_TIMEOUT_MS
+#define FIRMWARE_VERIFY_TIMEOUT_MS 300000
+#endif
+// Progress is logged and reported every this many percent
+#ifndef FIRMWARE_PROGRESS_STEP
+#define FIRMWARE_PROGRESS_STEP 10
+#endif
+// Time for the response to reach the client before the restart
+#ifndef FIRMWARE_RESTART_DELAY_MS
+#define FIRMWARE_RESTART_DELAY_MS 1000
+#endif
+// Define FIRMWARE_UPDATE_PASSWORD to require HTTP Basic credentials
+// (user "admin") for /update; without it anyone who can reach it can flash.
+
+// Keep serving /update once connected and the portal is down. The station
+// network is not ours to trust, so only behind the password.
+#ifndef FIRMWARE_SERVE_CONNECTED
+#ifdef FIRMWARE_UPDATE_PASSWORD
+#define FIRMWARE_SERVE_CONNECTED 1
+#else
+#define FIRMWARE_SERVE_CONNECTED 0
+#endif
+#endif
+#if FIRMWARE_SERVE_CONNECTED && !defined(FIRMWARE_UPDATE_PASSWORD)
+#error "FIRMWARE_SERVE_CONNECTED needs FIRMWARE_UPDATE_PASSWORD"
+#endif
+
+enum class FirmwareState : uint8_t {
+    IDLE,
+    RECEIVING,  // An upload is being written
+    DONE,       // Written and activated, restarting
+    FAILED      // Last upload rejected, see error()
+};
+
+// written and total in bytes; total is 0 when the client did not say
+typedef std::function<void(size_t written, size_t total)> FirmwareProgressCallback;
+
+// Streams an image into the inactive OTA partition as it arrives, one
+// upload at a time. Chunks go straight to Update, which erases and writes
+// 4 KB sectors as its buffer fills, so the heap holds one sector whatever
+// the image size. The SHA-256 is computed along the way and compared with
+// the expected one before the image is activated. Called from the web
+// server task; state and progress can be read from any task.
+class FirmwareUpdate {
+private:
+    mbedtls_sha256_context sha;
+    uint8_t expected_sha[32];
+    bool check_sha;
+    std::atomic<const void*> owner;  // Request of the upload in progress
+    std::atomic<FirmwareState> state;
+    std::atomic<uint32_t> written;
+    std::atomic<uint32_t> total;
+    uint8_t reported_step;
+    unsigned long started_ms;
+    unsigned long done_ms;
+    char error_text[48];
+    FirmwareProgressCallback on_progress;
+
+    void fail(const char* reason);
+    void reportProgress();
+
+public:
+    FirmwareUpdate();
+    ~FirmwareUpdate();
+
+    // Starts an upload for request. expectedSize may be 0 (unknown);
+    // sha256Hex may be null or empty to skip the comparison. False when
+    // another upload is in progress, one already finished, or it cannot
+    // start (then FAILED, and request holds the upload until release() or
+    // abort() so its error can be answered).
+    bool begin(const void* request, size_t expectedSize, const char* sha256Hex);
+    bool write(const void* request, const uint8_t* data, size_t len);
+
+    // Checks the hash and activates the image for the next boot
+    bool finish(const void* request);
+
+    // Client went away mid-upload
+    void abort(const void* request);
+
+    // Request done: the next upload may start
+    void release(const void* request);
+
+    bool owns(const void* request) const { return owner.load() == request; }
+    // Another request holds the upload, or the device is restarting
+    bool busy() const { return owner.load() != nullptr || state == FirmwareState::DONE; }
+    FirmwareState getState() const { return state; }
+    size_t bytesWritten() const { return written; }
+    size_t expectedSize() const { return total; }
+    const char* error() const { return error_text; }
+
+    // Activated long enough ago for the response to have gone out
+    bool restartDue() const;
+    // Milliseconds until restartDue(), UINT32_MAX while no restart is pending
+    uint32_t restartIn() const;
+
+    void onProgress(FirmwareProgressCallback callback) { on_progress = callback; }
+
+    static const char* stateName(FirmwareState state);
+
+    // Running image is on its first boot, not yet confirmed
+    static bool bootPending();
+    // Keeps the running image; the bootloader will no longer roll back
+    static bool confirmBoot();
+    // Marks the running image invalid and restarts into the previous one.
+    // Returns only when there is none.
+    static bool rollBack();
+};
+
+#endif // FIRMWARE_UPDATE_H
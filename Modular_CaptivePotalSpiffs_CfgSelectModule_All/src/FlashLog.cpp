@@ -0,0 +1,325 @@
+#include "FlashLog.h"
+#include "ConfigStore.h"
+#include "Metrics.h"
+#include "Log.h"
+
+// Sector: u32 magic | u32 sequence | u32 number of its first record | records
+// Record: u16 length | u8 state | u8 0xff | u32 payload CRC32 | payload
+#define SECTOR_MAGIC 0x31474c46  // "FLG1"
+#define SECTOR_HEADER_SIZE 12
+#define RECORD_HEADER_SIZE 8
+#define STATE_PENDING 0xff
+#define STATE_DELIVERED 0x00
+
+enum RecordCheck { RECORD_DAMAGED = -1, RECORD_NONE = 0, RECORD_OK = 1 };
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FlashLog::FlashLog()
+    : partition(nullptr), mutex(nullptr), sector_count(0), head_sequence(0), next_erased(false), erasing(false) {
+    memset(&head, 0, sizeof(head));
+    memset(&tail, 0, sizeof(tail));
+}
+
+bool FlashLog::begin(const esp_partition_t* p) {
+    end();
+    if (!p || p->size < 2 * FLASH_LOG_SECTOR_SIZE) {
+        return false;
+    }
+    mutex = xSemaphoreCreateMutex();
+    if (!mutex) {
+        return false;
+    }
+    partition = p;
+    sector_count = min(p->size / FLASH_LOG_SECTOR_SIZE, (uint32_t)0xffff);
+    scan();
+    return true;
+}
+
+void FlashLog::end() {
+    if (mutex) {
+        vSemaphoreDelete(mutex);
+        mutex = nullptr;
+    }
+    partition = nullptr;
+}
+
+bool FlashLog::readSectorHeader(uint16_t sector, uint32_t& sequence, uint32_t& first_record) const {
+    uint8_t header[SECTOR_HEADER_SIZE];
+    if (esp_partition_read(partition, address(sector, 0), header, sizeof(header)) != ESP_OK ||
+        getU32(header) != SECTOR_MAGIC) {
+        return false;
+    }
+    sequence = getU32(header + 4);
+    first_record = getU32(header + 8);
+    return true;
+}
+
+bool FlashLog::startSector(uint16_t sector, uint32_t sequence, uint32_t first_record) {
+    uint8_t header[SECTOR_HEADER_SIZE];
+    putU32(header, SECTOR_MAGIC);
+    putU32(header + 4, sequence);
+    putU32(header + 8, first_record);
+    Metrics::count(MetricCounter::UPLOAD_FLASH_BYTES, sizeof(header));
+    return esp_partition_write(partition, address(sector, 0), header, sizeof(header)) == ESP_OK;
+}
+
+// RECORD_OK with the payload in data, RECORD_NONE where the written part of
+// the sector ends, RECORD_DAMAGED for a record cut short
+int FlashLog::recordAt(uint16_t sector, uint16_t offset, uint16_t& length, uint8_t& state, uint8_t* data) const {
+    if (offset + RECORD_HEADER_SIZE > FLASH_LOG_SECTOR_SIZE) {
+        return RECORD_NONE;
+    }
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (esp_partition_read(partition, address(sector, offset), header, sizeof(header)) != ESP_OK) {
+        return RECORD_DAMAGED;
+    }
+    length = header[0] | (header[1] << 8);
+    state = header[2];
+    if (length == 0xffff) {
+        return RECORD_NONE;
+    }
+    if (length == 0 || length > FLASH_LOG_RECORD_MAX || offset + RECORD_HEADER_SIZE + length > FLASH_LOG_SECTOR_SIZE ||
+        esp_partition_read(partition, address(sector, offset + RECORD_HEADER_SIZE), data, length) != ESP_OK ||
+        ConfigStore::crc32(data, length) != getU32(header + 4)) {
+        return RECORD_DAMAGED;
+    }
+    return RECORD_OK;
+}
+
+FlashLogPosition FlashLog::sectorStart(uint16_t sector) const {
+    FlashLogPosition at = { 0, sector, SECTOR_HEADER_SIZE, 0 };
+    uint32_t sequence;
+    if (!readSectorHeader(sector, sequence, at.record)) {
+        at.offset = FLASH_LOG_SECTOR_SIZE;  // Nothing to read here
+    }
+    return at;
+}
+
+void FlashLog::erase(uint16_t sector) {
+    esp_partition_erase_range(partition, address(sector, 0), FLASH_LOG_SECTOR_SIZE);
+    Metrics::count(MetricCounter::UPLOAD_FLASH_ERASES);
+}
+
+// The newest sector is the head. The chain of sectors numbered one less
+// before it holds the log; the tail follows the last delivered record.
+void FlashLog::scan() {
+    int32_t head_sector = -1;
+    uint32_t sequence;
+    uint32_t first_record;
+    for (uint16_t s = 0; s < sector_count; s++) {
+        if (readSectorHeader(s, sequence, first_record) && (head_sector < 0 || (int32_t)(sequence - head_sequence) > 0)) {
+            head_sector = s;
+            head_sequence = sequence;
+        }
+    }
+    next_erased = false;
+    if (head_sector < 0) {
+        erase(0);
+        head_sequence = 1;
+        startSector(0, head_sequence, 0);
+        head = sectorStart(0);
+        tail = head;
+        return;
+    }
+
+    uint16_t oldest = head_sector;
+    for (uint16_t n = 1; n < sector_count; n++) {
+        uint16_t previous = (oldest + sector_count - 1) % sector_count;
+        if (!readSectorHeader(previous, sequence, first_record) || sequence != head_sequence - n) {
+            break;
+        }
+        oldest = previous;
+    }
+
+    uint8_t data[FLASH_LOG_RECORD_MAX];
+    tail = sectorStart(oldest);
+    for (uint16_t s = oldest;; s = (s + 1) % sector_count) {
+        FlashLogPosition at = sectorStart(s);
+        uint16_t length;
+        uint8_t state;
+        int check;
+        while ((check = recordAt(s, at.offset, length, state, data)) == RECORD_OK) {
+            at.previous = at.offset;
+            at.offset += RECORD_HEADER_SIZE + length;
+            at.record++;
+            if (state != STATE_PENDING) {
+                tail = at;
+            }
+        }
+        if (s == head_sector) {
+            head = at;
+            if (check == RECORD_DAMAGED) {
+                head.offset = FLASH_LOG_SECTOR_SIZE;  // Never append after a torn record
+            }
+            break;
+        }
+    }
+    if (tail.record == head.record) {
+        tail = head;
+    }
+}
+
+bool FlashLog::append(const void* data, size_t length) {
+    if (!mutex || length == 0 || length > FLASH_LOG_RECORD_MAX) {
+        return false;
+    }
+    uint8_t buffer[RECORD_HEADER_SIZE + FLASH_LOG_RECORD_MAX];
+    buffer[0] = length;
+    buffer[1] = length >> 8;
+    buffer[2] = STATE_PENDING;
+    buffer[3] = 0xff;
+    putU32(buffer + 4, ConfigStore::crc32((const uint8_t*)data, length));
+    memcpy(buffer + RECORD_HEADER_SIZE, data, length);
+    size_t size = RECORD_HEADER_SIZE + length;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    bool ok = head.offset + size <= FLASH_LOG_SECTOR_SIZE || advanceHead();
+    if (ok) {
+        ok = esp_partition_write(partition, address(head.sector, head.offset), buffer, size) == ESP_OK;
+        if (ok) {
+            head.previous = head.offset;
+            head.offset += size;
+            head.record++;
+            Metrics::count(MetricCounter::UPLOAD_RECORDS);
+            Metrics::count(MetricCounter::UPLOAD_RECORD_BYTES, length);
+            Metrics::count(MetricCounter::UPLOAD_FLASH_BYTES, size);
+        } else {
+            head.offset = FLASH_LOG_SECTOR_SIZE;  // Start afresh in the next sector
+        }
+    }
+    xSemaphoreGive(mutex);
+    return ok;
+}
+
+// Lock held
+bool FlashLog::advanceHead() {
+    while (erasing) {
+        xSemaphoreGive(mutex);
+        vTaskDelay(1);
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+    uint16_t next = (head.sector + 1) % sector_count;
+    if (tail.sector == next && tail.record != head.record) {
+        // Full: the oldest sector goes, undelivered records and all
+        FlashLogPosition moved = sectorStart((next + 1) % sector_count);
+        if (moved.offset == FLASH_LOG_SECTOR_SIZE) {
+            moved.record = head.record;
+        }
+        uint32_t dropped = moved.record - tail.record;
+        if (dropped > 0) {
+            Metrics::count(MetricCounter::UPLOAD_DROPPED, dropped);
+            LOG_W("Upload log full, %u records dropped", (unsigned)dropped);
+        }
+        tail = moved;
+    }
+    if (!next_erased) {
+        erase(next);
+    }
+    next_erased = false;
+    if (!startSector(next, head_sequence + 1, head.record)) {
+        return false;
+    }
+    head_sequence++;
+    head.sector = next;
+    head.offset = SECTOR_HEADER_SIZE;
+    head.previous = 0;
+    if (tail.record == head.record) {
+        tail = head;
+    }
+    return true;
+}
+
+void FlashLog::prepare() {
+    if (!mutex) {
+        return;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (tail.record == head.record) {
+        tail = head;
+    }
+    uint16_t next = (head.sector + 1) % sector_count;
+    bool needed = !next_erased && tail.sector != next;
+    erasing = needed;
+    xSemaphoreGive(mutex);
+    if (!needed) {
+        return;
+    }
+
+    // Nobody touches the sector meanwhile: the head waits for it, and only
+    // this task moves the tail
+    erase(next);
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    erasing = false;
+    next_erased = true;
+    xSemaphoreGive(mutex);
+}
+
+FlashLogPosition FlashLog::oldest() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    FlashLogPosition at = tail;
+    xSemaphoreGive(mutex);
+    return at;
+}
+
+uint32_t FlashLog::pending() {
+    if (!mutex) {
+        return 0;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    uint32_t count = head.record - tail.record;
+    xSemaphoreGive(mutex);
+    return count;
+}
+
+bool FlashLog::read(FlashLogPosition& at, uint8_t* data, uint16_t& length) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if ((int32_t)(at.record - tail.record) < 0) {
+        at = tail;  // Overwritten meanwhile
+    }
+    bool found = false;
+    while ((int32_t)(head.record - at.record) > 0) {
+        uint8_t state;
+        if (recordAt(at.sector, at.offset, length, state, data) == RECORD_OK) {
+            at.previous = at.offset;
+            at.offset += RECORD_HEADER_SIZE + length;
+            at.record++;
+            found = true;
+            break;
+        }
+        if (at.sector == head.sector) {
+            break;
+        }
+        // End of the sector, or damage: go on with the next one
+        at = sectorStart((at.sector + 1) % sector_count);
+        if (at.offset == FLASH_LOG_SECTOR_SIZE) {
+            break;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return found;
+}
+
+void FlashLog::acknowledge(const FlashLogPosition& at) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if ((int32_t)(at.record - tail.record) > 0) {
+        // The record before at is still in the log; marking it marks all before
+        uint8_t state = STATE_DELIVERED;
+        esp_partition_write(partition, address(at.sector, at.previous) + 2, &state, 1);
+        Metrics::count(MetricCounter::UPLOAD_FLASH_BYTES, 1);
+        tail = at;
+        if (tail.record == head.record) {
+            tail = head;
+        }
+    }
+    xSemaphoreGive(mutex);
+}
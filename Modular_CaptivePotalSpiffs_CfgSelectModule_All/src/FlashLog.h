@@ -0,0 +1,85 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define FLASH_LOG_SECTOR_SIZE 4096
+
+// Longest record
+#ifndef FLASH_LOG_RECORD_MAX
+#define FLASH_LOG_RECORD_MAX 256
+#endif
+
+// Where reading stands in the log
+struct FlashLogPosition {
+    uint32_t record;    // Sequence number of the next record
+    uint16_t sector;
+    uint16_t offset;
+    uint16_t previous;  // Offset of the record just read, in the same sector
+};
+
+// Records kept on a raw flash partition until they are acknowledged, so
+// they survive reboots and power loss. The partition is a ring of 4 KB
+// sectors, each starting with a header that numbers it; records follow
+// back to back with a length, a CRC and a state byte. An append is one
+// flash write, an acknowledgement clears the state byte of the last
+// record delivered, and a sector is erased once per trip around the ring,
+// ahead of time by prepare(). When the ring is full the oldest sector is
+// erased, unacknowledged records and all. A record cut short by power loss
+// fails its CRC and ends its sector.
+//
+// Appends may come from any task; one reader (the uploader) reads and
+// acknowledges. Uses the whole partition, which must not be mounted.
+class FlashLog {
+private:
+    const esp_partition_t* partition;
+    SemaphoreHandle_t mutex;
+    uint16_t sector_count;
+    uint32_t head_sequence;     // Of the sector being written
+    FlashLogPosition head;      // Where the next record goes
+    FlashLogPosition tail;      // First record not acknowledged
+    bool next_erased;           // The sector after the head one is erased
+    bool erasing;               // prepare() is erasing it without the lock
+
+    size_t address(uint16_t sector, uint16_t offset) const {
+        return (size_t)sector * FLASH_LOG_SECTOR_SIZE + offset;
+    }
+    bool readSectorHeader(uint16_t sector, uint32_t& sequence, uint32_t& first_record) const;
+    bool startSector(uint16_t sector, uint32_t sequence, uint32_t first_record);
+    int recordAt(uint16_t sector, uint16_t offset, uint16_t& length, uint8_t& state, uint8_t* data) const;
+    FlashLogPosition sectorStart(uint16_t sector) const;
+    bool advanceHead();
+    void erase(uint16_t sector);
+    void scan();
+
+public:
+    FlashLog();
+    ~FlashLog() { end(); }
+
+    // Opens the log on partition, finding head and tail by scanning it
+    bool begin(const esp_partition_t* p);
+    void end();
+
+    bool append(const void* data, size_t length);
+
+    // Erases the sector the head moves to next, so appends do not wait
+    // for it. From the reader's task.
+    void prepare();
+
+    // The first record not acknowledged
+    FlashLogPosition oldest();
+    uint32_t pending();
+
+    // Reads the record at at into data (FLASH_LOG_RECORD_MAX bytes) and
+    // moves at past it; false at the head. Records lost to a full ring
+    // are skipped.
+    bool read(FlashLogPosition& at, uint8_t* data, uint16_t& length);
+
+    // Marks the records before at, a position read() returned, delivered
+    void acknowledge(const FlashLogPosition& at);
+};
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,165 @@
+#include "GzipWriter.h"
+#include "ConfigStore.h"
+
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+
+static const uint16_t LENGTH_BASE[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                          31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DISTANCE_BASE[30] = { 1,    2,    3,    4,    5,    7,     9,     13,    17,    25,
+                                            33,   49,   65,   97,   129,  193,   257,   385,   513,   769,
+                                            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Reserved by remaining(): end-of-block code, last partial byte, CRC and size
+#define TRAILER_SIZE 10
+
+static inline uint16_t hash3(const uint8_t* p) {
+    return (uint16_t)(((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & ((1 << GZIP_HASH_BITS) - 1));
+}
+
+GzipWriter::GzipWriter()
+    : out(nullptr), capacity(0), length(0), overflow(false), bit_buffer(0), bit_count(0), crc(0), total(0) {
+}
+
+void GzipWriter::begin(uint8_t* buffer, size_t size) {
+    out = buffer;
+    capacity = size;
+    length = 0;
+    overflow = false;
+    bit_buffer = 0;
+    bit_count = 0;
+    crc = 0;
+    total = 0;
+    // Positions this far back are out of the window until overwritten
+    for (size_t i = 0; i < sizeof(hash) / sizeof(hash[0]); i++) {
+        hash[i] = (uint16_t)(0 - GZIP_WINDOW - 1);
+    }
+
+    // Header: deflate, no name or time, unknown OS
+    static const uint8_t header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+    for (size_t i = 0; i < sizeof(header); i++) {
+        putByte(header[i]);
+    }
+    putBits(1, 1);  // Last block
+    putBits(1, 2);  // Fixed Huffman code
+}
+
+void GzipWriter::putByte(uint8_t b) {
+    if (length < capacity) {
+        out[length++] = b;
+    } else {
+        overflow = true;
+    }
+}
+
+void GzipWriter::putBits(uint32_t value, uint8_t count) {
+    bit_buffer |= value << bit_count;
+    bit_count += count;
+    while (bit_count >= 8) {
+        putByte((uint8_t)bit_buffer);
+        bit_buffer >>= 8;
+        bit_count -= 8;
+    }
+}
+
+// Huffman codes go out most significant bit first
+void GzipWriter::putCode(uint16_t code, uint8_t count) {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    putBits(reversed, count);
+}
+
+void GzipWriter::putLiteral(uint8_t c) {
+    if (c < 144) {
+        putCode(0x30 + c, 8);
+    } else {
+        putCode(0x190 + (c - 144), 9);
+    }
+}
+
+void GzipWriter::putMatch(uint16_t match_length, uint16_t distance) {
+    uint8_t code = 28;
+    while (LENGTH_BASE[code] > match_length) {
+        code--;
+    }
+    uint16_t symbol = 257 + code;
+    if (symbol < 280) {
+        putCode(symbol - 256, 7);
+    } else {
+        putCode(0xc0 + (symbol - 280), 8);
+    }
+    putBits(match_length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DISTANCE_BASE[code] > distance) {
+        code--;
+    }
+    putCode(code, 5);
+    putBits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+void GzipWriter::write(const uint8_t* data, size_t size) {
+    crc = ConfigStore::crc32(data, size, crc);
+    const uint32_t start = total;  // Input position of data[0]
+
+    // Byte at input position p: earlier writes are in the window
+    auto inputAt = [&](uint32_t p) -> uint8_t {
+        return p >= start ? data[p - start] : window[p & (GZIP_WINDOW - 1)];
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        uint32_t position = start + i;
+        uint16_t match_length = 0;
+        uint16_t distance = 0;
+        if (size - i >= MIN_MATCH) {
+            uint16_t h = hash3(data + i);
+            distance = (uint16_t)((uint16_t)position - hash[h]);
+            hash[h] = (uint16_t)position;
+            if (distance > 0 && distance <= GZIP_WINDOW && distance <= position) {
+                size_t limit = min(size - i, (size_t)MAX_MATCH);
+                while (match_length < limit && inputAt(position - distance + match_length) == data[i + match_length]) {
+                    match_length++;
+                }
+            }
+        }
+        if (match_length >= MIN_MATCH) {
+            putMatch(match_length, distance);
+            // Later input can refer into the repeat too
+            for (size_t k = 1; k < match_length && i + k + MIN_MATCH <= size; k++) {
+                hash[hash3(data + i + k)] = (uint16_t)(position + k);
+            }
+            i += match_length;
+        } else {
+            putLiteral(data[i]);
+            i++;
+        }
+    }
+
+    for (size_t k = size > GZIP_WINDOW ? size - GZIP_WINDOW : 0; k < size; k++) {
+        window[(start + k) & (GZIP_WINDOW - 1)] = data[k];
+    }
+    total += size;
+}
+
+bool GzipWriter::finish() {
+    putCode(0, 7);  // End of block
+    if (bit_count > 0) {
+        putBits(0, 8 - bit_count);
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        putByte((uint8_t)(crc >> shift));
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        putByte((uint8_t)(total >> shift));
+    }
+    return !overflow;
+}
+
+size_t GzipWriter::remaining() const {
+    return capacity > length + TRAILER_SIZE ? capacity - length - TRAILER_SIZE : 0;
+}
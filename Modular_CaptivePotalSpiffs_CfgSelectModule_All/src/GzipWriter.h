@@ -0,0 +1,57 @@
+#ifndef GZIP_WRITER_H
+#define GZIP_WRITER_H
+
+#include <Arduino.h>
+
+// History searched for repeats; a power of two. Larger finds more, at one
+// byte of RAM per byte plus the hash table.
+#ifndef GZIP_WINDOW
+#define GZIP_WINDOW 2048
+#endif
+#define GZIP_HASH_BITS 10
+
+// Compresses into a gzip member in a caller's buffer, for request bodies
+// sent with Content-Encoding: gzip. One deflate block with the fixed
+// Huffman code: repeats within the window become back-references, which is
+// where line-oriented telemetry gains most, without the tens of KB a
+// dynamic-code compressor needs. About 4 KB of state, no allocation.
+class GzipWriter {
+private:
+    uint8_t* out;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+    uint32_t bit_buffer;
+    uint8_t bit_count;
+    uint32_t crc;
+    uint32_t total;  // Input bytes so far
+
+    uint8_t window[GZIP_WINDOW];             // Last input, at total & (GZIP_WINDOW - 1)
+    uint16_t hash[1 << GZIP_HASH_BITS];      // Low 16 bits of the last position of each 3-byte hash
+
+    void putByte(uint8_t b);
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint16_t code, uint8_t count);
+    void putLiteral(uint8_t c);
+    void putMatch(uint16_t match_length, uint16_t distance);
+
+public:
+    GzipWriter();
+
+    void begin(uint8_t* buffer, size_t size);
+    void write(const uint8_t* data, size_t size);
+    void write(const char* text) { write((const uint8_t*)text, strlen(text)); }
+
+    // Ends the member; false if it did not fit the buffer
+    bool finish();
+
+    size_t size() const { return length; }
+    size_t inputSize() const { return total; }
+
+    // Room left for write(), with the end of the member reserved. Input of
+    // n bytes never takes more than bound(n).
+    size_t remaining() const;
+    static size_t bound(size_t n) { return n + (n + 7) / 8; }
+};
+
+#endif // GZIP_WRITER_H
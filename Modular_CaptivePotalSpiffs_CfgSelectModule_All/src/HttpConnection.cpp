@@ -0,0 +1,140 @@
+#include "HttpConnection.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+HttpConnection::HttpConnection(uint32_t timeoutMs)
+    : client(nullptr), timeout_ms(timeoutMs), out_length(0), out_failed(false), rx_pos(0), rx_length(0) {
+}
+
+bool HttpConnection::connect(const char* host, uint16_t port) {
+    out_length = 0;
+    out_failed = false;
+    rx_pos = 0;
+    rx_length = 0;
+    return client->connect(host, port, timeout_ms) != 0;
+}
+
+void HttpConnection::stop() {
+    if (client) {
+        client->stop();
+    }
+    rx_pos = 0;
+    rx_length = 0;
+}
+
+void HttpConnection::put(const char* data, size_t length) {
+    while (length > 0) {
+        if (out_length == sizeof(out)) {
+            sendOut();
+        }
+        size_t n = min(length, sizeof(out) - out_length);
+        memcpy(out + out_length, data, n);
+        out_length += n;
+        data += n;
+        length -= n;
+    }
+}
+
+void HttpConnection::sendOut() {
+    if (out_length > 0 && !out_failed && client->write((const uint8_t*)out, out_length) != out_length) {
+        out_failed = true;
+    }
+    out_length = 0;
+}
+
+bool HttpConnection::flush() {
+    sendOut();
+    bool ok = !out_failed;
+    out_failed = false;  // The next request starts clean
+    return ok;
+}
+
+// Next reply byte, -1 on timeout or a closed connection
+int HttpConnection::nextByte(uint32_t deadline) {
+    while (rx_pos == rx_length) {
+        int available = client->available();
+        if (available > 0) {
+            int n = client->read(rx, min((size_t)available, sizeof(rx)));
+            if (n > 0) {
+                rx_pos = 0;
+                rx_length = n;
+                break;
+            }
+        }
+        if (!client->connected() || (int32_t)(millis() - deadline) >= 0) {
+            return -1;
+        }
+        vTaskDelay(1);
+    }
+    return rx[rx_pos++];
+}
+
+// One header line without its CRLF, truncated to size; false on timeout
+bool HttpConnection::readLine(char* line, size_t size, uint32_t deadline) {
+    size_t length = 0;
+    for (;;) {
+        int c = nextByte(deadline);
+        if (c < 0) {
+            return false;
+        }
+        if (c == '\n') {
+            break;
+        }
+        if (c != '\r' && length + 1 < size) {
+            line[length++] = (char)c;
+        }
+    }
+    line[length] = '\0';
+    return true;
+}
+
+HttpConnection::Reply HttpConnection::readReply(char* body, size_t bodySize) {
+    Reply reply = { -1, false, 0 };
+    if (bodySize > 0) {
+        body[0] = '\0';
+    }
+    uint32_t deadline = millis() + timeout_ms;
+    char line[96];
+    if (!readLine(line, sizeof(line), deadline) || strncmp(line, "HTTP/1.", 7) != 0 || strlen(line) < 12) {
+        return reply;
+    }
+    int status = atoi(line + 9);
+
+    long content_length = -1;
+    for (;;) {
+        if (!readLine(line, sizeof(line), deadline)) {
+            return reply;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = atol(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line + 11, "close")) {
+            reply.close = true;
+        } else if (strncasecmp(line, "Retry-After:", 12) == 0) {
+            reply.retry_after_ms = atol(line + 12) * 1000;
+        }
+    }
+    if (content_length < 0) {
+        reply.close = true;  // Body runs to the end of the connection
+        reply.status = status;
+        return reply;
+    }
+
+    size_t kept = 0;
+    for (long i = 0; i < content_length; i++) {
+        int c = nextByte(deadline);
+        if (c < 0) {
+            return reply;
+        }
+        if (kept + 1 < bodySize) {
+            body[kept++] = (char)c;
+        }
+    }
+    if (bodySize > 0) {
+        body[kept] = '\0';
+    }
+    reply.status = status;
+    return reply;
+}
@@ -0,0 +1,53 @@
+#ifndef HTTP_CONNECTION_H
+#define HTTP_CONNECTION_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// HTTP/1.1 requests, one at a time, over a kept-alive WiFiClient or
+// WiFiClientSecure. Request bytes are gathered so they go out in few TLS
+// records, replies are read in blocks. For the integrations' worker tasks;
+// nothing is allocated.
+class HttpConnection {
+private:
+    WiFiClient* client;
+    uint32_t timeout_ms;
+    char out[512];
+    size_t out_length;
+    bool out_failed;
+    uint8_t rx[128];
+    uint8_t rx_pos;
+    uint8_t rx_length;
+
+    void sendOut();
+    int nextByte(uint32_t deadline);
+    bool readLine(char* line, size_t size, uint32_t deadline);
+
+public:
+    struct Reply {
+        int status;               // -1 on a transport failure or timeout
+        bool close;               // The server ends the connection after it
+        uint32_t retry_after_ms;  // From Retry-After, 0 without
+    };
+
+    explicit HttpConnection(uint32_t timeoutMs);
+
+    void use(WiFiClient& c) { client = &c; }
+
+    bool connect(const char* host, uint16_t port);
+    bool connected() { return client && client->connected(); }
+    void stop();
+
+    // Starts a request; the bytes are sent by put() as the buffer fills
+    // and by flush()
+    void put(const char* data, size_t length);
+    void put(const char* text) { put(text, strlen(text)); }
+    bool flush();  // false if any write of this request failed
+
+    // Reads the status line, headers and body. Up to bodySize - 1 body
+    // bytes are kept in body (nul-terminated), the rest is read and
+    // dropped so the connection can carry the next request.
+    Reply readReply(char* body, size_t bodySize);
+};
+
+#endif // HTTP_CONNECTION_H
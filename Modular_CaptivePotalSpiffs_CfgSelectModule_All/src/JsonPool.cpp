@@ -0,0 +1,68 @@
+#include "JsonPool.h"
+
+// Each block is preceded by its (aligned) size
+static const size_t BLOCK_HEADER = 8;
+static const size_t NO_BLOCK = SIZE_MAX;
+
+static size_t alignBlock(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+JsonPool::JsonPool() : used(0), last(NO_BLOCK), peak(0), failures(0) {
+}
+
+void JsonPool::reset() {
+    used = 0;
+    last = NO_BLOCK;
+}
+
+void* JsonPool::allocate(size_t size) {
+    size = alignBlock(size);
+    if (size > sizeof(buffer) - used || BLOCK_HEADER > sizeof(buffer) - used - size) {
+        failures++;
+        return nullptr;
+    }
+    uint8_t* block = buffer + used;
+    *(size_t*)block = size;
+    last = used;
+    used += BLOCK_HEADER + size;
+    peak = max(peak, used);
+    return block + BLOCK_HEADER;
+}
+
+void JsonPool::deallocate(void* ptr) {
+    // Only the newest block is given back; the rest goes with reset()
+    if (ptr && last != NO_BLOCK && ptr == buffer + last + BLOCK_HEADER) {
+        used = last;
+        last = NO_BLOCK;
+    }
+}
+
+void* JsonPool::reallocate(void* ptr, size_t new_size) {
+    if (!ptr) {
+        return allocate(new_size);
+    }
+    new_size = alignBlock(new_size);
+    uint8_t* block = (uint8_t*)ptr - BLOCK_HEADER;
+    size_t old_size = *(size_t*)block;
+
+    // Newest block: resize where it is
+    if (last != NO_BLOCK && block == buffer + last) {
+        if (new_size > sizeof(buffer) - last - BLOCK_HEADER) {
+            failures++;
+            return nullptr;
+        }
+        *(size_t*)block = new_size;
+        used = last + BLOCK_HEADER + new_size;
+        peak = max(peak, used);
+        return ptr;
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    void* moved = allocate(new_size);
+    if (moved) {
+        memcpy(moved, ptr, old_size);
+    }
+    return moved;
+}
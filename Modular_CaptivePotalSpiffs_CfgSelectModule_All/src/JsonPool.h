@@ -0,0 +1,37 @@
+#ifndef JSON_POOL_H
+#define JSON_POOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef API_JSON_POOL_SIZE
+#define API_JSON_POOL_SIZE 6144
+#endif
+
+// Fixed-size arena for ArduinoJson documents, so API requests never touch
+// the heap. Blocks are bump-allocated; only the most recent one can be
+// grown or released in place, which covers how ArduinoJson builds strings.
+// Call reset() before each document; one document at a time.
+class JsonPool : public ArduinoJson::Allocator {
+private:
+    alignas(8) uint8_t buffer[API_JSON_POOL_SIZE];
+    size_t used;
+    size_t last;       // Offset of the most recent block, or SIZE_MAX
+    size_t peak;
+    uint32_t failures;
+
+public:
+    JsonPool();
+
+    void reset();
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t new_size) override;
+
+    size_t capacity() const { return sizeof(buffer); }
+    size_t peakUsage() const { return peak; }
+    uint32_t failureCount() const { return failures; }
+};
+
+#endif // JSON_POOL_H
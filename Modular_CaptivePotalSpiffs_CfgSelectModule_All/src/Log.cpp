@@ -0,0 +1,208 @@
+#include "Log.h"
+#include "Metrics.h"
+#include <atomic>
+#include <stdarg.h>
+
+// Bounded multi-producer ring: a writer claims a slot by advancing
+// write_seq, formats into it and publishes it through the slot's sequence.
+// Only the drain side (drain task or flush(), one at a time) reads.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    uint32_t time_ms;
+    LogLevel level;
+    char text[LOG_LINE_MAX];
+};
+
+static_assert((LOG_RING_SLOTS & (LOG_RING_SLOTS - 1)) == 0, "LOG_RING_SLOTS must be a power of two");
+
+static LogSlot slots[LOG_RING_SLOTS];
+static std::atomic<uint32_t> write_seq(0);
+static uint32_t read_seq = 0;
+static std::atomic<bool> ring_ready(false);
+static std::atomic<bool> draining(false);
+
+static std::atomic<TaskHandle_t> drain_task(nullptr);
+static std::atomic<bool> drain_stop(false);
+
+// Drained output, written by the drain side only
+static char tail_ring[LOG_TAIL_SIZE];
+static uint32_t tail_written = 0;
+static portMUX_TYPE tail_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void initRing() {
+    if (ring_ready.load(std::memory_order_acquire)) {
+        return;
+    }
+    static portMUX_TYPE init_lock = portMUX_INITIALIZER_UNLOCKED;
+    portENTER_CRITICAL(&init_lock);
+    if (!ring_ready.load(std::memory_order_relaxed)) {
+        for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        ring_ready.store(true, std::memory_order_release);
+    }
+    portEXIT_CRITICAL(&init_lock);
+}
+
+static char levelLetter(LogLevel level) {
+    switch (level) {
+        case LogLevel::ERROR: return 'E';
+        case LogLevel::WARN:  return 'W';
+        case LogLevel::INFO:  return 'I';
+        case LogLevel::DEBUG: return 'D';
+    }
+    return '?';
+}
+
+static void appendTail(const char* data, size_t length) {
+    portENTER_CRITICAL(&tail_lock);
+    for (size_t i = 0; i < length; i++) {
+        tail_ring[(tail_written + i) % LOG_TAIL_SIZE] = data[i];
+    }
+    tail_written += length;
+    portEXIT_CRITICAL(&tail_lock);
+}
+
+// Writes out every published line; the caller holds draining
+static void drainRing() {
+    char line[LOG_LINE_MAX + 24];
+    for (;;) {
+        LogSlot& slot = slots[read_seq % LOG_RING_SLOTS];
+        if (slot.sequence.load(std::memory_order_acquire) != read_seq + 1) {
+            return;
+        }
+        int n = snprintf(line, sizeof(line), "%c (%lu) %s\n", levelLetter(slot.level),
+                         (unsigned long)slot.time_ms, slot.text);
+        slot.sequence.store(read_seq + LOG_RING_SLOTS, std::memory_order_release);
+        read_seq++;
+        if (n <= 0) {
+            continue;
+        }
+        size_t length = min((size_t)n, sizeof(line) - 1);
+        Serial.write((const uint8_t*)line, length);
+        appendTail(line, length);
+    }
+}
+
+static void drainTaskMain(void* arg) {
+    (void)arg;
+    while (!drain_stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        Log::flush();
+    }
+    drain_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+namespace Log {
+
+void write(LogLevel level, const char* format, ...) {
+    initRing();
+    uint32_t seq = write_seq.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    for (;;) {
+        slot = &slots[seq % LOG_RING_SLOTS];
+        int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - seq);
+        if (diff == 0) {
+            if (write_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the drain task is behind, the line is lost
+            Metrics::count(MetricCounter::LOG_DROPPED);
+            return;
+        } else {
+            seq = write_seq.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->time_ms = millis();
+    slot->level = level;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(slot->text, sizeof(slot->text), format, args);
+    va_end(args);
+    slot->sequence.store(seq + 1, std::memory_order_release);
+
+    TaskHandle_t task = drain_task;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+bool begin() {
+    initRing();
+    if (drain_task) {
+        return true;
+    }
+    drain_stop = false;
+    TaskHandle_t task;
+    if (xTaskCreate(drainTaskMain, "log", LOG_TASK_STACK, nullptr, LOG_TASK_PRIORITY, &task) != pdPASS) {
+        return false;
+    }
+    drain_task = task;
+    Metrics::watchTask(task);
+    xTaskNotifyGive(task);
+    return true;
+}
+
+void end() {
+    TaskHandle_t task = drain_task;
+    if (!task) {
+        return;
+    }
+    Metrics::unwatchTask(task);
+    drain_stop = true;
+    xTaskNotifyGive(task);
+    while (drain_task) {
+        vTaskDelay(1);
+    }
+    flush();
+}
+
+void flush() {
+    initRing();
+    while (draining.exchange(true)) {
+        vTaskDelay(1);
+    }
+    drainRing();
+    draining = false;
+}
+
+const char* redact(const char* secret) {
+    return secret && secret[0] ? "********" : "(none)";
+}
+
+void tail(uint32_t& start, uint32_t& length) {
+    portENTER_CRITICAL(&tail_lock);
+    uint32_t written = tail_written;
+    length = min(written, (uint32_t)LOG_TAIL_SIZE);
+    start = written - length;
+    // Once wrapped, start at the first complete line
+    if (written > LOG_TAIL_SIZE) {
+        while (length > 0 && tail_ring[start % LOG_TAIL_SIZE] != '\n') {
+            start++;
+            length--;
+        }
+        if (length > 0) {
+            start++;
+            length--;
+        }
+    }
+    portEXIT_CRITICAL(&tail_lock);
+}
+
+size_t readTail(uint32_t position, char* buffer, size_t size) {
+    size_t copied = 0;
+    portENTER_CRITICAL(&tail_lock);
+    if (tail_written - position <= LOG_TAIL_SIZE) {
+        copied = min((size_t)(tail_written - position), size);
+        for (size_t i = 0; i < copied; i++) {
+            buffer[i] = tail_ring[(position + i) % LOG_TAIL_SIZE];
+        }
+    }
+    portEXIT_CRITICAL(&tail_lock);
+    return copied;
+}
+
+} // namespace Log
@@ -0,0 +1,98 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define PORTAL_LOG_NONE  0
+#define PORTAL_LOG_ERROR 1
+#define PORTAL_LOG_WARN  2
+#define PORTAL_LOG_INFO  3
+#define PORTAL_LOG_DEBUG 4
+
+// Build threshold, calls above it compile to nothing
+#ifndef PORTAL_LOG_LEVEL
+#define PORTAL_LOG_LEVEL PORTAL_LOG_INFO
+#endif
+
+// Lines waiting for the drain task; one more is dropped, not waited for
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 32
+#endif
+// Longest message, longer ones are truncated
+#ifndef LOG_LINE_MAX
+#define LOG_LINE_MAX 120
+#endif
+// Recent output kept for /log
+#ifndef LOG_TAIL_SIZE
+#define LOG_TAIL_SIZE 2048
+#endif
+
+#ifndef LOG_TASK_STACK
+#define LOG_TASK_STACK 2560
+#endif
+#ifndef LOG_TASK_PRIORITY
+#define LOG_TASK_PRIORITY 0
+#endif
+
+enum class LogLevel : uint8_t {
+    ERROR = PORTAL_LOG_ERROR,
+    WARN = PORTAL_LOG_WARN,
+    INFO = PORTAL_LOG_INFO,
+    DEBUG = PORTAL_LOG_DEBUG
+};
+
+// Leveled printf-style logging. A call formats straight into a slot of a
+// lock-free ring and returns; a low-priority task writes the lines to Serial
+// and keeps the most recent output for /log. Safe from any task, not from
+// interrupts. Nothing is allocated. Secrets never go in: log them through
+// Log::redact().
+namespace Log {
+    void write(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Starts the drain task; lines logged before are kept until then
+    bool begin();
+
+    // Stops the drain task after writing out what is queued
+    void end();
+
+    // Writes out queued lines from the calling task, e.g. before a restart
+    void flush();
+
+    // What to log in place of a secret
+    const char* redact(const char* secret);
+
+    // Window of the tail: bytes [start, start + length) by position
+    void tail(uint32_t& start, uint32_t& length);
+
+    // Copies tail bytes from position on; 0 once they have been overwritten
+    size_t readTail(uint32_t position, char* buffer, size_t size);
+}
+
+#if PORTAL_LOG_LEVEL >= PORTAL_LOG_ERROR
+#define LOG_E(...) Log::write(LogLevel::ERROR, __VA_ARGS__)
+#else
+#define LOG_E(...) do {} while (0)
+#endif
+#if PORTAL_LOG_LEVEL >= PORTAL_LOG_WARN
+#define LOG_W(...) Log::write(LogLevel::WARN, __VA_ARGS__)
+#else
+#define LOG_W(...) do {} while (0)
+#endif
+#if PORTAL_LOG_LEVEL >= PORTAL_LOG_INFO
+#define LOG_I(...) Log::write(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_I(...) do {} while (0)
+#endif
+#if PORTAL_LOG_LEVEL >= PORTAL_LOG_DEBUG
+#define LOG_D(...) Log::write(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_D(...) do {} while (0)
+#endif
+
+// IPAddress arguments without a String: LOG_I("IP " LOG_IP_FMT, LOG_IP_ARGS(ip))
+#define LOG_IP_FMT "%u.%u.%u.%u"
+#define LOG_IP_ARGS(ip) (unsigned)(ip)[0], (unsigned)(ip)[1], (unsigned)(ip)[2], (unsigned)(ip)[3]
+
+#endif // LOG_H
@@ -0,0 +1,206 @@
+#include "Metrics.h"
+#include <stdarg.h>
+
+struct MetricInfo {
+    const char* name;
+    const char* help;
+};
+
+#define METRIC_INFO_ENTRY(id, name, help, ...) { name, help },
+#define METRIC_BOUNDS_ENTRY(id, name, help, ...) { __VA_ARGS__ },
+
+static const MetricInfo COUNTER_INFO[] = { METRIC_COUNTERS(METRIC_INFO_ENTRY) };
+static const MetricInfo GAUGE_INFO[] = { METRIC_GAUGES(METRIC_INFO_ENTRY) };
+static const MetricInfo HISTOGRAM_INFO[] = { METRIC_HISTOGRAMS(METRIC_INFO_ENTRY) };
+static const uint32_t HISTOGRAM_BOUNDS[][METRIC_BUCKETS] = { METRIC_HISTOGRAMS(METRIC_BOUNDS_ENTRY) };
+
+static std::atomic<uint32_t> counters[(size_t)MetricCounter::COUNT];
+static std::atomic<int32_t> gauges[(size_t)MetricGauge::COUNT];
+static HistogramData histograms[(size_t)MetricHistogram::COUNT];
+static portMUX_TYPE histogram_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t watched_tasks[METRICS_MAX_TASKS];
+static portMUX_TYPE task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Renders the whole exposition on every call and keeps only the requested
+// window, so no state is carried between the chunks of a response
+class WindowWriter {
+    char* out;
+    size_t size;
+    size_t skip;
+    size_t position;
+    size_t written;
+
+public:
+    WindowWriter(char* buffer, size_t bufferSize, size_t offset)
+        : out(buffer), size(bufferSize), skip(offset), position(0), written(0) {}
+
+    size_t length() const { return written; }
+    bool full() const { return written == size; }
+
+    void append(const char* data, size_t len) {
+        if (position + len > skip && written < size) {
+            size_t from = position < skip ? skip - position : 0;
+            size_t n = min(len - from, size - written);
+            memcpy(out + written, data + from, n);
+            written += n;
+        }
+        position += len;
+    }
+
+    void printf(const char* format, ...) {
+        char line[128];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (n > 0) {
+            append(line, min((size_t)n, sizeof(line) - 1));
+        }
+    }
+};
+
+// Microseconds as seconds without trailing zeros, e.g. "0.0025"
+static const char* formatSeconds(char* out, size_t size, uint64_t us) {
+    snprintf(out, size, "%llu.%06llu", (unsigned long long)(us / 1000000), (unsigned long long)(us % 1000000));
+    char* end = out + strlen(out) - 1;
+    while (*end == '0') {
+        *end-- = '\0';
+    }
+    if (*end == '.') {
+        *end = '\0';
+    }
+    return out;
+}
+
+static void writeHeader(WindowWriter& out, const MetricInfo& info, const char* type) {
+    out.printf("# HELP " METRICS_PREFIX "%s %s\n", info.name, info.help);
+    out.printf("# TYPE " METRICS_PREFIX "%s %s\n", info.name, type);
+}
+
+namespace Metrics {
+
+void count(MetricCounter counter, uint32_t n) {
+    counters[(size_t)counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void set(MetricGauge gauge, int32_t value) {
+    gauges[(size_t)gauge].store(value, std::memory_order_relaxed);
+}
+
+void observe(MetricHistogram histogram, uint32_t micros) {
+    const uint32_t* bounds = HISTOGRAM_BOUNDS[(size_t)histogram];
+    size_t bucket = 0;
+    while (bucket < METRIC_BUCKETS && micros > bounds[bucket]) {
+        bucket++;
+    }
+    HistogramData& data = histograms[(size_t)histogram];
+    portENTER_CRITICAL(&histogram_lock);
+    data.buckets[bucket]++;
+    data.count++;
+    data.sum_us += micros;
+    portEXIT_CRITICAL(&histogram_lock);
+}
+
+void watchTask(TaskHandle_t task) {
+    if (!task) {
+        return;
+    }
+    portENTER_CRITICAL(&task_lock);
+    TaskHandle_t* slot = nullptr;
+    for (size_t i = 0; i < METRICS_MAX_TASKS; i++) {
+        if (watched_tasks[i] == task) {
+            slot = nullptr;
+            break;
+        }
+        if (!watched_tasks[i] && !slot) {
+            slot = &watched_tasks[i];
+        }
+    }
+    if (slot) {
+        *slot = task;
+    }
+    portEXIT_CRITICAL(&task_lock);
+}
+
+void unwatchTask(TaskHandle_t task) {
+    portENTER_CRITICAL(&task_lock);
+    for (size_t i = 0; i < METRICS_MAX_TASKS; i++) {
+        if (watched_tasks[i] == task) {
+            watched_tasks[i] = nullptr;
+        }
+    }
+    portEXIT_CRITICAL(&task_lock);
+}
+
+void capture(MetricsSnapshot& snapshot) {
+    set(MetricGauge::HEAP_FREE, ESP.getFreeHeap());
+    set(MetricGauge::HEAP_MIN_FREE, ESP.getMinFreeHeap());
+    set(MetricGauge::HEAP_LARGEST_BLOCK, ESP.getMaxAllocHeap());
+    set(MetricGauge::UPTIME, millis() / 1000);
+
+    for (size_t i = 0; i < (size_t)MetricCounter::COUNT; i++) {
+        snapshot.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < (size_t)MetricGauge::COUNT; i++) {
+        snapshot.gauges[i] = gauges[i].load(std::memory_order_relaxed);
+    }
+    portENTER_CRITICAL(&histogram_lock);
+    memcpy(snapshot.histograms, histograms, sizeof(histograms));
+    portEXIT_CRITICAL(&histogram_lock);
+
+    // Name and watermark are read under the lock: a task may be deleted
+    // right after unwatchTask() returns, and that waits for this loop
+    portENTER_CRITICAL(&task_lock);
+    snapshot.task_count = 0;
+    for (size_t i = 0; i < METRICS_MAX_TASKS; i++) {
+        if (!watched_tasks[i]) {
+            continue;
+        }
+        TaskStackSample& sample = snapshot.tasks[snapshot.task_count++];
+        strlcpy(sample.name, pcTaskGetName(watched_tasks[i]), sizeof(sample.name));
+        sample.free_bytes = uxTaskGetStackHighWaterMark(watched_tasks[i]);
+    }
+    portEXIT_CRITICAL(&task_lock);
+}
+
+size_t render(const MetricsSnapshot& snapshot, char* buffer, size_t size, size_t offset) {
+    WindowWriter out(buffer, size, offset);
+
+    for (size_t i = 0; i < (size_t)MetricCounter::COUNT && !out.full(); i++) {
+        writeHeader(out, COUNTER_INFO[i], "counter");
+        out.printf(METRICS_PREFIX "%s %lu\n", COUNTER_INFO[i].name, (unsigned long)snapshot.counters[i]);
+    }
+    for (size_t i = 0; i < (size_t)MetricGauge::COUNT && !out.full(); i++) {
+        writeHeader(out, GAUGE_INFO[i], "gauge");
+        out.printf(METRICS_PREFIX "%s %ld\n", GAUGE_INFO[i].name, (long)snapshot.gauges[i]);
+    }
+
+    char seconds[24];
+    for (size_t i = 0; i < (size_t)MetricHistogram::COUNT && !out.full(); i++) {
+        const MetricInfo& info = HISTOGRAM_INFO[i];
+        const HistogramData& data = snapshot.histograms[i];
+        writeHeader(out, info, "histogram");
+        uint32_t cumulative = 0;
+        for (size_t b = 0; b < METRIC_BUCKETS; b++) {
+            cumulative += data.buckets[b];
+            out.printf(METRICS_PREFIX "%s_bucket{le=\"%s\"} %lu\n", info.name,
+                       formatSeconds(seconds, sizeof(seconds), HISTOGRAM_BOUNDS[i][b]), (unsigned long)cumulative);
+        }
+        out.printf(METRICS_PREFIX "%s_bucket{le=\"+Inf\"} %lu\n", info.name, (unsigned long)data.count);
+        out.printf(METRICS_PREFIX "%s_sum %s\n", info.name, formatSeconds(seconds, sizeof(seconds), data.sum_us));
+        out.printf(METRICS_PREFIX "%s_count %lu\n", info.name, (unsigned long)data.count);
+    }
+
+    if (snapshot.task_count > 0 && !out.full()) {
+        static const MetricInfo TASK_INFO = { "task_stack_free_bytes", "Least free stack seen per task" };
+        writeHeader(out, TASK_INFO, "gauge");
+        for (size_t i = 0; i < snapshot.task_count; i++) {
+            out.printf(METRICS_PREFIX "%s{task=\"%s\"} %lu\n", TASK_INFO.name, snapshot.tasks[i].name,
+                       (unsigned long)snapshot.tasks[i].free_bytes);
+        }
+    }
+    return out.length();
+}
+
+} // namespace Metrics
@@ -0,0 +1,134 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Prefix of every exported metric name
+#ifndef METRICS_PREFIX
+#define METRICS_PREFIX "portal_"
+#endif
+
+// Tasks whose stack high-water mark is exported
+#ifndef METRICS_MAX_TASKS
+#define METRICS_MAX_TASKS 6
+#endif
+
+// Monotonic counters: X(id, name, help)
+#define METRIC_COUNTERS(X) \
+    X(WIFI_CONNECTS,         "wifi_connects_total",         "Connection cycles that reached an IP") \
+    X(WIFI_CONNECT_FAILURES, "wifi_connect_failures_total", "Connection attempts that failed or timed out") \
+    X(WIFI_RECONNECTS,       "wifi_reconnects_total",       "Reconnects after the station link was lost") \
+    X(LOG_DROPPED,           "log_dropped_total",           "Log lines dropped because the ring was full") \
+    X(CAPTIVE_PROBES,        "captive_probes_total",        "Known connectivity checks and page noise answered by the portal") \
+    X(DNS_QUERIES,           "dns_queries_total",           "Queries answered by the captive DNS responder") \
+    X(DNS_DROPPED,           "dns_dropped_total",           "DNS queries dropped as malformed or over the per-client rate") \
+    X(TELEGRAM_MESSAGES,     "telegram_messages_total",     "Notifications delivered to Telegram") \
+    X(TELEGRAM_REQUESTS,     "telegram_requests_total",     "sendMessage calls, each carrying one or more notifications") \
+    X(TELEGRAM_HANDSHAKES,   "telegram_handshakes_total",   "TLS connections opened to the Bot API") \
+    X(TELEGRAM_DROPPED,      "telegram_dropped_total",      "Notifications pushed out of a full queue or rejected by Telegram") \
+    X(UPLOAD_RECORDS,        "upload_records_total",        "Records appended to the upload log") \
+    X(UPLOAD_RECORD_BYTES,   "upload_record_bytes_total",   "Payload bytes of the records appended") \
+    X(UPLOAD_FLASH_BYTES,    "upload_flash_bytes_total",    "Bytes written to the log partition, headers and acknowledgements included") \
+    X(UPLOAD_FLASH_ERASES,   "upload_flash_erases_total",   "Log sectors erased") \
+    X(UPLOAD_DELIVERED,      "upload_delivered_total",      "Records acknowledged by the web host") \
+    X(UPLOAD_DROPPED,        "upload_dropped_total",        "Records overwritten in a full upload log") \
+    X(UPLOAD_REQUESTS,       "upload_requests_total",       "Upload requests, each carrying one batch") \
+    X(UPLOAD_BODY_BYTES,     "upload_body_bytes_total",     "Compressed bytes sent in upload requests") \
+    X(FIRMWARE_UPDATES,      "firmware_updates_total",      "Firmware images written and activated through /update") \
+    X(FIRMWARE_FAILURES,     "firmware_failures_total",     "Firmware uploads rejected or interrupted") \
+    X(HTTP_SHED_BUSY,        "http_shed_busy_total",        "Requests refused with 503 at the connection limit") \
+    X(HTTP_SHED_CLIENT,      "http_shed_client_total",      "Requests refused with 429 over a client's connection or rate limit") \
+    X(HTTP_SHED_MEMORY,      "http_shed_memory_total",      "Requests refused with 503 below the heap watermark") \
+    X(LOOP_WAKEUPS,          "loop_wakeups_total",          "Times the task calling handle() woke from waitForWork()") \
+    X(LOOP_IDLE_MS,          "loop_idle_milliseconds_total", "Time the task calling handle() spent blocked in waitForWork()")
+
+// Current values: X(id, name, help). Heap and uptime are sampled by
+// Metrics::capture(), the rest is set by their owners.
+#define METRIC_GAUGES(X) \
+    X(HEAP_FREE,          "heap_free_bytes",               "Free heap") \
+    X(HEAP_MIN_FREE,      "heap_min_free_bytes",           "Lowest free heap since boot") \
+    X(HEAP_LARGEST_BLOCK, "heap_largest_free_block_bytes", "Largest block that can be allocated") \
+    X(UPTIME,             "uptime_seconds",                "Time since boot") \
+    X(WIFI_CONNECTED,     "wifi_connected",                "1 while the station has an IP") \
+    X(WIFI_RSSI,          "wifi_rssi_dbm",                 "Station signal strength, 0 when not connected") \
+    X(PORTAL_ACTIVE,      "captive_active",                "1 while the captive portal is up") \
+    X(CONFIG_VERSION,     "config_version",                "Published configuration version") \
+    X(UPLOAD_BACKLOG,     "upload_backlog_records",        "Records in the upload log not yet acknowledged") \
+    X(HTTP_CONNECTIONS,   "http_connections",              "Requests being handled or sent")
+
+// Fixed-bucket histograms of durations: X(id, name, help, upper bounds in
+// microseconds). Exactly METRIC_BUCKETS bounds each, +Inf is implicit.
+#define METRIC_BUCKETS 8
+#define METRIC_HISTOGRAMS(X) \
+    X(WIFI_CONNECT, "wifi_connect_duration_seconds", "Connection cycles from start to IP", \
+      250000, 500000, 1000000, 2000000, 4000000, 8000000, 15000000, 30000000) \
+    X(HTTP_HANDLER, "http_handler_duration_seconds", "Time spent in web server handlers", \
+      100, 250, 500, 1000, 2500, 5000, 10000, 50000) \
+    X(NVS_WRITE,    "nvs_write_duration_seconds",    "Configuration image writes to NVS", \
+      1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000) \
+    X(TELEGRAM_POST, "telegram_post_duration_seconds", "sendMessage round trips, connection setup included", \
+      50000, 100000, 250000, 500000, 1000000, 2000000, 4000000, 8000000) \
+    X(UPLOAD_POST,   "upload_post_duration_seconds",   "Upload round trips, connection setup included", \
+      50000, 100000, 250000, 500000, 1000000, 2000000, 4000000, 8000000)
+
+#define METRIC_ENUM_ENTRY(id, ...) id,
+
+enum class MetricCounter : uint8_t { METRIC_COUNTERS(METRIC_ENUM_ENTRY) COUNT };
+enum class MetricGauge : uint8_t { METRIC_GAUGES(METRIC_ENUM_ENTRY) COUNT };
+enum class MetricHistogram : uint8_t { METRIC_HISTOGRAMS(METRIC_ENUM_ENTRY) COUNT };
+
+struct HistogramData {
+    uint32_t buckets[METRIC_BUCKETS + 1];  // Per bucket, not cumulative; last is +Inf
+    uint32_t count;
+    uint64_t sum_us;
+};
+
+struct TaskStackSample {
+    char name[16];
+    uint32_t free_bytes;
+};
+
+// Everything one scrape exports, copied at once so that a response rendered
+// in several chunks stays consistent
+struct MetricsSnapshot {
+    uint32_t counters[(size_t)MetricCounter::COUNT];
+    int32_t gauges[(size_t)MetricGauge::COUNT];
+    HistogramData histograms[(size_t)MetricHistogram::COUNT];
+    TaskStackSample tasks[METRICS_MAX_TASKS];
+    uint8_t task_count;
+};
+
+// Process-wide registry in static memory. Updates are lock-free (counters,
+// gauges) or a short critical section (histograms) and safe from any task;
+// nothing here allocates.
+namespace Metrics {
+    void count(MetricCounter counter, uint32_t n = 1);
+    void set(MetricGauge gauge, int32_t value);
+    void observe(MetricHistogram histogram, uint32_t micros);
+
+    // Tasks must be unwatched before they are deleted; unwatchTask() waits
+    // for a capture that is reading them
+    void watchTask(TaskHandle_t task);
+    void unwatchTask(TaskHandle_t task);
+
+    void capture(MetricsSnapshot& snapshot);
+
+    // Prometheus text exposition of a snapshot, bytes [offset, offset + size).
+    // Returns the number written, 0 past the end. Suits chunked responses.
+    size_t render(const MetricsSnapshot& snapshot, char* buffer, size_t size, size_t offset);
+}
+
+// Observes the lifetime of a scope into a histogram
+class MetricTimer {
+    MetricHistogram histogram;
+    uint32_t started;
+
+public:
+    explicit MetricTimer(MetricHistogram h) : histogram(h), started(micros()) {}
+    ~MetricTimer() { Metrics::observe(histogram, micros() - started); }
+};
+
+#endif // METRICS_H
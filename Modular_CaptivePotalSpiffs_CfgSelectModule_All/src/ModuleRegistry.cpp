@@ -0,0 +1,116 @@
+#include "ModuleRegistry.h"
+#include "Log.h"
+
+bool ModuleRegistry::add(ConfigSection section, PortalModuleFactory create) {
+    if (count >= MAX_PORTAL_MODULES || !create || hasSection(section)) {
+        return false;
+    }
+    entries[count++] = { section, create, nullptr, 0, false };
+    return true;
+}
+
+bool ModuleRegistry::hasSection(ConfigSection section) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].section == section) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The section's "active" flag; a section without one is always enabled
+bool ModuleRegistry::sectionEnabled(const ConfigData& config, ConfigSection section) {
+    bool enabled = true;
+    forEachConfigField([&](const ConfigField& field) {
+        if (field.section == section && field.type == ConfigFieldType::BOOL && strcmp(field.key, "active") == 0) {
+            enabled = configField<bool>(config, field);
+        }
+    });
+    return enabled;
+}
+
+// FNV-1a over the section's field values
+uint32_t ModuleRegistry::sectionHash(const ConfigData& config, ConfigSection section) {
+    uint32_t hash = 2166136261u;
+    forEachConfigField([&](const ConfigField& field) {
+        if (field.section != section) {
+            return;
+        }
+        const uint8_t* value = &configField<uint8_t>(config, field);
+        size_t length = field.type == ConfigFieldType::BOOL ? 1 : strlen(configString(config, field)) + 1;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= value[i];
+            hash *= 16777619u;
+        }
+    });
+    return hash;
+}
+
+void ModuleRegistry::stop(Entry& entry) {
+    if (entry.instance) {
+        entry.instance->end();
+        delete entry.instance;
+        entry.instance = nullptr;
+        LOG_I("Module %s stopped", CONFIG_SECTION_TABLE[(size_t)entry.section].key);
+    }
+    entry.applied = false;
+}
+
+void ModuleRegistry::update(const ConfigData& config, bool start) {
+    for (uint8_t i = 0; i < count; i++) {
+        Entry& entry = entries[i];
+        if (!sectionEnabled(config, entry.section)) {
+            stop(entry);
+            continue;
+        }
+        uint32_t hash = sectionHash(config, entry.section);
+        if (entry.applied && entry.section_hash == hash) {
+            continue;
+        }
+        stop(entry);
+        if (!start) {
+            continue;
+        }
+        entry.section_hash = hash;
+        entry.applied = true;
+        const char* name = CONFIG_SECTION_TABLE[(size_t)entry.section].key;
+        PortalModule* module = entry.create();
+        if (!module) {
+            LOG_E("Module %s could not be allocated", name);
+            continue;
+        }
+        module->wake_group = wake_group;
+        module->wake_bits = wake_bits;
+        if (!module->begin(config)) {
+            LOG_W("Module %s failed to start", name);
+            delete module;
+            continue;
+        }
+        entry.instance = module;
+        LOG_I("Module %s started", name);
+    }
+}
+
+void ModuleRegistry::run() {
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].instance) {
+            entries[i].instance->run();
+        }
+    }
+}
+
+void ModuleRegistry::stopAll() {
+    for (uint8_t i = 0; i < count; i++) {
+        stop(entries[i]);
+    }
+}
+
+uint8_t ModuleRegistry::running() const {
+    uint8_t active = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].instance) {
+            active++;
+        }
+    }
+    return active;
+}
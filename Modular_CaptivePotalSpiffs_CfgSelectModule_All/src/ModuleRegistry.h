@@ -0,0 +1,57 @@
+#ifndef MODULE_REGISTRY_H
+#define MODULE_REGISTRY_H
+
+#include <Arduino.h>
+#include "PortalModule.h"
+
+// Modules that can be registered with one portal
+#ifndef MAX_PORTAL_MODULES
+#define MAX_PORTAL_MODULES 4
+#endif
+
+// Registered modules and the instances of the enabled ones. Registration
+// only stores the factory; update() constructs, restarts and deletes
+// instances as the config changes. Only used from the task calling handle(),
+// apart from hasSection(), which is fixed once begin() has run.
+class ModuleRegistry {
+private:
+    struct Entry {
+        ConfigSection section;
+        PortalModuleFactory create;
+        PortalModule* instance;
+        uint32_t section_hash;  // Of the section the instance was started with
+        bool applied;           // section_hash is current, even if begin() failed
+    };
+
+    Entry entries[MAX_PORTAL_MODULES];
+    uint8_t count;
+    EventGroupHandle_t wake_group;
+    EventBits_t wake_bits;
+
+    static bool sectionEnabled(const ConfigData& config, ConfigSection section);
+    static uint32_t sectionHash(const ConfigData& config, ConfigSection section);
+    static void stop(Entry& entry);
+
+public:
+    ModuleRegistry() : count(0), wake_group(nullptr), wake_bits(0) {}
+    ~ModuleRegistry() { stopAll(); }
+
+    // One module per section; false when full or the section is taken
+    bool add(ConfigSection section, PortalModuleFactory create);
+
+    // Bits set in group by a module's requestRun(), for modules started later
+    void wakeOnRequest(EventGroupHandle_t group, EventBits_t bits) { wake_group = group; wake_bits = bits; }
+
+    uint8_t size() const { return count; }
+    bool hasSection(ConfigSection section) const;
+
+    // Stops modules that were disabled or whose settings changed; starts
+    // enabled ones that are not running if start is set
+    void update(const ConfigData& config, bool start);
+
+    void run();
+    void stopAll();
+    uint8_t running() const;
+};
+
+#endif // MODULE_REGISTRY_H
@@ -0,0 +1,141 @@
+#include "PortalAdmission.h"
+#include "Metrics.h"
+#include "Log.h"
+
+PortalAdmission::PortalAdmission() : open(0) {
+    portMUX_INITIALIZE(&lock);
+    memset(clients, 0, sizeof(clients));
+}
+
+// Slot of address, or a free or idle one taken over; null when every slot
+// has connections open
+PortalAdmission::ClientSlot* PortalAdmission::slotFor(uint32_t address, uint32_t now) {
+    ClientSlot* oldest = nullptr;
+    for (size_t i = 0; i < HTTP_CLIENT_SLOTS; i++) {
+        ClientSlot& slot = clients[i];
+        if (slot.address == address) {
+            return &slot;
+        }
+        if (slot.open > 0) {
+            continue;
+        }
+        if (!oldest || slot.address == 0 ||
+            (oldest->address != 0 && now - slot.refilled_ms > now - oldest->refilled_ms)) {
+            oldest = &slot;
+        }
+    }
+    if (oldest) {
+        oldest->address = address;
+        oldest->refilled_ms = now;
+        oldest->tokens = HTTP_RATE_BURST;
+    }
+    return oldest;
+}
+
+Admission PortalAdmission::admit(uint32_t address, bool held) {
+    // Checked first: a starving device answers without touching anything else
+    if (ESP.getFreeHeap() < HTTP_MIN_FREE_HEAP || ESP.getMaxAllocHeap() < HTTP_MIN_LARGEST_BLOCK) {
+        Metrics::count(MetricCounter::HTTP_SHED_MEMORY);
+        return Admission::LOW_MEMORY;
+    }
+
+    Admission verdict = Admission::ADMITTED;
+    uint32_t now = millis();
+    portENTER_CRITICAL(&lock);
+    ClientSlot* slot = held && open >= HTTP_MAX_CONNECTIONS ? nullptr : slotFor(address, now);
+    if (!slot) {
+        verdict = Admission::BUSY;
+    } else {
+        // Whole tokens only, the remainder keeps accruing
+        uint32_t earned = (now - slot->refilled_ms) * HTTP_RATE_PER_S / 1000;
+        if (earned > 0) {
+            slot->tokens = min((uint32_t)HTTP_RATE_BURST, slot->tokens + earned);
+            slot->refilled_ms = slot->tokens == HTTP_RATE_BURST ? now : slot->refilled_ms + earned * 1000 / HTTP_RATE_PER_S;
+        }
+        if (held && slot->open >= HTTP_MAX_CONNECTIONS_PER_CLIENT) {
+            verdict = Admission::CLIENT_BUSY;
+        } else if (slot->tokens == 0) {
+            verdict = Admission::RATE_LIMITED;
+        } else {
+            slot->tokens--;
+            if (held) {
+                slot->open++;
+                open++;
+            }
+        }
+    }
+    uint8_t connections = open;
+    portEXIT_CRITICAL(&lock);
+
+    switch (verdict) {
+        case Admission::ADMITTED:
+            Metrics::set(MetricGauge::HTTP_CONNECTIONS, connections);
+            break;
+        case Admission::BUSY:
+            Metrics::count(MetricCounter::HTTP_SHED_BUSY);
+            break;
+        default:
+            Metrics::count(MetricCounter::HTTP_SHED_CLIENT);
+            break;
+    }
+    return verdict;
+}
+
+void PortalAdmission::release(uint32_t address) {
+    portENTER_CRITICAL(&lock);
+    for (size_t i = 0; i < HTTP_CLIENT_SLOTS; i++) {
+        if (clients[i].address == address && clients[i].open > 0) {
+            clients[i].open--;
+            open--;
+            break;
+        }
+    }
+    uint8_t connections = open;
+    portEXIT_CRITICAL(&lock);
+    Metrics::set(MetricGauge::HTTP_CONNECTIONS, connections);
+}
+
+int PortalAdmission::statusCode(Admission verdict) {
+    switch (verdict) {
+        case Admission::ADMITTED:     return 200;
+        case Admission::CLIENT_BUSY:
+        case Admission::RATE_LIMITED: return 429;
+        case Admission::BUSY:
+        case Admission::LOW_MEMORY:   return 503;
+    }
+    return 503;
+}
+
+// Runs once per request, after its headers and before any body. Refused
+// requests keep their verdict in _tempObject for handleRequest().
+bool AdmissionHandler::canHandle(AsyncWebServerRequest *request) const {
+    uint32_t address = request->client()->remoteIP();
+    // By route: an Accept header is the client's to choose
+    bool held = !(stream_url && request->method() == HTTP_GET && request->url().equals(stream_url));
+    Admission verdict = admission->admit(address, held);
+    if (verdict == Admission::ADMITTED) {
+        if (held) {
+            PortalAdmission* counted = admission;
+            request->onDisconnect([counted, address]() {
+                counted->release(address);
+            });
+        }
+        return false;
+    }
+    request->_tempObject = malloc(sizeof(Admission));
+    if (request->_tempObject) {
+        *(Admission*)request->_tempObject = verdict;
+    }
+    return true;
+}
+
+// No body, no content type: the cheapest response the library can send
+void AdmissionHandler::handleRequest(AsyncWebServerRequest *request) {
+    Admission verdict = request->_tempObject ? *(Admission*)request->_tempObject : Admission::LOW_MEMORY;
+    char retry[12];
+    snprintf(retry, sizeof(retry), "%u", (unsigned)HTTP_RETRY_AFTER_S);
+    AsyncWebServerResponse *response = request->beginResponse(PortalAdmission::statusCode(verdict));
+    response->addHeader("Retry-After", retry);
+    request->send(response);
+    LOG_D("Refused %s with %d", request->url().c_str(), PortalAdmission::statusCode(verdict));
+}
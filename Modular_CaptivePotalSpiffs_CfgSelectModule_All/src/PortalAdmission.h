@@ -0,0 +1,101 @@
+#ifndef PORTAL_ADMISSION_H
+#define PORTAL_ADMISSION_H
+
+#include <Arduino.h>
+#include "ESPAsyncWebServer.h"
+#include <freertos/FreeRTOS.h>
+
+// Requests being handled or sent at once, over all clients and per client.
+// Each one holds a connection, its buffers in AsyncTCP and the response.
+#ifndef HTTP_MAX_CONNECTIONS
+#define HTTP_MAX_CONNECTIONS 8
+#endif
+#ifndef HTTP_MAX_CONNECTIONS_PER_CLIENT
+#define HTTP_MAX_CONNECTIONS_PER_CLIENT 4
+#endif
+
+// Per-client token bucket: sustained requests per second and burst size
+#ifndef HTTP_RATE_PER_S
+#define HTTP_RATE_PER_S 10
+#endif
+#ifndef HTTP_RATE_BURST
+#define HTTP_RATE_BURST 20
+#endif
+
+// Clients tracked, least recently seen idle one is replaced
+#ifndef HTTP_CLIENT_SLOTS
+#define HTTP_CLIENT_SLOTS 8
+#endif
+
+// Below either watermark every request is answered 503 at once
+#ifndef HTTP_MIN_FREE_HEAP
+#define HTTP_MIN_FREE_HEAP 20000
+#endif
+#ifndef HTTP_MIN_LARGEST_BLOCK
+#define HTTP_MIN_LARGEST_BLOCK 6144
+#endif
+
+// Retry-After of refused requests
+#ifndef HTTP_RETRY_AFTER_S
+#define HTTP_RETRY_AFTER_S 2
+#endif
+
+enum class Admission : uint8_t {
+    ADMITTED,
+    BUSY,          // HTTP_MAX_CONNECTIONS reached, 503
+    CLIENT_BUSY,   // Client at HTTP_MAX_CONNECTIONS_PER_CLIENT, 429
+    RATE_LIMITED,  // Client out of tokens, 429
+    LOW_MEMORY     // Heap below a watermark, 503
+};
+
+// Admission control of the portal web server. Decides from the client
+// address and the heap before a request is handled, and counts admitted
+// requests until their connection closes. State lives as long as the
+// portal; the server's handlers come and go with server.reset().
+class PortalAdmission {
+    struct ClientSlot {
+        uint32_t address;  // 0: free
+        uint32_t refilled_ms;
+        uint16_t tokens;
+        uint8_t open;      // Admitted, not yet closed
+    };
+
+    portMUX_TYPE lock;
+    ClientSlot clients[HTTP_CLIENT_SLOTS];
+    uint8_t open;
+
+    ClientSlot* slotFor(uint32_t address, uint32_t now);
+
+public:
+    PortalAdmission();
+
+    // ADMITTED requests must be released once; held: counts as an open
+    // connection (event streams are handed over and only rate limited)
+    Admission admit(uint32_t address, bool held = true);
+    void release(uint32_t address);
+
+    uint8_t openConnections() const { return open; }
+
+    static int statusCode(Admission verdict);
+};
+
+// First handler of the server: claims the requests admission refuses, so
+// their bodies are discarded and no route runs, and leaves the rest to the
+// routes. Admitted requests are released from their onDisconnect hook; the
+// library keeps one per request, so a route that sets its own must call
+// release() in it. A GET of streamUrl, the event source, is not held: it
+// stays open for as long as the page does. Owned by the server like any
+// handler.
+class AdmissionHandler : public AsyncWebHandler {
+    PortalAdmission* admission;
+    const char* stream_url;
+
+public:
+    explicit AdmissionHandler(PortalAdmission& admission, const char* streamUrl = nullptr)
+        : admission(&admission), stream_url(streamUrl) {}
+
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+};
+
+#endif // PORTAL_ADMISSION_H
@@ -0,0 +1,17 @@
+#ifndef PORTAL_ASSET_H
+#define PORTAL_ASSET_H
+
+#include <Arduino.h>
+
+// A static web asset served straight from flash.
+// Generated assets (see scripts/embed_web_assets.py) are gzipped; custom
+// pages set at runtime are served as-is.
+struct PortalAsset {
+    const uint8_t* data;
+    size_t length;
+    const char* etag;          // Strong ETag, including the quotes
+    const char* content_type;
+    bool gzipped;
+};
+
+#endif // PORTAL_ASSET_H
@@ -0,0 +1,293 @@
+// Generated by scripts/embed_web_assets.py from web/ - do not edit.
+#ifndef PORTAL_ASSETS_H
+#define PORTAL_ASSETS_H
+
+#include "PortalAsset.h"
+
+// index.html: 5431 bytes, 2010 gzipped
+static const uint8_t PORTAL_ASSET_INDEX_HTML_DATA[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x58, 0xfb, 0x6f, 0xdb, 0x46,
+    0x12, 0xfe, 0xdd, 0x7f, 0xc5, 0x94, 0xc1, 0x95, 0x12, 0x6c, 0x3d, 0x6c, 0xcb, 0xc9, 0x45, 0xaf,
+    0x22, 0x71, 0x53, 0x5c, 0x81, 0xd6, 0x35, 0x6a, 0x03, 0xc5, 0x21, 0x08, 0x8a, 0x15, 0xb9, 0x12,
+    0xf7, 0x42, 0x72, 0xd9, 0xdd, 0xa5, 0x6d, 0x5d, 0xe0, 0xff, 0xbd, 0x33, 0xfb, 0xa0, 0x48, 0x59,
+    0x76, 0x13, 0x08, 0xb0, 0x45, 0xee, 0xec, 0x37, 0xb3, 0xdf, 0x3c, 0x57, 0xf3, 0xef, 0x7e, 0xfc,
+    0xed, 0xf2, 0xf6, 0xbf, 0xd7, 0x1f, 0xe0, 0x3f, 0xb7, 0xbf, 0xfe, 0xb2, 0x9c, 0x67, 0xa6, 0xc8,
+    0xf1, 0x2f, 0x67, 0xe9, 0xf2, 0x68, 0x6e, 0x84, 0xc9, 0xf9, 0xf2, 0xc3, 0xcd, 0xf5, 0xf9, 0x19,
+    0x5c, 0xca, 0x72, 0x2d, 0x36, 0xb5, 0x62, 0x46, 0xc8, 0x12, 0xae, 0xa5, 0x32, 0x2c, 0x9f, 0x8f,
+    0x9c, 0xc4, 0xd1, 0xbc, 0xe0, 0x86, 0x41, 0xc9, 0x0a, 0xbe, 0x88, 0xee, 0x04, 0xbf, 0xaf, 0x70,
+    0x39, 0x82, 0x44, 0x96, 0x86, 0x97, 0x66, 0x11, 0xdd, 0x8b, 0xd4, 0x64, 0x8b, 0x94, 0xdf, 0x89,
+    0x84, 0x0f, 0xec, 0xc3, 0x09, 0x88, 0x52, 0x18, 0xc1, 0xf2, 0x81, 0x4e, 0x58, 0xce, 0x17, 0xa7,
+    0x11, 0x82, 0x68, 0xb3, 0x25, 0xb0, 0x95, 0x4c, 0xb7, 0xf0, 0x05, 0xd6, 0xb8, 0x7b, 0xb0, 0x66,
+    0x85, 0xc8, 0xb7, 0x53, 0x78, 0xa7, 0x50, 0xf6, 0x04, 0x34, 0x2b, 0xf5, 0x40, 0x73, 0x25, 0xd6,
+    0x33, 0x28, 0x98, 0xda, 0x88, 0x72, 0x0a, 0x67, 0xe3, 0xea, 0x61, 0x06, 0x2b, 0x96, 0x7c, 0xde,
+    0x28, 0x59, 0x97, 0xe9, 0x20, 0x91, 0xb9, 0x54, 0x53, 0x78, 0xb5, 0x1e, 0xd3, 0x67, 0x06, 0x8f,
+    0x47, 0x43, 0xb2, 0x84, 0x89, 0x92, 0x2b, 0xc4, 0x7d, 0x2a, 0x79, 0x9f, 0x09, 0xc3, 0x67, 0x50,
+    0xb1, 0x34, 0x15, 0xe5, 0xa6, 0x41, 0x94, 0x2a, 0xe5, 0x6a, 0xa0, 0x58, 0x2a, 0x6a, 0x3d, 0x85,
+    0x53, 0xff, 0xf2, 0x61, 0xa0, 0x33, 0x96, 0xca, 0xfb, 0x29, 0x8c, 0xe1, 0xac, 0x7a, 0xb0, 0xef,
+    0x41, 0x6d, 0x56, 0xac, 0x37, 0x3e, 0xb1, 0x9f, 0xe1, 0x69, 0xdf, 0xea, 0xd4, 0x3c, 0xb1, 0x54,
+    0x7d, 0xf1, 0x96, 0x0e, 0x56, 0xd2, 0x18, 0x59, 0x20, 0xfc, 0x05, 0x21, 0x35, 0xda, 0x4e, 0x2f,
+    0x76, 0xda, 0xf0, 0x09, 0xd1, 0xb4, 0xcc, 0x45, 0x0a, 0xaf, 0xd2, 0x34, 0x7d, 0x62, 0x85, 0x95,
+    0x6d, 0x81, 0x67, 0x93, 0x1d, 0xbe, 0x91, 0x15, 0x1a, 0x35, 0x83, 0x70, 0xfe, 0xf3, 0xf3, 0x73,
+    0x92, 0x15, 0x65, 0x55, 0x9b, 0x8f, 0x66, 0x5b, 0xa1, 0x6f, 0x0c, 0x7f, 0x30, 0xd1, 0x27, 0x22,
+    0x7f, 0xf7, 0xae, 0x62, 0x5a, 0xdf, 0xa3, 0x96, 0xfd, 0xf7, 0xb5, 0xca, 0xa3, 0x4f, 0x88, 0x6e,
+    0xfd, 0x45, 0xe7, 0x1f, 0xff, 0xab, 0x65, 0xf5, 0xbf, 0xc9, 0x90, 0xe0, 0x02, 0xb4, 0x8a, 0x14,
+    0x7f, 0xe5, 0x19, 0x26, 0xee, 0x0c, 0x6d, 0x5d, 0x49, 0xc6, 0x93, 0xcf, 0xc8, 0xad, 0x55, 0xe8,
+    0x8f, 0xa3, 0xc4, 0x26, 0x33, 0x81, 0xf7, 0xc7, 0xa3, 0x9c, 0xad, 0x78, 0x8e, 0xab, 0xa9, 0xd0,
+    0x55, 0xce, 0x30, 0x24, 0x56, 0xb9, 0x4c, 0x3e, 0x3f, 0xb1, 0x01, 0xb9, 0xb9, 0x17, 0x6b, 0x31,
+    0xa8, 0x94, 0x5c, 0x8b, 0x9c, 0x1f, 0xf4, 0xf7, 0xab, 0xf5, 0x5b, 0xfa, 0xec, 0xf6, 0x5a, 0x1f,
+    0x8e, 0xdb, 0x3e, 0x39, 0x14, 0x01, 0x0d, 0xf7, 0xf5, 0xaa, 0x10, 0x66, 0xb0, 0x32, 0xe5, 0x61,
+    0xf4, 0xc9, 0xe5, 0xbb, 0x9f, 0x2e, 0x76, 0x7e, 0xd8, 0x8f, 0xae, 0x53, 0x8a, 0x9a, 0x76, 0x88,
+    0x4d, 0xa1, 0x94, 0x25, 0x3f, 0x4c, 0x53, 0x52, 0x2b, 0x4d, 0x20, 0x95, 0x14, 0x98, 0x4b, 0x6a,
+    0xe6, 0xb2, 0x42, 0x8b, 0xff, 0x73, 0x04, 0x7a, 0xfd, 0xc4, 0xa0, 0x69, 0x26, 0xef, 0x9e, 0x09,
+    0xf2, 0x57, 0x93, 0x0b, 0x36, 0x9e, 0xbc, 0xb5, 0x1b, 0xd0, 0x14, 0x92, 0x3e, 0x81, 0xa1, 0xe2,
+    0x05, 0xee, 0x78, 0x72, 0x96, 0xae, 0x49, 0x1d, 0x8f, 0x32, 0xc6, 0x0e, 0x9b, 0xda, 0x1c, 0x70,
+    0xe2, 0xb3, 0xe2, 0x80, 0xf5, 0x5d, 0xaf, 0x97, 0x75, 0xb1, 0xe2, 0xaa, 0x1d, 0x64, 0xaf, 0xc7,
+    0x1d, 0xa4, 0xd7, 0xdf, 0x90, 0x19, 0x3e, 0xaa, 0x86, 0x19, 0xaa, 0x42, 0xc0, 0x70, 0xea, 0x37,
+    0x6f, 0xde, 0x74, 0x49, 0x3b, 0x77, 0x72, 0xf3, 0x91, 0xaf, 0x36, 0xf3, 0x91, 0x2d, 0x76, 0x73,
+    0xaa, 0x3a, 0xf8, 0x94, 0x8a, 0x3b, 0x48, 0x72, 0x4c, 0x09, 0x0c, 0xca, 0x50, 0x34, 0xa8, 0x36,
+    0x65, 0x67, 0x2f, 0xd6, 0x41, 0x5c, 0x3e, 0x9a, 0xaf, 0xa5, 0x2a, 0x80, 0xd9, 0xc4, 0x5c, 0x44,
+    0x23, 0xcd, 0xee, 0x78, 0x04, 0x58, 0x18, 0x33, 0x99, 0x2e, 0xa2, 0xeb, 0xdf, 0x6e, 0x6e, 0xa3,
+    0x2e, 0xbe, 0xcf, 0x61, 0x8b, 0x3e, 0x59, 0xfe, 0x21, 0x7e, 0x12, 0x70, 0xc5, 0x0d, 0xa6, 0xe2,
+    0x67, 0x8d, 0x80, 0x13, 0x2f, 0x2c, 0x70, 0xb3, 0x0f, 0x66, 0x1d, 0x2d, 0xe7, 0x23, 0x7c, 0x47,
+    0x2b, 0x0c, 0xd5, 0x0a, 0x6d, 0xec, 0x72, 0xe9, 0x77, 0xd9, 0x65, 0xbf, 0x80, 0x32, 0xab, 0x1a,
+    0xeb, 0x4d, 0x09, 0x8e, 0x6b, 0xf7, 0x10, 0x05, 0xdd, 0x3e, 0x02, 0x22, 0xbb, 0x9f, 0x1e, 0xbc,
+    0x8a, 0x68, 0x79, 0x0c, 0xef, 0xd2, 0x14, 0x3c, 0xe4, 0x7c, 0xe4, 0xf6, 0x21, 0x5a, 0x15, 0xb6,
+    0x12, 0xc1, 0xd1, 0xf2, 0x36, 0xe3, 0xa0, 0x8d, 0x92, 0xe5, 0x86, 0xa3, 0x15, 0x8a, 0xb3, 0x24,
+    0x63, 0x2b, 0xcc, 0x37, 0xbf, 0x11, 0x84, 0x86, 0x5a, 0x73, 0x74, 0x53, 0x86, 0x69, 0x8c, 0x21,
+    0x59, 0x29, 0x21, 0x95, 0x30, 0x5b, 0xf4, 0x74, 0xa9, 0xc1, 0x08, 0xae, 0x87, 0xf3, 0x51, 0x45,
+    0xf4, 0xfb, 0x03, 0xf9, 0xa3, 0x16, 0x32, 0xad, 0x3b, 0x27, 0xb5, 0x01, 0xe3, 0x0f, 0xe1, 0x02,
+    0x3d, 0x82, 0x3b, 0x96, 0xd7, 0xf8, 0x78, 0x83, 0x0c, 0x77, 0xfd, 0xd1, 0x9c, 0x6f, 0x97, 0x12,
+    0x44, 0xef, 0x88, 0x3c, 0xb3, 0xd3, 0xa5, 0x13, 0x25, 0x2a, 0x64, 0xe8, 0x8e, 0x29, 0x2c, 0x01,
+    0x0f, 0xd7, 0x9e, 0x5d, 0x58, 0xc0, 0x64, 0x66, 0x5f, 0x5a, 0x66, 0x17, 0x90, 0xca, 0xa4, 0x2e,
+    0xb0, 0x81, 0x0d, 0x37, 0xdc, 0x7c, 0xc8, 0x39, 0x7d, 0x7d, 0xbf, 0xfd, 0x39, 0xed, 0xc5, 0xc1,
+    0x1f, 0x71, 0xdf, 0xc9, 0x23, 0x81, 0xef, 0x1d, 0xd9, 0x2f, 0x6c, 0x6a, 0xb1, 0x4c, 0xfb, 0xd6,
+    0x75, 0xe9, 0x4a, 0xb8, 0xe2, 0x2e, 0x0f, 0x7a, 0x7d, 0xf8, 0x72, 0x84, 0x86, 0x42, 0x8f, 0x20,
+    0x05, 0x42, 0x61, 0x0d, 0x11, 0x30, 0xb7, 0xd6, 0x0c, 0x93, 0x4c, 0xe4, 0x29, 0x8a, 0x0e, 0x73,
+    0x5e, 0x6e, 0x4c, 0x86, 0x2b, 0xc7, 0xc7, 0xb4, 0xc1, 0xca, 0x12, 0x45, 0x64, 0x7e, 0x47, 0xf2,
+    0xa3, 0xf8, 0xd4, 0xb2, 0x41, 0xbf, 0xdf, 0xde, 0xb2, 0xcd, 0x15, 0x76, 0xe8, 0x5e, 0x6c, 0xe5,
+    0xc9, 0x06, 0xb7, 0xf1, 0xe3, 0xf8, 0xd3, 0x90, 0x5a, 0x37, 0x02, 0xc4, 0x54, 0x3b, 0xff, 0xd4,
+    0x5a, 0xa4, 0x7f, 0xc6, 0x70, 0x0c, 0xa2, 0x2d, 0xa2, 0xf8, 0x5f, 0xb5, 0x50, 0x3c, 0x45, 0x31,
+    0x34, 0x8e, 0xac, 0x0b, 0x8b, 0xa7, 0x7b, 0xfb, 0x43, 0x47, 0xd9, 0xc3, 0x38, 0xdb, 0x17, 0xf3,
+    0x21, 0x11, 0xc4, 0x1e, 0x8f, 0x1a, 0x1e, 0x87, 0x36, 0x39, 0x87, 0xbe, 0xd6, 0xef, 0x9f, 0xcc,
+    0x73, 0x80, 0xd4, 0xb4, 0xbd, 0xf7, 0x03, 0xc4, 0x31, 0x4c, 0x21, 0xa6, 0xca, 0x15, 0x13, 0x5a,
+    0xc3, 0x30, 0xc2, 0x7a, 0xa9, 0x9e, 0x77, 0x00, 0x31, 0x27, 0xd6, 0xd0, 0x3b, 0x08, 0xbb, 0x5c,
+    0xb4, 0x71, 0xfb, 0xe8, 0x20, 0x53, 0xab, 0xd2, 0x79, 0x5a, 0xc9, 0xfb, 0xb6, 0x8f, 0x13, 0x0c,
+    0x7c, 0xc3, 0x3d, 0xc5, 0xbd, 0x18, 0xc3, 0x8b, 0x68, 0x45, 0xa1, 0xa1, 0x8d, 0xc3, 0xab, 0xd6,
+    0x71, 0x1b, 0xdf, 0xbb, 0x75, 0x51, 0x62, 0x61, 0xa1, 0x91, 0x8b, 0xd6, 0x6f, 0x6e, 0x7e, 0xfe,
+    0x71, 0x0a, 0x9d, 0x50, 0xb7, 0x9d, 0x9a, 0xec, 0x70, 0x46, 0x2d, 0xa2, 0xf3, 0xb3, 0x08, 0x90,
+    0x8c, 0x84, 0x67, 0x32, 0xc7, 0xba, 0xb7, 0x88, 0x7c, 0xad, 0x00, 0x52, 0x12, 0x59, 0x82, 0x5a,
+    0x95, 0x00, 0x58, 0x6d, 0x64, 0x22, 0x8b, 0x2a, 0xe7, 0x06, 0xd1, 0xe4, 0x7a, 0x8d, 0x19, 0xb5,
+    0x52, 0x4b, 0xa4, 0xfa, 0x28, 0xbe, 0xf6, 0xfe, 0xd9, 0x53, 0xd9, 0x0c, 0x02, 0x6d, 0xb5, 0xaf,
+    0x27, 0xcf, 0xa8, 0x0d, 0x20, 0x6d, 0x5c, 0xef, 0xd0, 0x3d, 0x5c, 0x5f, 0xe6, 0xa1, 0x10, 0x58,
+    0x16, 0xc7, 0x16, 0x7d, 0x11, 0xbd, 0x6d, 0xb2, 0x78, 0x1c, 0x2d, 0xc1, 0x6e, 0x7f, 0xb1, 0x60,
+    0xed, 0x1a, 0x55, 0xb4, 0xfc, 0xdd, 0x7e, 0x6f, 0x6a, 0x53, 0x3c, 0xeb, 0x66, 0x01, 0xd1, 0xfb,
+    0xd5, 0x81, 0x8f, 0xd5, 0x03, 0x9d, 0x69, 0x93, 0x47, 0xb2, 0x34, 0xd4, 0xdf, 0x99, 0x8d, 0x8e,
+    0x76, 0xb0, 0x34, 0x1b, 0xac, 0xd5, 0x28, 0xee, 0x17, 0x87, 0x94, 0x2c, 0xed, 0x10, 0xdf, 0x5f,
+    0x0f, 0x51, 0xde, 0x81, 0x1c, 0x66, 0x4c, 0x37, 0x69, 0xd2, 0x87, 0x5d, 0x1e, 0xb5, 0xa8, 0xa6,
+    0xc0, 0xe8, 0x61, 0x08, 0x67, 0x0c, 0x6b, 0x6c, 0xda, 0xb7, 0x21, 0xfd, 0xfc, 0xd1, 0x1c, 0x17,
+    0x71, 0xdf, 0x9d, 0x29, 0xc9, 0x45, 0xf2, 0x19, 0x01, 0x42, 0x0a, 0xd8, 0xda, 0x62, 0x83, 0xdd,
+    0xf1, 0x78, 0x49, 0x21, 0xdf, 0x43, 0xb4, 0xbe, 0x33, 0xeb, 0xbb, 0x43, 0x89, 0xd0, 0x6f, 0x27,
+    0x0e, 0x85, 0x75, 0x53, 0xa8, 0xd0, 0x94, 0x99, 0x83, 0x63, 0x55, 0xc5, 0xcb, 0xb4, 0x0d, 0xd7,
+    0x91, 0x6a, 0x65, 0xf4, 0x61, 0xa3, 0xba, 0x2a, 0x00, 0x61, 0x47, 0x23, 0xf8, 0xd5, 0xf6, 0x00,
+    0xd0, 0xdc, 0x18, 0x1c, 0x03, 0x34, 0x30, 0xc5, 0xa9, 0x4a, 0x22, 0x27, 0x58, 0x7d, 0xd6, 0x4a,
+    0x16, 0x60, 0xb0, 0xfb, 0xb8, 0xeb, 0x44, 0xac, 0x61, 0x2d, 0x78, 0x9e, 0xa2, 0xc0, 0x06, 0x0d,
+    0x52, 0xdb, 0x4e, 0xda, 0xdf, 0xb8, 0x16, 0xdb, 0xf3, 0xad, 0x36, 0x14, 0x4c, 0x6a, 0x36, 0xff,
+    0x98, 0xc5, 0xf8, 0xaf, 0x9b, 0xc5, 0x1e, 0xc4, 0x87, 0x9b, 0xbd, 0xf9, 0xbc, 0x80, 0x92, 0x4d,
+    0x08, 0xc4, 0x4a, 0x0d, 0x29, 0x99, 0x2f, 0xdd, 0x65, 0x08, 0x77, 0x78, 0x9c, 0xa1, 0x5d, 0x73,
+    0x7a, 0xda, 0x34, 0xda, 0xd7, 0xb8, 0x35, 0x88, 0xd9, 0xe3, 0xe9, 0x21, 0x76, 0x86, 0x0f, 0xd8,
+    0x64, 0x7b, 0x0d, 0x7b, 0xf6, 0x7d, 0x38, 0x91, 0x9b, 0x8e, 0x9f, 0xb7, 0xc6, 0xae, 0x87, 0x76,
+    0xe5, 0x92, 0xf3, 0x79, 0xe1, 0x6e, 0x9a, 0x84, 0xa2, 0x6d, 0xf5, 0xd9, 0x07, 0x17, 0x33, 0xee,
+    0x99, 0x92, 0x95, 0xba, 0x41, 0xbc, 0x92, 0x12, 0x15, 0x84, 0x54, 0xf1, 0xef, 0x21, 0x0e, 0x93,
+    0x7d, 0x1c, 0xd0, 0x42, 0x7e, 0xc4, 0xa7, 0xcd, 0x2b, 0x2b, 0x63, 0x1b, 0x8b, 0xc3, 0xb4, 0x22,
+    0x33, 0x37, 0xf1, 0x77, 0xa8, 0xb1, 0xe2, 0xfd, 0x43, 0x2b, 0x7b, 0x47, 0xb9, 0x45, 0xc2, 0xaf,
+    0x64, 0xca, 0xbd, 0x91, 0x56, 0xbe, 0x4f, 0x01, 0x09, 0x3c, 0xd7, 0x7c, 0xdf, 0x48, 0x27, 0x84,
+    0x7c, 0x63, 0xa5, 0xa7, 0x36, 0x12, 0x12, 0x93, 0xda, 0xc9, 0xee, 0x94, 0xc1, 0x5a, 0x2c, 0x5f,
+    0xbf, 0xb8, 0x46, 0x11, 0x76, 0xe2, 0x9b, 0x36, 0x25, 0x0e, 0xc8, 0x67, 0xf5, 0x5e, 0x46, 0x7b,
+    0x09, 0x23, 0x29, 0x94, 0x7f, 0xe8, 0x26, 0x38, 0x35, 0x2f, 0xe4, 0xc4, 0x5a, 0xd8, 0xe5, 0xea,
+    0x1f, 0x68, 0xf9, 0x8a, 0xc3, 0x63, 0x87, 0x8d, 0x11, 0xbe, 0xdf, 0x7f, 0x89, 0xd6, 0xc7, 0x27,
+    0xb1, 0xe8, 0x88, 0xc3, 0x15, 0xca, 0x87, 0xe7, 0x06, 0x1b, 0x3f, 0xb2, 0xc5, 0xfd, 0xae, 0x51,
+    0xe2, 0xce, 0x42, 0xae, 0xb9, 0xc1, 0xa8, 0x8d, 0x47, 0xac, 0x12, 0x23, 0x8d, 0x9e, 0x2e, 0x18,
+    0x0a, 0x62, 0xfe, 0x96, 0xbb, 0x48, 0x56, 0x54, 0x08, 0x5c, 0x97, 0x05, 0x35, 0xfc, 0x9f, 0xa6,
+    0xd2, 0x80, 0xb5, 0x60, 0x5f, 0x8c, 0x46, 0x5b, 0x0a, 0x30, 0xfa, 0x1f, 0x2e, 0xc0, 0xbb, 0xbc,
+    0xd8, 0x65, 0xbb, 0xb7, 0x17, 0x0b, 0xc9, 0x15, 0x67, 0x6a, 0xb5, 0x0d, 0x33, 0xa9, 0x2b, 0x24,
+    0xb2, 0xcc, 0xb7, 0x60, 0x8d, 0x42, 0x0f, 0x60, 0x51, 0xe2, 0xc0, 0x4a, 0xa0, 0x06, 0xec, 0xeb,
+    0x48, 0x33, 0xb8, 0xa2, 0x72, 0xc2, 0x70, 0x65, 0x06, 0x85, 0xf4, 0x3d, 0x57, 0x1a, 0x2f, 0x6e,
+    0x67, 0x74, 0xa3, 0xc3, 0xd4, 0x17, 0xd8, 0x6c, 0x74, 0x82, 0x9b, 0x71, 0x87, 0x36, 0x22, 0xcf,
+    0x41, 0xd5, 0x65, 0x89, 0x05, 0xcb, 0xe6, 0x58, 0xd0, 0xf9, 0x3b, 0x4e, 0x4d, 0x38, 0x21, 0xbb,
+    0xe8, 0x66, 0xe8, 0xda, 0xd6, 0xe4, 0xd7, 0xee, 0x38, 0xbd, 0x30, 0x92, 0x3c, 0xd9, 0xb8, 0x1b,
+    0x40, 0x0e, 0x61, 0x1a, 0x45, 0x31, 0x61, 0x87, 0x50, 0x63, 0x78, 0x51, 0xd9, 0x0e, 0x88, 0xa3,
+    0x59, 0x43, 0x1b, 0x5e, 0xbe, 0xf2, 0xdc, 0xcd, 0x96, 0xde, 0x13, 0x64, 0xb4, 0x65, 0xf9, 0xa0,
+    0x23, 0x8e, 0xf6, 0x1c, 0x71, 0xd8, 0x09, 0xc1, 0x5d, 0x5f, 0x80, 0x3c, 0x6e, 0x2f, 0x6b, 0x0a,
+    0xc3, 0x9a, 0x19, 0x6a, 0xa5, 0x0b, 0x62, 0xe9, 0x04, 0x48, 0x74, 0x6a, 0xff, 0x62, 0x5d, 0x87,
+    0x47, 0xeb, 0x96, 0x7d, 0x85, 0x5c, 0xd7, 0xb9, 0x69, 0xca, 0x72, 0xb8, 0xd4, 0xbc, 0x30, 0x45,
+    0x07, 0x0e, 0x6c, 0x85, 0xf6, 0xf2, 0xdd, 0x61, 0x8a, 0x06, 0x2c, 0x0b, 0x3b, 0xb4, 0x81, 0x12,
+    0x36, 0x3c, 0x2d, 0xa0, 0x7e, 0x25, 0x68, 0x97, 0x95, 0xa5, 0xeb, 0xf9, 0xb2, 0xe8, 0x04, 0x48,
+    0xb1, 0xfb, 0xd6, 0xa4, 0xa7, 0x07, 0xf2, 0xa3, 0x80, 0x5f, 0x0c, 0x15, 0x39, 0x2c, 0x2a, 0x5c,
+    0xa5, 0x2c, 0x84, 0xf4, 0x7d, 0x41, 0x03, 0x6f, 0xaf, 0xd9, 0xc5, 0xf1, 0x9a, 0xcc, 0x9b, 0xf1,
+    0xf5, 0x04, 0x0d, 0xe1, 0x65, 0xe7, 0x78, 0xed, 0xb4, 0x72, 0xe8, 0x3e, 0xc4, 0x29, 0x5e, 0xfc,
+    0x59, 0xbd, 0x1b, 0xe0, 0xfb, 0xef, 0xe1, 0xf8, 0xb8, 0x09, 0x85, 0x39, 0x9c, 0x5e, 0xf4, 0xa9,
+    0x91, 0xde, 0x8a, 0x82, 0xcb, 0xda, 0xf4, 0x28, 0x18, 0x4e, 0xf0, 0xe5, 0x78, 0xec, 0xdc, 0x91,
+    0x30, 0xd3, 0xa6, 0x84, 0x3c, 0xfb, 0x7c, 0xe4, 0x7a, 0x1f, 0xf6, 0x3a, 0x79, 0x4d, 0xb3, 0xed,
+    0x28, 0x5c, 0x88, 0x9e, 0x0f, 0xab, 0x6f, 0xc8, 0xef, 0xee, 0x95, 0xcc, 0x3a, 0xd1, 0x56, 0x58,
+    0xfb, 0xad, 0xd1, 0xd4, 0xca, 0x7b, 0x2f, 0xfd, 0x2d, 0xb3, 0xcc, 0xe1, 0xa3, 0xef, 0x0d, 0x23,
+    0x28, 0x37, 0x1f, 0x85, 0xcb, 0x22, 0x8e, 0x9b, 0xf4, 0x0b, 0x01, 0xde, 0xcc, 0xe9, 0x17, 0xd2,
+    0xbf, 0x01, 0xf9, 0x53, 0xaf, 0xa1, 0x37, 0x15, 0x00, 0x00,
+};
+static const PortalAsset PORTAL_ASSET_INDEX_HTML = {
+    PORTAL_ASSET_INDEX_HTML_DATA, sizeof(PORTAL_ASSET_INDEX_HTML_DATA), "\"8790a8ebf4029e8a\"", "text/html", true
+};
+
+// success.html: 2000 bytes, 973 gzipped
+static const uint8_t PORTAL_ASSET_SUCCESS_HTML_DATA[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x55, 0x6d, 0x6f, 0x22, 0x37,
+    0x10, 0xfe, 0xce, 0xaf, 0x98, 0xd0, 0x0f, 0xbb, 0xa8, 0xb0, 0xbc, 0x44, 0x6d, 0x4f, 0x2c, 0x50,
+    0x25, 0x1c, 0x69, 0xd3, 0xe6, 0xc8, 0xa9, 0x89, 0x54, 0xf5, 0x53, 0x65, 0xd6, 0xb3, 0xac, 0x15,
+    0x63, 0xef, 0xd9, 0xe6, 0x4d, 0xa7, 0xfc, 0xf7, 0x8e, 0xbd, 0x0b, 0x25, 0x5c, 0x0e, 0x21, 0x21,
+    0x7b, 0x3c, 0x9e, 0x79, 0xe6, 0x99, 0x67, 0xbc, 0xa3, 0xab, 0x8f, 0x8f, 0xd3, 0xe7, 0x7f, 0x3e,
+    0xcf, 0xe0, 0xf7, 0xe7, 0x4f, 0x0f, 0x93, 0x51, 0xe1, 0x56, 0x92, 0xfe, 0x91, 0xf1, 0x49, 0x63,
+    0xb4, 0x42, 0xc7, 0x40, 0xb1, 0x15, 0x8e, 0x9b, 0x1b, 0x81, 0xdb, 0x52, 0x1b, 0xd7, 0x84, 0x4c,
+    0x2b, 0x87, 0xca, 0x8d, 0x9b, 0x5b, 0xc1, 0x5d, 0x31, 0xe6, 0xb8, 0x11, 0x19, 0x76, 0xc2, 0xa6,
+    0x0d, 0x42, 0x09, 0x27, 0x98, 0xec, 0xd8, 0x8c, 0x49, 0x1c, 0xf7, 0x9b, 0x14, 0x44, 0x69, 0x9b,
+    0x19, 0x51, 0xba, 0x49, 0x15, 0xae, 0x70, 0xae, 0xec, 0xe0, 0x97, 0xb5, 0xd8, 0x8c, 0x9b, 0x06,
+    0x73, 0x83, 0xb6, 0x38, 0x89, 0xd9, 0xff, 0xa9, 0x39, 0x19, 0x75, 0x8f, 0x57, 0x1a, 0x23, 0xeb,
+    0xf6, 0x12, 0x27, 0x8d, 0x85, 0xe6, 0x7b, 0xf8, 0x0a, 0x39, 0xf9, 0x75, 0x72, 0xb6, 0x12, 0x72,
+    0x3f, 0x84, 0x1b, 0x43, 0x99, 0xda, 0x60, 0x99, 0xb2, 0x1d, 0x8b, 0x46, 0xe4, 0x29, 0xac, 0x98,
+    0x59, 0x0a, 0x35, 0x84, 0x41, 0xaf, 0xdc, 0xa5, 0xb0, 0x60, 0xd9, 0xcb, 0xd2, 0xe8, 0xb5, 0xe2,
+    0x9d, 0x4c, 0x4b, 0x6d, 0x86, 0xf0, 0x43, 0xde, 0xf3, 0xbf, 0x14, 0x1c, 0xee, 0x5c, 0x87, 0x49,
+    0xb1, 0x24, 0xe7, 0x8c, 0x32, 0xa3, 0x49, 0xe1, 0xb5, 0x91, 0x78, 0x1c, 0x4c, 0x28, 0x34, 0x94,
+    0xeb, 0xdb, 0xdb, 0xdb, 0x42, 0x38, 0x4c, 0xa1, 0x64, 0x9c, 0x0b, 0xb5, 0x1c, 0xc2, 0x75, 0x95,
+    0x45, 0x1b, 0x8e, 0xa6, 0x63, 0x18, 0x17, 0x6b, 0x3b, 0x84, 0x7e, 0x6d, 0xdc, 0x75, 0x6c, 0xc1,
+    0xb8, 0xde, 0x0e, 0xa1, 0x07, 0x83, 0x72, 0x17, 0xec, 0x60, 0x96, 0x0b, 0x16, 0xf7, 0xda, 0xe1,
+    0x97, 0xf4, 0x5b, 0x29, 0x70, 0x61, 0x4b, 0xc9, 0xa8, 0x18, 0xa1, 0x24, 0xe5, 0xed, 0x2c, 0xa4,
+    0xce, 0x5e, 0x02, 0x94, 0x9c, 0x09, 0x89, 0x9c, 0x70, 0x1c, 0xa0, 0x67, 0x3f, 0x0f, 0x3e, 0x0c,
+    0x3e, 0x1c, 0x60, 0x2a, 0xcc, 0xdc, 0x9b, 0xe3, 0x01, 0xfe, 0xc2, 0xaf, 0x07, 0xfe, 0x78, 0xd4,
+    0xad, 0x49, 0x1b, 0x75, 0x43, 0x1f, 0x47, 0x9e, 0x3c, 0xda, 0x71, 0xb1, 0x81, 0x4c, 0x32, 0x6b,
+    0xc7, 0xcd, 0x63, 0x9d, 0xbe, 0x41, 0xc5, 0xf5, 0x64, 0xaa, 0x55, 0x2e, 0x96, 0x6b, 0xc3, 0x9c,
+    0xd0, 0x0a, 0x9e, 0xd8, 0x06, 0xf9, 0x15, 0xdd, 0xbe, 0xa6, 0xd3, 0x12, 0x04, 0x1f, 0x37, 0xad,
+    0x63, 0x6e, 0x6d, 0x9b, 0xde, 0xd1, 0x67, 0xa6, 0xf2, 0xc1, 0x69, 0xf8, 0x5b, 0xdc, 0x09, 0x50,
+    0xe8, 0xb6, 0xda, 0xbc, 0x24, 0x49, 0x32, 0x5a, 0x98, 0xc9, 0x67, 0x89, 0xcc, 0x22, 0x6c, 0x99,
+    0x70, 0x9e, 0x2f, 0x89, 0xe0, 0x0a, 0x84, 0x4a, 0x24, 0x50, 0xe3, 0xb6, 0xc9, 0xa8, 0x5b, 0x1e,
+    0x43, 0x73, 0x52, 0x85, 0x90, 0xcd, 0x03, 0xb4, 0xaa, 0x6e, 0xaf, 0x02, 0xef, 0xd2, 0x25, 0xd0,
+    0x5e, 0x05, 0xb5, 0x1c, 0x36, 0xcc, 0x40, 0x05, 0x05, 0xc6, 0xc0, 0x75, 0xb6, 0x5e, 0x51, 0xef,
+    0x92, 0x25, 0xba, 0x99, 0x44, 0xbf, 0xbc, 0xdd, 0xdf, 0xf3, 0x38, 0xaa, 0x3c, 0xa2, 0x56, 0x1a,
+    0xfc, 0xab, 0xf8, 0x97, 0xfc, 0x2b, 0x8f, 0xa3, 0xbf, 0x56, 0x48, 0xde, 0x39, 0x93, 0x16, 0x2b,
+    0x8b, 0xd5, 0x6b, 0x93, 0x79, 0x9b, 0xc2, 0x2d, 0xcc, 0x36, 0x74, 0xef, 0x29, 0x58, 0xe2, 0xa8,
+    0x8b, 0x7e, 0x17, 0x52, 0x55, 0x4e, 0x09, 0x69, 0x23, 0x78, 0x3c, 0x08, 0x4b, 0x8a, 0x46, 0x53,
+    0xa1, 0xc1, 0xa8, 0x0d, 0xf9, 0x5a, 0x65, 0x81, 0xde, 0x18, 0x5b, 0xf0, 0xb5, 0x0a, 0x4c, 0x31,
+    0xff, 0x78, 0x7a, 0x9c, 0x27, 0x25, 0x33, 0x16, 0x63, 0x4c, 0x38, 0x73, 0xcc, 0xc7, 0x0a, 0x05,
+    0x24, 0x81, 0x91, 0x39, 0x8d, 0x1f, 0xb9, 0x45, 0x51, 0xda, 0x10, 0x39, 0xc4, 0x36, 0x09, 0xf1,
+    0x60, 0x4c, 0xa6, 0xe9, 0xe3, 0x7c, 0x3e, 0x9b, 0x3e, 0xdf, 0xcf, 0x7f, 0x8b, 0x7c, 0xc4, 0xfa,
+    0x96, 0x97, 0xf6, 0xb4, 0x9a, 0x27, 0x7f, 0xef, 0x6d, 0xc7, 0x22, 0xf8, 0x11, 0x28, 0x84, 0x15,
+    0x9c, 0x16, 0x14, 0x4c, 0xe7, 0x30, 0x81, 0x3e, 0xfc, 0x4a, 0x07, 0x71, 0x75, 0xc6, 0x9c, 0xc3,
+    0x55, 0xe9, 0x68, 0x1d, 0x01, 0x9d, 0x56, 0x46, 0x5a, 0xd0, 0xbe, 0x15, 0xc1, 0x90, 0x80, 0xb4,
+    0xfc, 0x9a, 0xda, 0x4d, 0x88, 0x5e, 0x01, 0x89, 0x25, 0x38, 0x07, 0xf6, 0x34, 0xbd, 0x99, 0xcf,
+    0x2f, 0xc3, 0x7a, 0xd0, 0xfa, 0xc5, 0x63, 0xca, 0xb5, 0x81, 0x17, 0xa5, 0xb7, 0xea, 0xa0, 0x23,
+    0x7b, 0x31, 0x72, 0x5d, 0xf2, 0xec, 0x63, 0x08, 0x5d, 0xb7, 0xca, 0x99, 0x35, 0xbe, 0x4f, 0xda,
+    0x71, 0x50, 0xa2, 0xf4, 0x32, 0x3d, 0x34, 0x4a, 0xe7, 0xec, 0x44, 0xc0, 0x6c, 0x6d, 0x11, 0x65,
+    0xd8, 0xc7, 0x96, 0xde, 0x0b, 0x26, 0x6b, 0xa3, 0x21, 0xbf, 0x60, 0xe6, 0xb7, 0xab, 0xb6, 0xb7,
+    0x35, 0x08, 0xe9, 0xca, 0x42, 0x97, 0x46, 0xbd, 0xd7, 0x6b, 0x25, 0x4e, 0xdf, 0x89, 0x1d, 0xf2,
+    0xb8, 0x1f, 0xf8, 0x02, 0xdb, 0x4a, 0xe0, 0xb9, 0x10, 0x16, 0x58, 0x96, 0xa1, 0xb5, 0x50, 0x6a,
+    0x41, 0x08, 0xb6, 0x42, 0x4a, 0x52, 0xbe, 0xa6, 0x52, 0x89, 0x04, 0x5f, 0x78, 0x25, 0xc6, 0x73,
+    0x98, 0xd1, 0x51, 0x60, 0xc1, 0x39, 0x6e, 0x7d, 0x97, 0xa1, 0xdb, 0x9b, 0xe9, 0x9f, 0x8f, 0x77,
+    0x77, 0xa7, 0xd4, 0xbf, 0xa1, 0xa4, 0x9a, 0xaf, 0x0b, 0x7c, 0xac, 0x25, 0x27, 0x2c, 0xee, 0x30,
+    0xac, 0xdf, 0xf2, 0x32, 0x3c, 0x10, 0x40, 0x93, 0x4e, 0x72, 0xf6, 0x62, 0x80, 0xbf, 0xd0, 0x99,
+    0xbd, 0xef, 0xa7, 0x50, 0x81, 0x8a, 0x4f, 0xcc, 0x15, 0x49, 0x78, 0x3c, 0x63, 0xef, 0x48, 0x87,
+    0xff, 0xfe, 0x4f, 0x4d, 0xc5, 0x47, 0x1b, 0xa8, 0xf5, 0x4b, 0x1d, 0xde, 0x59, 0x60, 0x8a, 0x53,
+    0x42, 0x63, 0x42, 0x42, 0x7a, 0x30, 0x2c, 0x3a, 0x2f, 0x59, 0x1b, 0xa4, 0xd0, 0x78, 0xbd, 0x34,
+    0x5f, 0x75, 0x41, 0xef, 0x0e, 0x58, 0xfe, 0x9d, 0x01, 0x7b, 0x97, 0xe4, 0xfc, 0xac, 0xc2, 0xbc,
+    0xae, 0x30, 0x3d, 0xcd, 0x4f, 0x8a, 0x33, 0x86, 0x80, 0x8f, 0x4f, 0xd2, 0xf9, 0x6c, 0xbe, 0x0d,
+    0x57, 0x5e, 0x8f, 0x2d, 0x78, 0xbf, 0x83, 0x0f, 0xda, 0x06, 0x4e, 0x1d, 0xcb, 0x7c, 0xdb, 0x5d,
+    0x71, 0xf2, 0x30, 0x26, 0x70, 0x9f, 0x83, 0x38, 0x52, 0x8e, 0xbc, 0x4d, 0x87, 0xe7, 0x52, 0xa1,
+    0xfd, 0x92, 0xe2, 0x07, 0x46, 0x52, 0xff, 0xc8, 0x1f, 0x3e, 0x91, 0xdd, 0xf0, 0xbe, 0xd3, 0x73,
+    0xed, 0x3f, 0xdd, 0xff, 0x01, 0x54, 0xe1, 0xe3, 0xe0, 0xd0, 0x07, 0x00, 0x00,
+};
+static const PortalAsset PORTAL_ASSET_SUCCESS_HTML = {
+    PORTAL_ASSET_SUCCESS_HTML_DATA, sizeof(PORTAL_ASSET_SUCCESS_HTML_DATA), "\"7958111d67dee3b0\"", "text/html", true
+};
+
+// update.html: 2637 bytes, 1237 gzipped
+static const uint8_t PORTAL_ASSET_UPDATE_HTML_DATA[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x56, 0x6d, 0x6f, 0xdb, 0x36,
+    0x10, 0xfe, 0xee, 0x5f, 0x71, 0x55, 0x31, 0xd8, 0xde, 0x2c, 0xd9, 0xc9, 0xd2, 0x74, 0xf3, 0xdb,
+    0x90, 0x25, 0x0d, 0x52, 0xa0, 0x45, 0x8b, 0x36, 0x05, 0x3a, 0x14, 0xfd, 0x40, 0x8b, 0x94, 0x45,
+    0x54, 0x22, 0x59, 0x92, 0xb2, 0x9d, 0x05, 0xfd, 0xef, 0xbb, 0x23, 0x25, 0x27, 0x69, 0xd2, 0x60,
+    0x1b, 0x8c, 0x38, 0x22, 0x79, 0xf7, 0xdc, 0xdd, 0x73, 0xcf, 0x51, 0x9e, 0x3f, 0x39, 0x7b, 0x73,
+    0x7a, 0xf9, 0xd7, 0xdb, 0x17, 0x70, 0x71, 0xf9, 0xfa, 0xd5, 0x72, 0x5e, 0xfa, 0xba, 0xc2, 0x6f,
+    0xc1, 0xf8, 0xb2, 0x37, 0xf7, 0xd2, 0x57, 0x62, 0x79, 0x2e, 0x6d, 0xbd, 0x65, 0x56, 0xc0, 0x07,
+    0xc3, 0x99, 0x17, 0xf3, 0x71, 0xdc, 0xee, 0xcd, 0x6b, 0xe1, 0x19, 0x28, 0x56, 0x8b, 0x45, 0xb2,
+    0x91, 0x62, 0x6b, 0xb4, 0xf5, 0x09, 0xe4, 0x5a, 0x79, 0xa1, 0xfc, 0x22, 0xd9, 0x4a, 0xee, 0xcb,
+    0x05, 0x17, 0x1b, 0x99, 0x8b, 0x34, 0x2c, 0x46, 0x20, 0x95, 0xf4, 0x92, 0x55, 0xa9, 0xcb, 0x59,
+    0x25, 0x16, 0x07, 0x09, 0x82, 0x38, 0x7f, 0x45, 0x60, 0x2b, 0xcd, 0xaf, 0xe0, 0x1a, 0x0a, 0xf4,
+    0x4e, 0x0b, 0x56, 0xcb, 0xea, 0x6a, 0x0a, 0x27, 0x16, 0x6d, 0x47, 0xe0, 0x98, 0x72, 0xa9, 0x13,
+    0x56, 0x16, 0x33, 0xa8, 0x99, 0x5d, 0x4b, 0x35, 0x85, 0xc3, 0x89, 0xd9, 0xcd, 0x60, 0xc5, 0xf2,
+    0x2f, 0x6b, 0xab, 0x1b, 0xc5, 0xd3, 0x5c, 0x57, 0xda, 0x4e, 0xe1, 0x69, 0x31, 0xa1, 0xcf, 0x0c,
+    0xbe, 0xf5, 0x32, 0xca, 0x84, 0x49, 0x25, 0x2c, 0xe2, 0xde, 0xb7, 0xdc, 0x96, 0xd2, 0x8b, 0x19,
+    0x18, 0xc6, 0xb9, 0x54, 0xeb, 0x3d, 0xa2, 0xb6, 0x5c, 0xd8, 0xd4, 0x32, 0x2e, 0x1b, 0x37, 0x85,
+    0x83, 0x76, 0x73, 0x97, 0xba, 0x92, 0x71, 0xbd, 0x9d, 0xc2, 0x04, 0x0e, 0xcd, 0x2e, 0xec, 0x83,
+    0x5d, 0xaf, 0xd8, 0x60, 0x32, 0x0a, 0x9f, 0xec, 0x60, 0x48, 0x31, 0xa5, 0x32, 0x8d, 0xff, 0xe4,
+    0xaf, 0x0c, 0x52, 0xe2, 0xc5, 0xce, 0x27, 0x9f, 0x31, 0x76, 0xa8, 0x9d, 0xb0, 0x26, 0x3f, 0xdd,
+    0x8a, 0xf7, 0x1b, 0x21, 0x77, 0xe5, 0x3c, 0x43, 0xb8, 0x49, 0x17, 0x1d, 0x4d, 0x71, 0xe9, 0x74,
+    0x25, 0x39, 0x3c, 0xe5, 0x9c, 0xdf, 0xcb, 0xea, 0x88, 0x5c, 0xef, 0x30, 0x55, 0x6b, 0xa5, 0x9d,
+    0x61, 0xb9, 0xa0, 0x24, 0x2a, 0xb6, 0x12, 0x15, 0xc6, 0xe5, 0xd2, 0x99, 0x8a, 0xe1, 0xe9, 0xaa,
+    0xd2, 0xf9, 0x97, 0x9b, 0x60, 0x21, 0xf9, 0x09, 0xc5, 0x0c, 0x34, 0xb9, 0x66, 0x55, 0x4b, 0x9f,
+    0xae, 0xbc, 0x7a, 0x90, 0xa7, 0xa7, 0x47, 0xa7, 0x27, 0xe7, 0xcf, 0x30, 0xb9, 0x1f, 0xf0, 0x76,
+    0x40, 0x7c, 0xdc, 0x26, 0x6f, 0x0a, 0x4a, 0x2b, 0xf1, 0x70, 0xd2, 0x79, 0x63, 0x1d, 0x81, 0x18,
+    0x2d, 0x51, 0x25, 0xb6, 0xad, 0xc2, 0xc9, 0xbf, 0x05, 0x02, 0x1d, 0xdf, 0x30, 0x92, 0x7a, 0x6d,
+    0x70, 0xe7, 0x7e, 0x8a, 0x53, 0x2c, 0x8a, 0xad, 0x2a, 0xc1, 0x1f, 0xce, 0x95, 0x31, 0x46, 0x0e,
+    0xc6, 0xea, 0xb5, 0x15, 0xce, 0x7d, 0x4f, 0x7e, 0x29, 0xe4, 0xba, 0xf4, 0x5d, 0xaf, 0x1f, 0x0c,
+    0x55, 0x62, 0x62, 0xe8, 0xd6, 0x01, 0x3e, 0x7f, 0xfe, 0xfc, 0x6e, 0x92, 0xbf, 0x46, 0xbb, 0xf9,
+    0xb8, 0xd5, 0xed, 0x7c, 0x1c, 0x66, 0x65, 0x4e, 0xfa, 0xc5, 0x15, 0x97, 0x1b, 0xc8, 0x2b, 0xe6,
+    0xdc, 0x22, 0xd9, 0xcb, 0x8f, 0x54, 0x5e, 0x1e, 0xde, 0x1f, 0x23, 0xdc, 0xeb, 0xcd, 0x0b, 0x6d,
+    0x6b, 0x90, 0x7c, 0x91, 0x34, 0x61, 0x97, 0x6c, 0x43, 0xff, 0x6e, 0xcc, 0x65, 0xcd, 0xd6, 0x02,
+    0x06, 0xd9, 0x4a, 0xaa, 0xe1, 0x7c, 0x1c, 0x0f, 0x7b, 0xf3, 0xa0, 0x34, 0x88, 0x4a, 0x2b, 0x64,
+    0x25, 0x92, 0x00, 0x12, 0x9f, 0x58, 0x9e, 0x0b, 0x83, 0x13, 0x48, 0x2e, 0x09, 0x58, 0xf1, 0xb5,
+    0x91, 0x56, 0xf0, 0x3d, 0xf2, 0xfb, 0x8b, 0x93, 0xf4, 0xf0, 0xd9, 0x31, 0x0c, 0xb4, 0xf1, 0x52,
+    0x2b, 0x56, 0xfd, 0x00, 0x36, 0x08, 0x38, 0xc0, 0xa2, 0xf8, 0x13, 0x40, 0x2d, 0xe5, 0xa2, 0xd4,
+    0x15, 0x36, 0x75, 0x91, 0x1c, 0x1f, 0x21, 0x99, 0x3b, 0x94, 0xd8, 0x5a, 0x7a, 0x37, 0x02, 0x91,
+    0xad, 0x33, 0x28, 0xac, 0xae, 0x01, 0x4d, 0x11, 0xdb, 0x35, 0x35, 0x14, 0x6d, 0x01, 0x31, 0x0b,
+    0xc3, 0x3c, 0x36, 0x5c, 0x2d, 0x92, 0x4f, 0x93, 0xf4, 0x77, 0x96, 0x16, 0x27, 0xe9, 0xf9, 0xe7,
+    0xeb, 0xe3, 0xa3, 0x6f, 0x54, 0xb0, 0xe9, 0x28, 0x23, 0xf2, 0x93, 0xe5, 0x65, 0xd9, 0x15, 0x2d,
+    0x1d, 0x6c, 0xad, 0x44, 0x47, 0x45, 0xb2, 0xab, 0x70, 0xc3, 0x43, 0x63, 0x2a, 0xcd, 0xb8, 0x03,
+    0xa6, 0x38, 0xe4, 0xa5, 0xc8, 0xbf, 0xa0, 0x16, 0x56, 0x02, 0x69, 0x0c, 0xa7, 0xe8, 0xc1, 0x72,
+    0x2f, 0x37, 0x48, 0x25, 0xcf, 0xe0, 0x65, 0x01, 0x1e, 0xc1, 0x94, 0xd8, 0xee, 0xb3, 0x81, 0x9c,
+    0x29, 0xa5, 0x3d, 0xac, 0x85, 0x0f, 0x02, 0x02, 0xad, 0x2a, 0x6c, 0x12, 0xb0, 0x02, 0xd3, 0x43,
+    0x04, 0x87, 0x7c, 0x39, 0xcf, 0xac, 0x1f, 0x05, 0xd7, 0x78, 0x7d, 0xe1, 0x9e, 0x6f, 0xac, 0x72,
+    0xe0, 0x75, 0xd8, 0x45, 0x19, 0x5b, 0xbc, 0xe3, 0xd0, 0x57, 0x64, 0xf3, 0xb1, 0xf9, 0x8e, 0xb7,
+    0xa8, 0xd6, 0x04, 0x36, 0xac, 0x6a, 0x70, 0x19, 0xdb, 0x9d, 0x74, 0x35, 0xde, 0x68, 0xb9, 0xe5,
+    0x96, 0x82, 0x11, 0x0b, 0x63, 0x92, 0x02, 0xb1, 0xd1, 0x89, 0x97, 0x4e, 0xbb, 0x45, 0x82, 0x6a,
+    0xdd, 0x2d, 0x12, 0x94, 0xf1, 0x1e, 0x17, 0x9f, 0x4a, 0xc9, 0xb9, 0x50, 0x4b, 0x4c, 0xa1, 0x35,
+    0x0b, 0x64, 0xb6, 0xa8, 0xbe, 0x71, 0xc9, 0x32, 0x66, 0x37, 0x46, 0x59, 0xd2, 0x55, 0x9b, 0x5b,
+    0x69, 0xfc, 0xb2, 0xb7, 0x61, 0x16, 0x82, 0xee, 0x16, 0xc0, 0x75, 0xde, 0xd4, 0x58, 0x4a, 0x86,
+    0x7c, 0xbc, 0xa8, 0x04, 0x3d, 0xfe, 0x79, 0xf5, 0x92, 0x0f, 0xfa, 0x51, 0x8e, 0xfd, 0xe1, 0x2c,
+    0x58, 0xaf, 0xf0, 0xef, 0x11, 0xe3, 0x2e, 0x7c, 0x67, 0x1e, 0xa3, 0x3f, 0xe6, 0x11, 0x2d, 0xc8,
+    0x9e, 0x12, 0xc9, 0xb4, 0x8a, 0xb4, 0xa0, 0x4b, 0xd1, 0xa8, 0x9c, 0x64, 0x09, 0x03, 0x31, 0x84,
+    0xeb, 0x9e, 0xc8, 0x8c, 0x15, 0x1b, 0xf4, 0x3b, 0x13, 0x05, 0x6b, 0x2a, 0x3f, 0x68, 0x43, 0x90,
+    0xd2, 0x1f, 0x0b, 0x40, 0xe7, 0xfd, 0x61, 0x46, 0xff, 0xdc, 0xa7, 0xc9, 0xe7, 0x59, 0x4f, 0x16,
+    0x30, 0x78, 0x42, 0xcb, 0x61, 0xdb, 0xcd, 0x88, 0x83, 0x55, 0x32, 0xc4, 0x21, 0x89, 0x9c, 0x63,
+    0x26, 0x67, 0xb8, 0xa4, 0x10, 0xb4, 0x9d, 0x31, 0x63, 0x84, 0x0a, 0x58, 0x51, 0x3b, 0xfd, 0x51,
+    0x08, 0x1b, 0xbf, 0x33, 0x7a, 0xf1, 0xb5, 0xc9, 0xec, 0x4a, 0xdb, 0x62, 0x7c, 0x7c, 0xfd, 0xea,
+    0xc2, 0x7b, 0xf3, 0x0e, 0x67, 0x0e, 0x65, 0x44, 0x48, 0x78, 0x96, 0x69, 0xc4, 0x19, 0xf4, 0xdf,
+    0xbe, 0x79, 0x7f, 0x89, 0x10, 0xfd, 0xf1, 0x5d, 0x6e, 0x71, 0x62, 0x1e, 0x65, 0xaa, 0x64, 0x58,
+    0x47, 0xe8, 0x79, 0xe6, 0xad, 0xac, 0x09, 0x93, 0x6a, 0xc1, 0xfd, 0x21, 0x05, 0xce, 0x9c, 0xf0,
+    0x6d, 0xb8, 0x0b, 0xbc, 0x89, 0x84, 0x1d, 0xf4, 0x3f, 0xa6, 0xdd, 0xe5, 0x91, 0xe2, 0xac, 0xe3,
+    0x38, 0x62, 0x54, 0x32, 0x8f, 0xc9, 0xc4, 0x01, 0x42, 0xca, 0xf7, 0x42, 0xbb, 0x4d, 0xba, 0x21,
+    0xd2, 0x09, 0xdf, 0x64, 0x95, 0x50, 0x6b, 0x5f, 0x9e, 0xea, 0x1a, 0xa5, 0x4d, 0x77, 0xee, 0x90,
+    0x64, 0x10, 0x33, 0x41, 0x97, 0xd7, 0xcc, 0x97, 0x59, 0xb8, 0x7d, 0xc9, 0x14, 0x11, 0x71, 0x0e,
+    0x7f, 0xa6, 0x7b, 0x16, 0xc6, 0x60, 0x32, 0xaf, 0x3d, 0xde, 0x2b, 0xb3, 0xde, 0xb7, 0x96, 0x00,
+    0x45, 0x16, 0x77, 0x02, 0x51, 0x9c, 0xa8, 0x82, 0x8c, 0x2e, 0x9a, 0xd3, 0xf8, 0xb3, 0x01, 0x4d,
+    0x42, 0x4d, 0xad, 0x80, 0x16, 0x78, 0x55, 0x4f, 0xe0, 0x0f, 0xe8, 0x9f, 0xe1, 0xa8, 0x8d, 0xba,
+    0xd1, 0xc4, 0xf7, 0x4e, 0x06, 0xef, 0x04, 0x5e, 0xb0, 0x4a, 0xe4, 0x38, 0xf3, 0x0a, 0x18, 0x14,
+    0x48, 0xbe, 0xa3, 0x2d, 0xee, 0xb2, 0x3e, 0x4c, 0xa1, 0x7f, 0xce, 0xb0, 0x49, 0x1c, 0x1f, 0xe0,
+    0x97, 0x00, 0x89, 0xbe, 0x06, 0x65, 0x26, 0x2e, 0x31, 0x18, 0xf6, 0xf7, 0x11, 0x61, 0x5a, 0x8f,
+    0x84, 0xef, 0xdf, 0x33, 0x98, 0x33, 0xab, 0x9c, 0xb8, 0x55, 0x8a, 0xb0, 0x56, 0xdb, 0x7f, 0x57,
+    0x4b, 0xff, 0x34, 0xe6, 0x48, 0x56, 0x95, 0x76, 0x3e, 0xeb, 0xff, 0xdf, 0xd0, 0x44, 0x7d, 0x1c,
+    0xf7, 0x9b, 0xed, 0xdb, 0xed, 0x98, 0xcc, 0x7e, 0x90, 0xc1, 0x87, 0xd0, 0x6e, 0xa2, 0x2c, 0xfb,
+    0xaf, 0xd1, 0xbd, 0x6d, 0x44, 0x2c, 0xda, 0xd1, 0x1c, 0xd0, 0x4c, 0xc4, 0x96, 0xe2, 0xdb, 0xaf,
+    0xbd, 0x4a, 0xe6, 0xe3, 0xf0, 0xe2, 0xc3, 0x97, 0x19, 0xfd, 0x6e, 0xfc, 0x07, 0xa5, 0xa6, 0x48,
+    0xf7, 0x4d, 0x0a, 0x00, 0x00,
+};
+static const PortalAsset PORTAL_ASSET_UPDATE_HTML = {
+    PORTAL_ASSET_UPDATE_HTML_DATA, sizeof(PORTAL_ASSET_UPDATE_HTML_DATA), "\"f0e4924486a29e9c\"", "text/html", true
+};
+
+#endif // PORTAL_ASSETS_H
@@ -0,0 +1,118 @@
+#include "PortalButton.h"
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <esp_sleep.h>
+
+PortalButton::PortalButton(int buttonPin)
+    : pin(buttonPin), long_press_ms(1000), reset_hold_ms(3000),
+      events(nullptr), wake_group(nullptr), wake_bits(0), debounce_timer(nullptr), hold_timer(nullptr),
+      pressed(false), suppress_release(false), press_start_ms(0) {
+}
+
+PortalButton::~PortalButton() {
+    if (events) {
+        end();
+        xTimerDelete(debounce_timer, 0);
+        xTimerDelete(hold_timer, 0);
+        vQueueDelete(events);
+    }
+}
+
+bool PortalButton::begin(uint32_t longPressMs, uint32_t resetHoldMs) {
+    long_press_ms = longPressMs;
+    reset_hold_ms = resetHoldMs;
+
+    if (!events) {
+        events = xQueueCreate(8, sizeof(ButtonEvent));
+        debounce_timer = xTimerCreate("btn_debounce", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS), pdFALSE, this, onDebounced);
+        hold_timer = xTimerCreate("btn_hold", pdMS_TO_TICKS(reset_hold_ms), pdFALSE, this, onHoldElapsed);
+        if (!events || !debounce_timer || !hold_timer) {
+            return false;
+        }
+    }
+
+    pinMode(pin, INPUT_PULLUP);
+
+    // A press that started before boot is not classified on release
+    pressed = digitalRead(pin) == LOW;
+    suppress_release = pressed;
+    press_start_ms = millis();
+
+    attachInterruptArg(pin, onEdge, this, CHANGE);
+    armWake(pressed);
+    esp_sleep_enable_gpio_wakeup();
+    return true;
+}
+
+void PortalButton::end() {
+    gpio_wakeup_disable((gpio_num_t)pin);
+    detachInterrupt(pin);
+    if (debounce_timer) {
+        xTimerStop(debounce_timer, 0);
+        xTimerStop(hold_timer, 0);
+    }
+}
+
+bool PortalButton::poll(ButtonEvent& event) {
+    return events && xQueueReceive(events, &event, 0) == pdTRUE;
+}
+
+// Light-sleep only wakes on a GPIO level. The pin waits for the level it is
+// not at; this also turns its interrupt into a level one. Called from task
+// context only: gpio_wakeup_enable() lives in flash and takes a lock.
+void PortalButton::armWake(bool low) {
+    gpio_wakeup_enable((gpio_num_t)pin, low ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    gpio_intr_enable((gpio_num_t)pin);
+}
+
+// The level interrupt would keep firing while the pin stays there, so it is
+// masked with a register write (safe with the flash cache off) until
+// onDebounced() re-arms it for the next change.
+void IRAM_ATTR PortalButton::onEdge(void* arg) {
+    PortalButton* self = static_cast<PortalButton*>(arg);
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)self->pin);
+    BaseType_t woken = pdFALSE;
+    xTimerResetFromISR(self->debounce_timer, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void PortalButton::onDebounced(TimerHandle_t timer) {
+    PortalButton* self = static_cast<PortalButton*>(pvTimerGetTimerID(timer));
+    bool level_pressed = digitalRead(self->pin) == LOW;
+    self->armWake(level_pressed);
+
+    if (level_pressed && !self->pressed) {
+        self->pressed = true;
+        self->suppress_release = false;
+        self->press_start_ms = millis();
+        xTimerChangePeriod(self->hold_timer, pdMS_TO_TICKS(self->reset_hold_ms), 0);
+    } else if (!level_pressed && self->pressed) {
+        self->pressed = false;
+        xTimerStop(self->hold_timer, 0);
+
+        if (self->suppress_release) {
+            // Boot-time hold or factory reset already reported
+            self->suppress_release = false;
+            return;
+        }
+        uint32_t held = millis() - self->press_start_ms;
+        self->push(held >= self->long_press_ms ? ButtonEvent::LONG_PRESS : ButtonEvent::SHORT_PRESS);
+    }
+}
+
+void PortalButton::onHoldElapsed(TimerHandle_t timer) {
+    PortalButton* self = static_cast<PortalButton*>(pvTimerGetTimerID(timer));
+    if (self->pressed && !self->suppress_release) {
+        self->suppress_release = true;
+        self->push(ButtonEvent::FACTORY_RESET);
+    }
+}
+
+void PortalButton::push(ButtonEvent event) {
+    xQueueSend(events, &event, 0);
+    if (wake_group) {
+        xEventGroupSetBits(wake_group, wake_bits);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef PORTAL_BUTTON_H
+#define PORTAL_BUTTON_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/timers.h>
+#include <freertos/event_groups.h>
+#include <functional>
+
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 30
+#endif
+
+// Classified button presses
+enum class ButtonEvent : uint8_t {
+    SHORT_PRESS,    // Released before the long press time
+    LONG_PRESS,     // Released after the long press time
+    FACTORY_RESET   // Still held at the reset hold time, fired while held
+};
+
+typedef std::function<void(ButtonEvent)> ButtonCallback;
+
+// Active-low push button handled by a GPIO interrupt and FreeRTOS timers.
+// An edge masks the interrupt and starts a debounce timer; the timer task
+// classifies the settled level, queues the event and re-arms the pin. The
+// owner only drains events with poll(), and may sleep on an event group bit
+// set with each one. The pin is also a light-sleep wake source.
+class PortalButton {
+private:
+    int pin;
+    uint32_t long_press_ms;
+    uint32_t reset_hold_ms;
+
+    QueueHandle_t events;
+    EventGroupHandle_t wake_group;
+    EventBits_t wake_bits;
+    TimerHandle_t debounce_timer;
+    TimerHandle_t hold_timer;
+
+    // Only touched from the timer task once begin() has returned
+    volatile bool pressed;
+    bool suppress_release;
+    uint32_t press_start_ms;
+
+    void armWake(bool low);
+    static void IRAM_ATTR onEdge(void* arg);
+    static void onDebounced(TimerHandle_t timer);
+    static void onHoldElapsed(TimerHandle_t timer);
+    void push(ButtonEvent event);
+
+public:
+    explicit PortalButton(int buttonPin);
+    ~PortalButton();
+
+    bool begin(uint32_t longPressMs, uint32_t resetHoldMs);
+    void end();
+
+    // Fetch the next queued event, never blocks
+    bool poll(ButtonEvent& event);
+
+    // Bits set in group whenever an event is queued
+    void wakeOnEvent(EventGroupHandle_t group, EventBits_t bits) { wake_group = group; wake_bits = bits; }
+
+    bool isPressed() const { return pressed; }
+};
+
+#endif // PORTAL_BUTTON_H
@@ -0,0 +1,53 @@
+#ifndef PORTAL_MODULE_H
+#define PORTAL_MODULE_H
+
+#include <new>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include "ConfigData.h"
+
+// An integration (Telegram, web host, ...) driven by the portal. Its
+// settings are the fields of its CONFIG_SECTIONS entry, and a BOOL field
+// with the json key "active" turns it on and off. The portal only
+// constructs a module while that flag is set, so a disabled module costs
+// no heap and no start-up time. All hooks run in the task calling handle().
+class PortalModule {
+    friend class ModuleRegistry;
+    EventGroupHandle_t wake_group;
+    EventBits_t wake_bits;
+
+public:
+    PortalModule() : wake_group(nullptr), wake_bits(0) {}
+    virtual ~PortalModule() {}
+
+    // Starts with the config that enabled it; false leaves the module off
+    // until its section changes
+    virtual bool begin(const ConfigData& config) = 0;
+
+    // Called from handle() while the device is configured and online, each
+    // time it wakes: for WiFi events, button presses, deadlines and
+    // requestRun(). Not on a fixed interval.
+    virtual void run() = 0;
+
+    // Before the module is deleted: disabled, reconfigured or portal gone
+    virtual void end() {}
+
+protected:
+    // Has run() called soon from any task; the task calling handle() may be
+    // asleep until something wakes it
+    void requestRun() {
+        if (wake_group) {
+            xEventGroupSetBits(wake_group, wake_bits);
+        }
+    }
+};
+
+// Returns nullptr when the module cannot be allocated
+typedef PortalModule* (*PortalModuleFactory)();
+
+template <typename T>
+PortalModule* createPortalModule() {
+    return new (std::nothrow) T();
+}
+
+#endif // PORTAL_MODULE_H
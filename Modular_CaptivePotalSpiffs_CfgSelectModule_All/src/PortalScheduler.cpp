@@ -0,0 +1,100 @@
+#include "PortalScheduler.h"
+#include "Metrics.h"
+#include "Log.h"
+
+// Longest single wait; pdMS_TO_TICKS() overflows on an hour and more
+#define PORTAL_WAIT_MAX_MS 3600000UL
+
+static const char* const WAKE_SOURCE_NAMES[PORTAL_WAKE_SOURCES] = {
+    "wifi", "web", "button", "module", "setup"
+};
+
+PortalScheduler::PortalScheduler() : group(nullptr) {
+    resetLoopStats();
+}
+
+PortalScheduler::~PortalScheduler() {
+    if (group) {
+        vEventGroupDelete(group);
+    }
+}
+
+bool PortalScheduler::begin() {
+    if (!group) {
+        group = xEventGroupCreate();
+    }
+    return group != nullptr;
+}
+
+void PortalScheduler::notify(EventBits_t bits) {
+    if (group) {
+        xEventGroupSetBits(group, bits);
+    }
+}
+
+EventBits_t PortalScheduler::wait(EventBits_t bits, uint32_t timeoutMs, bool measured) {
+    uint32_t started = micros();
+    EventBits_t set = 0;
+    if (!group) {
+        // Not started: a plain poll interval
+        delay(min(timeoutMs, (uint32_t)100));
+    } else {
+        TickType_t ticks = timeoutMs == PORTAL_NEVER ? portMAX_DELAY
+                                                     : pdMS_TO_TICKS(min(timeoutMs, (uint32_t)PORTAL_WAIT_MAX_MS));
+        set = xEventGroupWaitBits(group, bits, pdTRUE, pdFALSE, ticks) & bits;
+    }
+    if (!measured) {
+        return set;
+    }
+
+    uint32_t blocked = micros() - started;
+    idle_us += blocked;
+    stats.wakeups++;
+    if (set == 0) {
+        stats.timeouts++;
+    }
+    for (size_t i = 0; i < PORTAL_WAKE_SOURCES; i++) {
+        if (set & (1 << i)) {
+            stats.by_source[i]++;
+        }
+    }
+    idle_carry_us += blocked;
+    Metrics::count(MetricCounter::LOOP_WAKEUPS);
+    if (idle_carry_us >= 1000) {
+        Metrics::count(MetricCounter::LOOP_IDLE_MS, idle_carry_us / 1000);
+        idle_carry_us %= 1000;
+    }
+    return set;
+}
+
+const LoopStats& PortalScheduler::loopStats() {
+    stats.window_ms = millis() - window_started;
+    stats.idle_ms = idle_us / 1000;
+    return stats;
+}
+
+void PortalScheduler::resetLoopStats() {
+    memset(&stats, 0, sizeof(stats));
+    window_started = millis();
+    idle_us = 0;
+    idle_carry_us = 0;
+}
+
+// e.g. "Loop: 0.35 wakeups/s, 99.8% idle (wifi 2, button 1, timer 18)"
+void PortalScheduler::logLoopStats() {
+    const LoopStats& current = loopStats();
+    uint32_t window = max(current.window_ms, (uint32_t)1);
+    uint32_t rate = (uint64_t)current.wakeups * 100000 / window;  // Hundredths per second
+    uint32_t idle = (uint64_t)current.idle_ms * 1000 / window;    // Per mille
+
+    char sources[96];
+    int length = snprintf(sources, sizeof(sources), "timer %lu", (unsigned long)current.timeouts);
+    for (size_t i = 0; i < PORTAL_WAKE_SOURCES && length < (int)sizeof(sources); i++) {
+        if (current.by_source[i] > 0) {
+            length += snprintf(sources + length, sizeof(sources) - length, ", %s %lu",
+                               WAKE_SOURCE_NAMES[i], (unsigned long)current.by_source[i]);
+        }
+    }
+    LOG_I("Loop: %lu.%02lu wakeups/s, %lu.%lu%% idle (%s)", (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+          (unsigned long)(idle / 10), (unsigned long)(idle % 10), sources);
+}
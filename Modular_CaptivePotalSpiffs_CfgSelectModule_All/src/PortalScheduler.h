@@ -0,0 +1,70 @@
+#ifndef PORTAL_SCHEDULER_H
+#define PORTAL_SCHEDULER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+// Log wakeups per second and idle time of the task calling handle() this
+// often, 0: off. The loop_* metrics count them either way.
+#ifndef PORTAL_LOOP_STATS_MS
+#define PORTAL_LOOP_STATS_MS 0
+#endif
+
+// Wake sources, bits of the scheduler's event group. WIFI and WEB go to
+// whichever task drives the connection, the rest to the one calling handle().
+#define PORTAL_WAKE_WIFI    BIT0  // WiFi event
+#define PORTAL_WAKE_WEB     BIT1  // Config submitted or firmware written
+#define PORTAL_WAKE_BUTTON  BIT2  // Button event queued
+#define PORTAL_WAKE_MODULE  BIT3  // A module asked for run()
+#define PORTAL_WAKE_SETUP   BIT4  // Setup task adopted a config or finished
+#define PORTAL_WAKE_SOURCES 5
+
+// Deadline of nothing
+#define PORTAL_NEVER UINT32_MAX
+
+// Wakeups of the measured task over a window
+struct LoopStats {
+    uint32_t window_ms;
+    uint32_t wakeups;
+    uint32_t timeouts;  // Woken by a deadline, not an event
+    uint32_t idle_ms;   // Blocked in wait()
+    uint32_t by_source[PORTAL_WAKE_SOURCES];
+};
+
+// Event group the portal's tasks sleep on between events. Wake sources set
+// bits from any task; a task waits for its own bits or its next
+// deadline, whichever comes first. Only the measured task, the one calling
+// handle(), updates the statistics.
+class PortalScheduler {
+    EventGroupHandle_t group;
+    LoopStats stats;
+    uint32_t window_started;
+    uint64_t idle_us;
+    uint32_t idle_carry_us;  // Below a millisecond, not yet counted in metrics
+
+public:
+    PortalScheduler();
+    ~PortalScheduler();
+
+    bool begin();
+    EventGroupHandle_t events() const { return group; }
+
+    void notify(EventBits_t bits);
+
+    // Blocks until one of the bits is set or timeoutMs passed; returns and
+    // clears the bits that were set, 0 on timeout
+    EventBits_t wait(EventBits_t bits, uint32_t timeoutMs, bool measured);
+
+    const LoopStats& loopStats();
+    void resetLoopStats();
+    void logLoopStats();
+
+    // Milliseconds until millis() - since reaches period, 0 when it has
+    static uint32_t remaining(unsigned long since, unsigned long period) {
+        unsigned long elapsed = millis() - since;
+        return elapsed >= period ? 0 : period - elapsed;
+    }
+};
+
+#endif // PORTAL_SCHEDULER_H
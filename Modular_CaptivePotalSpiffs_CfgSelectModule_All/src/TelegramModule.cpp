@@ -0,0 +1,365 @@
+#include "TelegramModule.h"
+#include "Metrics.h"
+#include "Log.h"
+
+#define WAIT_FOREVER UINT32_MAX
+
+portMUX_TYPE TelegramModule::lock = portMUX_INITIALIZER_UNLOCKED;
+TelegramModule* TelegramModule::instance = nullptr;
+
+// JSON string form of one character into escaped (7 bytes); returns its length
+static size_t escapeChar(char c, char* escaped) {
+    switch (c) {
+        case '"':  memcpy(escaped, "\\\"", 2); return 2;
+        case '\\': memcpy(escaped, "\\\\", 2); return 2;
+        case '\n': memcpy(escaped, "\\n", 2); return 2;
+        case '\r': memcpy(escaped, "\\r", 2); return 2;
+        case '\t': memcpy(escaped, "\\t", 2); return 2;
+        default:
+            if ((uint8_t)c < 0x20) {
+                snprintf(escaped, 7, "\\u%04x", (uint8_t)c);
+                return 6;
+            }
+            escaped[0] = c;
+            return 1;
+    }
+}
+
+static size_t escapedLength(const char* text, size_t length) {
+    char escaped[7];
+    size_t total = 0;
+    for (size_t i = 0; i < length; i++) {
+        total += escapeChar(text[i], escaped);
+    }
+    return total;
+}
+
+TelegramModule::TelegramModule()
+    : queue_head(0), queue_count(0), senders(0), http(TELEGRAM_TIMEOUT_MS), worker(nullptr), stopping(false), worker_running(false),
+      batch_length(0), batch_messages(0), post_count(0), post_next(0), retry_pending(false), retry_at_ms(0),
+      retry_delay_ms(0), retry_after_ms(0), last_used_ms(0) {
+    http.use(client);
+    token[0] = '\0';
+    chat[0] = '\0';
+    batch[0] = '\0';
+}
+
+bool TelegramModule::begin(const ConfigData& config) {
+    if (config.tg_token[0] == '\0' || config.tg_chat[0] == '\0') {
+        LOG_W("Telegram needs a bot token and a chat ID");
+        return false;
+    }
+    strlcpy(token, config.tg_token, sizeof(token));
+    strlcpy(chat, config.tg_chat, sizeof(chat));
+#ifdef TELEGRAM_ROOT_CA
+    client.setCACert(TELEGRAM_ROOT_CA);
+#else
+    client.setInsecure();
+#endif
+
+    stopping = false;
+    worker_running = true;
+    if (xTaskCreatePinnedToCore(workerMain, "telegram", TELEGRAM_TASK_STACK, this,
+                                TELEGRAM_TASK_PRIORITY, &worker, TELEGRAM_TASK_CORE) != pdPASS) {
+        LOG_E("Failed to start Telegram task");
+        worker_running = false;
+        worker = nullptr;
+        return false;
+    }
+    Metrics::watchTask(worker);
+
+    portENTER_CRITICAL(&lock);
+    instance = this;
+    portEXIT_CRITICAL(&lock);
+    LOG_I("Telegram notifications to chat %s", chat);
+    return true;
+}
+
+void TelegramModule::stopWorker() {
+    if (!worker) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    if (instance == this) {
+        instance = nullptr;
+    }
+    portEXIT_CRITICAL(&lock);
+    while (senders > 0) {
+        vTaskDelay(1);
+    }
+
+    // The worker finishes the request it is in, at most two timeouts
+    Metrics::unwatchTask(worker);
+    stopping = true;
+    xTaskNotifyGive(worker);
+    uint32_t started = millis();
+    while (worker_running && millis() - started < 2 * TELEGRAM_TIMEOUT_MS + 1000) {
+        vTaskDelay(10);
+    }
+    if (worker_running) {
+        LOG_E("Telegram task did not stop, deleting it");
+        vTaskDelete(worker);
+    }
+    http.stop();
+    worker = nullptr;
+}
+
+bool TelegramModule::send(const char* text) {
+    if (!text || text[0] == '\0') {
+        return false;
+    }
+    portENTER_CRITICAL(&lock);
+    TelegramModule* self = instance;
+    if (self) {
+        self->enqueue(text);
+        self->senders++;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!self) {
+        return false;
+    }
+    xTaskNotifyGive(self->worker);
+    self->senders--;
+    return true;
+}
+
+// Under lock. A full queue loses its oldest entry.
+void TelegramModule::enqueue(const char* text) {
+    if (queue_count == TELEGRAM_QUEUE_SLOTS) {
+        queue_head = (queue_head + 1) % TELEGRAM_QUEUE_SLOTS;
+        queue_count--;
+        Metrics::count(MetricCounter::TELEGRAM_DROPPED);
+    }
+    Message& message = queue[(queue_head + queue_count) % TELEGRAM_QUEUE_SLOTS];
+    size_t length = strnlen(text, TELEGRAM_MESSAGE_MAX + 1);
+    if (length > TELEGRAM_MESSAGE_MAX) {
+        // Cut before a UTF-8 continuation byte, Telegram rejects broken text
+        length = TELEGRAM_MESSAGE_MAX;
+        while (length > 0 && ((uint8_t)text[length] & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    memcpy(message.text, text, length);
+    message.text[length] = '\0';
+    message.length = length;
+    message.queued_ms = millis();
+    queue_count++;
+}
+
+// Moves as many queued notifications as fit into the batch
+void TelegramModule::takeBatch() {
+    portENTER_CRITICAL(&lock);
+    while (queue_count > 0) {
+        const Message& message = queue[queue_head];
+        size_t separator = batch_messages > 0 ? 1 : 0;
+        if (batch_messages > 0 && batch_length + separator + message.length > TELEGRAM_BATCH_MAX) {
+            break;
+        }
+        if (separator) {
+            batch[batch_length++] = '\n';
+        }
+        memcpy(batch + batch_length, message.text, message.length);
+        batch_length += message.length;
+        batch_messages++;
+        queue_head = (queue_head + 1) % TELEGRAM_QUEUE_SLOTS;
+        queue_count--;
+    }
+    portEXIT_CRITICAL(&lock);
+    batch[batch_length] = '\0';
+}
+
+void TelegramModule::workerMain(void* arg) {
+    TelegramModule* self = static_cast<TelegramModule*>(arg);
+    while (!self->stopping) {
+        uint32_t wait = self->step();
+        if (wait > 0) {
+            ulTaskNotifyTake(pdTRUE, wait == WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+        }
+    }
+    self->http.stop();
+    self->worker_running = false;
+    vTaskDelete(nullptr);
+}
+
+// One pass of the worker; returns how long to sleep, 0 to go on at once.
+// send() wakes it early.
+uint32_t TelegramModule::step() {
+    uint32_t now = millis();
+    if (batch_messages == 0) {
+        portENTER_CRITICAL(&lock);
+        bool queued = queue_count > 0;
+        uint32_t oldest = queued ? queue[queue_head].queued_ms : 0;
+        portEXIT_CRITICAL(&lock);
+        if (!queued) {
+            return idleWait(now);
+        }
+        // Let a burst finish so it goes out as one message
+        if (now - oldest < TELEGRAM_COALESCE_MS) {
+            return TELEGRAM_COALESCE_MS - (now - oldest);
+        }
+    }
+    uint32_t wait = sendWait(now);
+    if (wait > 0) {
+        return wait;
+    }
+    if (batch_messages == 0) {
+        takeBatch();
+    }
+
+    switch (post()) {
+        case SendResult::SENT:
+            Metrics::count(MetricCounter::TELEGRAM_MESSAGES, batch_messages);
+            retry_pending = false;
+            retry_delay_ms = 0;
+            batch_length = 0;
+            batch_messages = 0;
+            break;
+        case SendResult::RETRY:
+            if (retry_after_ms > 0) {
+                retry_delay_ms = retry_after_ms;
+            } else {
+                retry_delay_ms = retry_delay_ms == 0 ? TELEGRAM_RETRY_MIN_MS : min((uint32_t)TELEGRAM_RETRY_MAX_MS, retry_delay_ms * 2);
+            }
+            retry_pending = true;
+            retry_at_ms = millis() + retry_delay_ms;
+            LOG_W("Telegram send failed, retrying in %lu ms", (unsigned long)retry_delay_ms);
+            break;
+        case SendResult::REJECTED:
+            Metrics::count(MetricCounter::TELEGRAM_DROPPED, batch_messages);
+            retry_pending = false;
+            retry_delay_ms = 0;
+            batch_length = 0;
+            batch_messages = 0;
+            break;
+    }
+    return 0;
+}
+
+// Nothing to send: close the connection once it has idled long enough
+uint32_t TelegramModule::idleWait(uint32_t now) {
+    if (!http.connected()) {
+        return WAIT_FOREVER;
+    }
+    uint32_t idle = now - last_used_ms;
+    if (idle >= TELEGRAM_IDLE_CLOSE_MS) {
+        http.stop();
+        return WAIT_FOREVER;
+    }
+    return TELEGRAM_IDLE_CLOSE_MS - idle;
+}
+
+// Time until the next send is allowed: retry delay, per-chat interval and
+// the per-minute window
+uint32_t TelegramModule::sendWait(uint32_t now) const {
+    uint32_t wait = 0;
+    if (retry_pending && (int32_t)(retry_at_ms - now) > 0) {
+        wait = retry_at_ms - now;
+    }
+    if (post_count > 0) {
+        uint32_t since_last = now - post_times[(post_next + TELEGRAM_RATE_PER_MIN - 1) % TELEGRAM_RATE_PER_MIN];
+        if (since_last < TELEGRAM_MIN_INTERVAL_MS) {
+            wait = max(wait, TELEGRAM_MIN_INTERVAL_MS - since_last);
+        }
+        if (post_count == TELEGRAM_RATE_PER_MIN) {
+            uint32_t since_oldest = now - post_times[post_next];
+            if (since_oldest < 60000) {
+                wait = max(wait, 60000 - since_oldest);
+            }
+        }
+    }
+    return wait;
+}
+
+TelegramModule::SendResult TelegramModule::post() {
+    MetricTimer timer(MetricHistogram::TELEGRAM_POST);
+    Metrics::count(MetricCounter::TELEGRAM_REQUESTS);
+    retry_after_ms = 0;
+
+    // The server may have closed a kept-alive connection in the meantime:
+    // then the request is repeated once on a fresh one
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = http.connected();
+        if (!reused && !connect()) {
+            return SendResult::RETRY;
+        }
+        // Telegram counts from arrival, so the window starts after the handshake
+        if (attempt == 0) {
+            recordSend();
+        }
+        char body[160];
+        HttpConnection::Reply reply = { -1, false, 0 };
+        if (writeRequest()) {
+            reply = http.readReply(body, sizeof(body));
+        }
+        if (reply.status > 0) {
+            last_used_ms = millis();
+            if (reply.close) {
+                http.stop();
+            }
+            if (reply.status >= 200 && reply.status < 300) {
+                return SendResult::SENT;
+            }
+            if (reply.status == 429 || reply.status >= 500) {
+                retry_after_ms = reply.retry_after_ms;
+                const char* retry_after = strstr(body, "\"retry_after\":");
+                if (reply.status == 429 && retry_after) {
+                    retry_after_ms = atol(retry_after + 14) * 1000;
+                }
+                return SendResult::RETRY;
+            }
+            LOG_E("Telegram rejected the message (HTTP %d)", reply.status);
+            return SendResult::REJECTED;
+        }
+        http.stop();
+        if (!reused) {
+            break;
+        }
+    }
+    return SendResult::RETRY;
+}
+
+void TelegramModule::recordSend() {
+    post_times[post_next] = millis();
+    post_next = (post_next + 1) % TELEGRAM_RATE_PER_MIN;
+    if (post_count < TELEGRAM_RATE_PER_MIN) {
+        post_count++;
+    }
+}
+
+bool TelegramModule::connect() {
+    Metrics::count(MetricCounter::TELEGRAM_HANDSHAKES);
+    if (!http.connect(TELEGRAM_HOST, TELEGRAM_PORT)) {
+        LOG_W("Telegram: cannot connect to %s", TELEGRAM_HOST);
+        return false;
+    }
+    return true;
+}
+
+bool TelegramModule::writeRequest() {
+    static const char chat_prefix[] = "{\"chat_id\":\"";
+    static const char text_prefix[] = "\",\"text\":\"";
+    static const char suffix[] = "\"}";
+    size_t body = sizeof(chat_prefix) - 1 + escapedLength(chat, strlen(chat)) + sizeof(text_prefix) - 1 +
+                  escapedLength(batch, batch_length) + sizeof(suffix) - 1;
+    char length[12];
+    snprintf(length, sizeof(length), "%u", (unsigned)body);
+
+    http.put("POST /bot");
+    http.put(token);
+    http.put("/sendMessage HTTP/1.1\r\nHost: " TELEGRAM_HOST "\r\nContent-Type: application/json\r\nContent-Length: ");
+    http.put(length);
+    http.put("\r\nConnection: keep-alive\r\n\r\n");
+    http.put(chat_prefix);
+    putEscaped(chat, strlen(chat));
+    http.put(text_prefix);
+    putEscaped(batch, batch_length);
+    http.put(suffix);
+    return http.flush();
+}
+
+void TelegramModule::putEscaped(const char* text, size_t length) {
+    char escaped[7];
+    for (size_t i = 0; i < length; i++) {
+        http.put(escaped, escapeChar(text[i], escaped));
+    }
+}
@@ -0,0 +1,148 @@
+#ifndef TELEGRAM_MODULE_H
+#define TELEGRAM_MODULE_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "HttpConnection.h"
+#include "PortalModule.h"
+
+#ifndef TELEGRAM_HOST
+#define TELEGRAM_HOST "api.telegram.org"
+#endif
+#ifndef TELEGRAM_PORT
+#define TELEGRAM_PORT 443
+#endif
+
+// Notifications waiting to be sent; a new one pushes out the oldest
+#ifndef TELEGRAM_QUEUE_SLOTS
+#define TELEGRAM_QUEUE_SLOTS 16
+#endif
+// Longest notification, longer ones are truncated
+#ifndef TELEGRAM_MESSAGE_MAX
+#define TELEGRAM_MESSAGE_MAX 200
+#endif
+// Text of one sendMessage, queued notifications joined by newlines.
+// Telegram takes up to 4096 characters.
+#ifndef TELEGRAM_BATCH_MAX
+#define TELEGRAM_BATCH_MAX 1024
+#endif
+// How long a notification waits for others to share its message
+#ifndef TELEGRAM_COALESCE_MS
+#define TELEGRAM_COALESCE_MS 250
+#endif
+
+// Bot API limits: about one message a second to a chat, 20 a minute to a group
+#ifndef TELEGRAM_MIN_INTERVAL_MS
+#define TELEGRAM_MIN_INTERVAL_MS 1000
+#endif
+#ifndef TELEGRAM_RATE_PER_MIN
+#define TELEGRAM_RATE_PER_MIN 20
+#endif
+
+// Delay after a failed send, doubled per failure; 429 answers set their own
+#ifndef TELEGRAM_RETRY_MIN_MS
+#define TELEGRAM_RETRY_MIN_MS 2000
+#endif
+#ifndef TELEGRAM_RETRY_MAX_MS
+#define TELEGRAM_RETRY_MAX_MS 120000
+#endif
+
+// The kept-alive connection is closed after this long without a send,
+// which frees its TLS buffers
+#ifndef TELEGRAM_IDLE_CLOSE_MS
+#define TELEGRAM_IDLE_CLOSE_MS 60000
+#endif
+#ifndef TELEGRAM_TIMEOUT_MS
+#define TELEGRAM_TIMEOUT_MS 10000
+#endif
+
+#ifndef TELEGRAM_TASK_STACK
+#define TELEGRAM_TASK_STACK 8192
+#endif
+#ifndef TELEGRAM_TASK_PRIORITY
+#define TELEGRAM_TASK_PRIORITY 1
+#endif
+#ifndef TELEGRAM_TASK_CORE
+#define TELEGRAM_TASK_CORE 1
+#endif
+
+// Define TELEGRAM_ROOT_CA as the PEM of the CA that signs api.telegram.org
+// to verify the server; without it the connection is encrypted but the
+// certificate is not checked.
+
+// Notifications to the chat of the "telegram" config section. send()
+// copies the text into a fixed queue and returns. A worker task owns the
+// connection: it joins whatever is queued into one sendMessage, keeps the
+// TLS connection open between sends so a burst costs one handshake, and
+// paces requests to the Bot API limits, waiting out 429 answers. Nothing
+// is allocated per notification; the queue and buffers belong to the
+// module, which only exists while Telegram is enabled.
+class TelegramModule : public PortalModule {
+private:
+    struct Message {
+        uint32_t queued_ms;
+        uint16_t length;
+        char text[TELEGRAM_MESSAGE_MAX + 1];
+    };
+
+    enum class SendResult : uint8_t { SENT, RETRY, REJECTED };
+
+    // Queue, shared with send() under lock
+    Message queue[TELEGRAM_QUEUE_SLOTS];
+    uint8_t queue_head;
+    uint8_t queue_count;
+    std::atomic<uint8_t> senders;  // send() calls still notifying the worker
+
+    // Worker side
+    char token[sizeof(ConfigData::tg_token)];
+    char chat[sizeof(ConfigData::tg_chat)];
+    WiFiClientSecure client;
+    HttpConnection http;
+    TaskHandle_t worker;
+    std::atomic<bool> stopping;
+    std::atomic<bool> worker_running;
+    char batch[TELEGRAM_BATCH_MAX + 1];
+    uint16_t batch_length;
+    uint8_t batch_messages;
+    uint32_t post_times[TELEGRAM_RATE_PER_MIN];  // When recent sends were written, oldest at post_next once full
+    uint8_t post_count;
+    uint8_t post_next;
+    bool retry_pending;
+    uint32_t retry_at_ms;
+    uint32_t retry_delay_ms;
+    uint32_t retry_after_ms;  // From the last 429, 0 without
+    uint32_t last_used_ms;
+
+    static portMUX_TYPE lock;
+    static TelegramModule* instance;
+
+    static void workerMain(void* arg);
+    uint32_t step();
+    uint32_t idleWait(uint32_t now);
+    uint32_t sendWait(uint32_t now) const;
+    void enqueue(const char* text);
+    void takeBatch();
+    SendResult post();
+    void recordSend();
+    bool connect();
+    bool writeRequest();
+    void putEscaped(const char* text, size_t length);
+    void stopWorker();
+
+public:
+    TelegramModule();
+    ~TelegramModule() { stopWorker(); }
+
+    bool begin(const ConfigData& config) override;
+    void run() override {}
+    void end() override { stopWorker(); }
+
+    // Queues a notification for the configured chat; any task, not from
+    // interrupts. False while Telegram is disabled or not configured.
+    static bool send(const char* text);
+};
+
+#endif // TELEGRAM_MODULE_H
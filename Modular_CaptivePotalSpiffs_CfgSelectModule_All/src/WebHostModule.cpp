@@ -0,0 +1,370 @@
+#include "WebHostModule.h"
+#include <WiFi.h>
+#include "Metrics.h"
+#include "Log.h"
+
+#define WAIT_FOREVER UINT32_MAX
+
+static_assert(WEBHOST_BODY_MAX >= 2 * FLASH_LOG_RECORD_MAX, "WEBHOST_BODY_MAX must hold the longest record");
+
+portMUX_TYPE WebHostModule::lock = portMUX_INITIALIZER_UNLOCKED;
+WebHostModule* WebHostModule::instance = nullptr;
+
+WebHostModule::WebHostModule()
+    : writers(0), first_pending_ms(0), port(0), tls(false), http(WEBHOST_TIMEOUT_MS), worker(nullptr),
+      stopping(false), worker_running(false), waiting_for_link(false), link_lost(false), retry_pending(false),
+      retry_at_ms(0), retry_delay_ms(0), last_used_ms(0), body_length(0), body_records(0), body_first(0),
+      body_full(false) {
+    host[0] = '\0';
+    path[0] = '\0';
+    memset(&body_end, 0, sizeof(body_end));
+}
+
+// Scheme, host, optional port and path; the form validated it as http(s)
+bool WebHostModule::parseUrl(const char* url) {
+    if (strncmp(url, "https://", 8) == 0) {
+        tls = true;
+        port = 443;
+        url += 8;
+    } else if (strncmp(url, "http://", 7) == 0) {
+        tls = false;
+        port = 80;
+        url += 7;
+    } else {
+        return false;
+    }
+    size_t host_length = strcspn(url, ":/");
+    if (host_length == 0 || host_length >= sizeof(host)) {
+        return false;
+    }
+    memcpy(host, url, host_length);
+    host[host_length] = '\0';
+    url += host_length;
+    if (*url == ':') {
+        port = (uint16_t)atoi(url + 1);
+        url += strcspn(url, "/");
+    }
+    strlcpy(path, *url ? url : "/", sizeof(path));
+    return port != 0;
+}
+
+bool WebHostModule::begin(const ConfigData& config) {
+    if (!parseUrl(config.host_url)) {
+        LOG_W("Web host needs an http(s) URL");
+        return false;
+    }
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, WEBHOST_LOG_PARTITION);
+    if (!log.begin(partition)) {
+        LOG_E("No data partition for the upload log");
+        return false;
+    }
+    if (tls) {
+#ifdef WEBHOST_ROOT_CA
+        secure_client.setCACert(WEBHOST_ROOT_CA);
+#else
+        secure_client.setInsecure();
+#endif
+        http.use(secure_client);
+    } else {
+        http.use(plain_client);
+    }
+
+    // A backlog from before a restart goes out as soon as the link is up
+    first_pending_ms = millis() - WEBHOST_BATCH_DELAY_MS;
+    stopping = false;
+    worker_running = true;
+    if (xTaskCreatePinnedToCore(workerMain, "webhost", WEBHOST_TASK_STACK, this, WEBHOST_TASK_PRIORITY, &worker,
+                                WEBHOST_TASK_CORE) != pdPASS) {
+        LOG_E("Failed to start web host task");
+        worker_running = false;
+        worker = nullptr;
+        log.end();
+        return false;
+    }
+    Metrics::watchTask(worker);
+
+    portENTER_CRITICAL(&lock);
+    instance = this;
+    portEXIT_CRITICAL(&lock);
+    LOG_I("Uploading to %s:%u, %u records waiting", host, port, (unsigned)log.pending());
+    return true;
+}
+
+void WebHostModule::run() {
+    if (waiting_for_link.exchange(false)) {
+        xTaskNotifyGive(worker);
+    }
+}
+
+void WebHostModule::stopWorker() {
+    if (!worker) {
+        return;
+    }
+    portENTER_CRITICAL(&lock);
+    if (instance == this) {
+        instance = nullptr;
+    }
+    portEXIT_CRITICAL(&lock);
+    while (writers > 0) {
+        vTaskDelay(1);
+    }
+
+    // The worker finishes the upload it is in, at most two timeouts
+    Metrics::unwatchTask(worker);
+    stopping = true;
+    xTaskNotifyGive(worker);
+    uint32_t started = millis();
+    while (worker_running && millis() - started < 2 * WEBHOST_TIMEOUT_MS + 1000) {
+        vTaskDelay(10);
+    }
+    if (worker_running) {
+        LOG_E("Web host task did not stop, deleting it");
+        vTaskDelete(worker);
+    }
+    http.stop();
+    worker = nullptr;
+    log.end();
+}
+
+bool WebHostModule::record(const void* data, size_t length) {
+    portENTER_CRITICAL(&lock);
+    WebHostModule* self = instance;
+    if (self) {
+        self->writers++;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!self) {
+        return false;
+    }
+    bool was_empty = self->log.pending() == 0;
+    bool ok = self->log.append(data, length);
+    if (ok && was_empty) {
+        self->first_pending_ms = millis();
+        xTaskNotifyGive(self->worker);
+    }
+    self->writers--;
+    return ok;
+}
+
+uint32_t WebHostModule::backlog() {
+    portENTER_CRITICAL(&lock);
+    WebHostModule* self = instance;
+    if (self) {
+        self->writers++;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (!self) {
+        return 0;
+    }
+    uint32_t pending = self->log.pending();
+    self->writers--;
+    return pending;
+}
+
+void WebHostModule::workerMain(void* arg) {
+    WebHostModule* self = static_cast<WebHostModule*>(arg);
+    while (!self->stopping) {
+        uint32_t wait = self->step();
+        if (wait > 0) {
+            ulTaskNotifyTake(pdTRUE, wait == WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+        }
+    }
+    self->http.stop();
+    self->worker_running = false;
+    vTaskDelete(nullptr);
+}
+
+// One pass of the worker; returns how long to sleep, 0 to go on at once.
+// record() and run() wake it early.
+uint32_t WebHostModule::step() {
+    log.prepare();
+    uint32_t now = millis();
+    uint32_t pending = log.pending();
+    Metrics::set(MetricGauge::UPLOAD_BACKLOG, pending);
+    if (body_records == 0 && pending == 0) {
+        return idleWait(now);
+    }
+    if (WiFi.status() != WL_CONNECTED) {
+        http.stop();
+        link_lost = true;
+        waiting_for_link = true;  // run() wakes the worker once the link is back
+        requestRun();
+        return WAIT_FOREVER;
+    }
+    if (link_lost) {
+        // Failures while the link was down say nothing about the host
+        link_lost = false;
+        retry_pending = false;
+        retry_delay_ms = 0;
+    }
+    if (body_records == 0) {
+        uint32_t waited = now - first_pending_ms;
+        if (waited < WEBHOST_BATCH_DELAY_MS) {
+            return WEBHOST_BATCH_DELAY_MS - waited;
+        }
+    }
+    if (retry_pending && (int32_t)(retry_at_ms - now) > 0) {
+        return retry_at_ms - now;
+    }
+    if (body_records == 0) {
+        buildBody();
+        if (body_records == 0) {
+            return WEBHOST_BATCH_DELAY_MS;
+        }
+    }
+
+    uint32_t retry_after_ms = 0;
+    UploadResult result = upload(retry_after_ms);
+    if (result != UploadResult::DELIVERED) {
+        if (result == UploadResult::REJECTED) {
+            // Most likely the host's or our configuration (auth, URL): keep
+            // the records and ask rarely, the full log drops the oldest meanwhile
+            retry_delay_ms = WEBHOST_RETRY_MAX_MS;
+            retry_after_ms = 0;
+        } else if (retry_after_ms == 0) {
+            retry_delay_ms = retry_delay_ms == 0 ? WEBHOST_RETRY_MIN_MS : min((uint32_t)WEBHOST_RETRY_MAX_MS, retry_delay_ms * 2);
+        }
+        uint32_t wait = retry_after_ms != 0 ? retry_after_ms : retry_delay_ms / 2 + random(retry_delay_ms / 2 + 1);
+        retry_pending = true;
+        retry_at_ms = millis() + wait;
+        LOG_W("Upload failed, retrying in %lu ms", (unsigned long)wait);
+        return 0;
+    }
+
+    log.acknowledge(body_end);
+    Metrics::count(MetricCounter::UPLOAD_DELIVERED, body_records);
+    retry_pending = false;
+    retry_delay_ms = 0;
+    body_records = 0;
+    // A backlog goes on at once, records that came in meanwhile wait for company
+    first_pending_ms = body_full ? millis() - WEBHOST_BATCH_DELAY_MS : millis();
+    return 0;
+}
+
+// Nothing to send: close the connection once it has idled long enough
+uint32_t WebHostModule::idleWait(uint32_t now) {
+    if (!http.connected()) {
+        return WAIT_FOREVER;
+    }
+    uint32_t idle = now - last_used_ms;
+    if (idle >= WEBHOST_IDLE_CLOSE_MS) {
+        http.stop();
+        return WAIT_FOREVER;
+    }
+    return WEBHOST_IDLE_CLOSE_MS - idle;
+}
+
+// Reads records from the oldest on until the body is full
+void WebHostModule::buildBody() {
+    FlashLogPosition at = log.oldest();
+    body_records = 0;
+    body_full = false;
+#if WEBHOST_GZIP
+    gzip.begin(body, sizeof(body));
+#else
+    body_length = 0;
+#endif
+    for (;;) {
+        FlashLogPosition next = at;
+        uint16_t length;
+        if (!log.read(next, record_buffer, length)) {
+            break;
+        }
+#if WEBHOST_GZIP
+        bool fits = gzip.remaining() >= GzipWriter::bound(length + 1);
+#else
+        bool fits = body_length + length + 1 <= sizeof(body);
+#endif
+        if (!fits) {
+            body_full = true;
+            break;
+        }
+        if (body_records == 0) {
+            body_first = next.record - 1;
+        }
+#if WEBHOST_GZIP
+        gzip.write(record_buffer, length);
+        gzip.write("\n");
+#else
+        memcpy(body + body_length, record_buffer, length);
+        body_length += length;
+        body[body_length++] = '\n';
+#endif
+        body_records++;
+        at = next;
+    }
+#if WEBHOST_GZIP
+    gzip.finish();
+    body_length = gzip.size();
+#endif
+    body_end = at;
+}
+
+WebHostModule::UploadResult WebHostModule::upload(uint32_t& retry_after_ms) {
+    MetricTimer timer(MetricHistogram::UPLOAD_POST);
+    Metrics::count(MetricCounter::UPLOAD_REQUESTS);
+
+    // The host may have closed a kept-alive connection in the meantime:
+    // then the request is repeated once on a fresh one
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = http.connected();
+        if (!reused && !http.connect(host, port)) {
+            LOG_W("Upload: cannot connect to %s", host);
+            return UploadResult::RETRY;
+        }
+        HttpConnection::Reply reply = { -1, false, 0 };
+        if (writeRequest()) {
+            reply = http.readReply(nullptr, 0);
+        }
+        if (reply.status > 0) {
+            last_used_ms = millis();
+            if (reply.close) {
+                http.stop();
+            }
+            if (reply.status >= 200 && reply.status < 300) {
+                return UploadResult::DELIVERED;
+            }
+            if (reply.status == 408 || reply.status == 429 || reply.status >= 500) {
+                retry_after_ms = reply.retry_after_ms;
+                return UploadResult::RETRY;
+            }
+            LOG_E("Web host refused %u records (HTTP %d), keeping them", (unsigned)body_records, reply.status);
+            return UploadResult::REJECTED;
+        }
+        http.stop();
+        if (!reused) {
+            break;
+        }
+    }
+    return UploadResult::RETRY;
+}
+
+bool WebHostModule::writeRequest() {
+    char number[12];
+    http.put("POST ");
+    http.put(path);
+    http.put(" HTTP/1.1\r\nHost: ");
+    http.put(host);
+    if (port != (tls ? 443 : 80)) {
+        snprintf(number, sizeof(number), ":%u", port);
+        http.put(number);
+    }
+    http.put("\r\nContent-Type: application/x-ndjson\r\n");
+#if WEBHOST_GZIP
+    http.put("Content-Encoding: gzip\r\n");
+#endif
+    snprintf(number, sizeof(number), "%u", (unsigned)body_length);
+    http.put("Content-Length: ");
+    http.put(number);
+    snprintf(number, sizeof(number), "%lu", (unsigned long)body_first);
+    http.put("\r\nX-Record-Sequence: ");
+    http.put(number);
+    http.put("\r\nConnection: keep-alive\r\n\r\n");
+    http.put((const char*)body, body_length);
+    if (!http.flush()) {
+        return false;
+    }
+    Metrics::count(MetricCounter::UPLOAD_BODY_BYTES, body_length);
+    return true;
+}
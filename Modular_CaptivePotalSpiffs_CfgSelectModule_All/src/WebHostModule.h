@@ -0,0 +1,141 @@
+#ifndef WEB_HOST_MODULE_H
+#define WEB_HOST_MODULE_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "FlashLog.h"
+#include "GzipWriter.h"
+#include "HttpConnection.h"
+#include "PortalModule.h"
+
+// Data partition holding the upload log, by label; nullptr takes the first
+// SPIFFS one. Its file system must not be mounted.
+#ifndef WEBHOST_LOG_PARTITION
+#define WEBHOST_LOG_PARTITION nullptr
+#endif
+
+// How long the first record of a batch waits for more
+#ifndef WEBHOST_BATCH_DELAY_MS
+#define WEBHOST_BATCH_DELAY_MS 2000
+#endif
+// Request body of one batch, compressed
+#ifndef WEBHOST_BODY_MAX
+#define WEBHOST_BODY_MAX 4096
+#endif
+// 0 sends batches uncompressed, for hosts without Content-Encoding support
+#ifndef WEBHOST_GZIP
+#define WEBHOST_GZIP 1
+#endif
+
+// Delay after a failed upload, doubled per failure with random jitter;
+// Retry-After answers set their own
+#ifndef WEBHOST_RETRY_MIN_MS
+#define WEBHOST_RETRY_MIN_MS 2000
+#endif
+#ifndef WEBHOST_RETRY_MAX_MS
+#define WEBHOST_RETRY_MAX_MS 300000
+#endif
+
+#ifndef WEBHOST_IDLE_CLOSE_MS
+#define WEBHOST_IDLE_CLOSE_MS 30000
+#endif
+#ifndef WEBHOST_TIMEOUT_MS
+#define WEBHOST_TIMEOUT_MS 10000
+#endif
+
+#ifndef WEBHOST_TASK_STACK
+#define WEBHOST_TASK_STACK 8192
+#endif
+#ifndef WEBHOST_TASK_PRIORITY
+#define WEBHOST_TASK_PRIORITY 1
+#endif
+#ifndef WEBHOST_TASK_CORE
+#define WEBHOST_TASK_CORE 1
+#endif
+
+// Define WEBHOST_ROOT_CA as the PEM of the CA that signs the host's
+// certificate to verify https:// hosts; without it the connection is
+// encrypted but the certificate is not checked.
+
+// Store-and-forward upload to host_url. record() appends to a log on
+// flash, so records survive lost links and reboots. A worker task sends
+// them in order as POST requests of newline-separated records
+// (application/x-ndjson), gzip-compressed, over a kept-alive connection.
+// Records leave the log only when the host answered 2xx; the
+// X-Record-Sequence header numbers the first record of a batch so the
+// host can drop a batch it sees twice. Failures are retried with
+// exponential backoff and jitter, other answers at the longest delay; the
+// log's size bounds what is kept meanwhile.
+class WebHostModule : public PortalModule {
+private:
+    enum class UploadResult : uint8_t { DELIVERED, RETRY, REJECTED };
+
+    FlashLog log;
+    std::atomic<uint8_t> writers;           // record() calls still using the log
+    std::atomic<uint32_t> first_pending_ms;  // When the log last went from empty to not
+
+    // Worker side
+    char host[64];
+    char path[sizeof(ConfigData::host_url)];
+    uint16_t port;
+    bool tls;
+    WiFiClient plain_client;
+    WiFiClientSecure secure_client;
+    HttpConnection http;
+    TaskHandle_t worker;
+    std::atomic<bool> stopping;
+    std::atomic<bool> worker_running;
+    std::atomic<bool> waiting_for_link;
+    bool link_lost;
+    bool retry_pending;
+    uint32_t retry_at_ms;
+    uint32_t retry_delay_ms;
+    uint32_t last_used_ms;
+
+    // The batch in flight; kept until the host takes it
+#if WEBHOST_GZIP
+    GzipWriter gzip;
+#endif
+    uint8_t body[WEBHOST_BODY_MAX];
+    size_t body_length;
+    uint32_t body_records;
+    uint32_t body_first;   // Sequence number of its first record
+    FlashLogPosition body_end;
+    bool body_full;        // More records waited than fit
+    uint8_t record_buffer[FLASH_LOG_RECORD_MAX];
+
+    static portMUX_TYPE lock;
+    static WebHostModule* instance;
+
+    static void workerMain(void* arg);
+    uint32_t step();
+    uint32_t idleWait(uint32_t now);
+    bool parseUrl(const char* url);
+    void buildBody();
+    UploadResult upload(uint32_t& retry_after_ms);
+    bool writeRequest();
+    void stopWorker();
+
+public:
+    WebHostModule();
+    ~WebHostModule() { stopWorker(); }
+
+    bool begin(const ConfigData& config) override;
+    void run() override;
+    void end() override { stopWorker(); }
+
+    // Appends a record (at most FLASH_LOG_RECORD_MAX bytes, one line of
+    // the upload, e.g. JSON) to the log; any task, not from interrupts.
+    // Blocks for the flash write. False while the web host is disabled.
+    static bool record(const void* data, size_t length);
+    static bool record(const char* text) { return text && record(text, strlen(text)); }
+
+    // Records not yet acknowledged by the host
+    static uint32_t backlog();
+};
+
+#endif // WEB_HOST_MODULE_H
@@ -0,0 +1,107 @@
+#include "WiFiScanCache.h"
+
+WiFiScanCache::WiFiScanCache() : count(0), scanned_at(0), scanning(false), valid(false) {
+    portMUX_INITIALIZE(&lock);
+}
+
+bool WiFiScanCache::start() {
+    bool idle = false;
+    if (!scanning.compare_exchange_strong(idle, true)) {
+        return true; // Join the scan already in flight
+    }
+    if (WiFi.scanNetworks(true) != WIFI_SCAN_RUNNING) {
+        scanning = false;
+        return false;
+    }
+    return true;
+}
+
+bool WiFiScanCache::poll() {
+    if (!scanning) {
+        return false;
+    }
+    int16_t found = WiFi.scanComplete();
+    if (found == WIFI_SCAN_RUNNING) {
+        return false;
+    }
+    scanning = false;
+    if (found < 0) {
+        return false;
+    }
+
+    // Build off to the side (WiFi.SSID() allocates), then publish under the lock
+    ScanResult fresh[SCAN_CACHE_MAX_RESULTS];
+    uint8_t fresh_count = collect(found, fresh);
+    WiFi.scanDelete();
+
+    portENTER_CRITICAL(&lock);
+    memcpy(results, fresh, fresh_count * sizeof(ScanResult));
+    count = fresh_count;
+    scanned_at = millis();
+    valid = true;
+    portEXIT_CRITICAL(&lock);
+    return true;
+}
+
+uint8_t WiFiScanCache::collect(int16_t found, ScanResult* out) const {
+    uint8_t count = 0;
+    for (int16_t i = 0; i < found; i++) {
+        String ssid = WiFi.SSID(i);
+        if (ssid.length() == 0) {
+            continue; // Hidden network
+        }
+        int32_t rssi = WiFi.RSSI(i);
+
+        ScanResult* slot = nullptr;
+        for (uint8_t j = 0; j < count; j++) {
+            if (ssid == out[j].ssid) {
+                slot = &out[j];
+                break;
+            }
+        }
+        if (slot) {
+            if (rssi <= slot->rssi) {
+                continue;
+            }
+        } else if (count < SCAN_CACHE_MAX_RESULTS) {
+            slot = &out[count++];
+            strlcpy(slot->ssid, ssid.c_str(), sizeof(slot->ssid));
+        } else {
+            // Full: replace the weakest entry if this one is stronger
+            slot = &out[0];
+            for (uint8_t j = 1; j < count; j++) {
+                if (out[j].rssi < slot->rssi) {
+                    slot = &out[j];
+                }
+            }
+            if (rssi <= slot->rssi) {
+                continue;
+            }
+            strlcpy(slot->ssid, ssid.c_str(), sizeof(slot->ssid));
+        }
+        slot->rssi = rssi;
+        slot->channel = WiFi.channel(i);
+        slot->secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+        memcpy(slot->bssid, WiFi.BSSID(i), sizeof(slot->bssid));
+    }
+    return count;
+}
+
+const ScanResult* WiFiScanCache::find(const char* ssid) const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (strcmp(ssid, results[i].ssid) == 0) {
+            return &results[i];
+        }
+    }
+    return nullptr;
+}
+
+uint8_t WiFiScanCache::copyResults(ScanResult* out, uint8_t max, unsigned long& ageMs, bool& fresh) const {
+    portENTER_CRITICAL(&lock);
+    uint8_t n = min(count, max);
+    memcpy(out, results, n * sizeof(ScanResult));
+    ageMs = millis() - scanned_at;
+    fresh = valid && ageMs < SCAN_CACHE_TTL_MS;
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
@@ -0,0 +1,61 @@
+#ifndef WIFI_SCAN_CACHE_H
+#define WIFI_SCAN_CACHE_H
+
+#include <WiFi.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+
+#ifndef SCAN_CACHE_MAX_RESULTS
+#define SCAN_CACHE_MAX_RESULTS 20
+#endif
+#ifndef SCAN_CACHE_TTL_MS
+#define SCAN_CACHE_TTL_MS 30000
+#endif
+
+// One visible network, strongest BSSID per SSID
+struct ScanResult {
+    char ssid[33];
+    int32_t rssi;
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool secure;
+};
+
+// Results of the last asynchronous WiFi scan, deduplicated by SSID and kept
+// for SCAN_CACHE_TTL_MS. Only one scan is ever in flight; start() may be
+// called from any task and later callers share the running scan. poll() and
+// the direct accessors belong to the task driving the connection, other
+// tasks read through copyResults().
+class WiFiScanCache {
+private:
+    ScanResult results[SCAN_CACHE_MAX_RESULTS];
+    uint8_t count;
+    unsigned long scanned_at;
+    std::atomic<bool> scanning;
+    bool valid;
+    mutable portMUX_TYPE lock;
+
+    uint8_t collect(int16_t found, ScanResult* out) const;
+
+public:
+    WiFiScanCache();
+
+    // Starts a background scan unless one is already running
+    bool start();
+
+    // Picks up finished results; returns true when a scan just completed
+    bool poll();
+
+    bool isScanning() const { return scanning; }
+    bool isFresh() const { return valid && millis() - scanned_at < SCAN_CACHE_TTL_MS; }
+    unsigned long age() const { return millis() - scanned_at; }
+
+    uint8_t size() const { return count; }
+    const ScanResult& operator[](uint8_t index) const { return results[index]; }
+    const ScanResult* find(const char* ssid) const;
+
+    // Consistent copy for readers in other tasks; returns the number copied
+    uint8_t copyResults(ScanResult* out, uint8_t max, unsigned long& ageMs, bool& fresh) const;
+};
+
+#endif // WIFI_SCAN_CACHE_H
@@ -1,7 +1,9 @@
 #include "ESP32ConfigPortal.h"
+#include "TelegramModule.h"
+#include "WebHostModule.h"
 
 //Pototype function
-void runYourApplication();
+uint32_t runYourApplication();
 
 
 // Create config portal instance
@@ -12,10 +14,13 @@ String deviceName = "MyESP32Device";
 bool applicationRunning = false;
 
 void onConfigurationReceived(const ConfigData& config) {
-    Serial.println("=== New Configuration Received ===");
-    Serial.println("WiFi SSID: " + config.wifi_ssid);
-    Serial.println("Telegram Active: " + String(config.tg_active));
-    Serial.println("Host Active: " + String(config.host_active));
+    LOG_I("=== New Configuration Received ===");
+    for (uint8_t i = 0; i < config.wifi_profile_count; i++) {
+        LOG_I("WiFi SSID: %s", config.wifi_profiles[i].ssid);
+    }
+    // Secrets are redacted where they are logged
+    LOG_I("Telegram Active: %d, token %s", config.tg_active, Log::redact(config.tg_token));
+    LOG_I("Host Active: %d", config.host_active);
     
     // You can process the configuration here
     // For example, initialize Telegram bot, setup web connections, etc.
@@ -23,15 +28,16 @@ void onConfigurationReceived(const ConfigData& config) {
 }
 
 void onWiFiConnected() {
-    Serial.println("WiFi connected successfully!");
+    LOG_I("WiFi connected successfully!");
     applicationRunning = true;
+
     
     // Initialize your application components here
     // For example: start web server, connect to MQTT, etc.
 }
 
 void onWiFiDisconnected() {
-    Serial.println("WiFi disconnected!");
+    LOG_W("WiFi disconnected!");
     applicationRunning = false;
     
     // Handle disconnection here
@@ -39,79 +45,112 @@ void onWiFiDisconnected() {
 }
 
 void onConfigReset() {
-    Serial.println("Configuration was reset!");
+    LOG_I("Configuration was reset!");
     applicationRunning = false;
     
     // Handle reset here
     // For example: clear application data, stop services, etc.
 }
 
+void onButtonPressed(ButtonEvent event) {
+    // Short press reopens the portal; a factory-reset hold is handled by the library
+    if (event == ButtonEvent::SHORT_PRESS) {
+        LOG_I("Button pressed, entering configuration mode");
+        configPortal.forceConfigMode();
+    }
+}
+
 void setup() {
     Serial.begin(115200);
-    Serial.println("Starting " + deviceName);
+    Log::begin();
+    LOG_I("Starting %s", deviceName.c_str());
     
     // Configure the portal settings (optional)
     configPortal.setWiFiTimeout(30000);  // 30 seconds
     configPortal.setResetHoldTime(3000); // 3 seconds
     configPortal.setStatusPrintInterval(60000); // 1 minute
+    configPortal.setPowerSave(true);            // Light-sleep and 80-240 MHz once online
     
     // Set up callbacks
     configPortal.onConfig(onConfigurationReceived);
     configPortal.onWiFiConnect(onWiFiConnected);
     configPortal.onWiFiDisconnect(onWiFiDisconnected);
     configPortal.onReset(onConfigReset);
+    configPortal.onButton(onButtonPressed);
+    
+    // Integrations; the portal form only shows their sections. The portal
+    // constructs each one only while its "active" flag is set, so a
+    // disabled integration takes no RAM and no start-up time. Subclass
+    // PortalModule for your own.
+    configPortal.addModule<TelegramModule>(ConfigSection::telegram);
+    configPortal.addModule<WebHostModule>(ConfigSection::host);
     
     // Optional: Set custom HTML
     // configPortal.setCustomHTML(myCustomHTML, myCustomSuccessHTML);
     
-    // Start the configuration portal
+    // Start the configuration portal.
+    // Alternatively configPortal.begin(PortalMode::ASYNC) returns immediately and
+    // serves the portal from a background task; use configPortal.waitForSetup()
+    // or getPortalStatus() to find out when the device is online.
     if (configPortal.begin()) {
-        Serial.println("Configuration portal started successfully");
+        LOG_I("Configuration portal started successfully");
         
         // Get current configuration
-        ConfigData currentConfig = configPortal.getConfig();
-        Serial.println("Current WiFi: " + currentConfig.wifi_ssid);
+        const WiFiProfile* profile = configPortal.getActiveProfile();
+        if (profile) {
+            LOG_I("Current WiFi: %s", profile->ssid);
+        }
         
         applicationRunning = true;
     } else {
-        Serial.println("Failed to start configuration portal");
+        LOG_E("Failed to start configuration portal");
     }
 }
 
 void loop() {
-    // Handle configuration portal (must be called regularly)
+    // Handle configuration portal (after every wakeup)
     configPortal.handle();
     
     // Your main application logic here
+    uint32_t nextAction = PORTAL_NEVER;
     if (applicationRunning && configPortal.isWiFiConnected()) {
         // Example: Your application code
-        runYourApplication();
+        nextAction = runYourApplication();
     }
     
-    delay(100);
+    // Sleep until the portal has work or the application's next action is
+    // due. Build with -DPORTAL_LOOP_STATS_MS=60000 to log wakeups per second
+    // and idle time.
+    configPortal.waitForWork(nextAction);
 }
 
-void runYourApplication() {
-    // Get current configuration when needed
-    ConfigData config = configPortal.getConfig();
-    
-    // Example: Use Telegram if enabled
-    if (config.tg_active && config.tg_token.length() > 0) {
-        // Your Telegram bot code here
-        // handleTelegramMessages(config.tg_token);
-    }
-    
-    // Example: Use web host if enabled
-    if (config.host_active && config.host_url.length() > 0) {
-        // Your web host communication code here
-        // sendDataToHost(config.host_url, someData);
+// Returns the milliseconds until it has something to do again
+uint32_t runYourApplication() {
+    // Telegram and the web host run as modules, started by configPortal.handle()
+    static uint32_t appliedVersion = 0;
+    if (configPortal.configVersion() != appliedVersion) {
+        appliedVersion = configPortal.configVersion();
+        LOG_I("Configuration version %lu in use, %u modules running",
+              (unsigned long)appliedVersion, configPortal.runningModules());
     }
     
     // Your other application logic
     static unsigned long lastAction = 0;
-    if (millis() - lastAction > 10000) { // Every 10 seconds
+    if (millis() - lastAction >= 10000) { // Every 10 seconds
         lastAction = millis();
-        Serial.println("Application running normally...");
+        LOG_D("Application running normally...");
+        
+        // Example: Notify through Telegram. Queued and sent in the
+        // background; returns false while Telegram is disabled.
+        // if (alarmTriggered) {
+        //     TelegramModule::send("Alarm triggered");
+        // }
+
+        // Example: Report a reading to the web host. Kept on flash until
+        // the host has it; returns false while the web host is disabled.
+        // char line[64];
+        // snprintf(line, sizeof(line), "{\"t\":%lu,\"temp\":%.1f}", millis(), temperature);
+        // WebHostModule::record(line);
         
         // Example: Force config mode under certain conditions
         // if (someErrorCondition) {
@@ -123,4 +162,5 @@ void runYourApplication() {
         //     configPortal.resetConfig();
         // }
     }
+    return PortalScheduler::remaining(lastAction, 10000);
 }
\ No newline at end of file
@@ -0,0 +1,288 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// Host stand-in for the parts of the ESP32 Arduino core the library uses.
+// Time, pins and the heap are driven by the harness, see FakeDevice.h.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define F(s) (s)
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// glibc before 2.38 has no strlcpy
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t n = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return length;
+}
+#endif
+
+class String {
+protected:
+    std::string s;
+
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const String& other) : s(other.s) {}
+    String(String&& other) : s(std::move(other.s)) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(int v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned int v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(long v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned long v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(long long v, unsigned char base = 10) { fromSigned(v, base); }
+    explicit String(unsigned long long v, unsigned char base = 10) { fromUnsigned(v, base); }
+    explicit String(float v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+    explicit String(double v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+
+    String& operator=(const String& other) { s = other.s; return *this; }
+    String& operator=(String&& other) { s = std::move(other.s); return *this; }
+    String& operator=(const char* c) { s = c ? c : ""; return *this; }
+
+    unsigned int length() const { return s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(const char* c) { if (c) s += c; return c != nullptr; }
+    bool concat(const char* c, unsigned int n) { s.append(c, n); return true; }
+    bool concat(char c) { s += c; return true; }
+    template <typename T> bool concat(T v) { s += String(v).s; return true; }
+
+    String& operator+=(const String& other) { concat(other); return *this; }
+    String& operator+=(const char* c) { concat(c); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    template <typename T> String& operator+=(T v) { concat(v); return *this; }
+
+    bool equals(const String& other) const { return s == other.s; }
+    bool equals(const char* c) const { return s == (c ? c : ""); }
+    bool equalsIgnoreCase(const String& other) const {
+        return s.size() == other.s.size() && strcasecmp(s.c_str(), other.s.c_str()) == 0;
+    }
+    bool operator==(const String& other) const { return equals(other); }
+    bool operator==(const char* c) const { return equals(c); }
+    bool operator!=(const String& other) const { return !equals(other); }
+    bool operator!=(const char* c) const { return !equals(c); }
+    bool operator<(const String& other) const { return s < other.s; }
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+    }
+
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return s[i]; }
+
+    int indexOf(char c, unsigned int from = 0) const { return position(s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return position(s.find(str.s, from)); }
+    int lastIndexOf(char c) const { return position(s.rfind(c)); }
+    String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from).c_str()) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from < s.size() ? String(s.substr(from, to - from).c_str()) : String();
+    }
+
+    void replace(const String& find, const String& with) {
+        if (find.s.empty()) return;
+        for (size_t pos = s.find(find.s); pos != std::string::npos; pos = s.find(find.s, pos + with.s.size())) {
+            s.replace(pos, find.s.size(), with.s);
+        }
+    }
+    void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+    void toLowerCase() { for (size_t i = 0; i < s.size(); i++) s[i] = tolower(s[i]); }
+    void toUpperCase() { for (size_t i = 0; i < s.size(); i++) s[i] = toupper(s[i]); }
+    void trim() {
+        size_t begin = s.find_first_not_of(" \t\r\n");
+        size_t end = s.find_last_not_of(" \t\r\n");
+        s = begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+    }
+
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    double toDouble() const { return atof(s.c_str()); }
+
+private:
+    static int position(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+    void fromSigned(long long v, unsigned char base) {
+        if (v < 0 && base == 10) { fromUnsigned(-(unsigned long long)v, base); s.insert(s.begin(), '-'); }
+        else fromUnsigned((unsigned long long)v, base);
+    }
+    void fromUnsigned(unsigned long long v, unsigned char base) {
+        char buf[66];
+        char* p = buf + sizeof(buf) - 1;
+        *p = '\0';
+        do { *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[v % base]; v /= base; } while (v);
+        s = p;
+    }
+    void fromDouble(double v, unsigned int decimals) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        s = buf;
+    }
+};
+
+// Result type of String concatenation, as in the Arduino core
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* c) : String(c) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String& a, const char* b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const char* a, const String& b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String& a, char b) { StringSumHelper r(a); r.concat(b); return r; }
+template <typename T>
+inline StringSumHelper operator+(const String& a, T b) { StringSumHelper r(a); r.concat(String(b)); return r; }
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str(), str.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(const Printable& x) { return x.printTo(*this); }
+    size_t print(int v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned int v, int base = 10) { return print(String(v, base)); }
+    size_t print(long v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = 10) { return print(String(v, base)); }
+    size_t print(long long v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned long long v, int base = 10) { return print(String(v, base)); }
+    size_t print(unsigned char v, int base = 10) { return print(String(v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(const T& v, int format) { size_t n = print(v, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        return n < 0 ? 0 : write(buf, min((size_t)n, sizeof(buf) - 1));
+    }
+
+    virtual void flush() {}
+};
+
+class IPAddress : public Printable {
+    uint8_t bytes[4];
+
+public:
+    IPAddress() { memset(bytes, 0, sizeof(bytes)); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d; }
+    IPAddress(uint32_t address) { memcpy(bytes, &address, sizeof(bytes)); }
+    operator uint32_t() const { uint32_t v; memcpy(&v, bytes, sizeof(v)); return v; }
+    bool operator==(const IPAddress& other) const { return memcmp(bytes, other.bytes, sizeof(bytes)) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+    uint8_t operator[](int i) const { return bytes[i]; }
+    uint8_t& operator[](int i) { return bytes[i]; }
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+        return String(buf);
+    }
+    size_t printTo(Print& p) const override { return p.print(toString()); }
+};
+
+// Output is captured, see fake::serialOutput()
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    int availableForWrite() { return 128; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    [[noreturn]] void restart();  // Throws fake::Restart
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getHeapSize();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+#endif // FAKE_ARDUINO_H
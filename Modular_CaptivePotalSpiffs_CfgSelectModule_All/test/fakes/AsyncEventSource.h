@@ -0,0 +1,70 @@
+#ifndef FAKE_ASYNC_EVENT_SOURCE_H
+#define FAKE_ASYNC_EVENT_SOURCE_H
+
+#include <list>
+#include <mutex>
+
+// Server-Sent Events as ESPAsyncWebServer provides them. Messages reach the
+// test's stream (fake::openEvents) as soon as they are sent; nothing queues.
+
+class AsyncEventSource;
+
+class AsyncEventSourceClient {
+    AsyncEventSource* _server;
+    int _stream;  // fake::openEvents handle
+    uint32_t _lastId;
+
+public:
+    AsyncEventSourceClient(AsyncEventSource* server, int stream, uint32_t lastId);
+    ~AsyncEventSourceClient();
+
+    bool send(const char* message, const char* event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+    void close();
+    bool connected() const { return true; }  // Closed clients are deleted
+    uint32_t lastId() const { return _lastId; }
+    size_t packetsWaiting() const { return 0; }
+
+    // Harness side
+    int _getStream() const { return _stream; }
+};
+
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+class AsyncEventSource : public AsyncWebHandler {
+    String _url;
+    std::list<AsyncEventSourceClient*> _clients;
+    mutable std::recursive_mutex _lock;
+    ArEventHandlerFunction _connectcb;
+
+public:
+    explicit AsyncEventSource(const String& url) : _url(url) {}
+    ~AsyncEventSource();
+
+    const char* url() const { return _url.c_str(); }
+    void close();
+    void onConnect(ArEventHandlerFunction cb) { _connectcb = cb; }
+    void send(const char* message, const char* event = NULL, uint32_t id = 0, uint32_t reconnect = 0);
+    size_t count() const;
+    size_t avgPacketsWaiting() const { return 0; }
+
+    bool canHandle(AsyncWebServerRequest* request) const override;
+    // Keeps the connection as a client; no response is sent
+    void handleRequest(AsyncWebServerRequest* request) override;
+
+    // Library side
+    void _removeClient(AsyncEventSourceClient* client);
+};
+
+namespace fake {
+namespace detail {
+
+// Streams of fake::openEvents, kept by FakeNetwork.cpp
+int openEventStream();
+void attachEventStream(int stream, AsyncEventSourceClient* client);
+void eventSent(int stream, const char* event, const char* data, uint32_t id);
+void closeEventStream(int stream);
+
+} // namespace detail
+} // namespace fake
+
+#endif // FAKE_ASYNC_EVENT_SOURCE_H
@@ -0,0 +1,25 @@
+#ifndef FAKE_ASYNC_TCP_H
+#define FAKE_ASYNC_TCP_H
+
+// Host stand-in for AsyncTCP: requests are injected in-process, the client
+// only reports its peer (fake::setHttpClient())
+
+#include <Arduino.h>
+
+class AsyncClient {
+    IPAddress _remote;
+
+public:
+    AsyncClient() : _remote(192, 168, 4, 2) {}
+    IPAddress remoteIP() const { return _remote; }
+    uint16_t remotePort() const { return 49152; }
+    IPAddress localIP() const { return IPAddress(192, 168, 4, 1); }
+    uint16_t localPort() const { return 80; }
+    bool connected() const { return true; }
+    void close(bool now = false) { (void)now; }
+
+    // Harness side
+    void _setRemoteIP(const IPAddress& address) { _remote = address; }
+};
+
+#endif // FAKE_ASYNC_TCP_H
@@ -0,0 +1,55 @@
+#ifndef FAKE_ASYNC_UDP_H
+#define FAKE_ASYNC_UDP_H
+
+// Host stand-in for AsyncUDP: datagrams are injected in-process by
+// fake::dnsLookup(), and the packet callback runs in the sending thread
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+
+class AsyncUDP;
+
+class AsyncUDPPacket {
+    const uint8_t* _data;
+    size_t _length;
+    IPAddress _remote;
+    uint16_t _remotePort;
+    std::string* _reply;
+
+public:
+    AsyncUDPPacket(const uint8_t* data, size_t length, const IPAddress& remote, uint16_t remotePort, std::string* reply)
+        : _data(data), _length(length), _remote(remote), _remotePort(remotePort), _reply(reply) {}
+
+    uint8_t* data() { return const_cast<uint8_t*>(_data); }
+    size_t length() const { return _length; }
+    IPAddress remoteIP() const { return _remote; }
+    uint16_t remotePort() const { return _remotePort; }
+    IPAddress localIP() const { return IPAddress(192, 168, 4, 1); }
+
+    // Sends a datagram back to the sender
+    size_t write(const uint8_t* data, size_t length);
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP {
+    uint16_t _port;
+    bool _listening;
+    AuPacketHandlerFunction _handler;
+
+public:
+    AsyncUDP() : _port(0), _listening(false) {}
+    ~AsyncUDP() { close(); }
+
+    bool listen(uint16_t port);
+    void close();
+    bool connected() const { return _listening; }
+    void onPacket(AuPacketHandlerFunction handler) { _handler = handler; }
+
+    // Harness side
+    uint16_t _getPort() const { return _port; }
+    void _deliver(AsyncUDPPacket& packet) { if (_handler) _handler(packet); }
+};
+
+#endif // FAKE_ASYNC_UDP_H
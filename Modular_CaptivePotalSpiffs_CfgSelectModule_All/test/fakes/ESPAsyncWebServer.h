@@ -0,0 +1,283 @@
+#ifndef FAKE_ESP_ASYNC_WEB_SERVER_H
+#define FAKE_ESP_ASYNC_WEB_SERVER_H
+
+// Host stand-in for ESPAsyncWebServer. Handlers, responses and headers are
+// allocated the way the library does; there is no socket, requests are
+// injected with fake::http() and answered in the calling thread.
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <functional>
+#include <list>
+#include <vector>
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+
+class AsyncWebParameter {
+    String _name;
+    String _value;
+    bool _isForm;
+
+public:
+    AsyncWebParameter(const String& name, const String& value, bool form = false)
+        : _name(name), _value(value), _isForm(form) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    size_t size() const { return _value.length(); }
+    bool isPost() const { return _isForm; }
+    bool isFile() const { return false; }
+};
+
+typedef AsyncWebParameter AsyncWebParam;
+
+class AsyncWebHeader {
+    String _name;
+    String _value;
+
+public:
+    AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+    const String& name() const { return _name; }
+    const String& value() const { return _value; }
+    String toString() const { return _name + ": " + _value + "\r\n"; }
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                           size_t total)> ArBodyHandlerFunction;
+typedef std::function<void()> ArDisconnectHandler;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebServerResponse {
+protected:
+    int _code;
+    String _contentType;
+    size_t _contentLength;
+    std::list<AsyncWebHeader> _headers;
+
+public:
+    AsyncWebServerResponse(int code = 200, const char* contentType = "")
+        : _code(code), _contentType(contentType), _contentLength(0) {}
+    virtual ~AsyncWebServerResponse() {}
+
+    void setCode(int code) { _code = code; }
+    int code() const { return _code; }
+    void setContentType(const char* type) { _contentType = type; }
+    const String& contentType() const { return _contentType; }
+    void setContentLength(size_t length) { _contentLength = length; }
+    bool addHeader(const char* name, const char* value, bool replaceExisting = true);
+    bool addHeader(const String& name, const String& value, bool replaceExisting = true) {
+        return addHeader(name.c_str(), value.c_str(), replaceExisting);
+    }
+    const std::list<AsyncWebHeader>& getHeaders() const { return _headers; }
+
+    // Whole body, for the harness
+    virtual void _fillBody(std::string& out) = 0;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+    String _content;
+
+public:
+    AsyncBasicResponse(int code, const char* contentType, const String& content)
+        : AsyncWebServerResponse(code, contentType), _content(content) {
+        _contentLength = _content.length();
+    }
+    void _fillBody(std::string& out) override { out.assign(_content.c_str(), _content.length()); }
+};
+
+// Sent straight from the caller's buffer (flash on the device), no copy
+class AsyncProgmemResponse : public AsyncWebServerResponse {
+    const uint8_t* _content;
+
+public:
+    AsyncProgmemResponse(int code, const char* contentType, const uint8_t* content, size_t length)
+        : AsyncWebServerResponse(code, contentType), _content(content) {
+        _contentLength = length;
+    }
+    void _fillBody(std::string& out) override { out.assign((const char*)_content, _contentLength); }
+};
+
+class AsyncCallbackResponse : public AsyncWebServerResponse {
+    AwsResponseFiller _filler;
+    bool _chunked;
+
+public:
+    AsyncCallbackResponse(const char* contentType, size_t length, AwsResponseFiller filler, bool chunked)
+        : AsyncWebServerResponse(200, contentType), _filler(filler), _chunked(chunked) {
+        _contentLength = length;
+    }
+    void _fillBody(std::string& out) override;
+};
+
+typedef AsyncCallbackResponse AsyncChunkedResponse;
+
+// Body is written through Print into a buffer that grows as needed
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _length;
+
+public:
+    AsyncResponseStream(const char* contentType, size_t bufferSize);
+    ~AsyncResponseStream();
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override;
+    using Print::write;
+    size_t available() const { return _length; }
+    void _fillBody(std::string& out) override { out.assign((const char*)_buffer, _length); }
+};
+
+class AsyncWebHandler {
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest* request) const = 0;
+    virtual void handleRequest(AsyncWebServerRequest* request) = 0;
+    virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                              size_t len, bool final) {
+        (void)request; (void)filename; (void)index; (void)data; (void)len; (void)final;
+    }
+    virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+        (void)request; (void)data; (void)len; (void)index; (void)total;
+    }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+    String _uri;
+    WebRequestMethodComposite _method;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+
+public:
+    AsyncCallbackWebHandler() : _method(HTTP_ANY) {}
+    void setUri(const String& uri) { _uri = uri; }
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+    void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+    void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+    bool canHandle(AsyncWebServerRequest* request) const override;
+    void handleRequest(AsyncWebServerRequest* request) override;
+    void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data,
+                      size_t len, bool final) override;
+    void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) override;
+};
+
+class AsyncWebServerRequest {
+    friend class AsyncWebServer;
+
+    AsyncWebServer* _server;
+    AsyncClient _client;
+    WebRequestMethodComposite _method;
+    String _url;
+    String _contentType;
+    size_t _contentLength;
+    std::vector<AsyncWebParameter> _params;
+    std::vector<AsyncWebHeader> _headers;
+    AsyncWebServerResponse* _response;
+    ArDisconnectHandler _onDisconnect;
+
+public:
+    void* _tempObject;  // Freed with free() when the request ends
+
+    AsyncWebServerRequest(AsyncWebServer* server, WebRequestMethodComposite method, const String& url);
+    ~AsyncWebServerRequest();
+
+    AsyncClient* client() { return &_client; }
+    WebRequestMethodComposite method() const { return _method; }
+    const String& url() const { return _url; }
+    const String& contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+
+    size_t params() const { return _params.size(); }
+    bool hasParam(const char* name, bool post = false, bool file = false) const { return getParam(name, post, file) != nullptr; }
+    bool hasParam(const String& name, bool post = false, bool file = false) const { return hasParam(name.c_str(), post, file); }
+    const AsyncWebParameter* getParam(const char* name, bool post = false, bool file = false) const;
+    const AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const {
+        return getParam(name.c_str(), post, file);
+    }
+    const AsyncWebParameter* getParam(size_t index) const { return index < _params.size() ? &_params[index] : nullptr; }
+    bool hasArg(const char* name) const { return hasParam(name) || hasParam(name, true); }
+    const String& arg(const char* name) const;
+
+    size_t headers() const { return _headers.size(); }
+    bool hasHeader(const char* name) const { return getHeader(name) != nullptr; }
+    bool hasHeader(const String& name) const { return hasHeader(name.c_str()); }
+    const AsyncWebHeader* getHeader(const char* name) const;
+    const AsyncWebHeader* getHeader(const String& name) const { return getHeader(name.c_str()); }
+    const String& header(const char* name) const;
+
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = fn; }
+
+    // Basic credentials in the Authorization header; digest is not modeled
+    bool authenticate(const char* username, const char* password, const char* realm = NULL, bool passwordIsHash = false) const;
+    void requestAuthentication(const char* realm = NULL, bool isDigest = true);
+
+    void send(AsyncWebServerResponse* response);
+    void send(int code, const char* contentType = "", const char* content = "");
+    void send(int code, const String& contentType, const String& content = String());
+    void send(int code, const char* contentType, const uint8_t* content, size_t len);
+    void redirect(const char* url, int code = 302);
+
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType = "", const char* content = "");
+    AsyncWebServerResponse* beginResponse(int code, const String& contentType, const String& content = String());
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType, const uint8_t* content, size_t len);
+    AsyncWebServerResponse* beginResponse(const char* contentType, size_t len, AwsResponseFiller filler);
+    AsyncWebServerResponse* beginChunkedResponse(const char* contentType, AwsResponseFiller filler);
+    AsyncResponseStream* beginResponseStream(const char* contentType, size_t bufferSize = 1460);
+
+    // Harness side
+    void _addParam(const String& name, const String& value, bool post);
+    void _addHeader(const String& name, const String& value);
+    void _setBody(const String& contentType, size_t length) { _contentType = contentType; _contentLength = length; }
+    AsyncWebServerResponse* _sent() const { return _response; }
+};
+
+class AsyncWebServer {
+    uint16_t _port;
+    bool _running;
+    std::list<AsyncWebHandler*> _handlers;
+    AsyncCallbackWebHandler _catchAll;
+
+public:
+    explicit AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+    void reset();
+
+    AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr);
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+    bool removeHandler(AsyncWebHandler* handler);
+    void onNotFound(ArRequestHandlerFunction fn) { _catchAll.onRequest(fn); }
+
+    // Harness side
+    uint16_t _getPort() const { return _port; }
+    bool _isRunning() const { return _running; }
+    AsyncWebHandler* _findHandler(AsyncWebServerRequest* request);
+};
+
+#include "AsyncEventSource.h"
+
+#endif // FAKE_ESP_ASYNC_WEB_SERVER_H
@@ -0,0 +1,293 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <Arduino.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <map>
+
+// Serial capture, GPIO levels with interrupts, power management and ESP
+// system calls
+
+HardwareSerial Serial;
+EspClass ESP;
+gpio_dev_t GPIO;
+
+namespace fake {
+namespace {
+
+struct Pin {
+    int level;
+    void (*handler)(void*);
+    void* arg;
+    int mode;
+    int wake_level;  // -1, or the level that wakes; it replaces mode
+    bool enabled;    // Interrupt unmasked
+};
+
+std::mutex serial_mutex;
+std::string serial_output;
+bool serial_echo = false;
+
+std::mutex gpio_mutex;
+std::map<uint8_t, Pin> pins;
+
+std::mutex power_mutex;
+PowerConfig power;
+bool light_sleep_supported = true;
+
+Pin& pin(uint8_t number) {
+    HeapPause pause;
+    std::map<uint8_t, Pin>::iterator it = pins.find(number);
+    if (it == pins.end()) {
+        Pin idle = { HIGH, nullptr, nullptr, 0, -1, false };
+        it = pins.insert(std::make_pair(number, idle)).first;
+    }
+    return it->second;
+}
+
+void captureSerial(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> guard(serial_mutex);
+    HeapPause pause;
+    serial_output.append((const char*)data, size);
+    if (serial_echo) {
+        fwrite(data, 1, size, stdout);
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+void resetSerial() {
+    clearSerial();
+}
+
+void resetGpio() {
+    std::lock_guard<std::mutex> guard(gpio_mutex);
+    HeapPause pause;
+    pins.clear();
+}
+
+void resetPower() {
+    std::lock_guard<std::mutex> guard(power_mutex);
+    memset(&power, 0, sizeof(power));
+    light_sleep_supported = true;
+}
+
+} // namespace detail
+
+const std::string& serialOutput() {
+    return serial_output;
+}
+
+bool serialContains(const char* text) {
+    std::lock_guard<std::mutex> guard(serial_mutex);
+    return serial_output.find(text) != std::string::npos;
+}
+
+void clearSerial() {
+    std::lock_guard<std::mutex> guard(serial_mutex);
+    HeapPause pause;
+    serial_output.clear();
+}
+
+void echoSerial(bool enabled) {
+    serial_echo = enabled;
+}
+
+void setPin(uint8_t number, int level) {
+    void (*handler)(void*) = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(gpio_mutex);
+        Pin& p = pin(number);
+        bool rising = p.level == LOW && level != LOW;
+        bool falling = p.level != LOW && level == LOW;
+        bool reached = p.wake_level >= 0 && p.level != level && level == p.wake_level;
+        p.level = level;
+        bool edge = p.wake_level < 0 && ((p.mode == CHANGE && (rising || falling)) || (p.mode == RISING && rising) ||
+                                         (p.mode == FALLING && falling));
+        if (p.handler && p.enabled && (edge || reached)) {
+            handler = p.handler;
+            arg = p.arg;
+        }
+    }
+    if (handler) {
+        handler(arg);
+    }
+}
+
+int wakeLevel(uint8_t number) {
+    std::lock_guard<std::mutex> guard(gpio_mutex);
+    return pin(number).wake_level;
+}
+
+PowerConfig powerConfig() {
+    std::lock_guard<std::mutex> guard(power_mutex);
+    return power;
+}
+
+void setLightSleepSupported(bool supported) {
+    std::lock_guard<std::mutex> guard(power_mutex);
+    light_sleep_supported = supported;
+}
+
+} // namespace fake
+
+esp_err_t esp_pm_configure(const void* config) {
+    const esp_pm_config_t* pm = (const esp_pm_config_t*)config;
+    std::lock_guard<std::mutex> guard(fake::power_mutex);
+    fake::power.calls++;
+    if (!pm || pm->min_freq_mhz > pm->max_freq_mhz) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pm->light_sleep_enable && !fake::light_sleep_supported) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    fake::power.max_freq_mhz = pm->max_freq_mhz;
+    fake::power.min_freq_mhz = pm->min_freq_mhz;
+    fake::power.light_sleep = pm->light_sleep_enable;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    std::lock_guard<std::mutex> guard(fake::power_mutex);
+    fake::power.gpio_wakeup = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::pin(gpio_num).wake_level = intr_type == GPIO_INTR_LOW_LEVEL ? LOW : HIGH;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::pin(gpio_num).wake_level = -1;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    void (*handler)(void*) = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+        fake::Pin& p = fake::pin(gpio_num);
+        p.enabled = true;
+        if (p.handler && p.wake_level >= 0 && p.level == p.wake_level) {
+            handler = p.handler;
+            arg = p.arg;
+        }
+    }
+    if (handler) {
+        handler(arg);
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::pin(gpio_num).enabled = false;
+    return ESP_OK;
+}
+
+void gpio_ll_intr_disable(gpio_dev_t* hw, uint32_t gpio_num) {
+    (void)hw;
+    gpio_intr_disable((gpio_num_t)gpio_num);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    fake::captureSerial(&c, 1);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    fake::captureSerial(buffer, size);
+    return size;
+}
+
+void EspClass::restart() {
+    throw fake::Restart();
+}
+
+uint32_t EspClass::getFreeHeap() {
+    fake::HeapModel heap = fake::heapModel();
+    return (uint32_t)(heap.size - heap.used);
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    fake::HeapModel heap = fake::heapModel();
+    return (uint32_t)(heap.size - heap.peak_used);
+}
+
+// Largest block less its allocator header
+uint32_t EspClass::getMaxAllocHeap() {
+    fake::HeapModel heap = fake::heapModel();
+    return heap.largest_free > 8 ? (uint32_t)(heap.largest_free - 8) : 0;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return (uint32_t)fake::heapModel().size;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+int digitalRead(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    return fake::pin(pin).level;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::pin(pin).level = value;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::Pin& p = fake::pin(pin);
+    p.handler = handler;
+    p.arg = arg;
+    p.mode = mode;
+    p.enabled = true;
+}
+
+static void (*plain_handlers[64])(void);
+
+static void callPlainHandler(void* arg) {
+    plain_handlers[(uintptr_t)arg]();
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+    plain_handlers[pin % 64] = handler;
+    attachInterruptArg(pin, callPlainHandler, (void*)(uintptr_t)(pin % 64), mode);
+}
+
+void detachInterrupt(uint8_t pin) {
+    std::lock_guard<std::mutex> guard(fake::gpio_mutex);
+    fake::pin(pin).handler = nullptr;
+}
+
+// Deterministic across runs
+static uint32_t random_state = 1;
+
+void randomSeed(unsigned long seed) {
+    random_state = seed ? seed : 1;
+}
+
+long random(long maxValue) {
+    random_state = random_state * 1103515245u + 12345u;
+    return maxValue > 0 ? (long)((random_state >> 8) % (uint32_t)maxValue) : 0;
+}
+
+long random(long minValue, long maxValue) {
+    return minValue >= maxValue ? minValue : minValue + random(maxValue - minValue);
+}
@@ -0,0 +1,316 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <WiFiClient.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <strings.h>
+#include <list>
+#include <map>
+
+// Outgoing WiFiClient/WiFiClientSecure connections and the in-process
+// HTTP(S) servers they reach
+
+namespace fake {
+namespace detail {
+
+struct Connection {
+    std::string host;
+    uint16_t port;
+    std::string out;    // Written, not yet a whole request
+    std::string in;     // Reply bytes not read yet
+    bool closed;        // By the server; readable until in is drained
+    uint64_t ready_at;  // When the last reply has come over the link
+    void* session;      // TLS session heap, counted
+};
+
+} // namespace detail
+
+namespace {
+
+std::mutex client_mutex;
+std::map<std::string, ServerHandler> stand_ins;  // "host:port"
+std::list<detail::Connection*> connections;
+ClientStats client_stats;
+uint32_t handshake_ms = 1200;
+size_t session_bytes = 40000;
+uint32_t link_rtt_ms = 0;
+uint32_t link_bytes_per_second = 0;
+
+uint32_t transferMs(size_t bytes) {
+    return link_bytes_per_second ? (uint32_t)((uint64_t)bytes * 1000 / link_bytes_per_second) : 0;
+}
+
+std::string endpoint(const std::string& host, uint16_t port) {
+    return host + ":" + std::to_string(port);
+}
+
+std::string headerValue(const Headers& headers, const char* name) {
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (strcasecmp(headers[i].first.c_str(), name) == 0) {
+            return headers[i].second;
+        }
+    }
+    return std::string();
+}
+
+const char* reasonPhrase(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "Status";
+    }
+}
+
+// Splits a whole request off the front of out; false until one is complete
+bool takeRequest(std::string& out, ServerRequest& request) {
+    size_t head_end = out.find("\r\n\r\n");
+    if (head_end == std::string::npos) {
+        return false;
+    }
+    Headers headers;
+    size_t line_end = out.find("\r\n");
+    std::string request_line = out.substr(0, line_end);
+    for (size_t pos = line_end + 2; pos < head_end;) {
+        size_t end = out.find("\r\n", pos);
+        std::string line = out.substr(pos, end - pos);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            size_t value = line.find_first_not_of(' ', colon + 1);
+            headers.push_back(std::make_pair(line.substr(0, colon),
+                                             value == std::string::npos ? std::string() : line.substr(value)));
+        }
+        pos = end + 2;
+    }
+    size_t length = strtoul(headerValue(headers, "Content-Length").c_str(), nullptr, 10);
+    if (out.size() < head_end + 4 + length) {
+        return false;
+    }
+    size_t space = request_line.find(' ');
+    size_t second = request_line.find(' ', space + 1);
+    request.method = request_line.substr(0, space);
+    request.path = request_line.substr(space + 1, second - space - 1);
+    request.headers = headers;
+    request.body = out.substr(head_end + 4, length);
+    out.erase(0, head_end + 4 + length);
+    return true;
+}
+
+std::string formatReply(const ServerReply& reply) {
+    std::string text = "HTTP/1.1 " + std::to_string(reply.code) + " " + reasonPhrase(reply.code) + "\r\n";
+    text += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n";
+    for (size_t i = 0; i < reply.headers.size(); i++) {
+        text += reply.headers[i].first + ": " + reply.headers[i].second + "\r\n";
+    }
+    if (reply.close) {
+        text += "Connection: close\r\n";
+    }
+    return text + "\r\n" + reply.body;
+}
+
+} // namespace
+
+namespace detail {
+
+void resetClients() {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    HeapPause pause;
+    stand_ins.clear();
+    connections.clear();
+    memset(&client_stats, 0, sizeof(client_stats));
+    handshake_ms = 1200;
+    session_bytes = 40000;
+    link_rtt_ms = 0;
+    link_bytes_per_second = 0;
+}
+
+} // namespace detail
+
+std::string ServerRequest::header(const char* name) const {
+    return headerValue(headers, name);
+}
+
+void serveHttp(const char* host, uint16_t port, ServerHandler handler) {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    HeapPause pause;
+    if (handler) {
+        stand_ins[endpoint(host, port)] = handler;
+    } else {
+        stand_ins.erase(endpoint(host, port));
+    }
+}
+
+void closeConnections(const char* host) {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    for (std::list<detail::Connection*>::iterator it = connections.begin(); it != connections.end(); ++it) {
+        if ((*it)->host == host) {
+            (*it)->closed = true;
+        }
+    }
+}
+
+void setTlsCost(uint32_t handshakeMs, size_t sessionBytes) {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    handshake_ms = handshakeMs;
+    session_bytes = sessionBytes;
+}
+
+void setClientLink(uint32_t rttMs, uint32_t bytesPerSecond) {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    link_rtt_ms = rttMs;
+    link_bytes_per_second = bytesPerSecond;
+}
+
+ClientStats clientStats() {
+    std::lock_guard<std::mutex> guard(client_mutex);
+    ClientStats stats = client_stats;
+    stats.open = (int)connections.size();
+    return stats;
+}
+
+} // namespace fake
+
+using fake::detail::Connection;
+
+int WiFiClient::_open(const char* host, uint16_t port, bool tls) {
+    stop();
+    uint32_t delay_ms;
+    size_t session;
+    {
+        std::lock_guard<std::mutex> guard(fake::client_mutex);
+        if (!fake::staConnected() || fake::stand_ins.count(fake::endpoint(host, port)) == 0) {
+            return 0;
+        }
+        delay_ms = fake::link_rtt_ms + (tls ? fake::handshake_ms : 0);
+        session = tls ? fake::session_bytes : 0;
+    }
+    if (delay_ms > 0) {
+        vTaskDelay(delay_ms);
+    }
+
+    Connection* connection;
+    {
+        fake::HeapPause pause;
+        connection = new Connection();
+        connection->host = host;
+        connection->port = port;
+        connection->closed = false;
+        connection->ready_at = 0;
+    }
+    connection->session = session > 0 ? malloc(session) : nullptr;
+
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    fake::HeapPause pause;
+    fake::connections.push_back(connection);
+    fake::client_stats.connects++;
+    if (tls) {
+        fake::client_stats.handshakes++;
+    }
+    _connection = connection;
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    fake::ServerHandler handler;
+    fake::ServerRequest request;
+    size_t request_bytes;
+    {
+        std::lock_guard<std::mutex> guard(fake::client_mutex);
+        if (!_connection || _connection->closed || !fake::staConnected()) {
+            return 0;
+        }
+        fake::HeapPause pause;
+        _connection->out.append((const char*)buffer, size);
+        size_t buffered = _connection->out.size();
+        if (!fake::takeRequest(_connection->out, request)) {
+            return size;
+        }
+        request_bytes = buffered - _connection->out.size();
+        std::map<std::string, fake::ServerHandler>::iterator it =
+            fake::stand_ins.find(fake::endpoint(_connection->host, _connection->port));
+        if (it == fake::stand_ins.end()) {
+            _connection->closed = true;  // Server went away
+            return size;
+        }
+        handler = it->second;
+    }
+
+    fake::ServerReply reply;
+    {
+        fake::HeapPause pause;
+        reply = handler(request);
+    }
+
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    fake::HeapPause pause;
+    fake::client_stats.requests++;
+    std::string text = fake::formatReply(reply);
+    _connection->in += text;
+    _connection->ready_at = fake::now() + fake::link_rtt_ms + fake::transferMs(request_bytes + text.size());
+    if (reply.close) {
+        _connection->closed = true;
+    }
+    return size;
+}
+
+// Reply bytes are held back until the link has carried them
+static bool arrived(const Connection* connection) {
+    return fake::now() >= connection->ready_at;
+}
+
+int WiFiClient::available() {
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    return _connection && arrived(_connection) ? (int)_connection->in.size() : 0;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    if (!_connection || _connection->in.empty() || !arrived(_connection)) {
+        return -1;
+    }
+    size_t n = std::min(size, _connection->in.size());
+    memcpy(buffer, _connection->in.data(), n);
+    fake::HeapPause pause;
+    _connection->in.erase(0, n);
+    return (int)n;
+}
+
+int WiFiClient::peek() {
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    return _connection && !_connection->in.empty() && arrived(_connection) ? (uint8_t)_connection->in[0] : -1;
+}
+
+void WiFiClient::stop() {
+    if (!_connection) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(fake::client_mutex);
+        fake::HeapPause pause;
+        fake::connections.remove(_connection);
+    }
+    free(_connection->session);
+    {
+        fake::HeapPause pause;
+        delete _connection;
+    }
+    _connection = nullptr;
+}
+
+uint8_t WiFiClient::connected() {
+    std::lock_guard<std::mutex> guard(fake::client_mutex);
+    return _connection && ((!_connection->closed && fake::staConnected()) || !_connection->in.empty());
+}
@@ -0,0 +1,373 @@
+#ifndef FAKE_DEVICE_H
+#define FAKE_DEVICE_H
+
+// Test-side controls of the host fakes. Code under test only sees the
+// Arduino/ESP-IDF/library headers in this directory; tests script the
+// device through here.
+//
+// Time is virtual and only moves when the test thread advances it
+// (fake::advance(), or delay()/blocking waits made on the test thread).
+// Timers, WiFi events and scheduled actions run on the test thread, in time
+// order. FreeRTOS tasks are real threads run in lockstep with the clock:
+// each millisecond, every task that is due runs until it blocks again.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fake {
+
+// Thrown by ESP.restart()
+struct Restart {};
+
+// Fresh device: clock at 0, no radio networks, empty NVS and data partition
+// (unless keepNvs, e.g. to simulate a reboot), pins high, web and DNS servers stopped, no
+// stand-in servers, Serial output cleared, all tasks stopped. RTC_DATA_ATTR
+// variables are plain statics here and survive, like RTC memory across a
+// deep-sleep wake-up.
+void reset(bool keepNvs = false);
+
+// Ends all FreeRTOS tasks at their next blocking call. Call before
+// destroying objects a task uses.
+void stopTasks();
+int taskCount();
+
+// ESP.restart() calls made from tasks (the task ends there)
+int taskRestarts();
+
+// ---- Clock ----
+
+uint64_t now();
+void advance(uint32_t ms);
+
+// Advances in 1 ms steps until done() holds; false on timeout
+bool advanceUntil(std::function<bool()> done, uint32_t timeoutMs);
+
+// Runs action on the test thread when the clock reaches atMs
+void at(uint64_t atMs, std::function<void()> action);
+void after(uint32_t ms, std::function<void()> action);
+
+// ---- Serial ----
+
+const std::string& serialOutput();
+bool serialContains(const char* text);
+void clearSerial();
+
+// Also copy Serial output to stdout
+void echoSerial(bool enabled);
+
+// ---- GPIO ----
+
+// Drives an input; attached interrupts fire on the change
+void setPin(uint8_t pin, int level);
+
+// Level a pin wakes light-sleep at (gpio_wakeup_enable()), -1 when it does not
+int wakeLevel(uint8_t pin);
+
+// ---- Power management ----
+
+struct PowerConfig {
+    uint32_t calls;       // esp_pm_configure() calls, refused ones too
+    int max_freq_mhz;     // Last accepted configuration, 0 before one
+    int min_freq_mhz;
+    bool light_sleep;
+    bool gpio_wakeup;     // esp_sleep_enable_gpio_wakeup() called
+};
+
+PowerConfig powerConfig();
+
+// false: light-sleep is refused with ESP_ERR_NOT_SUPPORTED, as on a core
+// built without tickless idle
+void setLightSleepSupported(bool supported);
+
+// ---- Radio environment ----
+
+struct Network {
+    std::string ssid;
+    std::string password;   // Empty for an open network
+    int32_t rssi;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint32_t connect_ms;    // begin() to GOT_IP
+    bool responsive;        // false: begin() never completes or fails
+    bool hidden;            // Not listed in scans
+};
+
+// Added or replaced by SSID; returned reference stays valid until reset()
+Network& addNetwork(const char* ssid, const char* password, int32_t rssi = -60, uint8_t channel = 6);
+
+// Out of range from now on; a station connected to it is dropped
+void removeNetwork(const char* ssid);
+
+// The connected station loses the link (reason 200, beacon timeout)
+void dropConnection(uint8_t reason = 200);
+
+void setScanDuration(uint32_t ms);
+
+bool staConnected();
+std::string staSsid();
+bool apActive();
+std::string apSsid();
+int wifiMode();            // wifi_mode_t
+uint32_t scanCount();
+uint32_t connectAttempts();
+uint8_t lastConnectChannel();  // Channel hint of the last begin(), 0 without
+
+// ---- NVS ----
+
+uint32_t nvsWrites();
+uint32_t nvsBytesWritten();
+bool nvsHasKey(const char* ns, const char* key);
+void nvsPutBytes(const char* ns, const char* key, const void* data, size_t length);
+void nvsPutString(const char* ns, const char* key, const char* value);
+void nvsPutBool(const char* ns, const char* key, bool value);
+
+// ---- Flash ----
+
+// The "spiffs" data partition behind esp_partition_*(): NOR semantics,
+// 1.375 MB as in the default partition table. Writes take 50 us plus
+// 1.5 us per byte of virtual time, a 4 KB sector erase 45 ms.
+struct FlashStats {
+    uint64_t bytes_written;
+    uint32_t writes;        // esp_partition_write() calls
+    uint32_t erases;        // Sectors
+    uint64_t bytes_read;
+};
+
+FlashStats flashStats();
+
+// Resizes the partition (whole sectors), erasing it
+void setFlashPartitionSize(size_t bytes);
+
+// ---- Firmware ----
+
+// Two 1.25 MB OTA app slots (ota_0 running after reset()) and a bootloader
+// with app rollback. Update writes the other slot in 4 KB sectors with the
+// flash timing above; end() makes it the boot image. reset(true) then boots
+// it pending verification, and a second reset(true) without
+// esp_ota_mark_app_valid_cancel_rollback() rolls back.
+struct FirmwareStats {
+    uint32_t updates;        // Images activated by Update.end()
+    uint32_t rollbacks;      // Boots back into the previous image
+    uint64_t bytes_written;
+    uint32_t sectors;        // Erased and written
+};
+
+FirmwareStats firmwareStats();
+
+// Contents of the slot not running: the last image written
+std::string firmwareImage();
+int runningFirmwareSlot();
+int firmwareState();  // esp_ota_img_states_t of the running slot
+
+// A valid image of size bytes: magic byte, pseudo-random body from seed and
+// the SHA-256 the bootloader checks appended
+std::string makeFirmwareImage(size_t size, uint32_t seed = 1);
+std::string sha256Hex(const std::string& data);
+
+// ---- DNS ----
+
+// A socket listens on UDP port 53
+bool dnsRunning();
+
+struct DnsReply {
+    bool answered;        // false: dropped, or nothing listening
+    uint16_t id;          // Of the query; the reply's matched it
+    uint8_t rcode;
+    uint16_t answers;
+    std::string address;  // First A record, dotted; empty without one
+};
+
+// A client query to the DNS responder on UDP port 53, delivered in the
+// calling thread like http(). client is the last byte of the sender's
+// address on the AP subnet (192.168.4.x).
+DnsReply dnsLookup(const char* name, uint16_t type = 1, uint8_t client = 2);
+
+// An A query for a fixed name; false when no answer came
+bool dnsQuery(uint8_t client = 2);
+
+struct DnsStats {
+    uint32_t queries;
+    uint32_t answered;
+    uint32_t dropped;
+};
+
+DnsStats dnsStats();
+
+// ---- HTTP ----
+
+typedef std::vector<std::pair<std::string, std::string> > Headers;
+
+struct HttpResponse {
+    int code;                  // 0 when no server listens on the port
+    std::string content_type;
+    Headers headers;
+    std::string body;
+
+    std::string header(const char* name) const;  // Empty when absent
+    bool hasHeader(const char* name) const;
+};
+
+// Runs one request through the AsyncWebServer listening on port, in the
+// calling thread. application/x-www-form-urlencoded bodies arrive as POST
+// params, other bodies through the body handler in chunkSize pieces
+// (0: one piece). Parsing the request and capturing the response are not
+// counted by HeapProbe; handlers, responses and their headers are.
+HttpResponse http(const char* method, const char* url, const std::string& body = std::string(),
+                  const Headers& headers = Headers(), size_t chunkSize = 0, uint16_t port = 80);
+HttpResponse get(const char* url, const Headers& headers = Headers());
+HttpResponse postForm(const char* url, const std::string& form);
+HttpResponse putJson(const char* url, const std::string& json, size_t chunkSize = 0);
+
+// A multipart/form-data POST of one file, the way a browser sends an
+// <input type=file>: the upload handler gets data in chunkSize pieces (a
+// TCP segment by default), then the request handler runs. disconnectAt > 0
+// drops the client once that many file bytes are in; the request is freed
+// without a response and code is 0.
+HttpResponse upload(const char* url, const char* filename, const std::string& data, const Headers& headers = Headers(),
+                    size_t chunkSize = 1436, size_t disconnectAt = 0, uint16_t port = 80);
+
+// Client link speed in bytes per second. 0 (default): a request and its
+// response are freed as soon as http() returns. Otherwise they stay
+// allocated for as long as the response takes to send, so slow clients
+// overlap on the heap like on the device.
+void setLinkSpeed(uint32_t bytesPerSecond);
+int httpInFlight();
+
+// Requests made from now on come from 192.168.4.<client> on the AP subnet,
+// like dnsLookup()'s client. Default 2, restored by reset().
+void setHttpClient(uint8_t client);
+
+// ---- Server-Sent Events ----
+
+struct ServerEvent {
+    uint32_t id;        // 0 when sent without one
+    std::string event;  // Empty for plain messages
+    std::string data;
+    uint64_t at;        // Virtual time it was sent
+};
+
+// A browser's EventSource on url: the GET goes to the AsyncEventSource
+// handling it, which keeps the connection. lastEventId > 0 is sent as
+// Last-Event-ID, like a reconnect. Returns a handle, or -1 when no event
+// source serves url.
+int openEvents(const char* url, uint32_t lastEventId = 0, uint16_t port = 80);
+
+// Everything received on the stream so far, oldest first
+std::vector<ServerEvent> receivedEvents(int stream);
+
+// The server still has the stream open
+bool eventsOpen(int stream);
+
+// Client side goes away, like a closed tab
+void closeEvents(int stream);
+
+// ---- Outgoing connections ----
+
+// A request received by a stand-in server
+struct ServerRequest {
+    std::string method;
+    std::string path;
+    Headers headers;
+    std::string body;
+
+    std::string header(const char* name) const;  // Empty when absent
+};
+
+struct ServerReply {
+    int code;
+    std::string body;
+    Headers headers;
+    bool close;         // Close the connection after this reply
+
+    ServerReply(int c = 200, const std::string& b = std::string()) : code(c), body(b), close(false) {}
+};
+
+typedef std::function<ServerReply(const ServerRequest&)> ServerHandler;
+
+// A remote HTTP(S) server reachable through WiFiClient/WiFiClientSecure by
+// host name and port while the station is connected. Keep-alive: one
+// connection carries any number of requests until either side closes it.
+// The handler runs in the client's thread once a whole request (headers and
+// Content-Length body) has been written. An empty handler takes it down.
+void serveHttp(const char* host, uint16_t port, ServerHandler handler);
+
+// Server side closes every open connection to host, like an idle timeout
+void closeConnections(const char* host);
+
+// Cost of a WiFiClientSecure handshake: virtual time connect() takes, and
+// heap held by the session until the connection is stopped. Defaults
+// 1200 ms and 40000 bytes, like mbedTLS on the device.
+void setTlsCost(uint32_t handshakeMs, size_t sessionBytes);
+
+// Link of outgoing connections: connect() and every reply take one round
+// trip more, and request and reply bytes the time they need at
+// bytesPerSecond (0: no limit). Default 0, 0: instant.
+void setClientLink(uint32_t rttMs, uint32_t bytesPerSecond);
+
+// Decodes a gzip member (Content-Encoding: gzip) for stand-ins; false when
+// the data is malformed or fails its CRC
+bool gunzip(const std::string& data, std::string& out);
+
+struct ClientStats {
+    uint32_t connects;     // Connections opened
+    uint32_t handshakes;   // Of them TLS
+    uint32_t requests;     // Answered by stand-ins
+    int open;              // Currently open
+};
+
+ClientStats clientStats();
+
+// ---- Heap ----
+
+struct HeapStats {
+    uint64_t allocations;  // malloc/calloc/realloc/new calls
+    uint64_t bytes;        // Bytes requested by them
+    int64_t live_bytes;    // Currently allocated, fakes included
+};
+
+HeapStats heapStats();
+
+// Heap use by the code under test since construction. Bookkeeping of the
+// fakes themselves is excluded; the process-wide counters include other
+// threads, so probe with no tasks running.
+class HeapProbe {
+    HeapStats start;
+
+public:
+    HeapProbe() { restart(); }
+    void restart() { start = heapStats(); }
+    uint64_t allocations() const { return heapStats().allocations - start.allocations; }
+    uint64_t bytes() const { return heapStats().bytes - start.bytes; }
+};
+
+// Device heap model. Counted allocations are also placed first-fit in an
+// arena the size of the ESP32's application heap, with allocator overhead,
+// so fragmentation and exhaustion behave like on the device: malloc fails
+// when nothing fits. ESP.getFreeHeap() and friends report from here.
+struct HeapModel {
+    size_t size;
+    size_t used;              // Blocks in use, overhead included
+    size_t peak_used;         // Since the last resetHeapPeaks()
+    size_t largest_free;
+    size_t min_largest_free;  // Since the last resetHeapPeaks()
+};
+
+HeapModel heapModel();
+
+// Also done by reset()
+void resetHeapPeaks();
+
+// Allocations on this thread inside the scope are not counted
+class HeapPause {
+public:
+    HeapPause();
+    ~HeapPause();
+};
+
+} // namespace fake
+
+#endif // FAKE_DEVICE_H
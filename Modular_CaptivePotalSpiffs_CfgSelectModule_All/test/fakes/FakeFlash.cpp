@@ -0,0 +1,128 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <esp_partition.h>
+#include <string.h>
+#include <vector>
+
+// The "spiffs" data partition as NOR flash: an erase sets a 4 KB sector to
+// 0xFF, a write can only clear bits. Both take virtual time from the
+// calling thread, with figures of a typical SPI flash chip.
+
+namespace fake {
+namespace {
+
+const size_t SECTOR_SIZE = 4096;
+const size_t DEFAULT_SIZE = 0x160000;  // default.csv
+const uint32_t WRITE_CALL_US = 50;     // Per write: command, cache off and on
+const uint32_t WRITE_BYTE_NS = 1500;   // Page program, about 0.4 ms per 256 bytes
+const uint32_t SECTOR_ERASE_MS = 45;
+
+std::mutex flash_mutex;
+std::vector<uint8_t> flash;
+esp_partition_t partition = { ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x290000,
+                              DEFAULT_SIZE, SECTOR_SIZE, "spiffs", false, false };
+FlashStats flash_stats;
+uint32_t busy_us = 0;  // Write time not yet taken, under a millisecond
+
+void format(size_t size) {
+    HeapPause pause;
+    flash.assign(size, 0xFF);
+    partition.size = size;
+}
+
+// Takes the time of a flash operation from the calling thread
+void spend(uint32_t us) {
+    uint32_t ms;
+    {
+        std::lock_guard<std::mutex> guard(flash_mutex);
+        busy_us += us;
+        ms = busy_us / 1000;
+        busy_us %= 1000;
+    }
+    if (ms > 0) {
+        advance(ms);
+    }
+}
+
+bool inRange(const esp_partition_t* p, size_t offset, size_t size) {
+    return p == &partition && offset <= flash.size() && size <= flash.size() - offset;
+}
+
+} // namespace
+
+namespace detail {
+
+void resetFlash() {
+    std::lock_guard<std::mutex> guard(flash_mutex);
+    format(DEFAULT_SIZE);
+    memset(&flash_stats, 0, sizeof(flash_stats));
+    busy_us = 0;
+}
+
+} // namespace detail
+
+void setFlashPartitionSize(size_t bytes) {
+    std::lock_guard<std::mutex> guard(flash_mutex);
+    format(bytes - bytes % SECTOR_SIZE);
+}
+
+FlashStats flashStats() {
+    std::lock_guard<std::mutex> guard(flash_mutex);
+    return flash_stats;
+}
+
+} // namespace fake
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    std::lock_guard<std::mutex> guard(fake::flash_mutex);
+    if (fake::flash.empty()) {
+        fake::format(fake::DEFAULT_SIZE);
+    }
+    const esp_partition_t& p = fake::partition;
+    if ((type != ESP_PARTITION_TYPE_ANY && type != p.type) ||
+        (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != p.subtype) || (label && strcmp(label, p.label) != 0)) {
+        return nullptr;
+    }
+    return &p;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    std::lock_guard<std::mutex> guard(fake::flash_mutex);
+    if (!fake::inRange(partition, src_offset, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, fake::flash.data() + src_offset, size);
+    fake::flash_stats.bytes_read += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+    {
+        std::lock_guard<std::mutex> guard(fake::flash_mutex);
+        if (!fake::inRange(partition, dst_offset, size)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        const uint8_t* bytes = (const uint8_t*)src;
+        for (size_t i = 0; i < size; i++) {
+            fake::flash[dst_offset + i] &= bytes[i];
+        }
+        fake::flash_stats.writes++;
+        fake::flash_stats.bytes_written += size;
+    }
+    fake::spend(fake::WRITE_CALL_US + (uint32_t)(size * fake::WRITE_BYTE_NS / 1000));
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    {
+        std::lock_guard<std::mutex> guard(fake::flash_mutex);
+        if (!fake::inRange(partition, offset, size) || offset % fake::SECTOR_SIZE || size % fake::SECTOR_SIZE) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        memset(fake::flash.data() + offset, 0xFF, size);
+        fake::flash_stats.erases += size / fake::SECTOR_SIZE;
+    }
+    fake::spend(fake::SECTOR_ERASE_MS * 1000 * (uint32_t)(size / fake::SECTOR_SIZE));
+    return ESP_OK;
+}
@@ -0,0 +1,274 @@
+#include "FakeDevice.h"
+#include <string.h>
+
+// gzip decoding for stand-in servers: a small inflate after zlib's puff,
+// all three block types
+
+namespace fake {
+namespace {
+
+struct Inflate {
+    const uint8_t* in;
+    size_t size;
+    size_t pos;
+    uint32_t bit_buffer;
+    int bit_count;
+    std::string* out;
+    bool error;  // Ran out of input
+
+    int bits(int need) {
+        uint64_t value = bit_buffer;
+        while (bit_count < need) {
+            if (pos == size) {
+                error = true;
+                return 0;
+            }
+            value |= (uint64_t)in[pos++] << bit_count;
+            bit_count += 8;
+        }
+        bit_buffer = (uint32_t)(value >> need);
+        bit_count -= need;
+        return (int)(value & ((1u << need) - 1));
+    }
+};
+
+struct Huffman {
+    short count[16];   // Codes per length
+    short symbol[288]; // Symbols ordered by code
+};
+
+const short LENGTH_BASE[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const short LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const short DISTANCE_BASE[30] = { 1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                  193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const short DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+int decode(Inflate& s, const Huffman& h) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length <= 15; length++) {
+        code |= s.bits(1);
+        if (s.error) {
+            return -1;
+        }
+        int count = h.count[length];
+        if (code - count < first) {
+            return h.symbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+// Canonical code from code lengths; false when over-subscribed
+bool construct(Huffman& h, const short* length, int n) {
+    memset(h.count, 0, sizeof(h.count));
+    for (int i = 0; i < n; i++) {
+        h.count[length[i]]++;
+    }
+    if (h.count[0] == n) {
+        return true;
+    }
+    int left = 1;
+    for (int len = 1; len <= 15; len++) {
+        left = (left << 1) - h.count[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+    short offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; len++) {
+        offsets[len + 1] = offsets[len] + h.count[len];
+    }
+    for (int i = 0; i < n; i++) {
+        if (length[i] != 0) {
+            h.symbol[offsets[length[i]]++] = i;
+        }
+    }
+    return true;
+}
+
+bool codes(Inflate& s, const Huffman& lengths, const Huffman& distances) {
+    for (;;) {
+        int symbol = decode(s, lengths);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 256) {
+            s.out->push_back((char)symbol);
+            continue;
+        }
+        if (symbol == 256) {
+            return true;
+        }
+        symbol -= 257;
+        if (symbol >= 29) {
+            return false;
+        }
+        int length = LENGTH_BASE[symbol] + s.bits(LENGTH_EXTRA[symbol]);
+        int distance_symbol = decode(s, distances);
+        if (distance_symbol < 0 || distance_symbol >= 30) {
+            return false;
+        }
+        size_t distance = DISTANCE_BASE[distance_symbol] + s.bits(DISTANCE_EXTRA[distance_symbol]);
+        if (s.error || distance > s.out->size()) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            s.out->push_back((*s.out)[s.out->size() - distance]);
+        }
+    }
+}
+
+bool stored(Inflate& s) {
+    s.bit_buffer = 0;
+    s.bit_count = 0;
+    if (s.pos + 4 > s.size) {
+        return false;
+    }
+    size_t length = s.in[s.pos] | (s.in[s.pos + 1] << 8);
+    size_t check = s.in[s.pos + 2] | (s.in[s.pos + 3] << 8);
+    s.pos += 4;
+    if (length != (~check & 0xffff) || s.pos + length > s.size) {
+        return false;
+    }
+    s.out->append((const char*)s.in + s.pos, length);
+    s.pos += length;
+    return true;
+}
+
+bool fixed(Inflate& s) {
+    Huffman lengths;
+    Huffman distances;
+    short code_lengths[288];
+    for (int i = 0; i < 288; i++) {
+        code_lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    construct(lengths, code_lengths, 288);
+    for (int i = 0; i < 30; i++) {
+        code_lengths[i] = 5;
+    }
+    construct(distances, code_lengths, 30);
+    return codes(s, lengths, distances);
+}
+
+bool dynamic(Inflate& s) {
+    static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    int length_count = s.bits(5) + 257;
+    int distance_count = s.bits(5) + 1;
+    int code_count = s.bits(4) + 4;
+    if (length_count > 286 || distance_count > 30) {
+        return false;
+    }
+    short code_lengths[320];
+    for (int i = 0; i < 19; i++) {
+        code_lengths[order[i]] = i < code_count ? s.bits(3) : 0;
+    }
+    Huffman lengths;
+    Huffman distances;
+    if (!construct(lengths, code_lengths, 19)) {
+        return false;
+    }
+    int index = 0;
+    while (index < length_count + distance_count) {
+        int symbol = decode(s, lengths);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            code_lengths[index++] = symbol;
+            continue;
+        }
+        short repeated = 0;
+        int times;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            repeated = code_lengths[index - 1];
+            times = 3 + s.bits(2);
+        } else if (symbol == 17) {
+            times = 3 + s.bits(3);
+        } else {
+            times = 11 + s.bits(7);
+        }
+        if (index + times > length_count + distance_count) {
+            return false;
+        }
+        while (times--) {
+            code_lengths[index++] = repeated;
+        }
+    }
+    if (s.error || code_lengths[256] == 0) {
+        return false;
+    }
+    if (!construct(lengths, code_lengths, length_count) ||
+        !construct(distances, code_lengths + length_count, distance_count)) {
+        return false;
+    }
+    return codes(s, lengths, distances);
+}
+
+uint32_t crc32(const std::string& data) {
+    uint32_t crc = 0xffffffff;
+    for (size_t i = 0; i < data.size(); i++) {
+        crc ^= (uint8_t)data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+bool gunzip(const std::string& data, std::string& out) {
+    const uint8_t* p = (const uint8_t*)data.data();
+    size_t n = data.size();
+    if (n < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8) {
+        return false;
+    }
+    uint8_t flags = p[3];
+    size_t pos = 10;
+    if (flags & 0x04) {  // FEXTRA
+        pos += 2 + (p[pos] | (p[pos + 1] << 8));
+    }
+    for (int field = 0x08; field <= 0x10; field <<= 1) {  // FNAME, FCOMMENT
+        if (flags & field) {
+            while (pos < n && p[pos]) {
+                pos++;
+            }
+            pos++;
+        }
+    }
+    if (flags & 0x02) {  // FHCRC
+        pos += 2;
+    }
+    if (pos > n - 8) {
+        return false;
+    }
+
+    out.clear();
+    Inflate s = { p + pos, n - 8 - pos, 0, 0, 0, &out, false };
+    int last;
+    do {
+        last = s.bits(1);
+        int type = s.bits(2);
+        bool ok = type == 0 ? stored(s) : type == 1 ? fixed(s) : type == 2 ? dynamic(s) : false;
+        if (!ok || s.error) {
+            return false;
+        }
+    } while (!last);
+    return le32(p + n - 8) == crc32(out) && le32(p + n - 4) == (uint32_t)out.size();
+}
+
+} // namespace fake
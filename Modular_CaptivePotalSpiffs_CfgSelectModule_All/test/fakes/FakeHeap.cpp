@@ -0,0 +1,350 @@
+#include "FakeDevice.h"
+#include <atomic>
+#include <malloc.h>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+
+// Heap accounting. malloc, calloc, realloc and free are wrapped at link time
+// (-Wl,--wrap=...), so every allocation made by code linked into the test
+// binary, ArduinoJson's default allocator included, passes through here;
+// operator new/delete are routed to them.
+//
+// Counted allocations are also placed in a model of the device heap: a
+// first-fit arena with per-block overhead, so that fragmentation and
+// exhaustion show up the way they would on the ESP32. An allocation that
+// does not fit the model fails like it would on the device.
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+void* __wrap_malloc(size_t size);
+void __wrap_free(void* ptr);
+}
+
+// Nominal ESP32 heap available to the application
+static const size_t MODEL_HEAP_SIZE = 320 * 1024;
+
+// Allocator header and payload alignment, as in multi_heap
+static const size_t MODEL_BLOCK_HEADER = 8;
+static const size_t MODEL_BLOCK_ALIGN = 4;
+
+namespace fake {
+namespace {
+
+std::atomic<uint64_t> allocation_count(0);
+std::atomic<uint64_t> allocated_bytes(0);
+std::atomic<int64_t> live_bytes(0);
+thread_local int pause_depth = 0;
+
+// The model's own containers allocate; those calls must bypass it
+thread_local bool in_model = false;
+
+struct ModelGuard {
+    ModelGuard() { in_model = true; }
+    ~ModelGuard() { in_model = false; }
+};
+
+struct Model {
+    std::mutex mutex;
+    std::map<size_t, size_t> free_ranges;       // offset -> length
+    std::map<void*, std::pair<size_t, size_t> > blocks;  // ptr -> offset, length
+    size_t used;
+    size_t peak_used;
+    size_t min_largest_free;
+
+    Model() : used(0), peak_used(0), min_largest_free(MODEL_HEAP_SIZE) {
+        ModelGuard guard;
+        free_ranges[0] = MODEL_HEAP_SIZE;
+    }
+
+    static size_t blockLength(size_t size) {
+        return MODEL_BLOCK_HEADER + (size + MODEL_BLOCK_ALIGN - 1) / MODEL_BLOCK_ALIGN * MODEL_BLOCK_ALIGN;
+    }
+
+    size_t largestFree() const {
+        size_t largest = 0;
+        for (std::map<size_t, size_t>::const_iterator it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+            largest = std::max(largest, it->second);
+        }
+        return largest;
+    }
+
+    // First fit; false when no free range is large enough
+    bool place(void* ptr, size_t size) {
+        size_t length = blockLength(size);
+        for (std::map<size_t, size_t>::iterator it = free_ranges.begin(); it != free_ranges.end(); ++it) {
+            if (it->second < length) {
+                continue;
+            }
+            size_t offset = it->first;
+            size_t remaining = it->second - length;
+            free_ranges.erase(it);
+            if (remaining > 0) {
+                free_ranges[offset + length] = remaining;
+            }
+            blocks[ptr] = std::make_pair(offset, length);
+            used += length;
+            peak_used = std::max(peak_used, used);
+            min_largest_free = std::min(min_largest_free, largestFree());
+            return true;
+        }
+        return false;
+    }
+
+    // Takes [offset, offset + length) out of the free range containing it
+    void carve(size_t offset, size_t length) {
+        std::map<size_t, size_t>::iterator it = free_ranges.upper_bound(offset);
+        --it;
+        size_t start = it->first;
+        size_t end = it->first + it->second;
+        free_ranges.erase(it);
+        if (offset > start) {
+            free_ranges[start] = offset - start;
+        }
+        if (offset + length < end) {
+            free_ranges[offset + length] = end - offset - length;
+        }
+    }
+
+    // Moves a block to a new size; on failure it stays where it was
+    bool resize(void* ptr, size_t size) {
+        std::pair<size_t, size_t> old = blocks[ptr];
+        release(ptr);
+        if (place(ptr, size)) {
+            return true;
+        }
+        carve(old.first, old.second);
+        blocks[ptr] = old;
+        used += old.second;
+        return false;
+    }
+
+    // Returns the block to the free ranges, merging with its neighbours
+    bool release(void* ptr) {
+        std::map<void*, std::pair<size_t, size_t> >::iterator block = blocks.find(ptr);
+        if (block == blocks.end()) {
+            return false;
+        }
+        size_t offset = block->second.first;
+        size_t length = block->second.second;
+        blocks.erase(block);
+        used -= length;
+
+        std::map<size_t, size_t>::iterator next = free_ranges.lower_bound(offset);
+        if (next != free_ranges.end() && offset + length == next->first) {
+            length += next->second;
+            free_ranges.erase(next);
+        }
+        std::map<size_t, size_t>::iterator prev = free_ranges.lower_bound(offset);
+        if (prev != free_ranges.begin()) {
+            --prev;
+            if (prev->first + prev->second == offset) {
+                prev->second += length;
+                return true;
+            }
+        }
+        free_ranges[offset] = length;
+        return true;
+    }
+};
+
+Model& model() {
+    static Model* instance = nullptr;
+    if (!instance) {
+        ModelGuard guard;
+        instance = new Model();
+    }
+    return *instance;
+}
+
+bool modelPlace(void* ptr, size_t size) {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    ModelGuard guard;
+    return m.place(ptr, size);
+}
+
+void modelRelease(void* ptr) {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    ModelGuard guard;
+    m.release(ptr);
+}
+
+bool modelResize(void* ptr, size_t size) {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    ModelGuard guard;
+    return m.resize(ptr, size);
+}
+
+void modelRekey(void* from, void* to) {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    ModelGuard guard;
+    m.blocks[to] = m.blocks[from];
+    m.blocks.erase(from);
+}
+
+bool modelTracks(void* ptr) {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    return m.blocks.count(ptr) != 0;
+}
+
+bool counting() {
+    return pause_depth == 0 && !in_model;
+}
+
+void counted(void* ptr, size_t size) {
+    if (!ptr) {
+        return;
+    }
+    live_bytes += malloc_usable_size(ptr);
+    if (counting()) {
+        allocation_count++;
+        allocated_bytes += size;
+    }
+}
+
+// Places a fresh counted allocation in the model, undoing it when it does not fit
+void* modeled(void* ptr, size_t size) {
+    if (!ptr || !counting()) {
+        return ptr;
+    }
+    if (!modelPlace(ptr, size)) {
+        live_bytes -= malloc_usable_size(ptr);
+        __real_free(ptr);
+        return nullptr;
+    }
+    return ptr;
+}
+
+} // namespace
+
+HeapStats heapStats() {
+    HeapStats stats = { allocation_count, allocated_bytes, live_bytes };
+    return stats;
+}
+
+HeapModel heapModel() {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    HeapModel result;
+    result.size = MODEL_HEAP_SIZE;
+    result.used = m.used;
+    result.peak_used = m.peak_used;
+    result.largest_free = m.largestFree();
+    result.min_largest_free = m.min_largest_free;
+    return result;
+}
+
+void resetHeapPeaks() {
+    Model& m = model();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    m.peak_used = m.used;
+    m.min_largest_free = m.largestFree();
+}
+
+HeapPause::HeapPause() {
+    pause_depth++;
+}
+
+HeapPause::~HeapPause() {
+    pause_depth--;
+}
+
+} // namespace fake
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    fake::counted(ptr, size);
+    return fake::modeled(ptr, size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    fake::counted(ptr, count * size);
+    return fake::modeled(ptr, count * size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (!ptr) {
+        return __wrap_malloc(size);
+    }
+    if (size == 0) {
+        __wrap_free(ptr);
+        return nullptr;
+    }
+    // A modeled block must be resized in the model before the real one moves
+    bool tracked = !fake::in_model && fake::modelTracks(ptr);
+    if (tracked && !fake::modelResize(ptr, size)) {
+        return nullptr;
+    }
+    size_t before = malloc_usable_size(ptr);
+    void* grown = __real_realloc(ptr, size);
+    if (!grown) {
+        return nullptr;
+    }
+    fake::live_bytes -= before;
+    fake::counted(grown, size);
+    if (tracked && grown != ptr) {
+        fake::modelRekey(ptr, grown);
+    }
+    return grown;
+}
+
+void __wrap_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    fake::live_bytes -= malloc_usable_size(ptr);
+    if (!fake::in_model) {
+        fake::modelRelease(ptr);
+    }
+    __real_free(ptr);
+}
+
+} // extern "C"
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
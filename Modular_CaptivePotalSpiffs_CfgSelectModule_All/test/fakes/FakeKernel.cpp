@@ -0,0 +1,690 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/event_groups.h>
+#include <freertos/timers.h>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <thread>
+#include <vector>
+
+// Virtual clock, scheduled actions and the FreeRTOS objects. Tasks are
+// threads that only run between two clock steps: the test thread advances
+// the clock, wakes every task that is due and waits until all of them have
+// blocked again before taking the next step.
+
+struct tskTaskControlBlock {
+    const char* name;
+    uint32_t stack_depth;
+    uint32_t notifications;
+    bool ended;
+};
+
+struct QueueDefinition {
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t* storage;
+};
+
+struct EventGroupDef_t {
+    EventBits_t bits;
+};
+
+struct tmrTimerControl {
+    const char* name;
+    TickType_t period;
+    bool auto_reload;
+    void* id;
+    TimerCallbackFunction_t callback;
+    bool active;
+    uint64_t generation;
+};
+
+namespace fake {
+namespace {
+
+// Ends a task from its next blocking call, see stopTasks()
+struct TaskExit {};
+
+struct Action {
+    uint64_t at;
+    uint64_t seq;
+    std::function<void()> run;
+};
+
+struct Waiter {
+    const std::function<bool()>* ready;
+    uint64_t deadline;
+    bool woken;
+};
+
+std::mutex kernel_mutex;
+std::condition_variable kernel_cv;
+std::atomic<uint64_t> clock_ms(0);
+std::vector<Action> actions;
+uint64_t action_seq = 0;
+std::vector<Waiter*> waiters;
+std::list<tskTaskControlBlock> tasks;
+int tasks_alive = 0;
+int tasks_running = 0;  // Alive and not parked in block()
+int task_restarts = 0;
+bool stopping = false;
+std::recursive_mutex critical_mutex;
+
+thread_local tskTaskControlBlock* current_task = nullptr;
+
+// Kernel lock held from here on
+
+void pushAction(uint64_t at, std::function<void()> run) {
+    HeapPause pause;
+    Action action = { at, action_seq++, std::move(run) };
+    actions.push_back(std::move(action));
+}
+
+bool takeDueAction(std::function<void()>& run) {
+    size_t best = actions.size();
+    for (size_t i = 0; i < actions.size(); i++) {
+        if (actions[i].at > clock_ms) {
+            continue;
+        }
+        if (best == actions.size() || actions[i].at < actions[best].at ||
+            (actions[i].at == actions[best].at && actions[i].seq < actions[best].seq)) {
+            best = i;
+        }
+    }
+    if (best == actions.size()) {
+        return false;
+    }
+    HeapPause pause;
+    run = std::move(actions[best].run);
+    actions.erase(actions.begin() + best);
+    return true;
+}
+
+void runDueActions(std::unique_lock<std::mutex>& lock) {
+    std::function<void()> run;
+    while (takeDueAction(run)) {
+        lock.unlock();
+        run();
+        {
+            HeapPause pause;
+            run = nullptr;
+        }
+        lock.lock();
+    }
+}
+
+void settle(std::unique_lock<std::mutex>& lock) {
+    kernel_cv.wait(lock, []() { return tasks_running == 0; });
+}
+
+uint64_t deadlineAfter(uint32_t ticks) {
+    return ticks == portMAX_DELAY ? UINT64_MAX : clock_ms + ticks;
+}
+
+void armTimer(tmrTimerControl* timer);
+
+void fireTimer(tmrTimerControl* timer, uint64_t generation) {
+    {
+        std::unique_lock<std::mutex> lock(kernel_mutex);
+        if (!timer->active || timer->generation != generation) {
+            return;
+        }
+        timer->active = false;
+        if (timer->auto_reload) {
+            armTimer(timer);
+        }
+    }
+    timer->callback(timer);
+}
+
+void armTimer(tmrTimerControl* timer) {
+    timer->active = true;
+    uint64_t generation = ++timer->generation;
+    pushAction(clock_ms + timer->period, [timer, generation]() { fireTimer(timer, generation); });
+}
+
+void taskMain(tskTaskControlBlock* task, TaskFunction_t code, void* arg) {
+    current_task = task;
+    try {
+        code(arg);
+    } catch (const TaskExit&) {
+    } catch (const Restart&) {
+        std::lock_guard<std::mutex> guard(kernel_mutex);
+        task_restarts++;
+    }
+    std::lock_guard<std::mutex> guard(kernel_mutex);
+    task->ended = true;
+    tasks_alive--;
+    tasks_running--;
+    kernel_cv.notify_all();
+}
+
+} // namespace
+
+namespace detail {
+
+std::unique_lock<std::mutex> lockKernel() {
+    return std::unique_lock<std::mutex>(kernel_mutex);
+}
+
+bool inTask() {
+    return current_task != nullptr;
+}
+
+void wake() {
+    for (size_t i = 0; i < waiters.size(); i++) {
+        Waiter* waiter = waiters[i];
+        if (!waiter->woken && (stopping || clock_ms >= waiter->deadline || (*waiter->ready)())) {
+            waiter->woken = true;
+            tasks_running++;
+        }
+    }
+    kernel_cv.notify_all();
+}
+
+bool block(std::unique_lock<std::mutex>& lock, const std::function<bool()>& ready, uint32_t ticks) {
+    if (ready()) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+    uint64_t deadline = deadlineAfter(ticks);
+
+    if (!current_task) {
+        // Test thread: move the clock until something makes ready() true
+        while (!ready()) {
+            if (clock_ms >= deadline) {
+                return false;
+            }
+            if (tasks_alive == 0 && actions.empty()) {
+                if (deadline == UINT64_MAX) {
+                    fprintf(stderr, "fake: test thread blocked forever, nothing left to wake it\n");
+                    return false;
+                }
+                uint64_t remaining = deadline - clock_ms;
+                lock.unlock();
+                advance(remaining);
+                lock.lock();
+                continue;
+            }
+            lock.unlock();
+            advance(1);
+            lock.lock();
+        }
+        return true;
+    }
+
+    if (stopping) {
+        throw TaskExit();
+    }
+    Waiter waiter = { &ready, deadline, false };
+    {
+        HeapPause pause;
+        waiters.push_back(&waiter);
+    }
+    tasks_running--;
+    kernel_cv.notify_all();
+    kernel_cv.wait(lock, [&waiter]() { return waiter.woken; });
+    waiters.erase(std::find(waiters.begin(), waiters.end(), &waiter));
+    if (stopping) {
+        throw TaskExit();
+    }
+    return ready();
+}
+
+void schedule(uint64_t atMs, std::function<void()> action) {
+    std::lock_guard<std::mutex> guard(kernel_mutex);
+    pushAction(atMs, std::move(action));
+}
+
+void resetKernel() {
+    std::lock_guard<std::mutex> guard(kernel_mutex);
+    HeapPause pause;
+    clock_ms = 0;
+    actions.clear();
+    action_seq = 0;
+    task_restarts = 0;
+    tasks.clear();
+}
+
+} // namespace detail
+
+void reset(bool keepNvs) {
+    stopTasks();
+    detail::resetKernel();
+    detail::resetSerial();
+    detail::resetGpio();
+    detail::resetPower();
+    detail::resetWiFi();
+    if (!keepNvs) {
+        detail::resetNvs();
+        detail::resetFlash();
+    }
+    detail::resetFirmware(keepNvs);
+    detail::resetNetwork();
+    detail::resetClients();
+    resetHeapPeaks();
+}
+
+void stopTasks() {
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    stopping = true;
+    detail::wake();
+    kernel_cv.wait(lock, []() { return tasks_alive == 0; });
+    stopping = false;
+}
+
+int taskCount() {
+    std::lock_guard<std::mutex> guard(kernel_mutex);
+    return tasks_alive;
+}
+
+int taskRestarts() {
+    std::lock_guard<std::mutex> guard(kernel_mutex);
+    return task_restarts;
+}
+
+uint64_t now() {
+    return clock_ms;
+}
+
+void advance(uint32_t ms) {
+    if (current_task) {
+        vTaskDelay(ms);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(kernel_mutex);
+    uint64_t target = clock_ms + ms;
+    settle(lock);
+    runDueActions(lock);
+    while (clock_ms < target) {
+        uint64_t next = clock_ms + 1;
+        if (tasks_alive == 0) {
+            // Nothing runs between actions, jump straight to the next one
+            next = target;
+            for (size_t i = 0; i < actions.size(); i++) {
+                next = min(next, max(actions[i].at, (uint64_t)clock_ms + 1));
+            }
+        }
+        clock_ms = next;
+        runDueActions(lock);
+        detail::wake();
+        settle(lock);
+    }
+}
+
+bool advanceUntil(std::function<bool()> done, uint32_t timeoutMs) {
+    uint64_t deadline = clock_ms + timeoutMs;
+    while (!done()) {
+        if (clock_ms >= deadline) {
+            return false;
+        }
+        advance(1);
+    }
+    return true;
+}
+
+void at(uint64_t atMs, std::function<void()> action) {
+    detail::schedule(atMs, std::move(action));
+}
+
+void after(uint32_t ms, std::function<void()> action) {
+    detail::schedule(clock_ms + ms, std::move(action));
+}
+
+} // namespace fake
+
+using fake::detail::block;
+using fake::detail::wake;
+
+// ---- Arduino timing ----
+
+unsigned long millis() {
+    return (unsigned long)fake::clock_ms;
+}
+
+unsigned long micros() {
+    return (unsigned long)(fake::clock_ms * 1000);
+}
+
+void delay(uint32_t ms) {
+    fake::advance(ms);
+}
+
+void delayMicroseconds(uint32_t us) {
+    (void)us;
+}
+
+void yield() {
+}
+
+// ---- Critical sections ----
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    fake::critical_mutex.lock();
+    mux->count++;
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    mux->count--;
+    fake::critical_mutex.unlock();
+}
+
+// ---- Tasks ----
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)fake::clock_ms;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char* name, uint32_t stackDepth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core) {
+    (void)priority;
+    (void)core;
+    std::lock_guard<std::mutex> guard(fake::kernel_mutex);
+    fake::HeapPause pause;
+    fake::tasks.push_back(tskTaskControlBlock());
+    tskTaskControlBlock* task = &fake::tasks.back();
+    task->name = name;
+    task->stack_depth = stackDepth;
+    task->notifications = 0;
+    task->ended = false;
+    fake::tasks_alive++;
+    fake::tasks_running++;
+    std::thread(fake::taskMain, task, code, arg).detach();
+    if (created) {
+        *created = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stackDepth, void* arg,
+                       UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(code, name, stackDepth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == fake::current_task) {
+        throw fake::TaskExit();
+    }
+    {
+        std::lock_guard<std::mutex> guard(fake::kernel_mutex);
+        if (task->ended) {
+            return;  // Already gone, e.g. through stopTasks()
+        }
+    }
+    fprintf(stderr, "fake: deleting another task is not supported\n");
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (!fake::current_task) {
+        fake::advance(ticks);
+        return;
+    }
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    static const std::function<bool()> never = []() { return false; };
+    block(lock, never, ticks == 0 ? 1 : ticks);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return fake::current_task;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    // Host stacks are not measured; report the whole stack as unused
+    tskTaskControlBlock* target = task ? task : fake::current_task;
+    return target ? target->stack_depth : 0;
+}
+
+char* pcTaskGetName(TaskHandle_t task) {
+    static char test_thread[] = "test";
+    tskTaskControlBlock* target = task ? task : fake::current_task;
+    return target ? (char*)target->name : test_thread;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    tskTaskControlBlock* task = fake::current_task;
+    if (!task) {
+        return 0;  // Only tasks are notified
+    }
+    std::unique_lock<std::mutex> lock(fake::kernel_mutex);
+    block(lock, [task]() { return task->notifications > 0; }, ticks);
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clearOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> guard(fake::kernel_mutex);
+    task->notifications++;
+    wake();
+    return pdPASS;
+}
+
+// ---- Queues ----
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    // One block, like the real queue storage
+    QueueDefinition* queue = (QueueDefinition*)malloc(sizeof(QueueDefinition) + length * itemSize);
+    if (!queue) {
+        return nullptr;
+    }
+    queue->length = length;
+    queue->item_size = itemSize;
+    queue->head = 0;
+    queue->count = 0;
+    queue->storage = (uint8_t*)(queue + 1);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    free(queue);
+}
+
+static uint8_t* queueSlot(QueueHandle_t queue, UBaseType_t index) {
+    return queue->storage + ((queue->head + index) % queue->length) * queue->item_size;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    std::function<bool()> ready = [queue]() { return queue->count < queue->length; };
+    if (!block(lock, ready, ticks)) {
+        return errQUEUE_FULL;
+    }
+    memcpy(queueSlot(queue, queue->count), item, queue->item_size);
+    queue->count++;
+    wake();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return xQueueSend(queue, item, ticks);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    if (queue->count == 0) {
+        queue->count = 1;
+    }
+    memcpy(queueSlot(queue, 0), item, queue->item_size);
+    wake();
+    return pdPASS;
+}
+
+static BaseType_t queueTake(QueueHandle_t queue, void* item, TickType_t ticks, bool remove) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    std::function<bool()> ready = [queue]() { return queue->count > 0; };
+    if (!block(lock, ready, ticks)) {
+        return pdFALSE;
+    }
+    memcpy(item, queueSlot(queue, 0), queue->item_size);
+    if (remove) {
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        wake();
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queueTake(queue, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return queueTake(queue, item, ticks, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    queue->head = 0;
+    queue->count = 0;
+    wake();
+    return pdPASS;
+}
+
+// ---- Event groups ----
+
+EventGroupHandle_t xEventGroupCreate() {
+    EventGroupDef_t* group = (EventGroupDef_t*)malloc(sizeof(EventGroupDef_t));
+    if (group) {
+        group->bits = 0;
+    }
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    group->bits |= bits;
+    wake();
+    return group->bits;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    xEventGroupSetBits(group, bits);
+    return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    std::function<bool()> ready = [group, bits, waitForAll]() {
+        return waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    bool met = block(lock, ready, ticks);
+    EventBits_t result = group->bits;
+    if (met && clearOnExit) {
+        group->bits &= ~bits;
+    }
+    return result;
+}
+
+// ---- Software timers ----
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback) {
+    tmrTimerControl* timer = (tmrTimerControl*)malloc(sizeof(tmrTimerControl));
+    if (!timer) {
+        return nullptr;
+    }
+    timer->name = name;
+    timer->period = period;
+    timer->auto_reload = autoReload;
+    timer->id = id;
+    timer->callback = callback;
+    timer->active = false;
+    timer->generation = 0;
+    return timer;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t timer) {
+    return timer->id;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+    (void)ticks;
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    fake::armTimer(timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+    (void)ticks;
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    timer->active = false;
+    timer->generation++;
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks) {
+    return xTimerStart(timer, ticks);
+}
+
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xTimerStart(timer, 0);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks) {
+    (void)ticks;
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    timer->period = period;
+    fake::armTimer(timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks) {
+    // Pending expiries still reference the timer; stop it and let it leak
+    return xTimerStop(timer, ticks);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+    std::unique_lock<std::mutex> lock = fake::detail::lockKernel();
+    return timer->active;
+}
@@ -0,0 +1,44 @@
+#ifndef FAKE_KERNEL_H
+#define FAKE_KERNEL_H
+
+// Shared plumbing of the fakes, not for tests
+
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+
+namespace fake {
+namespace detail {
+
+// Guards the clock, the action queue and all fake RTOS objects
+std::unique_lock<std::mutex> lockKernel();
+
+// Waits with the kernel lock held until ready() or ticks have passed.
+// Tasks park until the clock or a wake() lets them go; the test thread
+// advances the clock itself. Returns ready().
+bool block(std::unique_lock<std::mutex>& lock, const std::function<bool()>& ready, uint32_t ticks);
+
+// Re-checks blocked tasks after a state change, kernel lock held
+void wake();
+
+// Runs action on the test thread at atMs (kernel lock not held)
+void schedule(uint64_t atMs, std::function<void()> action);
+
+bool inTask();
+
+// Per-module resets, called by fake::reset()
+void resetKernel();
+void resetSerial();
+void resetGpio();
+void resetPower();
+void resetWiFi();
+void resetNvs();
+void resetNetwork();
+void resetClients();
+void resetFlash();
+void resetFirmware(bool reboot);  // reboot: boot the next image, keep the slots
+
+} // namespace detail
+} // namespace fake
+
+#endif // FAKE_KERNEL_H
@@ -0,0 +1,981 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <AsyncUDP.h>
+#include <ESPAsyncWebServer.h>
+#include <algorithm>
+#include <string.h>
+#include <strings.h>
+
+// Fake UDP sockets and web server, plus the in-process DNS and HTTP clients
+
+namespace fake {
+namespace {
+
+// Approximate status line and header bytes of a response
+const size_t RESPONSE_HEAD_SIZE = 200;
+const char* const UPLOAD_BOUNDARY = "----FakeUploadBoundary";
+const char* const BASE64_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::mutex network_mutex;
+std::vector<AsyncWebServer*> servers;  // Listening
+std::vector<AsyncUDP*> udp_sockets;  // Listening
+uint16_t dns_next_id = 1;
+DnsStats dns_stats;
+uint32_t link_speed = 0;
+uint8_t http_client = 2;
+std::list<AsyncWebServerRequest*> in_flight;
+
+// fake::openEvents handles index this
+struct EventStream {
+    AsyncEventSourceClient* client;  // Null once the server closed it
+    std::vector<ServerEvent> events;
+};
+std::vector<EventStream> event_streams;
+
+AsyncWebServer* listening(uint16_t port) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    for (size_t i = 0; i < servers.size(); i++) {
+        if (servers[i]->_getPort() == port) {
+            return servers[i];
+        }
+    }
+    return nullptr;
+}
+
+WebRequestMethodComposite parseMethod(const char* method) {
+    static const struct { const char* name; WebRequestMethod method; } methods[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "DELETE", HTTP_DELETE }, { "PUT", HTTP_PUT },
+        { "PATCH", HTTP_PATCH }, { "HEAD", HTTP_HEAD }, { "OPTIONS", HTTP_OPTIONS },
+    };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcasecmp(method, methods[i].name) == 0) {
+            return methods[i].method;
+        }
+    }
+    return HTTP_GET;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string urlDecode(const std::string& in) {
+    std::string out;
+    for (size_t i = 0; i < in.size(); i++) {
+        if (in[i] == '+') {
+            out += ' ';
+        } else if (in[i] == '%' && i + 2 < in.size() && hexValue(in[i + 1]) >= 0 && hexValue(in[i + 2]) >= 0) {
+            out += (char)(hexValue(in[i + 1]) * 16 + hexValue(in[i + 2]));
+            i += 2;
+        } else {
+            out += in[i];
+        }
+    }
+    return out;
+}
+
+void addParams(AsyncWebServerRequest* request, const std::string& encoded, bool post) {
+    size_t start = 0;
+    while (start < encoded.size()) {
+        size_t end = encoded.find('&', start);
+        if (end == std::string::npos) {
+            end = encoded.size();
+        }
+        std::string pair = encoded.substr(start, end - start);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            std::string name = urlDecode(pair.substr(0, eq));
+            std::string value = eq == std::string::npos ? std::string() : urlDecode(pair.substr(eq + 1));
+            request->_addParam(name.c_str(), value.c_str(), post);
+        }
+        start = end + 1;
+    }
+}
+
+std::string findHeader(const Headers& headers, const char* name) {
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (strcasecmp(headers[i].first.c_str(), name) == 0) {
+            return headers[i].second;
+        }
+    }
+    return std::string();
+}
+
+std::string base64Decode(const char* in) {
+    std::string out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (; *in && *in != '='; in++) {
+        const char* digit = strchr(BASE64_DIGITS, *in);
+        if (!digit) {
+            return std::string();
+        }
+        bits = (bits << 6) | (uint32_t)(digit - BASE64_DIGITS);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out += (char)(bits >> count);
+        }
+    }
+    return out;
+}
+
+// Request as the library would have parsed it from the socket, heap paused
+AsyncWebServerRequest* parseRequest(AsyncWebServer* server, const char* method, const char* url, const Headers& headers) {
+    std::string path(url);
+    std::string query;
+    size_t mark = path.find('?');
+    if (mark != std::string::npos) {
+        query = path.substr(mark + 1);
+        path.erase(mark);
+    }
+    AsyncWebServerRequest* request = new AsyncWebServerRequest(server, parseMethod(method), path.c_str());
+    {
+        std::lock_guard<std::mutex> guard(network_mutex);
+        request->client()->_setRemoteIP(IPAddress(192, 168, 4, http_client));
+    }
+    addParams(request, query, false);
+    for (size_t i = 0; i < headers.size(); i++) {
+        request->_addHeader(headers[i].first.c_str(), headers[i].second.c_str());
+    }
+    return request;
+}
+
+// Captures the response of a handled request, then frees the request once
+// the link has sent it
+HttpResponse respond(AsyncWebServerRequest* request) {
+    HttpResponse result;
+    result.code = 0;
+    {
+        HeapPause pause;
+        AsyncWebServerResponse* response = request->_sent();
+        if (response) {
+            result.code = response->code();
+            result.content_type = response->contentType().c_str();
+            const std::list<AsyncWebHeader>& sent = response->getHeaders();
+            for (std::list<AsyncWebHeader>::const_iterator it = sent.begin(); it != sent.end(); ++it) {
+                result.headers.push_back(std::make_pair(std::string(it->name().c_str()), std::string(it->value().c_str())));
+            }
+            response->_fillBody(result.body);
+        }
+    }
+
+    // Freeing the request, its _tempObject and the response is the library's
+    // work, so it stays counted (frees never add to the counters anyway)
+    uint32_t speed;
+    {
+        std::lock_guard<std::mutex> guard(network_mutex);
+        speed = link_speed;
+    }
+    if (speed == 0) {
+        delete request;
+        return result;
+    }
+    uint64_t send_ms = (uint64_t)(result.body.size() + RESPONSE_HEAD_SIZE) * 1000 / speed;
+    {
+        std::lock_guard<std::mutex> guard(network_mutex);
+        HeapPause pause;
+        in_flight.push_back(request);
+        detail::schedule(now() + max(send_ms, (uint64_t)1), [request]() {
+            {
+                std::lock_guard<std::mutex> guard(network_mutex);
+                HeapPause pause;
+                std::list<AsyncWebServerRequest*>::iterator it = std::find(in_flight.begin(), in_flight.end(), request);
+                if (it == in_flight.end()) {
+                    return;  // Dropped with its server
+                }
+                in_flight.erase(it);
+            }
+            delete request;
+        });
+    }
+    return result;
+}
+
+} // namespace
+
+namespace detail {
+
+void resetNetwork() {
+    HeapPause pause;
+    std::vector<AsyncWebServer*> stopping;
+    std::list<AsyncWebServerRequest*> sending;
+    {
+        std::lock_guard<std::mutex> guard(network_mutex);
+        stopping = servers;
+        sending.swap(in_flight);
+        udp_sockets.clear();
+        dns_next_id = 1;
+        memset(&dns_stats, 0, sizeof(dns_stats));
+        link_speed = 0;
+        http_client = 2;
+    }
+    for (std::list<AsyncWebServerRequest*>::iterator it = sending.begin(); it != sending.end(); ++it) {
+        delete *it;
+    }
+    for (size_t i = 0; i < stopping.size(); i++) {
+        stopping[i]->end();
+    }
+    std::lock_guard<std::mutex> guard(network_mutex);
+    event_streams.clear();
+}
+
+int openEventStream() {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    HeapPause pause;
+    event_streams.push_back(EventStream());
+    event_streams.back().client = nullptr;
+    return (int)event_streams.size() - 1;
+}
+
+void attachEventStream(int stream, AsyncEventSourceClient* client) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    if (stream >= 0 && (size_t)stream < event_streams.size()) {
+        event_streams[stream].client = client;
+    }
+}
+
+void eventSent(int stream, const char* event, const char* data, uint32_t id) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    if (stream < 0 || (size_t)stream >= event_streams.size()) {
+        return;
+    }
+    HeapPause pause;
+    ServerEvent sent;
+    sent.id = id;
+    sent.event = event ? event : "";
+    sent.data = data ? data : "";
+    sent.at = now();
+    event_streams[stream].events.push_back(sent);
+}
+
+void closeEventStream(int stream) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    if (stream >= 0 && (size_t)stream < event_streams.size()) {
+        event_streams[stream].client = nullptr;
+    }
+}
+
+} // namespace detail
+
+bool dnsRunning() {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    for (size_t i = 0; i < udp_sockets.size(); i++) {
+        if (udp_sockets[i]->_getPort() == 53) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DnsReply dnsLookup(const char* name, uint16_t type, uint8_t client) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    DnsReply result = { false, 0, 0, 0, std::string() };
+    std::string query;
+    std::string reply;
+    {
+        HeapPause pause;
+        dns_stats.queries++;
+        result.id = dns_next_id++;
+
+        // Header: ID, RD, one question; then the name as labels, type, class IN
+        const uint8_t header[] = { (uint8_t)(result.id >> 8), (uint8_t)result.id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0 };
+        query.assign((const char*)header, sizeof(header));
+        const char* label = name;
+        while (*label) {
+            const char* dot = strchr(label, '.');
+            size_t length = dot ? (size_t)(dot - label) : strlen(label);
+            query += (char)length;
+            query.append(label, length);
+            label += length + (dot ? 1 : 0);
+        }
+        query += '\0';
+        query += (char)(type >> 8);
+        query += (char)type;
+        query += '\0';
+        query += (char)1;
+    }
+
+    AsyncUDP* socket = nullptr;
+    for (size_t i = 0; i < udp_sockets.size(); i++) {
+        if (udp_sockets[i]->_getPort() == 53) {
+            socket = udp_sockets[i];
+        }
+    }
+    if (socket) {
+        AsyncUDPPacket packet((const uint8_t*)query.data(), query.size(), IPAddress(192, 168, 4, client), 49152, &reply);
+        socket->_deliver(packet);
+    }
+
+    HeapPause pause;
+    const uint8_t* data = (const uint8_t*)reply.data();
+    if (reply.size() < 12 || ((data[0] << 8) | data[1]) != result.id) {
+        dns_stats.dropped++;
+        return result;
+    }
+    dns_stats.answered++;
+    result.answered = true;
+    result.rcode = data[3] & 0x0F;
+    result.answers = (data[6] << 8) | data[7];
+
+    // First answer after the echoed question, if it is an A record
+    size_t pos = query.size();
+    if (result.answers > 0 && reply.size() >= pos + 16 && data[pos + 3] == 1 && data[pos + 11] == 4) {
+        char address[16];
+        snprintf(address, sizeof(address), "%u.%u.%u.%u", data[pos + 12], data[pos + 13], data[pos + 14], data[pos + 15]);
+        result.address = address;
+    }
+    return result;
+}
+
+bool dnsQuery(uint8_t client) {
+    return dnsLookup("connectivitycheck.gstatic.com", 1, client).answered;
+}
+
+DnsStats dnsStats() {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    return dns_stats;
+}
+
+void setLinkSpeed(uint32_t bytesPerSecond) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    link_speed = bytesPerSecond;
+}
+
+void setHttpClient(uint8_t client) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    http_client = client;
+}
+
+int httpInFlight() {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    return (int)in_flight.size();
+}
+
+std::string HttpResponse::header(const char* name) const {
+    return findHeader(headers, name);
+}
+
+bool HttpResponse::hasHeader(const char* name) const {
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (strcasecmp(headers[i].first.c_str(), name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HttpResponse http(const char* method, const char* url, const std::string& body, const Headers& headers,
+                  size_t chunkSize, uint16_t port) {
+    AsyncWebServer* server = listening(port);
+    if (!server) {
+        return HttpResponse();
+    }
+
+    AsyncWebServerRequest* request;
+    AsyncWebHandler* handler;
+    std::vector<uint8_t> data;
+    bool form;
+    {
+        HeapPause pause;
+        request = parseRequest(server, method, url, headers);
+        std::string content_type = findHeader(headers, "Content-Type");
+        request->_setBody(content_type.c_str(), body.size());
+        form = content_type.compare(0, 33, "application/x-www-form-urlencoded") == 0;
+        if (form) {
+            addParams(request, body, true);
+        }
+        handler = server->_findHandler(request);
+        data.assign(body.begin(), body.end());
+    }
+
+    // Handler side, counted
+    if (!form && !data.empty()) {
+        size_t piece = chunkSize ? chunkSize : data.size();
+        for (size_t index = 0; index < data.size(); index += piece) {
+            size_t len = min(piece, data.size() - index);
+            handler->handleBody(request, &data[index], len, index, data.size());
+        }
+    }
+    handler->handleRequest(request);
+    {
+        HeapPause pause;
+        data.clear();
+        data.shrink_to_fit();
+    }
+    return respond(request);
+}
+
+int openEvents(const char* url, uint32_t lastEventId, uint16_t port) {
+    AsyncWebServer* server = listening(port);
+    if (!server) {
+        return -1;
+    }
+    AsyncWebServerRequest* request;
+    AsyncEventSource* source;
+    size_t before;
+    {
+        HeapPause pause;
+        Headers headers;
+        headers.push_back(std::make_pair(std::string("Accept"), std::string("text/event-stream")));
+        if (lastEventId > 0) {
+            headers.push_back(std::make_pair(std::string("Last-Event-ID"), std::to_string(lastEventId)));
+        }
+        request = parseRequest(server, "GET", url, headers);
+        source = dynamic_cast<AsyncEventSource*>(server->_findHandler(request));
+        if (!source) {
+            delete request;
+            return -1;
+        }
+        std::lock_guard<std::mutex> guard(network_mutex);
+        before = event_streams.size();
+    }
+
+    // The source keeps the connection, the request itself is done with
+    source->handleRequest(request);
+    delete request;
+    std::lock_guard<std::mutex> guard(network_mutex);
+    return event_streams.size() > before ? (int)before : -1;
+}
+
+std::vector<ServerEvent> receivedEvents(int stream) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    HeapPause pause;
+    if (stream < 0 || (size_t)stream >= event_streams.size()) {
+        return std::vector<ServerEvent>();
+    }
+    return event_streams[stream].events;
+}
+
+bool eventsOpen(int stream) {
+    std::lock_guard<std::mutex> guard(network_mutex);
+    return stream >= 0 && (size_t)stream < event_streams.size() && event_streams[stream].client;
+}
+
+void closeEvents(int stream) {
+    AsyncEventSourceClient* client = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(network_mutex);
+        if (stream >= 0 && (size_t)stream < event_streams.size()) {
+            client = event_streams[stream].client;
+        }
+    }
+    if (client) {
+        client->close();
+    }
+}
+
+HttpResponse upload(const char* url, const char* filename, const std::string& data, const Headers& headers,
+                    size_t chunkSize, size_t disconnectAt, uint16_t port) {
+    AsyncWebServer* server = listening(port);
+    if (!server) {
+        return HttpResponse();
+    }
+
+    AsyncWebServerRequest* request;
+    AsyncWebHandler* handler;
+    std::vector<uint8_t> buffer;
+    String name;
+    {
+        HeapPause pause;
+        request = parseRequest(server, "POST", url, headers);
+        std::string head = std::string("--") + UPLOAD_BOUNDARY + "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"" +
+                           filename + "\"\r\nContent-Type: application/octet-stream\r\n\r\n";
+        std::string tail = std::string("\r\n--") + UPLOAD_BOUNDARY + "--\r\n";
+        request->_setBody((std::string("multipart/form-data; boundary=") + UPLOAD_BOUNDARY).c_str(),
+                          head.size() + data.size() + tail.size());
+        handler = server->_findHandler(request);
+        buffer.resize(chunkSize ? chunkSize : max(data.size(), (size_t)1));
+        name = filename;
+    }
+
+    // Handler side, counted. The library hands the file part over in the
+    // pieces it arrived in, the last one (possibly empty) marked final.
+    size_t index = 0;
+    bool connected = true;
+    do {
+        size_t len = min(buffer.size(), data.size() - index);
+        if (disconnectAt > 0 && index + len >= disconnectAt) {
+            connected = false;
+            len = disconnectAt - index;
+        }
+        memcpy(buffer.data(), data.data() + index, len);
+        bool final = connected && index + len == data.size();
+        handler->handleUpload(request, name, index, buffer.data(), len, final);
+        index += len;
+    } while (connected && index < data.size());
+    {
+        HeapPause pause;
+        buffer.clear();
+        buffer.shrink_to_fit();
+        name = String();
+    }
+    if (!connected) {
+        delete request;  // Runs onDisconnect()
+        return HttpResponse();
+    }
+    handler->handleRequest(request);
+    return respond(request);
+}
+
+HttpResponse get(const char* url, const Headers& headers) {
+    return http("GET", url, std::string(), headers);
+}
+
+HttpResponse postForm(const char* url, const std::string& form) {
+    Headers headers;
+    {
+        HeapPause pause;
+        headers.push_back(std::make_pair(std::string("Content-Type"), std::string("application/x-www-form-urlencoded")));
+    }
+    return http("POST", url, form, headers);
+}
+
+HttpResponse putJson(const char* url, const std::string& json, size_t chunkSize) {
+    Headers headers;
+    {
+        HeapPause pause;
+        headers.push_back(std::make_pair(std::string("Content-Type"), std::string("application/json")));
+    }
+    return http("PUT", url, json, headers, chunkSize);
+}
+
+} // namespace fake
+
+// ---- AsyncUDP ----
+
+size_t AsyncUDPPacket::write(const uint8_t* data, size_t length) {
+    fake::HeapPause pause;
+    _reply->assign((const char*)data, length);
+    return length;
+}
+
+bool AsyncUDP::listen(uint16_t port) {
+    std::lock_guard<std::mutex> guard(fake::network_mutex);
+    for (size_t i = 0; i < fake::udp_sockets.size(); i++) {
+        if (fake::udp_sockets[i]->_getPort() == port && fake::udp_sockets[i] != this) {
+            return false;
+        }
+    }
+    if (!_listening) {
+        fake::HeapPause pause;
+        fake::udp_sockets.push_back(this);
+    }
+    _port = port;
+    _listening = true;
+    return true;
+}
+
+void AsyncUDP::close() {
+    std::lock_guard<std::mutex> guard(fake::network_mutex);
+    for (size_t i = 0; i < fake::udp_sockets.size(); i++) {
+        if (fake::udp_sockets[i] == this) {
+            fake::udp_sockets.erase(fake::udp_sockets.begin() + i);
+            break;
+        }
+    }
+    _listening = false;
+}
+
+// ---- Responses ----
+
+bool AsyncWebServerResponse::addHeader(const char* name, const char* value, bool replaceExisting) {
+    for (std::list<AsyncWebHeader>::iterator it = _headers.begin(); it != _headers.end(); ++it) {
+        if (strcasecmp(it->name().c_str(), name) == 0) {
+            if (!replaceExisting) {
+                return false;
+            }
+            _headers.erase(it);
+            break;
+        }
+    }
+    _headers.push_back(AsyncWebHeader(name, value));
+    return true;
+}
+
+void AsyncCallbackResponse::_fillBody(std::string& out) {
+    uint8_t buffer[1460];
+    size_t index = 0;
+    out.clear();
+    while (_chunked || index < _contentLength) {
+        size_t max_len = _chunked ? sizeof(buffer) : min(sizeof(buffer), _contentLength - index);
+        size_t n = _filler(buffer, max_len, index);
+        if (n == 0 || n > max_len) {
+            break;
+        }
+        out.append((const char*)buffer, n);
+        index += n;
+    }
+}
+
+AsyncResponseStream::AsyncResponseStream(const char* contentType, size_t bufferSize)
+    : AsyncWebServerResponse(200, contentType), _capacity(bufferSize), _length(0) {
+    _buffer = (uint8_t*)malloc(_capacity);
+}
+
+AsyncResponseStream::~AsyncResponseStream() {
+    free(_buffer);
+}
+
+size_t AsyncResponseStream::write(const uint8_t* data, size_t len) {
+    if (!_buffer) {
+        return 0;
+    }
+    if (_length + len > _capacity) {
+        size_t capacity = max(_capacity * 2, _length + len);
+        uint8_t* grown = (uint8_t*)realloc(_buffer, capacity);
+        if (!grown) {
+            return 0;
+        }
+        _buffer = grown;
+        _capacity = capacity;
+    }
+    memcpy(_buffer + _length, data, len);
+    _length += len;
+    _contentLength = _length;
+    return len;
+}
+
+// ---- Handlers ----
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) const {
+    if (!_onRequest || !(_method & request->method())) {
+        return false;
+    }
+    const String& url = request->url();
+    if (_uri.length() == 0 || _uri == url) {
+        return true;
+    }
+    if (_uri.endsWith("*")) {
+        return url.startsWith(_uri.substring(0, _uri.length() - 1));
+    }
+    return url.startsWith(_uri + "/");
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest* request) {
+    if (_onRequest) {
+        _onRequest(request);
+    } else {
+        request->send(404);
+    }
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                                           uint8_t* data, size_t len, bool final) {
+    if (_onUpload) {
+        _onUpload(request, filename, index, data, len, final);
+    }
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index,
+                                         size_t total) {
+    if (_onBody) {
+        _onBody(request, data, len, index, total);
+    }
+}
+
+// ---- Requests ----
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, WebRequestMethodComposite method, const String& url)
+    : _server(server), _method(method), _url(url), _contentLength(0), _response(nullptr), _tempObject(nullptr) {
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+    if (_onDisconnect) {
+        _onDisconnect();
+    }
+    delete _response;
+    if (_tempObject) {
+        free(_tempObject);
+    }
+}
+
+const AsyncWebParameter* AsyncWebServerRequest::getParam(const char* name, bool post, bool file) const {
+    (void)file;
+    for (size_t i = 0; i < _params.size(); i++) {
+        if (_params[i].isPost() == post && _params[i].name() == name) {
+            return &_params[i];
+        }
+    }
+    return nullptr;
+}
+
+const String& AsyncWebServerRequest::arg(const char* name) const {
+    static const String empty;
+    const AsyncWebParameter* param = getParam(name);
+    if (!param) {
+        param = getParam(name, true);
+    }
+    return param ? param->value() : empty;
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const char* name) const {
+    for (size_t i = 0; i < _headers.size(); i++) {
+        if (strcasecmp(_headers[i].name().c_str(), name) == 0) {
+            return &_headers[i];
+        }
+    }
+    return nullptr;
+}
+
+const String& AsyncWebServerRequest::header(const char* name) const {
+    static const String empty;
+    const AsyncWebHeader* found = getHeader(name);
+    return found ? found->value() : empty;
+}
+
+bool AsyncWebServerRequest::authenticate(const char* username, const char* password, const char* realm,
+                                         bool passwordIsHash) const {
+    (void)realm;
+    if (passwordIsHash) {
+        return false;
+    }
+    const String& value = header("Authorization");
+    if (!value.startsWith("Basic ")) {
+        return false;
+    }
+    fake::HeapPause pause;
+    std::string expected = std::string(username) + ":" + password;
+    return fake::base64Decode(value.c_str() + 6) == expected;
+}
+
+void AsyncWebServerRequest::requestAuthentication(const char* realm, bool isDigest) {
+    AsyncWebServerResponse* response = beginResponse(401);
+    String challenge = String(isDigest ? "Digest" : "Basic") + " realm=\"" + (realm ? realm : "Login Required") + "\"";
+    response->addHeader("WWW-Authenticate", challenge.c_str());
+    send(response);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+    if (_response) {
+        // A second response is a handler bug; the library drops it too
+        delete response;
+        return;
+    }
+    _response = response;
+}
+
+void AsyncWebServerRequest::send(int code, const char* contentType, const char* content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+    send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(int code, const char* contentType, const uint8_t* content, size_t len) {
+    send(beginResponse(code, contentType, content, len));
+}
+
+void AsyncWebServerRequest::redirect(const char* url, int code) {
+    AsyncWebServerResponse* response = beginResponse(code);
+    response->addHeader("Location", url);
+    send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const char* contentType, const char* content) {
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+    return new AsyncBasicResponse(code, contentType.c_str(), content);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const char* contentType, const uint8_t* content,
+                                                             size_t len) {
+    return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(const char* contentType, size_t len, AwsResponseFiller filler) {
+    return new AsyncCallbackResponse(contentType, len, filler, false);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginChunkedResponse(const char* contentType, AwsResponseFiller filler) {
+    return new AsyncCallbackResponse(contentType, 0, filler, true);
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const char* contentType, size_t bufferSize) {
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+void AsyncWebServerRequest::_addParam(const String& name, const String& value, bool post) {
+    _params.push_back(AsyncWebParameter(name, value, post));
+}
+
+void AsyncWebServerRequest::_addHeader(const String& name, const String& value) {
+    _headers.push_back(AsyncWebHeader(name, value));
+}
+
+// ---- Server-Sent Events ----
+
+AsyncEventSourceClient::AsyncEventSourceClient(AsyncEventSource* server, int stream, uint32_t lastId)
+    : _server(server), _stream(stream), _lastId(lastId) {
+    fake::detail::attachEventStream(stream, this);
+}
+
+AsyncEventSourceClient::~AsyncEventSourceClient() {
+    fake::detail::closeEventStream(_stream);
+}
+
+bool AsyncEventSourceClient::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    (void)reconnect;
+    fake::detail::eventSent(_stream, event, message, id);
+    return true;
+}
+
+void AsyncEventSourceClient::close() {
+    _server->_removeClient(this);
+}
+
+AsyncEventSource::~AsyncEventSource() {
+    close();
+}
+
+void AsyncEventSource::close() {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (std::list<AsyncEventSourceClient*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        delete *it;
+    }
+    _clients.clear();
+}
+
+void AsyncEventSource::send(const char* message, const char* event, uint32_t id, uint32_t reconnect) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (std::list<AsyncEventSourceClient*>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        (*it)->send(message, event, id, reconnect);
+    }
+}
+
+size_t AsyncEventSource::count() const {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    return _clients.size();
+}
+
+bool AsyncEventSource::canHandle(AsyncWebServerRequest* request) const {
+    return request->method() == HTTP_GET && request->url() == _url;
+}
+
+void AsyncEventSource::handleRequest(AsyncWebServerRequest* request) {
+    uint32_t last = 0;
+    if (request->hasHeader("Last-Event-ID")) {
+        last = (uint32_t)strtoul(request->header("Last-Event-ID").c_str(), nullptr, 10);
+    }
+    AsyncEventSourceClient* client = new AsyncEventSourceClient(this, fake::detail::openEventStream(), last);
+    {
+        std::lock_guard<std::recursive_mutex> guard(_lock);
+        _clients.push_back(client);
+    }
+    if (_connectcb) {
+        _connectcb(client);
+    }
+}
+
+void AsyncEventSource::_removeClient(AsyncEventSourceClient* client) {
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _clients.remove(client);
+    delete client;
+}
+
+// ---- Server ----
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port), _running(false) {
+}
+
+AsyncWebServer::~AsyncWebServer() {
+    end();
+    reset();
+
+    // Responses still being sent go with the server, their disconnect
+    // handlers run while whatever they refer to is still there
+    std::list<AsyncWebServerRequest*> dropped;
+    {
+        std::lock_guard<std::mutex> guard(fake::network_mutex);
+        fake::HeapPause pause;
+        for (std::list<AsyncWebServerRequest*>::iterator it = fake::in_flight.begin(); it != fake::in_flight.end();) {
+            if ((*it)->_server == this) {
+                dropped.push_back(*it);
+                it = fake::in_flight.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (std::list<AsyncWebServerRequest*>::iterator it = dropped.begin(); it != dropped.end(); ++it) {
+        delete *it;
+    }
+}
+
+void AsyncWebServer::begin() {
+    std::lock_guard<std::mutex> guard(fake::network_mutex);
+    if (!_running) {
+        fake::HeapPause pause;
+        fake::servers.push_back(this);
+        _running = true;
+    }
+}
+
+void AsyncWebServer::end() {
+    std::lock_guard<std::mutex> guard(fake::network_mutex);
+    for (size_t i = 0; i < fake::servers.size(); i++) {
+        if (fake::servers[i] == this) {
+            fake::servers.erase(fake::servers.begin() + i);
+            break;
+        }
+    }
+    _running = false;
+}
+
+void AsyncWebServer::reset() {
+    for (std::list<AsyncWebHandler*>::iterator it = _handlers.begin(); it != _handlers.end(); ++it) {
+        delete *it;
+    }
+    _handlers.clear();
+    _catchAll.onRequest(nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, ArRequestHandlerFunction onRequest) {
+    return on(uri, HTTP_ANY, onRequest);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+    return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+    AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(onRequest);
+    handler->onUpload(onUpload);
+    handler->onBody(onBody);
+    addHandler(handler);
+    return *handler;
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler* handler) {
+    for (std::list<AsyncWebHandler*>::iterator it = _handlers.begin(); it != _handlers.end(); ++it) {
+        if (*it == handler) {
+            _handlers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+AsyncWebHandler* AsyncWebServer::_findHandler(AsyncWebServerRequest* request) {
+    for (std::list<AsyncWebHandler*>::iterator it = _handlers.begin(); it != _handlers.end(); ++it) {
+        if ((*it)->canHandle(request)) {
+            return *it;
+        }
+    }
+    return &_catchAll;
+}
@@ -0,0 +1,301 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <Preferences.h>
+#include <map>
+#include <string>
+
+// In-memory NVS: namespace -> key -> typed value. Every successful put is
+// counted as a flash write, whether or not the value changed.
+
+// NVS limits
+static const size_t KEY_MAX_LEN = 15;
+static const size_t BLOB_MAX_SIZE = 1984 * 2;
+static const size_t ENTRY_SIZE = 32;
+static const size_t TOTAL_ENTRIES = 630;  // 5 pages of 126 entries
+
+namespace fake {
+namespace {
+
+struct Value {
+    char type;  // b(ool), u(nsigned), i(nt), s(tring), B(lob)
+    std::string data;
+};
+
+typedef std::map<std::string, Value> Namespace;
+
+std::mutex nvs_mutex;
+std::map<std::string, Namespace> nvs;
+uint32_t write_count = 0;
+uint32_t write_bytes = 0;
+
+Namespace* findNamespace(const char* ns) {
+    std::map<std::string, Namespace>::iterator it = nvs.find(ns);
+    return it == nvs.end() ? nullptr : &it->second;
+}
+
+void store(const char* ns, const char* key, char type, const void* data, size_t length) {
+    HeapPause pause;
+    Value& value = nvs[ns][key];
+    value.type = type;
+    value.data.assign((const char*)data, length);
+    write_count++;
+    write_bytes += length;
+}
+
+} // namespace
+
+namespace detail {
+
+void resetNvs() {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    HeapPause pause;
+    nvs.clear();
+    write_count = 0;
+    write_bytes = 0;
+}
+
+} // namespace detail
+
+uint32_t nvsWrites() {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    return write_count;
+}
+
+uint32_t nvsBytesWritten() {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    return write_bytes;
+}
+
+bool nvsHasKey(const char* ns, const char* key) {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    Namespace* entries = findNamespace(ns);
+    return entries && entries->count(key);
+}
+
+void nvsPutBytes(const char* ns, const char* key, const void* data, size_t length) {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    store(ns, key, 'B', data, length);
+}
+
+void nvsPutString(const char* ns, const char* key, const char* value) {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    store(ns, key, 's', value, strlen(value) + 1);
+}
+
+void nvsPutBool(const char* ns, const char* key, bool value) {
+    uint8_t byte = value;
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    store(ns, key, 'b', &byte, 1);
+}
+
+} // namespace fake
+
+using fake::nvs_mutex;
+
+Preferences::Preferences() : started(false), read_only(false) {
+}
+
+Preferences::~Preferences() {
+    end();
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partition) {
+    (void)partition;
+    if (started || !name || strlen(name) > KEY_MAX_LEN) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::HeapPause pause;
+    if (readOnly && !fake::findNamespace(name)) {
+        return false;
+    }
+    if (!readOnly) {
+        fake::nvs[name];
+    }
+    ns = name;
+    started = true;
+    read_only = readOnly;
+    return true;
+}
+
+void Preferences::end() {
+    started = false;
+}
+
+bool Preferences::clear() {
+    if (!started || read_only) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::HeapPause pause;
+    fake::findNamespace(ns.c_str())->clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!started || read_only) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::HeapPause pause;
+    return fake::findNamespace(ns.c_str())->erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    if (!started) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::Namespace* entries = fake::findNamespace(ns.c_str());
+    return entries && entries->count(key);
+}
+
+size_t Preferences::freeEntries() {
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    size_t used = 0;
+    for (std::map<std::string, fake::Namespace>::iterator ns_it = fake::nvs.begin(); ns_it != fake::nvs.end(); ++ns_it) {
+        for (fake::Namespace::iterator it = ns_it->second.begin(); it != ns_it->second.end(); ++it) {
+            used += 1 + (it->second.type == 's' || it->second.type == 'B' ? (it->second.data.size() + ENTRY_SIZE - 1) / ENTRY_SIZE : 0);
+        }
+    }
+    return used < TOTAL_ENTRIES ? TOTAL_ENTRIES - used : 0;
+}
+
+size_t Preferences::put(const char* key, char type, const void* value, size_t length) {
+    if (!started || read_only || !key || strlen(key) > KEY_MAX_LEN || length > BLOB_MAX_SIZE) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::store(ns.c_str(), key, type, value, length);
+    return length;
+}
+
+bool Preferences::get(const char* key, char type, void* value, size_t length) {
+    if (!started) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::Namespace* entries = fake::findNamespace(ns.c_str());
+    if (!entries) {
+        return false;
+    }
+    fake::Namespace::iterator it = entries->find(key);
+    if (it == entries->end() || it->second.type != type || it->second.data.size() != length) {
+        return false;
+    }
+    memcpy(value, it->second.data.data(), length);
+    return true;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    uint8_t byte = value;
+    return put(key, 'b', &byte, 1);
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return put(key, 'u', &value, sizeof(value));
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return put(key, 'i', &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, 'u', &value, sizeof(value));
+}
+
+size_t Preferences::putULong(const char* key, uint32_t value) {
+    return put(key, 'u', &value, sizeof(value));
+}
+
+size_t Preferences::putULong64(const char* key, uint64_t value) {
+    return put(key, 'u', &value, sizeof(value));
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    // NVS stores the terminator too
+    return put(key, 's', value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!value || length == 0) {
+        return 0;
+    }
+    return put(key, 'B', value, length);
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) {
+    uint8_t byte;
+    return get(key, 'b', &byte, 1) ? byte != 0 : defaultValue;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    uint8_t value;
+    return get(key, 'u', &value, sizeof(value)) ? value : defaultValue;
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    int32_t value;
+    return get(key, 'i', &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value;
+    return get(key, 'u', &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint32_t Preferences::getULong(const char* key, uint32_t defaultValue) {
+    return getUInt(key, defaultValue);
+}
+
+uint64_t Preferences::getULong64(const char* key, uint64_t defaultValue) {
+    uint64_t value;
+    return get(key, 'u', &value, sizeof(value)) ? value : defaultValue;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    char buf[BLOB_MAX_SIZE];
+    return getString(key, buf, sizeof(buf)) ? String(buf) : defaultValue;
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLength) {
+    if (!started) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::Namespace* entries = fake::findNamespace(ns.c_str());
+    fake::Namespace::iterator it;
+    if (!entries || (it = entries->find(key)) == entries->end() || it->second.type != 's' ||
+        it->second.data.size() > maxLength) {
+        return 0;
+    }
+    memcpy(value, it->second.data.data(), it->second.data.size());
+    return it->second.data.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!started) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    fake::Namespace* entries = fake::findNamespace(ns.c_str());
+    fake::Namespace::iterator it;
+    if (!entries || (it = entries->find(key)) == entries->end() || it->second.type != 'B') {
+        return 0;
+    }
+    return it->second.data.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    size_t length = getBytesLength(key);
+    if (length == 0 || length > maxLength) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(nvs_mutex);
+    memcpy(buffer, fake::findNamespace(ns.c_str())->find(key)->second.data.data(), length);
+    return length;
+}
@@ -0,0 +1,439 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+// Two OTA app slots and a bootloader with rollback. Update writes the slot
+// not running, sector by sector with the flash timing of FakeFlash.cpp;
+// reset(true) boots whatever the bootloader would.
+
+UpdateClass Update;
+
+namespace fake {
+namespace {
+
+const size_t SECTOR_SIZE = 4096;
+const size_t SLOT_SIZE = 0x140000;  // default.csv
+const uint32_t WRITE_CALL_US = 50;
+const uint32_t WRITE_BYTE_NS = 1500;
+const uint32_t SECTOR_ERASE_MS = 45;
+const uint8_t IMAGE_MAGIC = 0xE9;
+const size_t HASH_APPENDED_OFFSET = 23;  // In esp_image_header_t
+
+std::mutex firmware_mutex;
+esp_partition_t slots[2] = {
+    { ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000, SLOT_SIZE, SECTOR_SIZE, "app0", false, false },
+    { ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x150000, SLOT_SIZE, SECTOR_SIZE, "app1", false, false },
+};
+std::string images[2];
+esp_ota_img_states_t states[2];
+int running = 0;
+int boot = 0;  // Slot the bootloader starts next
+FirmwareStats firmware_stats;
+uint32_t busy_us = 0;
+
+void spend(uint32_t us) {
+    uint32_t ms;
+    {
+        std::lock_guard<std::mutex> guard(firmware_mutex);
+        busy_us += us;
+        ms = busy_us / 1000;
+        busy_us %= 1000;
+    }
+    if (ms > 0) {
+        advance(ms);
+    }
+}
+
+std::string digest(const std::string& data) {
+    mbedtls_sha256_context sha;
+    unsigned char out[32];
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, (const unsigned char*)data.data(), data.size());
+    mbedtls_sha256_finish(&sha, out);
+    mbedtls_sha256_free(&sha);
+    return std::string((const char*)out, sizeof(out));
+}
+
+// What esp_ota_set_boot_partition() checks before it accepts an image
+bool validImage(const std::string& image) {
+    HeapPause pause;
+    if (image.size() < 32 + HASH_APPENDED_OFFSET + 1 || (uint8_t)image[0] != IMAGE_MAGIC) {
+        return false;
+    }
+    if (image[HASH_APPENDED_OFFSET] != 1) {
+        return true;
+    }
+    size_t body = image.size() - 32;
+    return digest(image.substr(0, body)) == image.substr(body);
+}
+
+} // namespace
+
+namespace detail {
+
+void resetFirmware(bool reboot) {
+    {
+        HeapPause pause;
+        Update.abort();
+    }
+    std::lock_guard<std::mutex> guard(firmware_mutex);
+    busy_us = 0;
+    if (!reboot) {
+        HeapPause pause;
+        images[0].clear();
+        images[1].clear();
+        states[0] = ESP_OTA_IMG_VALID;
+        states[1] = ESP_OTA_IMG_UNDEFINED;
+        running = 0;
+        boot = 0;
+        memset(&firmware_stats, 0, sizeof(firmware_stats));
+        return;
+    }
+
+    // A first boot that never confirmed its image: back to the previous one
+    if (states[running] == ESP_OTA_IMG_PENDING_VERIFY) {
+        states[running] = ESP_OTA_IMG_ABORTED;
+        boot = 1 - running;
+    }
+    if (boot != running) {
+        if (states[running] == ESP_OTA_IMG_ABORTED || states[running] == ESP_OTA_IMG_INVALID) {
+            firmware_stats.rollbacks++;
+        }
+        running = boot;
+        if (states[running] == ESP_OTA_IMG_NEW) {
+            states[running] = ESP_OTA_IMG_PENDING_VERIFY;
+        }
+    }
+}
+
+} // namespace detail
+
+FirmwareStats firmwareStats() {
+    std::lock_guard<std::mutex> guard(firmware_mutex);
+    return firmware_stats;
+}
+
+std::string firmwareImage() {
+    std::lock_guard<std::mutex> guard(firmware_mutex);
+    HeapPause pause;
+    return images[1 - running];
+}
+
+int runningFirmwareSlot() {
+    std::lock_guard<std::mutex> guard(firmware_mutex);
+    return running;
+}
+
+int firmwareState() {
+    std::lock_guard<std::mutex> guard(firmware_mutex);
+    return states[running];
+}
+
+std::string makeFirmwareImage(size_t size, uint32_t seed) {
+    HeapPause pause;
+    std::string image(size - 32, '\0');
+    uint32_t x = seed * 2654435761u + 1;
+    for (size_t i = 0; i < image.size(); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        // Code compresses a little; every fourth byte repeats
+        image[i] = (char)(i % 4 == 3 ? image[i - 1] : x);
+    }
+    image[0] = (char)IMAGE_MAGIC;
+    image[HASH_APPENDED_OFFSET] = 1;
+    return image + digest(image);
+}
+
+std::string sha256Hex(const std::string& data) {
+    HeapPause pause;
+    std::string raw = digest(data);
+    std::string hex;
+    char pair[3];
+    for (size_t i = 0; i < raw.size(); i++) {
+        snprintf(pair, sizeof(pair), "%02x", (uint8_t)raw[i]);
+        hex += pair;
+    }
+    return hex;
+}
+
+} // namespace fake
+
+// ---- Update ----
+
+static const char* const UPDATE_ERRORS[] = {
+    "No Error", "Flash Write Failed", "Flash Erase Failed", "Flash Read Failed", "Not Enough Space",
+    "Bad Size Given", "Stream Read Timeout", "MD5 Check Failed", "Wrong Magic Byte", "Could Not Activate The Firmware",
+    "Partition Could Not be Found", "Bad Argument", "Aborted",
+};
+
+UpdateClass::UpdateClass() : _buffer(nullptr), _bufferLen(0), _size(0), _progress(0), _error(UPDATE_ERROR_OK) {
+}
+
+void UpdateClass::_reset() {
+    free(_buffer);
+    _buffer = nullptr;
+    _bufferLen = 0;
+    _size = 0;
+    _progress = 0;
+}
+
+bool UpdateClass::begin(size_t size, int command, int ledPin, uint8_t ledOn, const char* label) {
+    (void)ledPin;
+    (void)ledOn;
+    (void)label;
+    if (_size > 0) {
+        return false;  // Already running
+    }
+    _reset();
+    _error = UPDATE_ERROR_OK;
+    if (command != U_FLASH || size == 0) {
+        _error = UPDATE_ERROR_BAD_ARGUMENT;
+        return false;
+    }
+    if (size != UPDATE_SIZE_UNKNOWN && size > fake::SLOT_SIZE) {
+        _error = UPDATE_ERROR_SIZE;
+        return false;
+    }
+    _buffer = (uint8_t*)malloc(fake::SECTOR_SIZE);
+    if (!_buffer) {
+        _error = UPDATE_ERROR_SPACE;  // The library reports out of memory as this too
+        return false;
+    }
+    _size = size == UPDATE_SIZE_UNKNOWN ? fake::SLOT_SIZE : size;
+    std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+    fake::HeapPause pause;
+    int target = 1 - fake::running;
+    fake::images[target].clear();
+    fake::states[target] = ESP_OTA_IMG_UNDEFINED;
+    return true;
+}
+
+// Erases the next sector and writes the buffer into it
+bool UpdateClass::_writeBuffer() {
+    if (_progress == 0 && _buffer[0] != fake::IMAGE_MAGIC) {
+        _error = UPDATE_ERROR_MAGIC_BYTE;
+        _reset();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+        fake::HeapPause pause;
+        fake::images[1 - fake::running].append((const char*)_buffer, _bufferLen);
+        fake::firmware_stats.sectors++;
+        fake::firmware_stats.bytes_written += _bufferLen;
+    }
+    fake::spend(fake::SECTOR_ERASE_MS * 1000 + fake::WRITE_CALL_US + (uint32_t)(_bufferLen * fake::WRITE_BYTE_NS / 1000));
+    _progress += _bufferLen;
+    _bufferLen = 0;
+    return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t len) {
+    if (hasError() || !isRunning()) {
+        return 0;
+    }
+    if (len > remaining()) {
+        _error = UPDATE_ERROR_SPACE;
+        _reset();
+        return 0;
+    }
+    size_t left = len;
+    while (_bufferLen + left > fake::SECTOR_SIZE) {
+        size_t fill = fake::SECTOR_SIZE - _bufferLen;
+        memcpy(_buffer + _bufferLen, data + (len - left), fill);
+        _bufferLen += fill;
+        if (!_writeBuffer()) {
+            return len - left;
+        }
+        left -= fill;
+    }
+    memcpy(_buffer + _bufferLen, data + (len - left), left);
+    _bufferLen += left;
+    if (_bufferLen == remaining() && !_writeBuffer()) {
+        return 0;
+    }
+    return len;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+    if (hasError() || _size == 0) {
+        return false;
+    }
+    if (!isFinished() && !evenIfRemaining) {
+        _error = UPDATE_ERROR_ABORT;
+        _reset();
+        return false;
+    }
+    if (evenIfRemaining) {
+        if (_bufferLen > 0 && !_writeBuffer()) {
+            return false;
+        }
+        _size = _progress;
+    }
+    std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+    int target = 1 - fake::running;
+    if (!fake::validImage(fake::images[target])) {
+        _error = UPDATE_ERROR_ACTIVATE;
+        _reset();
+        return false;
+    }
+    fake::states[target] = ESP_OTA_IMG_NEW;
+    fake::boot = target;
+    fake::firmware_stats.updates++;
+    _reset();
+    return true;
+}
+
+void UpdateClass::abort() {
+    if (_size > 0) {
+        _error = UPDATE_ERROR_ABORT;
+    }
+    _reset();
+}
+
+const char* UpdateClass::errorString() {
+    return _error < sizeof(UPDATE_ERRORS) / sizeof(UPDATE_ERRORS[0]) ? UPDATE_ERRORS[_error] : "Unknown Error";
+}
+
+// ---- esp_ota_ops ----
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+    return &fake::slots[fake::running];
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t* partition, esp_ota_img_states_t* ota_state) {
+    std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+    for (int i = 0; i < 2; i++) {
+        if (partition == &fake::slots[i]) {
+            if (fake::states[i] == ESP_OTA_IMG_UNDEFINED) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            *ota_state = fake::states[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback(void) {
+    std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+    fake::states[fake::running] = ESP_OTA_IMG_VALID;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_invalid_rollback_and_reboot(void) {
+    {
+        std::lock_guard<std::mutex> guard(fake::firmware_mutex);
+        int previous = 1 - fake::running;
+        if (fake::states[previous] != ESP_OTA_IMG_VALID) {
+            return ESP_FAIL;  // Nothing to go back to
+        }
+        fake::states[fake::running] = ESP_OTA_IMG_INVALID;
+        fake::boot = previous;
+    }
+    throw fake::Restart();
+}
+
+// ---- mbedtls SHA-256 ----
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256Block(mbedtls_sha256_context* ctx, const unsigned char* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | (block[i * 4 + 1] << 16) | (block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t v[8];
+    memcpy(v, ctx->state, sizeof(v));
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+        uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        uint32_t t1 = v[7] + s1 + ch + SHA256_K[i] + w[i];
+        uint32_t s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+        uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+        memmove(v + 1, v, 7 * sizeof(uint32_t));
+        v[4] += t1;
+        v[0] = t1 + s0 + maj;
+    }
+    for (int i = 0; i < 8; i++) {
+        ctx->state[i] += v[i];
+    }
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224) {
+    static const uint32_t initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    memset(ctx, 0, sizeof(*ctx));
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->is224 = is224;
+    return is224 ? -1 : 0;  // SHA-224 is not modeled
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen) {
+    size_t used = ctx->total[0] & 63;
+    uint64_t total = ((uint64_t)ctx->total[1] << 32 | ctx->total[0]) + ilen;
+    ctx->total[0] = (uint32_t)total;
+    ctx->total[1] = (uint32_t)(total >> 32);
+    while (ilen > 0) {
+        size_t take = 64 - used < ilen ? 64 - used : ilen;
+        memcpy(ctx->buffer + used, input, take);
+        used += take;
+        input += take;
+        ilen -= take;
+        if (used == 64) {
+            sha256Block(ctx, ctx->buffer);
+            used = 0;
+        }
+    }
+    return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]) {
+    uint64_t bits = ((uint64_t)ctx->total[1] << 32 | ctx->total[0]) * 8;
+    size_t used = ctx->total[0] & 63;
+    unsigned char pad[128] = { 0x80 };
+    size_t pad_length = used < 56 ? 56 - used : 120 - used;
+    for (int i = 0; i < 8; i++) {
+        pad[pad_length + i] = (unsigned char)(bits >> (56 - 8 * i));
+    }
+    mbedtls_sha256_update(ctx, pad, pad_length + 8);
+    for (int i = 0; i < 8; i++) {
+        output[i * 4] = (unsigned char)(ctx->state[i] >> 24);
+        output[i * 4 + 1] = (unsigned char)(ctx->state[i] >> 16);
+        output[i * 4 + 2] = (unsigned char)(ctx->state[i] >> 8);
+        output[i * 4 + 3] = (unsigned char)ctx->state[i];
+    }
+    return 0;
+}
@@ -0,0 +1,703 @@
+#include "FakeKernel.h"
+#include "FakeDevice.h"
+#include <WiFi.h>
+#include <list>
+#include <vector>
+
+// Scripted radio. A connect attempt takes the network's connect_ms, split
+// into channel scan, association and DHCP; a channel/BSSID hint skips most
+// of the scan and a static IP skips DHCP, as the RTC fast path does on the
+// device. Events are posted to the clock and delivered on the test thread.
+
+WiFiClass WiFi;
+
+// Share of Network::connect_ms spent in each connect phase
+static const uint32_t SCAN_SHARE = 40;
+static const uint32_t ASSOC_SHARE = 30;
+static const uint32_t HINTED_SCAN_SHARE = 5;
+
+// Time to give up on an SSID that is not in range
+static const uint32_t NO_AP_FOUND_MS = 3000;
+static const uint32_t NO_AP_FOUND_HINTED_MS = 300;
+
+namespace fake {
+namespace {
+
+enum class Station { IDLE, CONNECTING, CONNECTED };
+
+struct Callback {
+    wifi_event_id_t id;
+    WiFiEventFuncCb callback;
+    arduino_event_id_t event;
+};
+
+struct Radio {
+    std::list<Network> networks;
+    wifi_mode_t mode;
+    bool auto_reconnect;
+
+    Station station;
+    uint64_t attempt;        // Bumped on every begin/disconnect, cancels stale events
+    std::string target_ssid;
+    std::string sta_ssid;
+    uint8_t bssid[6];
+    int32_t channel;
+    int32_t rssi;
+    bool static_ip;
+    IPAddress ip, gateway, subnet, dns1, dns2;
+    IPAddress static_ip_address, static_gateway, static_subnet, static_dns1, static_dns2;
+
+    bool ap_active;
+    std::string ap_ssid;
+    wifi_ps_type_t sleep;
+
+    bool scan_running;
+    bool scan_done;
+    uint64_t scan_generation;
+    uint32_t scan_duration;
+    std::vector<Network> scan_results;
+
+    std::vector<Callback> callbacks;
+    wifi_event_id_t next_callback_id;
+
+    uint32_t scan_count;
+    uint32_t connect_attempts;
+    uint8_t last_channel_hint;
+
+    Radio() : mode(WIFI_OFF), auto_reconnect(true), station(Station::IDLE), attempt(0), channel(0), rssi(0),
+              static_ip(false), ap_active(false), sleep(WIFI_PS_MIN_MODEM), scan_running(false), scan_done(false), scan_generation(0),
+              scan_duration(2000), next_callback_id(1), scan_count(0), connect_attempts(0), last_channel_hint(0) {
+        memset(bssid, 0, sizeof(bssid));
+    }
+};
+
+std::recursive_mutex radio_mutex;
+Radio radio;
+
+typedef std::lock_guard<std::recursive_mutex> RadioLock;
+
+Network* findNetwork(const std::string& ssid) {
+    for (std::list<Network>::iterator it = radio.networks.begin(); it != radio.networks.end(); ++it) {
+        if (it->ssid == ssid) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+void dispatch(arduino_event_id_t event, arduino_event_info_t info) {
+    std::vector<Callback> callbacks;
+    {
+        RadioLock lock(radio_mutex);
+        HeapPause pause;
+        callbacks = radio.callbacks;
+    }
+    for (size_t i = 0; i < callbacks.size(); i++) {
+        if (callbacks[i].event == ARDUINO_EVENT_MAX || callbacks[i].event == event) {
+            callbacks[i].callback(event, info);
+        }
+    }
+    HeapPause pause;
+    callbacks.clear();
+}
+
+void post(uint64_t at, arduino_event_id_t event, const arduino_event_info_t& info) {
+    detail::schedule(at, [event, info]() { dispatch(event, info); });
+}
+
+arduino_event_info_t disconnectInfo(const std::string& ssid, uint8_t reason) {
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_sta_disconnected.ssid_len = min(ssid.size(), sizeof(info.wifi_sta_disconnected.ssid));
+    memcpy(info.wifi_sta_disconnected.ssid, ssid.data(), info.wifi_sta_disconnected.ssid_len);
+    info.wifi_sta_disconnected.reason = reason;
+    return info;
+}
+
+// Station leaves the current or pending link, radio lock held
+void leaveStation(uint8_t reason) {
+    if (radio.station == Station::IDLE) {
+        return;
+    }
+    bool had_ip = radio.station == Station::CONNECTED;
+    radio.station = Station::IDLE;
+    radio.attempt++;
+    radio.ip = IPAddress();
+    HeapPause pause;
+    post(now(), ARDUINO_EVENT_WIFI_STA_DISCONNECTED, disconnectInfo(radio.target_ssid, reason));
+    if (had_ip) {
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        post(now(), ARDUINO_EVENT_WIFI_STA_LOST_IP, info);
+    }
+    radio.sta_ssid.clear();
+}
+
+void failAttempt(uint64_t attempt, uint8_t reason) {
+    RadioLock lock(radio_mutex);
+    if (radio.attempt != attempt || radio.station != Station::CONNECTING) {
+        return;
+    }
+    radio.station = Station::IDLE;
+    HeapPause pause;
+    post(now(), ARDUINO_EVENT_WIFI_STA_DISCONNECTED, disconnectInfo(radio.target_ssid, reason));
+}
+
+void associate(uint64_t attempt) {
+    RadioLock lock(radio_mutex);
+    if (radio.attempt != attempt || radio.station != Station::CONNECTING) {
+        return;
+    }
+    Network* network = findNetwork(radio.target_ssid);
+    if (!network) {
+        failAttempt(attempt, WIFI_REASON_NO_AP_FOUND);
+        return;
+    }
+    HeapPause pause;
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_sta_connected.ssid_len = min(network->ssid.size(), sizeof(info.wifi_sta_connected.ssid));
+    memcpy(info.wifi_sta_connected.ssid, network->ssid.data(), info.wifi_sta_connected.ssid_len);
+    memcpy(info.wifi_sta_connected.bssid, network->bssid, 6);
+    info.wifi_sta_connected.channel = network->channel;
+    post(now(), ARDUINO_EVENT_WIFI_STA_CONNECTED, info);
+}
+
+void gotIp(uint64_t attempt) {
+    RadioLock lock(radio_mutex);
+    if (radio.attempt != attempt || radio.station != Station::CONNECTING) {
+        return;
+    }
+    Network* network = findNetwork(radio.target_ssid);
+    if (!network) {
+        failAttempt(attempt, WIFI_REASON_NO_AP_FOUND);
+        return;
+    }
+    radio.station = Station::CONNECTED;
+    {
+        HeapPause pause;
+        radio.sta_ssid = network->ssid;
+    }
+    memcpy(radio.bssid, network->bssid, 6);
+    radio.channel = network->channel;
+    radio.rssi = network->rssi;
+    if (radio.static_ip) {
+        radio.ip = radio.static_ip_address;
+        radio.gateway = radio.static_gateway;
+        radio.subnet = radio.static_subnet;
+        radio.dns1 = radio.static_dns1;
+        radio.dns2 = radio.static_dns2;
+    } else {
+        radio.ip = IPAddress(192, 168, 1, 100 + network->channel);
+        radio.gateway = IPAddress(192, 168, 1, 1);
+        radio.subnet = IPAddress(255, 255, 255, 0);
+        radio.dns1 = IPAddress(192, 168, 1, 1);
+        radio.dns2 = IPAddress(8, 8, 8, 8);
+    }
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.got_ip.ip_info.ip = radio.ip;
+    info.got_ip.ip_info.gw = radio.gateway;
+    info.got_ip.ip_info.netmask = radio.subnet;
+    HeapPause pause;
+    post(now(), ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+}
+
+void finishScan(uint64_t generation) {
+    RadioLock lock(radio_mutex);
+    if (!radio.scan_running || radio.scan_generation != generation) {
+        return;
+    }
+    HeapPause pause;
+    radio.scan_results.clear();
+    for (std::list<Network>::iterator it = radio.networks.begin(); it != radio.networks.end(); ++it) {
+        if (!it->hidden) {
+            radio.scan_results.push_back(*it);
+        }
+    }
+    radio.scan_running = false;
+    radio.scan_done = true;
+    arduino_event_info_t info;
+    memset(&info, 0, sizeof(info));
+    info.wifi_scan_done.number = radio.scan_results.size();
+    post(now(), ARDUINO_EVENT_WIFI_SCAN_DONE, info);
+}
+
+const Network* scanEntry(uint8_t index) {
+    return radio.scan_done && index < radio.scan_results.size() ? &radio.scan_results[index] : nullptr;
+}
+
+} // namespace
+
+namespace detail {
+
+void resetWiFi() {
+    RadioLock lock(radio_mutex);
+    HeapPause pause;
+    radio.networks.clear();
+    radio.mode = WIFI_OFF;
+    radio.auto_reconnect = true;
+    radio.station = Station::IDLE;
+    radio.attempt++;
+    radio.target_ssid.clear();
+    radio.sta_ssid.clear();
+    memset(radio.bssid, 0, sizeof(radio.bssid));
+    radio.channel = 0;
+    radio.rssi = 0;
+    radio.static_ip = false;
+    radio.ip = radio.gateway = radio.subnet = radio.dns1 = radio.dns2 = IPAddress();
+    radio.ap_active = false;
+    radio.ap_ssid.clear();
+    radio.sleep = WIFI_PS_MIN_MODEM;
+    radio.scan_running = false;
+    radio.scan_done = false;
+    radio.scan_generation++;
+    radio.scan_duration = 2000;
+    radio.scan_results.clear();
+    radio.callbacks.clear();
+    radio.next_callback_id = 1;
+    radio.scan_count = 0;
+    radio.connect_attempts = 0;
+    radio.last_channel_hint = 0;
+}
+
+} // namespace detail
+
+Network& addNetwork(const char* ssid, const char* password, int32_t rssi, uint8_t channel) {
+    RadioLock lock(radio_mutex);
+    HeapPause pause;
+    Network* network = findNetwork(ssid);
+    if (!network) {
+        radio.networks.push_back(Network());
+        network = &radio.networks.back();
+    }
+    network->ssid = ssid;
+    network->password = password ? password : "";
+    network->rssi = rssi;
+    network->channel = channel;
+    uint8_t bssid[6] = { 0x24, 0x0a, 0xc4, 0x00, (uint8_t)radio.networks.size(), channel };
+    memcpy(network->bssid, bssid, sizeof(bssid));
+    network->connect_ms = 2500;
+    network->responsive = true;
+    network->hidden = false;
+    return *network;
+}
+
+void removeNetwork(const char* ssid) {
+    RadioLock lock(radio_mutex);
+    HeapPause pause;
+    for (std::list<Network>::iterator it = radio.networks.begin(); it != radio.networks.end(); ++it) {
+        if (it->ssid == ssid) {
+            radio.networks.erase(it);
+            break;
+        }
+    }
+    if (radio.station == Station::CONNECTED && radio.sta_ssid == ssid) {
+        leaveStation(WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
+
+void dropConnection(uint8_t reason) {
+    RadioLock lock(radio_mutex);
+    if (radio.station == Station::CONNECTED) {
+        leaveStation(reason);
+    }
+}
+
+void setScanDuration(uint32_t ms) {
+    RadioLock lock(radio_mutex);
+    radio.scan_duration = ms;
+}
+
+bool staConnected() {
+    RadioLock lock(radio_mutex);
+    return radio.station == Station::CONNECTED;
+}
+
+std::string staSsid() {
+    RadioLock lock(radio_mutex);
+    return radio.sta_ssid;
+}
+
+bool apActive() {
+    RadioLock lock(radio_mutex);
+    return radio.ap_active;
+}
+
+std::string apSsid() {
+    RadioLock lock(radio_mutex);
+    return radio.ap_active ? radio.ap_ssid : std::string();
+}
+
+int wifiMode() {
+    RadioLock lock(radio_mutex);
+    return radio.mode;
+}
+
+uint32_t scanCount() {
+    RadioLock lock(radio_mutex);
+    return radio.scan_count;
+}
+
+uint32_t connectAttempts() {
+    RadioLock lock(radio_mutex);
+    return radio.connect_attempts;
+}
+
+uint8_t lastConnectChannel() {
+    RadioLock lock(radio_mutex);
+    return radio.last_channel_hint;
+}
+
+} // namespace fake
+
+using fake::radio;
+using fake::radio_mutex;
+using fake::RadioLock;
+using fake::Station;
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    RadioLock lock(radio_mutex);
+    if (!(mode & WIFI_STA)) {
+        fake::leaveStation(WIFI_REASON_ASSOC_LEAVE);
+        radio.scan_running = false;
+    }
+    if (!(mode & WIFI_AP) && radio.ap_active) {
+        radio.ap_active = false;
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        fake::HeapPause pause;
+        fake::post(fake::now(), ARDUINO_EVENT_WIFI_AP_STOP, info);
+    }
+    radio.mode = mode;
+    return true;
+}
+
+wifi_mode_t WiFiClass::getMode() {
+    RadioLock lock(radio_mutex);
+    return radio.mode;
+}
+
+bool WiFiClass::enableSTA(bool enable) {
+    RadioLock lock(radio_mutex);
+    return mode((wifi_mode_t)(enable ? radio.mode | WIFI_STA : radio.mode & ~WIFI_STA));
+}
+
+bool WiFiClass::enableAP(bool enable) {
+    RadioLock lock(radio_mutex);
+    return mode((wifi_mode_t)(enable ? radio.mode | WIFI_AP : radio.mode & ~WIFI_AP));
+}
+
+wl_status_t WiFiClass::status() {
+    RadioLock lock(radio_mutex);
+    switch (radio.station) {
+        case Station::CONNECTED:  return WL_CONNECTED;
+        case Station::CONNECTING: return WL_IDLE_STATUS;
+        case Station::IDLE:       break;
+    }
+    return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid, bool connect) {
+    RadioLock lock(radio_mutex);
+    if (!ssid || !*ssid || strlen(ssid) > 32) {
+        return WL_CONNECT_FAILED;
+    }
+    enableSTA(true);
+    fake::leaveStation(WIFI_REASON_ASSOC_LEAVE);
+    if (!connect) {
+        return WL_DISCONNECTED;
+    }
+
+    radio.connect_attempts++;
+    radio.last_channel_hint = channel > 0 ? channel : 0;
+    radio.station = Station::CONNECTING;
+    uint64_t attempt = ++radio.attempt;
+    {
+        fake::HeapPause pause;
+        radio.target_ssid = ssid;
+    }
+
+    bool hinted = channel > 0;
+    uint64_t now = fake::now();
+    const fake::Network* network = fake::findNetwork(ssid);
+    bool reachable = network && (!hinted || (network->channel == channel &&
+                                             (!bssid || memcmp(bssid, network->bssid, 6) == 0)));
+    fake::HeapPause pause;
+    if (!reachable) {
+        uint32_t give_up = hinted ? NO_AP_FOUND_HINTED_MS : NO_AP_FOUND_MS;
+        fake::detail::schedule(now + give_up, [attempt]() { fake::failAttempt(attempt, WIFI_REASON_NO_AP_FOUND); });
+        return WL_DISCONNECTED;
+    }
+    if (!network->responsive) {
+        return WL_DISCONNECTED;
+    }
+
+    uint32_t total = network->connect_ms;
+    uint32_t scan = total * (hinted ? HINTED_SCAN_SHARE : SCAN_SHARE) / 100;
+    uint32_t assoc = total * ASSOC_SHARE / 100;
+    uint32_t dhcp = radio.static_ip ? 1 : total - total * SCAN_SHARE / 100 - assoc;
+
+    if (network->password != (passphrase ? passphrase : "")) {
+        fake::detail::schedule(now + scan + assoc, [attempt]() {
+            fake::failAttempt(attempt, WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT);
+        });
+        return WL_DISCONNECTED;
+    }
+    fake::detail::schedule(now + scan + assoc, [attempt]() { fake::associate(attempt); });
+    fake::detail::schedule(now + scan + assoc + dhcp, [attempt]() { fake::gotIp(attempt); });
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2) {
+    RadioLock lock(radio_mutex);
+    radio.static_ip = (uint32_t)local != 0;
+    radio.static_ip_address = local;
+    radio.static_gateway = gateway;
+    radio.static_subnet = subnet;
+    radio.static_dns1 = dns1;
+    radio.static_dns2 = dns2;
+    return true;
+}
+
+bool WiFiClass::disconnect(bool wifioff, bool eraseap) {
+    (void)eraseap;
+    RadioLock lock(radio_mutex);
+    fake::leaveStation(WIFI_REASON_ASSOC_LEAVE);
+    if (wifioff) {
+        enableSTA(false);
+    }
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    RadioLock lock(radio_mutex);
+    std::string ssid;
+    {
+        fake::HeapPause pause;
+        ssid = radio.target_ssid;
+    }
+    const fake::Network* network = fake::findNetwork(ssid);
+    begin(ssid.c_str(), network ? network->password.c_str() : "");
+    return true;
+}
+
+bool WiFiClass::isConnected() {
+    return status() == WL_CONNECTED;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+    RadioLock lock(radio_mutex);
+    radio.auto_reconnect = autoReconnect;
+    return true;
+}
+
+bool WiFiClass::getAutoReconnect() {
+    RadioLock lock(radio_mutex);
+    return radio.auto_reconnect;
+}
+
+bool WiFiClass::persistent(bool persistent) {
+    (void)persistent;
+    return true;
+}
+
+bool WiFiClass::setSleep(bool enabled) {
+    return setSleep(enabled ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+}
+
+bool WiFiClass::setSleep(wifi_ps_type_t sleepType) {
+    RadioLock lock(radio_mutex);
+    radio.sleep = sleepType;
+    return true;
+}
+
+wifi_ps_type_t WiFiClass::getSleep() {
+    RadioLock lock(radio_mutex);
+    return radio.sleep;
+}
+
+bool WiFiClass::setHostname(const char* hostname) {
+    (void)hostname;
+    return true;
+}
+
+String WiFiClass::SSID() const {
+    RadioLock lock(radio_mutex);
+    return String(radio.station == Station::CONNECTED ? radio.sta_ssid.c_str() : "");
+}
+
+int8_t WiFiClass::RSSI() {
+    RadioLock lock(radio_mutex);
+    return radio.station == Station::CONNECTED ? radio.rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    RadioLock lock(radio_mutex);
+    return radio.station == Station::CONNECTED ? radio.bssid : nullptr;
+}
+
+int32_t WiFiClass::channel() {
+    RadioLock lock(radio_mutex);
+    return radio.channel;
+}
+
+IPAddress WiFiClass::localIP() {
+    RadioLock lock(radio_mutex);
+    return radio.station == Station::CONNECTED ? radio.ip : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    RadioLock lock(radio_mutex);
+    return radio.gateway;
+}
+
+IPAddress WiFiClass::subnetMask() {
+    RadioLock lock(radio_mutex);
+    return radio.subnet;
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index) {
+    RadioLock lock(radio_mutex);
+    return index == 0 ? radio.dns1 : radio.dns2;
+}
+
+String WiFiClass::macAddress() {
+    return String("24:0A:C4:12:34:56");
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* passphrase, int channel, int hidden, int maxConnection) {
+    (void)passphrase;
+    (void)channel;
+    (void)hidden;
+    (void)maxConnection;
+    RadioLock lock(radio_mutex);
+    if (!ssid || !*ssid) {
+        return false;
+    }
+    enableAP(true);
+    bool started = !radio.ap_active;
+    radio.ap_active = true;
+    fake::HeapPause pause;
+    radio.ap_ssid = ssid;
+    if (started) {
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        fake::post(fake::now(), ARDUINO_EVENT_WIFI_AP_START, info);
+    }
+    return true;
+}
+
+bool WiFiClass::softAPdisconnect(bool wifioff) {
+    RadioLock lock(radio_mutex);
+    if (wifioff) {
+        enableAP(false);
+    } else if (radio.ap_active) {
+        radio.ap_active = false;
+        arduino_event_info_t info;
+        memset(&info, 0, sizeof(info));
+        fake::HeapPause pause;
+        fake::post(fake::now(), ARDUINO_EVENT_WIFI_AP_STOP, info);
+    }
+    return true;
+}
+
+IPAddress WiFiClass::softAPIP() {
+    RadioLock lock(radio_mutex);
+    return radio.ap_active ? IPAddress(192, 168, 4, 1) : IPAddress();
+}
+
+uint8_t WiFiClass::softAPgetStationNum() {
+    return 0;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden, bool passive, uint32_t maxMsPerChannel, uint8_t channel) {
+    (void)showHidden;
+    (void)passive;
+    (void)maxMsPerChannel;
+    (void)channel;
+    uint32_t duration;
+    {
+        RadioLock lock(radio_mutex);
+        if (radio.scan_running) {
+            return WIFI_SCAN_RUNNING;
+        }
+        enableSTA(true);
+        radio.scan_count++;
+        radio.scan_running = true;
+        radio.scan_done = false;
+        uint64_t generation = ++radio.scan_generation;
+        duration = radio.scan_duration;
+        fake::HeapPause pause;
+        fake::detail::schedule(fake::now() + duration, [generation]() { fake::finishScan(generation); });
+    }
+    if (async) {
+        return WIFI_SCAN_RUNNING;
+    }
+    delay(duration + 1);
+    return scanComplete();
+}
+
+int16_t WiFiClass::scanComplete() {
+    RadioLock lock(radio_mutex);
+    if (radio.scan_running) {
+        return WIFI_SCAN_RUNNING;
+    }
+    return radio.scan_done ? (int16_t)radio.scan_results.size() : WIFI_SCAN_FAILED;
+}
+
+void WiFiClass::scanDelete() {
+    RadioLock lock(radio_mutex);
+    fake::HeapPause pause;
+    radio.scan_results.clear();
+    radio.scan_done = false;
+}
+
+String WiFiClass::SSID(uint8_t index) const {
+    RadioLock lock(radio_mutex);
+    const fake::Network* entry = fake::scanEntry(index);
+    return String(entry ? entry->ssid.c_str() : "");
+}
+
+int32_t WiFiClass::RSSI(uint8_t index) {
+    RadioLock lock(radio_mutex);
+    const fake::Network* entry = fake::scanEntry(index);
+    return entry ? entry->rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID(uint8_t index) {
+    RadioLock lock(radio_mutex);
+    fake::Network* entry = const_cast<fake::Network*>(fake::scanEntry(index));
+    return entry ? entry->bssid : nullptr;
+}
+
+int32_t WiFiClass::channel(uint8_t index) {
+    RadioLock lock(radio_mutex);
+    const fake::Network* entry = fake::scanEntry(index);
+    return entry ? entry->channel : 0;
+}
+
+wifi_auth_mode_t WiFiClass::encryptionType(uint8_t index) {
+    RadioLock lock(radio_mutex);
+    const fake::Network* entry = fake::scanEntry(index);
+    return entry && !entry->password.empty() ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventFuncCb callback, arduino_event_id_t event) {
+    RadioLock lock(radio_mutex);
+    fake::HeapPause pause;
+    fake::Callback entry = { radio.next_callback_id++, callback, event };
+    radio.callbacks.push_back(entry);
+    return entry.id;
+}
+
+void WiFiClass::removeEvent(wifi_event_id_t id) {
+    RadioLock lock(radio_mutex);
+    fake::HeapPause pause;
+    for (size_t i = 0; i < radio.callbacks.size(); i++) {
+        if (radio.callbacks[i].id == id) {
+            radio.callbacks.erase(radio.callbacks.begin() + i);
+            return;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef PORTAL_FIXTURE_H
+#define PORTAL_FIXTURE_H
+
+// One ESP32ConfigPortal on the simulated device, shared by the suites that
+// run the whole portal. Include it once, from the suite's test_main.cpp;
+// servers standing in for remote hosts stay with their suite.
+
+#include <unity.h>
+#include <functional>
+#include "FakeDevice.h"
+#include "ESP32ConfigPortal.h"
+
+static const char* NS = "test_portal";
+static ESP32ConfigPortal* portal = nullptr;
+
+inline ESP32ConfigPortal* newPortal() {
+    portal = new ESP32ConfigPortal(0, "Test-Config", NS);
+    return portal;
+}
+
+// Fresh device: empty NVS, no networks, no tasks. For setUp().
+inline void resetDevice() {
+    fake::reset();
+    ESP32ConfigPortal::invalidateFastConnect();
+}
+
+// Deletes the portal (its module workers with it), then the remaining
+// tasks. For tearDown().
+inline void stopDevice() {
+    Log::end();
+    delete portal;
+    portal = nullptr;
+    fake::stopTasks();
+}
+
+// Power cycle: same NVS, flash and OTA slots, fresh RAM
+inline void reboot() {
+    stopDevice();
+    fake::reset(true);
+    ESP32ConfigPortal::invalidateFastConnect();
+}
+
+inline uint32_t counter(MetricCounter id) {
+    MetricsSnapshot snapshot;
+    Metrics::capture(snapshot);
+    return snapshot.counters[(size_t)id];
+}
+
+// Runs the application loop for ms of virtual time
+inline void loopFor(uint32_t ms) {
+    uint64_t end = fake::now() + ms;
+    while (fake::now() < end) {
+        portal->handle();
+        fake::advance(10);
+    }
+}
+
+// Runs the application loop until done(), false after timeoutMs
+inline bool loopUntil(std::function<bool()> done, uint32_t timeoutMs) {
+    uint64_t end = fake::now() + timeoutMs;
+    while (!done()) {
+        if (fake::now() >= end) {
+            return false;
+        }
+        portal->handle();
+        fake::advance(1);
+    }
+    return true;
+}
+
+// Device whose saved config adds the "home" network to config. In range it
+// boots connected; out of range begin() runs ASYNC and keeps trying.
+// addModules registers integrations before begin().
+inline void startDevice(ConfigData config, bool inRange = true, std::function<void()> addModules = nullptr) {
+    if (inRange) {
+        fake::addNetwork("home", "password1");
+    }
+    config.addWiFiProfile("home", "password1");
+    ConfigStore(NS).save(config, true);
+
+    newPortal();
+    if (addModules) {
+        addModules();
+    }
+    if (inRange) {
+        TEST_ASSERT_TRUE(portal->begin());
+        loopFor(50);
+    } else {
+        portal->begin(PortalMode::ASYNC);
+    }
+}
+
+#endif // PORTAL_FIXTURE_H
@@ -0,0 +1,53 @@
+#ifndef FAKE_PREFERENCES_H
+#define FAKE_PREFERENCES_H
+
+// Host stand-in for the ESP32 Preferences (NVS) library, backed by an
+// in-memory store that outlives Preferences objects like flash does
+
+#include <Arduino.h>
+
+class Preferences {
+    String ns;
+    bool started;
+    bool read_only;
+
+public:
+    Preferences();
+    ~Preferences();
+
+    // Read-only opens of a namespace that was never written fail, as on the device
+    bool begin(const char* name, bool readOnly = false, const char* partition = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+    size_t freeEntries();
+
+    size_t putBool(const char* key, bool value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putULong(const char* key, uint32_t value);
+    size_t putULong64(const char* key, uint64_t value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+
+    bool getBool(const char* key, bool defaultValue = false);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0);
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0);
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getString(const char* key, char* value, size_t maxLength);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+
+private:
+    size_t put(const char* key, char type, const void* value, size_t length);
+    bool get(const char* key, char type, void* value, size_t length);
+};
+
+#endif // FAKE_PREFERENCES_H
@@ -0,0 +1,61 @@
+#ifndef FAKE_UPDATE_H
+#define FAKE_UPDATE_H
+
+// Host stand-in for the Arduino Update library. The image goes into a
+// model of the inactive OTA partition (FakeUpdate.cpp) the way the library
+// writes it: buffered into 4 KB sectors, each erased and written as it
+// fills, with the magic byte checked on the first one.
+
+#include <Arduino.h>
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_ERASE 2
+#define UPDATE_ERROR_READ 3
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_STREAM 6
+#define UPDATE_ERROR_MD5 7
+#define UPDATE_ERROR_MAGIC_BYTE 8
+#define UPDATE_ERROR_ACTIVATE 9
+#define UPDATE_ERROR_NO_PARTITION 10
+#define UPDATE_ERROR_BAD_ARGUMENT 11
+#define UPDATE_ERROR_ABORT 12
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+class UpdateClass {
+    uint8_t* _buffer;
+    size_t _bufferLen;
+    size_t _size;
+    size_t _progress;
+    uint8_t _error;
+
+    bool _writeBuffer();
+    void _reset();
+
+public:
+    UpdateClass();
+
+    bool begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW,
+               const char* label = NULL);
+    size_t write(uint8_t* data, size_t len);
+    bool end(bool evenIfRemaining = false);
+    void abort();
+
+    const char* errorString();
+    bool hasError() { return _error != UPDATE_ERROR_OK; }
+    uint8_t getError() { return _error; }
+    bool isRunning() { return _size > 0; }
+    bool isFinished() { return _progress == _size; }
+    size_t size() { return _size; }
+    size_t progress() { return _progress; }
+    size_t remaining() { return _size - _progress; }
+};
+
+extern UpdateClass Update;
+
+#endif // FAKE_UPDATE_H
@@ -0,0 +1,181 @@
+#ifndef FAKE_WIFI_H
+#define FAKE_WIFI_H
+
+// Host stand-in for the ESP32 WiFi library. The radio environment is
+// scripted through FakeDevice.h; connects, scans and disconnects complete
+// on the virtual clock and are reported through onEvent() like on the
+// device.
+
+#include <Arduino.h>
+#include <functional>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6,
+    WL_NO_SHIELD = 255
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM
+} wifi_ps_type_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+    WIFI_AUTH_WPA2_ENTERPRISE,
+    WIFI_AUTH_WPA3_PSK,
+    WIFI_AUTH_WPA2_WPA3_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_SCAN_DONE,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_STOP,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_AUTHMODE_CHANGE,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP6,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP,
+    ARDUINO_EVENT_WIFI_AP_START,
+    ARDUINO_EVENT_WIFI_AP_STOP,
+    ARDUINO_EVENT_WIFI_AP_STACONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STADISCONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED,
+    ARDUINO_EVENT_WIFI_AP_PROBEREQRECVED,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+// Disconnect reasons the fakes report (esp_wifi_types.h)
+#define WIFI_REASON_AUTH_EXPIRE 2
+#define WIFI_REASON_ASSOC_LEAVE 8
+#define WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT 15
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_NO_AP_FOUND 201
+#define WIFI_REASON_AUTH_FAIL 202
+#define WIFI_REASON_ASSOC_FAIL 203
+#define WIFI_REASON_HANDSHAKE_TIMEOUT 204
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_auth_mode_t authmode;
+} wifi_event_sta_connected_t;
+
+typedef struct {
+    uint16_t status;
+    uint8_t number;
+} wifi_event_sta_scan_done_t;
+
+typedef struct {
+    struct {
+        uint32_t ip;
+        uint32_t netmask;
+        uint32_t gw;
+    } ip_info;
+    bool ip_changed;
+} ip_event_got_ip_t;
+
+typedef union {
+    wifi_event_sta_scan_done_t wifi_scan_done;
+    wifi_event_sta_connected_t wifi_sta_connected;
+    wifi_event_sta_disconnected_t wifi_sta_disconnected;
+    ip_event_got_ip_t got_ip;
+} arduino_event_info_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode();
+    bool enableSTA(bool enable);
+    bool enableAP(bool enable);
+    wl_status_t status();
+
+    // Station
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet,
+                IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    bool disconnect(bool wifioff = false, bool eraseap = false);
+    bool reconnect();
+    bool isConnected();
+    bool setAutoReconnect(bool autoReconnect);
+    bool getAutoReconnect();
+    bool persistent(bool persistent);
+    bool setSleep(bool enabled);
+    bool setSleep(wifi_ps_type_t sleepType);
+    wifi_ps_type_t getSleep();
+    bool setHostname(const char* hostname);
+
+    String SSID() const;
+    int8_t RSSI();
+    uint8_t* BSSID();
+    int32_t channel();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    String macAddress();
+
+    // Access point
+    bool softAP(const char* ssid, const char* passphrase = nullptr, int channel = 1, int hidden = 0,
+                int maxConnection = 4);
+    bool softAPdisconnect(bool wifioff = false);
+    IPAddress softAPIP();
+    uint8_t softAPgetStationNum();
+
+    // Scanning
+    int16_t scanNetworks(bool async = false, bool showHidden = false, bool passive = false,
+                         uint32_t maxMsPerChannel = 300, uint8_t channel = 0);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t index) const;
+    int32_t RSSI(uint8_t index);
+    uint8_t* BSSID(uint8_t index);
+    int32_t channel(uint8_t index);
+    wifi_auth_mode_t encryptionType(uint8_t index);
+
+    // Events are delivered on the test thread, like the Arduino event task
+    wifi_event_id_t onEvent(WiFiEventFuncCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+    void removeEvent(wifi_event_id_t id);
+};
+
+extern WiFiClass WiFi;
+
+#endif // FAKE_WIFI_H
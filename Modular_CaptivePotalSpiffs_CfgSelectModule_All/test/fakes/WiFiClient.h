@@ -0,0 +1,43 @@
+#ifndef FAKE_WIFI_CLIENT_H
+#define FAKE_WIFI_CLIENT_H
+
+// Host stand-in for WiFiClient: connects in-process to the HTTP servers
+// registered with fake::serveHttp(), and only while the station is up
+
+#include <Arduino.h>
+
+namespace fake {
+namespace detail {
+struct Connection;
+}
+}
+
+class WiFiClient : public Print {
+protected:
+    fake::detail::Connection* _connection;
+
+    int _open(const char* host, uint16_t port, bool tls);
+
+public:
+    WiFiClient() : _connection(nullptr) {}
+    virtual ~WiFiClient() { stop(); }
+
+    virtual int connect(const char* host, uint16_t port) { return _open(host, port, false); }
+    virtual int connect(const char* host, uint16_t port, int32_t timeout) { (void)timeout; return connect(host, port); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int available();
+    int read();
+    int read(uint8_t* buffer, size_t size);
+    int peek();
+    void flush() override {}
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+    void setTimeout(uint32_t seconds) { (void)seconds; }
+};
+
+#endif // FAKE_WIFI_CLIENT_H
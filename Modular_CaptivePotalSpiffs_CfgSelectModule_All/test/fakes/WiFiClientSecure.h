@@ -0,0 +1,19 @@
+#ifndef FAKE_WIFI_CLIENT_SECURE_H
+#define FAKE_WIFI_CLIENT_SECURE_H
+
+// Host stand-in for WiFiClientSecure. No cryptography: connect() costs the
+// handshake time and session heap set with fake::setTlsCost(), which is
+// what the code under test has to economize on.
+
+#include "WiFiClient.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    int connect(const char* host, uint16_t port) override { return _open(host, port, true); }
+    int connect(const char* host, uint16_t port, int32_t timeout) override { (void)timeout; return connect(host, port); }
+
+    void setInsecure() {}
+    void setCACert(const char* rootCA) { (void)rootCA; }
+};
+
+#endif // FAKE_WIFI_CLIENT_SECURE_H
@@ -0,0 +1,9 @@
+#ifndef FAKE_ESP_IDF_VERSION_H
+#define FAKE_ESP_IDF_VERSION_H
+
+// The fakes follow the ESP-IDF 5 APIs of Arduino-ESP32 3.x
+#define ESP_IDF_VERSION_MAJOR 5
+#define ESP_IDF_VERSION_MINOR 1
+#define ESP_IDF_VERSION_PATCH 0
+
+#endif // FAKE_ESP_IDF_VERSION_H
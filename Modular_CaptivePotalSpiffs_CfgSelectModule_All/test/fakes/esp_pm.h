@@ -0,0 +1,18 @@
+#ifndef FAKE_ESP_PM_H
+#define FAKE_ESP_PM_H
+
+// Power management as ESP-IDF 5 declares it. Configurations are recorded
+// for fake::powerConfig(); light-sleep can be refused like on a core built
+// without tickless idle (fake::setLightSleepSupported).
+
+#include "esp_err.h"
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_t;
+
+esp_err_t esp_pm_configure(const void* config);
+
+#endif // FAKE_ESP_PM_H
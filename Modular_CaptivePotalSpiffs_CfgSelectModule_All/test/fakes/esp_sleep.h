@@ -0,0 +1,10 @@
+#ifndef FAKE_ESP_SLEEP_H
+#define FAKE_ESP_SLEEP_H
+
+// Light-sleep wake sources; recorded for fake::powerConfig()
+
+#include "esp_err.h"
+
+esp_err_t esp_sleep_enable_gpio_wakeup();
+
+#endif // FAKE_ESP_SLEEP_H
@@ -0,0 +1,34 @@
+#ifndef FAKE_FREERTOS_SEMPHR_H
+#define FAKE_FREERTOS_SEMPHR_H
+
+#include "queue.h"
+
+// Mutexes are one-slot queues holding a token, as in FreeRTOS itself
+// (without priority inheritance, which lockstep tasks do not need)
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    QueueHandle_t queue = xQueueCreate(1, 1);
+    uint8_t token = 0;
+    if (queue) {
+        xQueueSend(queue, &token, 0);
+    }
+    return queue;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    uint8_t token;
+    return xQueueReceive(semaphore, &token, ticks);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    uint8_t token = 0;
+    return xQueueSend(semaphore, &token, 0);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    vQueueDelete(semaphore);
+}
+
+#endif // FAKE_FREERTOS_SEMPHR_H
@@ -0,0 +1,21 @@
+#ifndef FAKE_FREERTOS_TIMERS_H
+#define FAKE_FREERTOS_TIMERS_H
+
+#include "FreeRTOS.h"
+
+typedef struct tmrTimerControl* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+// Callbacks run on the test thread as the clock passes their expiry
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload, void* id,
+                           TimerCallbackFunction_t callback);
+void* pvTimerGetTimerID(TimerHandle_t timer);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerResetFromISR(TimerHandle_t timer, BaseType_t* woken);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t ticks);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+
+#endif // FAKE_FREERTOS_TIMERS_H
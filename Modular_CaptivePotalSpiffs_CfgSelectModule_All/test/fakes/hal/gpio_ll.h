@@ -0,0 +1,14 @@
+#ifndef FAKE_HAL_GPIO_LL_H
+#define FAKE_HAL_GPIO_LL_H
+
+// The register-level GPIO call that is safe from an ISR with the flash cache
+// off. Masks the pin's interrupt like gpio_intr_disable().
+
+#include <stdint.h>
+
+struct gpio_dev_t {};
+extern gpio_dev_t GPIO;
+
+void gpio_ll_intr_disable(gpio_dev_t* hw, uint32_t gpio_num);
+
+#endif // FAKE_HAL_GPIO_LL_H
@@ -0,0 +1,330 @@
+#include <PortalFixture.h>
+
+// REST API and portal pages, served while the portal is up
+
+// Heap allocations per request, response and headers included. JSON
+// documents live in the portal's JsonPool and add nothing.
+#define PAGE_ALLOC_BUDGET 10
+#define API_GET_ALLOC_BUDGET 8
+#define API_PUT_ALLOC_BUDGET 10
+
+// Scrapes render from a snapshot into the response's own buffer; only the
+// response object and its headers are allocated
+#define METRICS_ALLOC_BUDGET 4
+
+void setUp() {
+    resetDevice();
+
+    // Stored but not yet confirmed: the portal starts with this config
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    strlcpy(config.tg_token, "123:abc", sizeof(config.tg_token));
+    ConfigStore(NS).save(config, false);
+
+    newPortal();
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->begin(PortalMode::ASYNC));
+}
+
+void tearDown() {
+    stopDevice();
+}
+
+static void test_get_config_masks_secrets() {
+    fake::HttpResponse response = fake::get("/api/config");
+    TEST_ASSERT_EQUAL(200, response.code);
+    TEST_ASSERT_EQUAL_STRING("application/json", response.content_type.c_str());
+    TEST_ASSERT_EQUAL_STRING("no-store", response.header("Cache-Control").c_str());
+    TEST_ASSERT_TRUE(response.body.find("\"home\"") != std::string::npos);
+    TEST_ASSERT_TRUE(response.body.find(CONFIG_SECRET_MASK) != std::string::npos);
+    TEST_ASSERT_TRUE(response.body.find("password1") == std::string::npos);
+    TEST_ASSERT_TRUE(response.body.find("123:abc") == std::string::npos);
+}
+
+static void test_put_rejects_bad_requests() {
+    fake::HttpResponse invalid = fake::putJson("/api/config", "{\"host\":{\"url\":\"ftp://example.com\"}}");
+    TEST_ASSERT_EQUAL(422, invalid.code);
+    TEST_ASSERT_TRUE(invalid.body.find("\"error\"") != std::string::npos);
+
+    fake::HttpResponse malformed = fake::putJson("/api/config", "{\"host\":");
+    TEST_ASSERT_EQUAL(400, malformed.code);
+
+    fake::HttpResponse empty = fake::putJson("/api/config", "");
+    TEST_ASSERT_EQUAL(400, empty.code);
+
+    std::string big = "{\"host\":{\"url\":\"https://example.com/" + std::string(API_BODY_MAX_SIZE, 'a') + "\"}}";
+    fake::HttpResponse oversized = fake::putJson("/api/config", big, 512);
+    TEST_ASSERT_EQUAL(413, oversized.code);
+
+    // Nothing reached the connection task
+    uint32_t version = portal->configVersion();
+    fake::advance(100);
+    TEST_ASSERT_EQUAL(version, portal->configVersion());
+}
+
+static void test_chunked_put_applies() {
+    uint32_t version = portal->configVersion();
+    fake::HttpResponse response = fake::putJson("/api/config",
+        "{\"telegram\":{\"active\":true,\"token\":\"" CONFIG_SECRET_MASK "\"},"
+        "\"host\":{\"active\":true,\"url\":\"https://example.com/in\"}}", 7);
+    TEST_ASSERT_EQUAL(200, response.code);
+
+    // Adopted by the setup task on its next pass
+    TEST_ASSERT_TRUE(fake::advanceUntil([&] { return portal->configVersion() != version; }, 1000));
+    bool host_active = false;
+    String token;
+    String url;
+    portal->withConfig([&](const ConfigData& config) {
+        host_active = config.host_active;
+        token = config.tg_token;
+        url = config.host_url;
+    });
+    TEST_ASSERT_TRUE(host_active);
+    TEST_ASSERT_EQUAL_STRING("123:abc", token.c_str());
+    TEST_ASSERT_EQUAL_STRING("https://example.com/in", url.c_str());
+}
+
+static void test_page_revalidation() {
+    fake::HttpResponse page = fake::get("/");
+    TEST_ASSERT_EQUAL(200, page.code);
+    TEST_ASSERT_TRUE(page.hasHeader("ETag"));
+    TEST_ASSERT_EQUAL_STRING("gzip", page.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL(ESP32ConfigPortal::getDefaultPage().length, page.body.size());
+
+    fake::Headers headers;
+    headers.push_back(std::make_pair(std::string("If-None-Match"), page.header("ETag")));
+    fake::HttpResponse cached = fake::get("/", headers);
+    TEST_ASSERT_EQUAL(304, cached.code);
+    TEST_ASSERT_TRUE(cached.body.empty());
+}
+
+static void test_allocation_budgets() {
+    // Warm up: first requests may size pools and caches
+    fake::get("/");
+    fake::get("/api/config");
+    fake::get("/api/status");
+
+    fake::HeapProbe probe;
+    TEST_ASSERT_EQUAL(200, fake::get("/").code);
+    TEST_ASSERT_LESS_OR_EQUAL(PAGE_ALLOC_BUDGET, probe.allocations());
+
+    probe.restart();
+    TEST_ASSERT_EQUAL(200, fake::get("/api/config").code);
+    TEST_ASSERT_LESS_OR_EQUAL(API_GET_ALLOC_BUDGET, probe.allocations());
+
+    probe.restart();
+    TEST_ASSERT_EQUAL(200, fake::get("/api/status").code);
+    TEST_ASSERT_LESS_OR_EQUAL(API_GET_ALLOC_BUDGET, probe.allocations());
+
+    probe.restart();
+    TEST_ASSERT_EQUAL(200, fake::putJson("/api/config", "{\"host\":{\"active\":false}}").code);
+    TEST_ASSERT_LESS_OR_EQUAL(API_PUT_ALLOC_BUDGET, probe.allocations());
+}
+
+static void test_metrics_scrape() {
+    fake::get("/api/status");
+    fake::HttpResponse scrape = fake::get("/metrics");
+    TEST_ASSERT_EQUAL(200, scrape.code);
+    TEST_ASSERT_EQUAL_STRING(METRICS_CONTENT_TYPE, scrape.content_type.c_str());
+    TEST_ASSERT_TRUE(scrape.body.find("# TYPE " METRICS_PREFIX "http_handler_duration_seconds histogram\n") != std::string::npos);
+    TEST_ASSERT_TRUE(scrape.body.find(METRICS_PREFIX "captive_active 1\n") != std::string::npos);
+    TEST_ASSERT_TRUE(scrape.body.find(METRICS_PREFIX "task_stack_free_bytes{task=\"config_portal\"}") != std::string::npos);
+    TEST_ASSERT_TRUE(scrape.body.find("_bucket{le=\"+Inf\"}") != std::string::npos);
+    TEST_ASSERT_GREATER_THAN(1460, scrape.body.size());  // Spans several chunks
+
+    // Any window of the exposition matches the whole
+    MetricsSnapshot snapshot;
+    Metrics::capture(snapshot);
+    char whole[12288];
+    size_t length = Metrics::render(snapshot, whole, sizeof(whole), 0);
+    TEST_ASSERT_LESS_THAN(sizeof(whole), length);
+    std::string pieces;
+    char chunk[97];
+    size_t n;
+    while ((n = Metrics::render(snapshot, chunk, sizeof(chunk), pieces.size())) > 0) {
+        pieces.append(chunk, n);
+    }
+    TEST_ASSERT_EQUAL(length, pieces.size());
+    TEST_ASSERT_EQUAL(0, memcmp(whole, pieces.data(), length));
+
+    fake::HeapProbe probe;
+    TEST_ASSERT_EQUAL(200, fake::get("/metrics").code);
+    TEST_ASSERT_LESS_OR_EQUAL(METRICS_ALLOC_BUDGET, probe.allocations());
+}
+
+static void test_log_tail_redacts_secrets() {
+    // Logging formats into the ring, nothing is allocated
+    fake::HeapProbe probe;
+    LOG_I("probe %d %s", 42, "value");
+    TEST_ASSERT_EQUAL(0, probe.allocations());
+
+    fake::HttpResponse saved = fake::postForm("/save", "wifi_ssid_0=office&wifi_password_0=secret99&wifi_priority_0=0");
+    TEST_ASSERT_EQUAL(200, saved.code);
+    Log::flush();
+
+    fake::HttpResponse log = fake::get("/log");
+    TEST_ASSERT_EQUAL(200, log.code);
+    TEST_ASSERT_TRUE(log.body.find("I (") == 0);
+    TEST_ASSERT_TRUE(log.body.find("Configuration Portal Ready\n") != std::string::npos);
+    TEST_ASSERT_TRUE(log.body.find("probe 42 value\n") != std::string::npos);
+    TEST_ASSERT_TRUE(log.body.find("WiFi SSID: office, password ********\n") != std::string::npos);
+    TEST_ASSERT_TRUE(log.body.find("secret99") == std::string::npos);
+    TEST_ASSERT_TRUE(log.body.find("123:abc") == std::string::npos);
+    TEST_ASSERT_TRUE(fake::serialContains("probe 42 value"));
+}
+
+static uint32_t probeCount() {
+    MetricsSnapshot snapshot;
+    Metrics::capture(snapshot);
+    return snapshot.counters[(size_t)MetricCounter::CAPTIVE_PROBES];
+}
+
+static void test_captive_probes_get_small_answers() {
+    uint32_t probes = probeCount();
+    const char* checks[] = { "/generate_204", "/hotspot-detect.html", "/connecttest.txt", "/redirect" };
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        fake::HttpResponse response = fake::get(checks[i]);
+        TEST_ASSERT_EQUAL(302, response.code);
+        TEST_ASSERT_EQUAL_STRING("http://192.168.4.1/", response.header("Location").c_str());
+        TEST_ASSERT_TRUE(response.body.empty());
+    }
+
+    // Unknown paths are redirected too, but not counted as probes
+    fake::HttpResponse stray = fake::get("/some/article.html");
+    TEST_ASSERT_EQUAL(302, stray.code);
+    TEST_ASSERT_EQUAL_STRING("http://192.168.4.1/", stray.header("Location").c_str());
+
+    fake::HttpResponse icon = fake::get("/favicon.ico");
+    TEST_ASSERT_EQUAL(204, icon.code);
+    TEST_ASSERT_TRUE(icon.body.empty());
+    TEST_ASSERT_EQUAL(404, fake::get("/wpad.dat").code);
+    TEST_ASSERT_EQUAL(probes + 6, probeCount());
+}
+
+static void test_dns_answers_and_rate_limit() {
+    fake::DnsReply a = fake::dnsLookup("captive.apple.com");
+    TEST_ASSERT_TRUE(a.answered);
+    TEST_ASSERT_EQUAL(0, a.rcode);
+    TEST_ASSERT_EQUAL(1, a.answers);
+    TEST_ASSERT_EQUAL_STRING("192.168.4.1", a.address.c_str());
+
+    // AAAA and HTTPS: answered at once with no records, not left to time out
+    const uint16_t empty_types[] = { 28, 65 };
+    for (size_t i = 0; i < 2; i++) {
+        fake::DnsReply reply = fake::dnsLookup("www.google.com", empty_types[i]);
+        TEST_ASSERT_TRUE(reply.answered);
+        TEST_ASSERT_EQUAL(0, reply.rcode);
+        TEST_ASSERT_EQUAL(0, reply.answers);
+    }
+
+    // A client storming the responder is cut to its rate, others are not
+    uint32_t answered = 0;
+    for (int i = 0; i < DNS_RATE_BURST * 2; i++) {
+        answered += fake::dnsQuery(7);
+    }
+    TEST_ASSERT_EQUAL(DNS_RATE_BURST, answered);
+    TEST_ASSERT_TRUE(fake::dnsQuery(8));
+    fake::advance(1000);
+    answered = 0;
+    for (int i = 0; i < DNS_RATE_BURST; i++) {
+        answered += fake::dnsQuery(7);
+    }
+    TEST_ASSERT_EQUAL(DNS_RATE_PER_S, answered);
+
+    // Nothing is allocated per query
+    fake::HeapProbe probe;
+    TEST_ASSERT_TRUE(fake::dnsQuery(9));
+    TEST_ASSERT_EQUAL(0, probe.allocations());
+}
+
+static void test_requests_over_the_limits_are_shed() {
+    uint32_t shed_client = counter(MetricCounter::HTTP_SHED_CLIENT);
+    uint32_t shed_busy = counter(MetricCounter::HTTP_SHED_BUSY);
+
+    // A client retrying in a loop gets its burst, then 429 until tokens accrue
+    fake::setHttpClient(10);
+    for (int i = 0; i < HTTP_RATE_BURST; i++) {
+        TEST_ASSERT_EQUAL(302, fake::get("/generate_204").code);
+    }
+    fake::HttpResponse limited = fake::get("/generate_204");
+    TEST_ASSERT_EQUAL(429, limited.code);
+    TEST_ASSERT_EQUAL_STRING("2", limited.header("Retry-After").c_str());
+    TEST_ASSERT_EQUAL(0, limited.body.size());
+    fake::setHttpClient(11);
+    TEST_ASSERT_EQUAL(302, fake::get("/generate_204").code);
+    fake::advance(1000);
+    fake::setHttpClient(10);
+    TEST_ASSERT_EQUAL(302, fake::get("/generate_204").code);
+
+    // Slow clients hold their connections while responses go out
+    fake::setLinkSpeed(1000);
+    fake::setHttpClient(20);
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS_PER_CLIENT; i++) {
+        TEST_ASSERT_EQUAL(200, fake::get("/").code);
+    }
+    TEST_ASSERT_EQUAL(429, fake::get("/").code);
+    for (int i = HTTP_MAX_CONNECTIONS_PER_CLIENT; i < HTTP_MAX_CONNECTIONS; i++) {
+        fake::setHttpClient((uint8_t)(21 + i));
+        TEST_ASSERT_EQUAL(200, fake::get("/").code);
+    }
+    fake::setHttpClient(30);
+    fake::HttpResponse busy = fake::get("/");
+    TEST_ASSERT_EQUAL(503, busy.code);
+    TEST_ASSERT_EQUAL_STRING("2", busy.header("Retry-After").c_str());
+
+    // Only the /events route streams; asking for a stream elsewhere is held
+    fake::Headers stream;
+    stream.push_back(std::make_pair(std::string("Accept"), std::string("text/event-stream")));
+    TEST_ASSERT_EQUAL(503, fake::get("/", stream).code);
+
+    // Admitted again once they are sent
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return fake::httpInFlight() == 0; }, 10000));
+    TEST_ASSERT_EQUAL(200, fake::get("/").code);
+    TEST_ASSERT_EQUAL(shed_client + 2, counter(MetricCounter::HTTP_SHED_CLIENT));
+    TEST_ASSERT_EQUAL(shed_busy + 2, counter(MetricCounter::HTTP_SHED_BUSY));
+}
+
+static void test_low_memory_answers_503_at_once() {
+    uint32_t shed = counter(MetricCounter::HTTP_SHED_MEMORY);
+
+    // Something else took the heap down to the watermark
+    std::vector<void*> taken;
+    while (ESP.getFreeHeap() >= HTTP_MIN_FREE_HEAP) {
+        void* block = malloc(2048);
+        TEST_ASSERT_NOT_NULL(block);
+        fake::HeapPause pause;
+        taken.push_back(block);
+    }
+
+    // Refused before any route runs: no body parsed, nothing applied
+    fake::HeapProbe probe;
+    fake::HttpResponse page = fake::get("/");
+    TEST_ASSERT_EQUAL(503, page.code);
+    TEST_ASSERT_EQUAL_STRING("2", page.header("Retry-After").c_str());
+    TEST_ASSERT_EQUAL(0, page.body.size());
+    TEST_ASSERT_LESS_OR_EQUAL(3, probe.allocations());
+    uint8_t profiles = portal->getConfig().wifi_profile_count;
+    TEST_ASSERT_EQUAL(503, fake::putJson("/api/config", "{\"wifi\":[]}").code);
+    TEST_ASSERT_EQUAL(profiles, portal->getConfig().wifi_profile_count);
+    TEST_ASSERT_EQUAL(shed + 2, counter(MetricCounter::HTTP_SHED_MEMORY));
+
+    for (size_t i = 0; i < taken.size(); i++) {
+        free(taken[i]);
+    }
+    TEST_ASSERT_EQUAL(200, fake::get("/").code);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_get_config_masks_secrets);
+    RUN_TEST(test_put_rejects_bad_requests);
+    RUN_TEST(test_chunked_put_applies);
+    RUN_TEST(test_page_revalidation);
+    RUN_TEST(test_allocation_budgets);
+    RUN_TEST(test_metrics_scrape);
+    RUN_TEST(test_log_tail_redacts_secrets);
+    RUN_TEST(test_captive_probes_get_small_answers);
+    RUN_TEST(test_dns_answers_and_rate_limit);
+    RUN_TEST(test_requests_over_the_limits_are_shed);
+    RUN_TEST(test_low_memory_answers_503_at_once);
+    return UNITY_END();
+}
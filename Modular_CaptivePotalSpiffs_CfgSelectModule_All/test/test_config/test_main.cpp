@@ -0,0 +1,181 @@
+#include <unity.h>
+#include <FakeDevice.h>
+#include "ConfigStore.h"
+#include "ConfigJson.h"
+
+// ConfigStore and ConfigJson against the in-memory NVS
+
+static const char* NS = "test_cfg";
+
+void setUp() {
+    fake::reset();
+}
+
+void tearDown() {
+}
+
+static void test_store_round_trip() {
+    ConfigData config;
+    TEST_ASSERT_TRUE(config.addWiFiProfile("home", "password1", 3));
+    TEST_ASSERT_TRUE(config.addWiFiProfile("office", "password2"));
+    config.wifi_profiles[1].last_success = 7;
+    config.tg_active = true;
+    strlcpy(config.tg_token, "123:abc", sizeof(config.tg_token));
+    strlcpy(config.host_url, "https://example.com/in", sizeof(config.host_url));
+
+    ConfigStore writer(NS);
+    TEST_ASSERT_TRUE(writer.save(config, true));
+
+    ConfigStore reader(NS);
+    ConfigData loaded;
+    bool setup_done = false;
+    TEST_ASSERT_TRUE(reader.load(loaded, setup_done));
+    TEST_ASSERT_TRUE(setup_done);
+    TEST_ASSERT_EQUAL(2, loaded.wifi_profile_count);
+    TEST_ASSERT_EQUAL_STRING("home", loaded.wifi_profiles[0].ssid);
+    TEST_ASSERT_EQUAL_STRING("password1", loaded.wifi_profiles[0].password);
+    TEST_ASSERT_EQUAL(3, loaded.wifi_profiles[0].priority);
+    TEST_ASSERT_EQUAL(7, loaded.wifi_profiles[1].last_success);
+    TEST_ASSERT_TRUE(loaded.tg_active);
+    TEST_ASSERT_FALSE(loaded.host_active);
+    TEST_ASSERT_EQUAL_STRING("123:abc", loaded.tg_token);
+    TEST_ASSERT_EQUAL_STRING("https://example.com/in", loaded.host_url);
+}
+
+static void test_store_empty_namespace() {
+    ConfigStore store(NS);
+    ConfigData config;
+    bool setup_done = true;
+    TEST_ASSERT_FALSE(store.load(config, setup_done));
+    TEST_ASSERT_FALSE(setup_done);
+    TEST_ASSERT_EQUAL(0, config.wifi_profile_count);
+}
+
+static void test_store_skips_unchanged_image() {
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    ConfigStore store(NS);
+    TEST_ASSERT_TRUE(store.save(config, true));
+    uint32_t writes = fake::nvsWrites();
+
+    TEST_ASSERT_TRUE(store.save(config, true));
+    TEST_ASSERT_EQUAL(writes, fake::nvsWrites());
+    TEST_ASSERT_EQUAL(1, store.writeCount());
+
+    config.host_active = true;
+    TEST_ASSERT_TRUE(store.save(config, true));
+    TEST_ASSERT_EQUAL(2, store.writeCount());
+    TEST_ASSERT_TRUE(fake::nvsWrites() > writes);
+}
+
+static void test_store_migrates_legacy_keys() {
+    fake::nvsPutBool(NS, "is_setup_done", true);
+    fake::nvsPutString(NS, "wifi_ssid", "legacy");
+    fake::nvsPutString(NS, "wifi_password", "password9");
+    fake::nvsPutString(NS, "tg_token", "42:xyz");
+    fake::nvsPutBool(NS, "tg_active", true);
+
+    ConfigStore store(NS);
+    uint16_t migrated_from = 0xffff;
+    store.onMigrate([&](uint16_t fromVersion, ConfigData&) { migrated_from = fromVersion; });
+    ConfigData config;
+    bool setup_done = false;
+    TEST_ASSERT_TRUE(store.load(config, setup_done));
+    TEST_ASSERT_EQUAL(0, migrated_from);
+    TEST_ASSERT_TRUE(setup_done);
+    TEST_ASSERT_EQUAL(1, config.wifi_profile_count);
+    TEST_ASSERT_EQUAL_STRING("legacy", config.wifi_profiles[0].ssid);
+    TEST_ASSERT_EQUAL_STRING("password9", config.wifi_profiles[0].password);
+    TEST_ASSERT_EQUAL_STRING("42:xyz", config.tg_token);
+    TEST_ASSERT_TRUE(config.tg_active);
+
+    // Rewritten as one blob, old keys gone
+    TEST_ASSERT_TRUE(fake::nvsHasKey(NS, "cfg"));
+    TEST_ASSERT_FALSE(fake::nvsHasKey(NS, "wifi_ssid"));
+    TEST_ASSERT_FALSE(fake::nvsHasKey(NS, "is_setup_done"));
+}
+
+static void test_store_rejects_corrupt_blob() {
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    ConfigStore(NS).save(config, true);
+
+    uint8_t garbage[32];
+    memset(garbage, 0x5a, sizeof(garbage));
+    fake::nvsPutBytes(NS, "cfg", garbage, sizeof(garbage));
+
+    ConfigStore store(NS);
+    ConfigData loaded;
+    bool setup_done = true;
+    TEST_ASSERT_FALSE(store.load(loaded, setup_done));
+    TEST_ASSERT_FALSE(setup_done);
+    TEST_ASSERT_EQUAL(0, loaded.wifi_profile_count);
+}
+
+static bool applyJson(const char* json, ConfigData& config, String& error) {
+    JsonDocument doc;
+    if (deserializeJson(doc, json)) {
+        error = "parse";
+        return false;
+    }
+    return configFromJson(doc.as<JsonObject>(), config, error);
+}
+
+static void test_json_masks_secrets() {
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    strlcpy(config.tg_token, "123:abc", sizeof(config.tg_token));
+
+    JsonDocument doc;
+    configToJson(config, doc.to<JsonObject>());
+    String out;
+    serializeJson(doc, out);
+    TEST_ASSERT_TRUE(out.indexOf("password1") < 0);
+    TEST_ASSERT_TRUE(out.indexOf("123:abc") < 0);
+    TEST_ASSERT_TRUE(out.indexOf(CONFIG_SECRET_MASK) >= 0);
+    TEST_ASSERT_TRUE(out.indexOf("\"home\"") >= 0);
+}
+
+static void test_json_masked_secret_keeps_value() {
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+    strlcpy(config.tg_token, "123:abc", sizeof(config.tg_token));
+
+    String error;
+    TEST_ASSERT_TRUE(applyJson("{\"wifi\":[{\"ssid\":\"home\",\"password\":\"" CONFIG_SECRET_MASK "\"}],"
+                               "\"telegram\":{\"active\":true,\"token\":\"" CONFIG_SECRET_MASK "\"}}",
+                               config, error));
+    TEST_ASSERT_EQUAL_STRING("password1", config.wifi_profiles[0].password);
+    TEST_ASSERT_EQUAL_STRING("123:abc", config.tg_token);
+    TEST_ASSERT_TRUE(config.tg_active);
+}
+
+static void test_json_validation_leaves_config_untouched() {
+    ConfigData config;
+    config.addWiFiProfile("home", "password1");
+
+    String error;
+    TEST_ASSERT_FALSE(applyJson("{\"host\":{\"active\":true,\"url\":\"ftp://example.com\"}}", config, error));
+    TEST_ASSERT_TRUE(error.indexOf("url") >= 0);
+    TEST_ASSERT_FALSE(config.host_active);
+
+    TEST_ASSERT_FALSE(applyJson("{\"wifi\":[{\"ssid\":\"cafe\",\"password\":\"short\"}]}", config, error));
+    TEST_ASSERT_EQUAL(1, config.wifi_profile_count);
+    TEST_ASSERT_EQUAL_STRING("home", config.wifi_profiles[0].ssid);
+
+    TEST_ASSERT_FALSE(applyJson("{\"telegram\":{\"active\":\"yes\"}}", config, error));
+    TEST_ASSERT_FALSE(config.tg_active);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_store_round_trip);
+    RUN_TEST(test_store_empty_namespace);
+    RUN_TEST(test_store_skips_unchanged_image);
+    RUN_TEST(test_store_migrates_legacy_keys);
+    RUN_TEST(test_store_rejects_corrupt_blob);
+    RUN_TEST(test_json_masks_secrets);
+    RUN_TEST(test_json_masked_secret_keeps_value);
+    RUN_TEST(test_json_validation_leaves_config_untouched);
+    return UNITY_END();
+}
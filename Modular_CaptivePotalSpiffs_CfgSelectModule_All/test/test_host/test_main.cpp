@@ -0,0 +1,266 @@
+#include <PortalFixture.h>
+#include <esp_partition.h>
+#include <deque>
+#include "WebHostModule.h"
+
+// Store-and-forward uploads to a web host stand-in, connected mode
+
+static const char* HOST = "logs.example.com";
+
+// Uploads the stand-in received, bodies decoded
+struct Upload {
+    uint64_t at;
+    std::string path;
+    std::string sequence;
+    std::string encoding;
+    std::string records;
+};
+static std::vector<Upload> uploads;
+
+// Replies for the next uploads, then 200
+static std::deque<fake::ServerReply> replies;
+
+static void serveHost() {
+    fake::serveHttp(HOST, 80, [](const fake::ServerRequest& request) {
+        Upload upload = { fake::now(), request.path, request.header("X-Record-Sequence"),
+                          request.header("Content-Encoding"), std::string() };
+        TEST_ASSERT_TRUE(fake::gunzip(request.body, upload.records));
+        uploads.push_back(upload);
+        if (replies.empty()) {
+            return fake::ServerReply(200);
+        }
+        fake::ServerReply reply = replies.front();
+        replies.pop_front();
+        return reply;
+    });
+}
+
+// Connected device with the web host module registered, enabled or not
+static void startHost(bool enabled) {
+    ConfigData config;
+    config.host_active = enabled;
+    strlcpy(config.host_url, "http://logs.example.com/ingest", sizeof(config.host_url));
+    startDevice(config, true, [] { portal->addModule<WebHostModule>(ConfigSection::host); });
+}
+
+static std::string line(int i) {
+    char text[64];
+    snprintf(text, sizeof(text), "{\"seq\":%d,\"sensor\":\"temp\",\"value\":%d.5}", i, 20 + i % 7);
+    return text;
+}
+
+static std::string recordLines(int first, int count) {
+    std::string lines;
+    for (int i = first; i < first + count; i++) {
+        std::string text = line(i);
+        TEST_ASSERT_TRUE(WebHostModule::record(text.c_str()));
+        lines += text + "\n";
+    }
+    return lines;
+}
+
+void setUp() {
+    resetDevice();
+    uploads.clear();
+    replies.clear();
+}
+
+void tearDown() {
+    stopDevice();
+}
+
+static void test_records_go_out_as_one_gzip_batch() {
+    serveHost();
+    startHost(true);
+    uint32_t delivered = counter(MetricCounter::UPLOAD_DELIVERED);
+
+    uint64_t first = fake::now();
+    std::string lines = recordLines(0, 50);
+    TEST_ASSERT_EQUAL(50, WebHostModule::backlog());
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 1; }, 5000));
+    TEST_ASSERT_GREATER_OR_EQUAL(WEBHOST_BATCH_DELAY_MS, uploads[0].at - first);
+    TEST_ASSERT_EQUAL_STRING("/ingest", uploads[0].path.c_str());
+    TEST_ASSERT_EQUAL_STRING("gzip", uploads[0].encoding.c_str());
+    TEST_ASSERT_EQUAL_STRING("0", uploads[0].sequence.c_str());
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[0].records.c_str());
+    loopFor(100);
+    TEST_ASSERT_EQUAL(0, WebHostModule::backlog());
+    TEST_ASSERT_EQUAL(delivered + 50, counter(MetricCounter::UPLOAD_DELIVERED));
+
+    // Similar lines compress well
+    TEST_ASSERT_LESS_THAN(lines.size() / 2, counter(MetricCounter::UPLOAD_BODY_BYTES));
+
+    // The next batch numbers on and reuses the connection
+    lines = recordLines(50, 3);
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 2; }, 5000));
+    TEST_ASSERT_EQUAL_STRING("50", uploads[1].sequence.c_str());
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[1].records.c_str());
+    TEST_ASSERT_EQUAL(1, fake::clientStats().connects);
+}
+
+static void test_kept_until_the_host_takes_them() {
+    serveHost();
+    startHost(true);
+    replies.push_back(fake::ServerReply(503));
+    replies.push_back(fake::ServerReply(500));
+    replies.push_back(fake::ServerReply(502));
+
+    std::string lines = recordLines(0, 3);
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 4; }, 60000));
+    TEST_ASSERT_EQUAL(0, WebHostModule::backlog());
+
+    // The same batch each time, after backoff doubling around its jitter
+    for (size_t i = 0; i < uploads.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING("0", uploads[i].sequence.c_str());
+        TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[i].records.c_str());
+    }
+    for (size_t i = 1; i < uploads.size(); i++) {
+        uint32_t delay = WEBHOST_RETRY_MIN_MS << (i - 1);
+        TEST_ASSERT_GREATER_OR_EQUAL(delay / 2, uploads[i].at - uploads[i - 1].at);
+        TEST_ASSERT_LESS_OR_EQUAL(delay + 20, uploads[i].at - uploads[i - 1].at);
+    }
+
+    // Retry-After sets the delay
+    fake::ServerReply busy(429);
+    busy.headers.push_back(std::make_pair(std::string("Retry-After"), std::string("7")));
+    replies.push_back(busy);
+    recordLines(3, 1);
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 6; }, 20000));
+    TEST_ASSERT_GREATER_OR_EQUAL(7000, uploads[5].at - uploads[4].at);
+    TEST_ASSERT_EQUAL_STRING("3", uploads[5].sequence.c_str());
+
+    // A refused batch is kept and asked again only at the longest delay
+    uint32_t dropped = counter(MetricCounter::UPLOAD_DROPPED);
+    replies.push_back(fake::ServerReply(401));
+    lines = recordLines(4, 2);
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 7; }, 5000));
+    loopFor(WEBHOST_RETRY_MAX_MS / 2 - 1000);
+    TEST_ASSERT_EQUAL(7, uploads.size());
+    TEST_ASSERT_EQUAL(2, WebHostModule::backlog());
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 8; }, WEBHOST_RETRY_MAX_MS));
+    TEST_ASSERT_EQUAL_STRING("4", uploads[7].sequence.c_str());
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[7].records.c_str());
+    TEST_ASSERT_TRUE(loopUntil([] { return WebHostModule::backlog() == 0; }, 1000));
+    TEST_ASSERT_EQUAL(dropped, counter(MetricCounter::UPLOAD_DROPPED));
+}
+
+static void test_backlog_survives_link_loss_and_reboot() {
+    startHost(true);  // Host unreachable
+
+    // Nothing goes out while the link is down, the worker waits for it
+    fake::dropConnection();
+    std::string lines = recordLines(0, 10);
+    loopFor(200);
+    uint32_t connects = fake::clientStats().connects;
+    serveHost();
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 1; }, 30000));
+    TEST_ASSERT_EQUAL(connects + 1, fake::clientStats().connects);
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[0].records.c_str());
+
+    // Power lost with records waiting, the last one half written
+    fake::serveHttp(HOST, 80, fake::ServerHandler());
+    lines = recordLines(10, 20);
+    loopFor(100);
+    size_t offset = 12;  // Sector header
+    for (int i = 0; i < 30; i++) {
+        offset += 8 + line(i).size();
+    }
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+    const uint8_t torn[12] = { 100, 0, 0xff, 0xff, 1, 2, 3, 4, '{', '"', 's', 'e' };
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(partition, offset, torn, sizeof(torn)));
+    reboot();
+
+    uploads.clear();
+    startHost(true);
+    TEST_ASSERT_EQUAL(20, WebHostModule::backlog());
+    serveHost();
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 1; }, 5000));
+    TEST_ASSERT_EQUAL_STRING("10", uploads[0].sequence.c_str());
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[0].records.c_str());
+
+    // Appends go on past the damage
+    lines = recordLines(30, 2);
+    TEST_ASSERT_TRUE(loopUntil([] { return uploads.size() == 2; }, 5000));
+    TEST_ASSERT_EQUAL_STRING("30", uploads[1].sequence.c_str());
+    TEST_ASSERT_EQUAL_STRING(lines.c_str(), uploads[1].records.c_str());
+}
+
+static void test_full_log_drops_oldest() {
+    fake::setFlashPartitionSize(4 * 4096);
+    startHost(true);  // Host unreachable
+    uint32_t dropped = counter(MetricCounter::UPLOAD_DROPPED);
+
+    std::string padding(150, 'x');
+    char text[200];
+    for (int i = 0; i < 100; i++) {
+        snprintf(text, sizeof(text), "{\"seq\":%d,\"pad\":\"%s\"}", i, padding.c_str());
+        TEST_ASSERT_TRUE(WebHostModule::record(text));
+    }
+    uint32_t lost = counter(MetricCounter::UPLOAD_DROPPED) - dropped;
+    TEST_ASSERT_GREATER_THAN(0, lost);
+    TEST_ASSERT_EQUAL(100 - lost, WebHostModule::backlog());
+
+    // The newest records remain, in order
+    serveHost();
+    TEST_ASSERT_TRUE(loopUntil([] { return WebHostModule::backlog() == 0; }, 120000));
+    std::string received;
+    for (size_t i = 0; i < uploads.size(); i++) {
+        received += uploads[i].records;
+    }
+    for (int i = lost; i < 100; i++) {
+        snprintf(text, sizeof(text), "{\"seq\":%d,\"pad\":\"%s\"}\n", i, padding.c_str());
+        TEST_ASSERT_EQUAL(0, received.find(text));
+        received.erase(0, strlen(text));
+    }
+    TEST_ASSERT_TRUE(received.empty());
+}
+
+static void test_flash_wear_stays_low() {
+    serveHost();
+    startHost(true);
+    fake::FlashStats before = fake::flashStats();
+
+    // A steady trickle: ten records a second
+    size_t record_bytes = 0;
+    for (int i = 0; i < 1000; i++) {
+        std::string text = line(i);
+        TEST_ASSERT_TRUE(WebHostModule::record(text.c_str()));
+        record_bytes += text.size();
+        loopFor(100);
+    }
+    loopFor(WEBHOST_BATCH_DELAY_MS + 500);
+    TEST_ASSERT_EQUAL(0, WebHostModule::backlog());
+
+    // One write per record, one per batch delivered, one erase per 4 KB
+    fake::FlashStats after = fake::flashStats();
+    uint64_t written = after.bytes_written - before.bytes_written;
+    TEST_ASSERT_LESS_OR_EQUAL(record_bytes * 5 / 4, written);
+    TEST_ASSERT_LESS_OR_EQUAL(1000 + uploads.size() + written / 4096 + 1, after.writes - before.writes);
+    TEST_ASSERT_LESS_OR_EQUAL(written / 4096 + 2, after.erases - before.erases);
+    TEST_ASSERT_LESS_OR_EQUAL(1000 / 15, uploads.size());
+}
+
+static void test_disabled_costs_nothing() {
+    serveHost();
+    startHost(false);
+    TEST_ASSERT_FALSE(WebHostModule::record("nobody listens"));
+    TEST_ASSERT_EQUAL(0, WebHostModule::backlog());
+    TEST_ASSERT_EQUAL(0, portal->runningModules());
+    TEST_ASSERT_EQUAL(1, fake::taskCount());  // Log drain only
+    loopFor(1000);
+    TEST_ASSERT_EQUAL(0, fake::flashStats().writes);
+    TEST_ASSERT_EQUAL(0, fake::flashStats().erases);
+    TEST_ASSERT_EQUAL(0, fake::clientStats().connects);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_go_out_as_one_gzip_batch);
+    RUN_TEST(test_kept_until_the_host_takes_them);
+    RUN_TEST(test_backlog_survives_link_loss_and_reboot);
+    RUN_TEST(test_full_log_drops_oldest);
+    RUN_TEST(test_flash_wear_stays_low);
+    RUN_TEST(test_disabled_costs_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,559 @@
+#include <PortalFixture.h>
+
+// Provisioning, reconnects and setup modes on the virtual clock
+
+static ESP32ConfigPortal* makePortal() {
+    newPortal()->setWiFiTimeout(10000);
+    return portal;
+}
+
+// Stored configuration for boots that skip the portal
+static void provision(const char* ssid, const char* password) {
+    ConfigData config;
+    config.addWiFiProfile(ssid, password);
+    ConfigStore(NS).save(config, true);
+}
+
+// Event-driven application loop, as main.cpp runs it, for ms of virtual time
+static void runLoopFor(uint32_t ms) {
+    uint64_t end = fake::now() + ms;
+    while (fake::now() < end) {
+        portal->handle();
+        portal->waitForWork(end - fake::now());
+    }
+}
+
+// Value of an unlabeled sample in a /metrics body, -1 when missing
+static long metric(const std::string& body, const char* name) {
+    std::string prefix = std::string("\n") + METRICS_PREFIX + name + " ";
+    size_t pos = body.find(prefix);
+    return pos == std::string::npos ? -1 : atol(body.c_str() + pos + prefix.size());
+}
+
+// Occurrences of text in the Serial output so far
+static int serialCount(const char* text) {
+    Log::flush();
+    const std::string& output = fake::serialOutput();
+    int count = 0;
+    for (size_t pos = output.find(text); pos != std::string::npos; pos = output.find(text, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// Web host integration that records what the portal does with it
+struct HostModuleLog {
+    int created;
+    int started;
+    int runs;
+    int ended;
+    char url[64];
+};
+static HostModuleLog host_log;
+
+class HostModule : public PortalModule {
+    char buffer[512];  // Held only while the module exists
+
+public:
+    HostModule() { host_log.created++; }
+    ~HostModule() { host_log.ended++; }
+    bool begin(const ConfigData& config) override {
+        host_log.started++;
+        strlcpy(host_log.url, config.host_url, sizeof(host_log.url));
+        buffer[0] = '\0';
+        return true;
+    }
+    void run() override { host_log.runs++; }
+};
+
+// Asks for run() when poked, as a module's worker would
+class WakeModule : public PortalModule {
+public:
+    static WakeModule* instance;
+    static int runs;
+
+    WakeModule() { instance = this; }
+    ~WakeModule() { instance = nullptr; }
+    bool begin(const ConfigData&) override { return true; }
+    void run() override { runs++; }
+    void poke() { requestRun(); }
+};
+WakeModule* WakeModule::instance = nullptr;
+int WakeModule::runs = 0;
+
+void setUp() {
+    resetDevice();
+}
+
+void tearDown() {
+    stopDevice();
+}
+
+static void test_first_boot_provisioning() {
+    fake::addNetwork("home", "password1");
+    makePortal();
+    fake::after(500, [] {
+        TEST_ASSERT_TRUE(fake::apActive());
+        TEST_ASSERT_TRUE(fake::dnsRunning());
+        fake::HttpResponse probe = fake::get("/generate_204");
+        TEST_ASSERT_EQUAL(302, probe.code);
+        TEST_ASSERT_EQUAL(200, fake::get("/").code);
+        fake::HttpResponse saved = fake::postForm("/save", "wifi_ssid_0=home&wifi_password_0=password1&wifi_priority_0=0");
+        TEST_ASSERT_EQUAL(200, saved.code);
+    });
+
+    TEST_ASSERT_TRUE(portal->begin());
+    TEST_ASSERT_TRUE(portal->isWiFiConnected());
+    TEST_ASSERT_TRUE(portal->isConfigured());
+    TEST_ASSERT_TRUE(fake::staConnected());
+    TEST_ASSERT_EQUAL_STRING("home", fake::staSsid().c_str());
+    TEST_ASSERT_FALSE(fake::apActive());
+    TEST_ASSERT_FALSE(fake::dnsRunning());
+    TEST_ASSERT_TRUE(fake::nvsHasKey(NS, "cfg"));
+    Log::flush();
+    TEST_ASSERT_TRUE(fake::serialContains("Setup complete!"));
+}
+
+static void test_reboot_uses_saved_config() {
+    fake::addNetwork("home", "password1");
+    provision("home", "password1");
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+    TEST_ASSERT_EQUAL(1, fake::connectAttempts());
+    reboot();
+    fake::addNetwork("home", "password1");
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+    TEST_ASSERT_FALSE(fake::apActive());
+    TEST_ASSERT_EQUAL(1, fake::connectAttempts());
+    TEST_ASSERT_EQUAL_STRING("home", portal->getActiveProfile()->ssid);
+}
+
+static void test_reconnects_with_backoff() {
+    fake::addNetwork("home", "password1");
+    provision("home", "password1");
+    makePortal();
+    int disconnects = 0;
+    portal->onWiFiDisconnect([&] { disconnects++; });
+    TEST_ASSERT_TRUE(portal->begin());
+    uint32_t attempts = fake::connectAttempts();
+
+    fake::dropConnection();
+    loopFor(50);
+    TEST_ASSERT_EQUAL(1, disconnects);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] {
+        portal->handle();
+        return portal->isWiFiConnected();
+    }, 10000));
+    TEST_ASSERT_EQUAL(attempts + 1, fake::connectAttempts());
+
+    // Network gone: attempts back off instead of spinning
+    fake::removeNetwork("home");
+    attempts = fake::connectAttempts();
+    loopFor(30000);
+    TEST_ASSERT_FALSE(portal->isWiFiConnected());
+    uint32_t retries = fake::connectAttempts() - attempts;
+    TEST_ASSERT_GREATER_OR_EQUAL(2, retries);
+    TEST_ASSERT_LESS_OR_EQUAL(6, retries);
+    Log::flush();
+    TEST_ASSERT_TRUE(fake::serialContains("retrying in 2s"));
+
+    fake::addNetwork("home", "password1");
+    TEST_ASSERT_TRUE(fake::advanceUntil([] {
+        portal->handle();
+        return portal->isWiFiConnected();
+    }, 60000));
+}
+
+static void test_wrong_password_falls_through() {
+    fake::addNetwork("office", "password2", -40);
+    fake::addNetwork("home", "password1", -70);
+    ConfigData config;
+    config.addWiFiProfile("office", "not-the-password");
+    config.addWiFiProfile("home", "password1");
+    ConfigStore(NS).save(config, true);
+
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+    TEST_ASSERT_EQUAL_STRING("home", fake::staSsid().c_str());
+    TEST_ASSERT_EQUAL(2, fake::connectAttempts());
+    Log::flush();
+    TEST_ASSERT_TRUE(fake::serialContains("Failed to connect to office (reason 15)"));
+}
+
+static void test_handle_does_not_allocate() {
+    fake::addNetwork("home", "password1");
+    provision("home", "password1");
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+    loopFor(100);
+
+    fake::HeapProbe probe;
+    for (int i = 0; i < 1000; i++) {
+        portal->handle();
+        fake::advance(1);
+    }
+    TEST_ASSERT_EQUAL(0, probe.allocations());
+}
+
+static void test_async_setup() {
+    fake::addNetwork("home", "password1");
+    makePortal();
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->begin(PortalMode::ASYNC));
+    TEST_ASSERT_EQUAL(2, fake::taskCount());  // Setup task and log drain
+    TEST_ASSERT_FALSE(portal->waitForSetup(1000));
+
+    fake::HttpResponse saved = fake::postForm("/save", "wifi_ssid=home&wifi_password=password1");
+    TEST_ASSERT_EQUAL(200, saved.code);
+    TEST_ASSERT_TRUE(portal->waitForSetup(20000));
+    TEST_ASSERT_EQUAL((int)PortalStatus::CONNECTED, (int)portal->getPortalStatus());
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return fake::taskCount() == 1; }, 1000));
+    TEST_ASSERT_TRUE(fake::nvsHasKey(NS, "cfg"));
+}
+
+static void test_metrics_when_connected() {
+    fake::addNetwork("home", "password1");
+    provision("home", "password1");
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+
+    // Portal routes are gone, the scrape endpoint is not
+    TEST_ASSERT_EQUAL(404, fake::get("/").code);
+    fake::HttpResponse scrape = fake::get("/metrics");
+    TEST_ASSERT_EQUAL(200, scrape.code);
+    TEST_ASSERT_EQUAL(1, metric(scrape.body, "wifi_connected"));
+    TEST_ASSERT_EQUAL(0, metric(scrape.body, "captive_active"));
+    long connects = metric(scrape.body, "wifi_connects_total");
+    long reconnects = metric(scrape.body, "wifi_reconnects_total");
+    TEST_ASSERT_GREATER_OR_EQUAL(1, connects);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, metric(scrape.body, "wifi_connect_duration_seconds_count"));
+    TEST_ASSERT_GREATER_OR_EQUAL(1, metric(scrape.body, "nvs_write_duration_seconds_count"));
+
+    fake::dropConnection();
+    loopFor(50);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] {
+        portal->handle();
+        return portal->isWiFiConnected();
+    }, 10000));
+    scrape = fake::get("/metrics");
+    TEST_ASSERT_EQUAL(reconnects + 1, metric(scrape.body, "wifi_reconnects_total"));
+    TEST_ASSERT_EQUAL(connects + 1, metric(scrape.body, "wifi_connects_total"));
+}
+
+static void test_portal_stays_up_while_retrying() {
+    provision("home", "password1");  // Not in range yet
+    makePortal();
+    TEST_ASSERT_EQUAL((int)PortalStatus::CONNECTING, (int)portal->begin(PortalMode::ASYNC));
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return fake::apActive(); }, 15000));
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->getPortalStatus());
+
+    // Retries run under the portal, which is never torn down or rebuilt
+    fake::addNetwork("home", "password1");
+    bool ap_lost = false;
+    TEST_ASSERT_TRUE(fake::advanceUntil([&] {
+        if (fake::staConnected()) {
+            return true;
+        }
+        ap_lost = ap_lost || !fake::apActive();
+        return false;
+    }, 2 * WIFI_PORTAL_RETRY_MS));
+    TEST_ASSERT_FALSE(ap_lost);
+
+    // Torn down once the link is up
+    TEST_ASSERT_TRUE(portal->waitForSetup(1000));
+    TEST_ASSERT_FALSE(fake::apActive());
+    TEST_ASSERT_EQUAL(1, serialCount("Starting Configuration Portal"));
+    TEST_ASSERT_EQUAL(0, fake::taskRestarts());
+}
+
+static void test_force_config_mode_while_connecting() {
+    provision("home", "password1");  // Not in range
+    makePortal();
+    TEST_ASSERT_EQUAL((int)PortalStatus::CONNECTING, (int)portal->begin(PortalMode::ASYNC));
+    TEST_ASSERT_FALSE(fake::apActive());
+
+    // Pressed during the station-only attempt: not dropped
+    portal->forceConfigMode();
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return fake::apActive(); }, 1000));
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->getPortalStatus());
+    TEST_ASSERT_EQUAL(200, fake::get("/").code);
+}
+
+static void test_reconfiguration_applied_live() {
+    fake::addNetwork("home", "password1");
+    makePortal();
+    portal->begin(PortalMode::ASYNC);
+
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=wrong").code);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return portal->getWiFiState() == WiFiState::BACKOFF; }, 15000));
+    TEST_ASSERT_TRUE(fake::apActive());
+    TEST_ASSERT_FALSE(fake::nvsHasKey(NS, "cfg"));
+
+    // A corrected config is tried with the AP still up, and only then saved
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=password1").code);
+    bool ap_lost = false;
+    TEST_ASSERT_TRUE(fake::advanceUntil([&] {
+        if (fake::staConnected()) {
+            return true;
+        }
+        ap_lost = ap_lost || !fake::apActive();
+        return false;
+    }, 15000));
+    TEST_ASSERT_FALSE(ap_lost);
+    TEST_ASSERT_TRUE(portal->waitForSetup(1000));
+    TEST_ASSERT_FALSE(fake::apActive());
+    TEST_ASSERT_TRUE(fake::nvsHasKey(NS, "cfg"));
+    TEST_ASSERT_EQUAL(1, serialCount("Starting Configuration Portal"));
+}
+
+// Index of the first event named name at or after from, -1 when none
+static int findEvent(const std::vector<fake::ServerEvent>& events, const char* name, size_t from = 0) {
+    for (size_t i = from; i < events.size(); i++) {
+        if (events[i].event == name) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void test_success_page_follows_connection() {
+    fake::addNetwork("home", "password1");
+    makePortal();
+    portal->begin(PortalMode::ASYNC);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return fake::apActive(); }, 15000));
+
+    // Subscribers get the current state straight away
+    int stream = fake::openEvents("/events");
+    TEST_ASSERT_GREATER_OR_EQUAL(0, stream);
+    std::vector<fake::ServerEvent> events = fake::receivedEvents(stream);
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_EQUAL_STRING("state", events[0].event.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"PORTAL\",\"ssid\":\"\"}", events[0].data.c_str());
+
+    // A wrong password says so, without waiting for a refresh
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=wrong").code);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return portal->getWiFiState() == WiFiState::BACKOFF; }, 15000));
+    events = fake::receivedEvents(stream);
+    int connecting = findEvent(events, "state", 1);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, connecting);
+    TEST_ASSERT_TRUE(events[connecting].data.find("\"CONNECTING\",\"ssid\":\"home\",\"attempt\":1,\"of\":1") != std::string::npos);
+    int failed = findEvent(events, "failed");
+    TEST_ASSERT_GREATER_THAN(connecting, failed);
+    TEST_ASSERT_EQUAL_STRING("{\"ssid\":\"home\",\"reason\":\"wrong password\",\"code\":15}", events[failed].data.c_str());
+    TEST_ASSERT_TRUE(events.back().data.find("\"BACKOFF\"") != std::string::npos);
+    TEST_ASSERT_TRUE(events.back().data.find("\"reason\":\"wrong password\"") != std::string::npos);
+    TEST_ASSERT_TRUE(events.back().data.find("\"retry_ms\":30000") != std::string::npos);
+    for (size_t i = 1; i < events.size(); i++) {
+        TEST_ASSERT_GREATER_THAN(events[i - 1].id, events[i].id);
+    }
+
+    // A page opened later, e.g. after a reload, starts from the same state
+    int late = fake::openEvents("/events", events.back().id);
+    TEST_ASSERT_EQUAL(1, fake::receivedEvents(late).size());
+    TEST_ASSERT_TRUE(fake::receivedEvents(late)[0].data.find("\"BACKOFF\"") != std::string::npos);
+    fake::closeEvents(late);
+    TEST_ASSERT_FALSE(fake::eventsOpen(late));
+
+    // Connected: the result reaches the page before the AP closes
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=password1").code);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return portal->getWiFiState() == WiFiState::CONNECTED; }, 15000));
+    uint64_t connected_at = fake::now();
+    events = fake::receivedEvents(stream);
+    const std::string& result = events.back().data;
+    TEST_ASSERT_TRUE(result.find("{\"state\":\"CONNECTED\",\"ssid\":\"home\",\"ip\":\"192.168.1.") == 0);
+    TEST_ASSERT_TRUE(result.find("\"rssi\":-") != std::string::npos);
+    TEST_ASSERT_TRUE(fake::apActive());
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return !fake::apActive(); }, PORTAL_EVENTS_LINGER_MS + 1000));
+    TEST_ASSERT_GREATER_OR_EQUAL(PORTAL_EVENTS_LINGER_MS, fake::now() - connected_at);
+    TEST_ASSERT_TRUE(portal->waitForSetup(1000));
+    TEST_ASSERT_TRUE(fake::nvsHasKey(NS, "cfg"));
+
+    // The stream went with the portal routes
+    TEST_ASSERT_FALSE(fake::eventsOpen(stream));
+    TEST_ASSERT_EQUAL(-1, fake::openEvents("/events"));
+}
+
+static void test_reset_without_restart() {
+    fake::addNetwork("home", "password1");
+    provision("home", "password1");
+    makePortal();
+    TEST_ASSERT_TRUE(portal->begin());
+
+    portal->resetConfig();
+    TEST_ASSERT_TRUE(fake::apActive());
+    TEST_ASSERT_FALSE(fake::nvsHasKey(NS, "cfg"));
+    TEST_ASSERT_FALSE(portal->isConfigured());
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->getPortalStatus());
+    TEST_ASSERT_EQUAL(200, fake::get("/").code);
+}
+
+static void test_modules_follow_enable_flag() {
+    memset(&host_log, 0, sizeof(host_log));
+    fake::addNetwork("home", "password1");
+    ConfigData stored;
+    stored.addWiFiProfile("home", "password1");
+    stored.tg_active = true;  // No module registered for it: ignored
+    ConfigStore(NS).save(stored, true);
+
+    makePortal();
+    TEST_ASSERT_TRUE(portal->addModule<HostModule>(ConfigSection::host));
+    TEST_ASSERT_FALSE(portal->addModule<HostModule>(ConfigSection::host));
+    TEST_ASSERT_TRUE(portal->begin());
+    loopFor(100);
+
+    // Disabled: never constructed
+    TEST_ASSERT_EQUAL(0, host_log.created);
+    TEST_ASSERT_EQUAL(0, portal->runningModules());
+
+    // Only the registered section is offered
+    portal->forceConfigMode();
+    fake::HttpResponse schema = fake::get("/api/schema");
+    TEST_ASSERT_EQUAL(200, schema.code);
+    TEST_ASSERT_TRUE(schema.body.find("Web Host Configuration") != std::string::npos);
+    TEST_ASSERT_TRUE(schema.body.find("Telegram Configuration") == std::string::npos);
+    fake::advance(1000);  // Filling in the form
+
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save",
+        "wifi_ssid=home&wifi_password=password1&host_active=on&host_url=https://example.com/in").code);
+    TEST_ASSERT_TRUE(portal->waitForSetup(20000));
+    loopFor(100);
+    TEST_ASSERT_EQUAL(1, host_log.created);
+    TEST_ASSERT_EQUAL(1, host_log.started);
+    TEST_ASSERT_EQUAL_STRING("https://example.com/in", host_log.url);
+    TEST_ASSERT_GREATER_THAN(0, host_log.runs);
+    TEST_ASSERT_TRUE(portal->getConfig().tg_active);
+
+    // Reset disables it again, and its memory goes with it
+    portal->resetConfig();
+    loopFor(100);
+    TEST_ASSERT_EQUAL(1, host_log.ended);
+    TEST_ASSERT_EQUAL(0, portal->runningModules());
+}
+
+static void test_idle_loop_sleeps_until_work() {
+    fake::addNetwork("home", "password1");
+    ConfigData stored;
+    stored.addWiFiProfile("home", "password1");
+    stored.host_active = true;
+    ConfigStore(NS).save(stored, true);
+    makePortal();
+    portal->setStatusPrintInterval(60000);
+    portal->addModule<WakeModule>(ConfigSection::host);
+    std::vector<uint64_t> presses;
+    portal->onButton([&presses](ButtonEvent event) {
+        if (event == ButtonEvent::SHORT_PRESS) {
+            presses.push_back(fake::now());
+        }
+    });
+    TEST_ASSERT_TRUE(portal->begin());
+    runLoopFor(100);
+    TEST_ASSERT_NOT_NULL(WakeModule::instance);
+
+    // Nothing happening: woken by the status print only, asleep otherwise
+    int prints = serialCount("=== Device Status ===");
+    portal->resetLoopStats();
+    runLoopFor(600000);
+    LoopStats stats = portal->getLoopStats();
+    TEST_ASSERT_EQUAL(10, serialCount("=== Device Status ===") - prints);
+    TEST_ASSERT_LESS_OR_EQUAL(11, stats.wakeups);
+    TEST_ASSERT_EQUAL(stats.wakeups, stats.timeouts);
+    TEST_ASSERT_GREATER_OR_EQUAL(stats.window_ms - 10, stats.idle_ms);
+
+    // Each source wakes it at once, not at the next deadline
+    portal->resetLoopStats();
+    uint64_t released = fake::now() + 1100;
+    fake::after(1000, [] { fake::setPin(0, LOW); });
+    fake::after(1100, [] { fake::setPin(0, HIGH); });
+    int runs = WakeModule::runs;
+    fake::after(5000, [] { WakeModule::instance->poke(); });
+    fake::after(8000, [] { fake::dropConnection(); });
+    runLoopFor(8100);
+    stats = portal->getLoopStats();
+    TEST_ASSERT_EQUAL(1, presses.size());
+    TEST_ASSERT_LESS_OR_EQUAL(released + BUTTON_DEBOUNCE_MS + 1, presses[0]);
+    TEST_ASSERT_EQUAL(1, stats.by_source[2]);  // PORTAL_WAKE_BUTTON
+    TEST_ASSERT_EQUAL(1, stats.by_source[3]);  // PORTAL_WAKE_MODULE
+    TEST_ASSERT_GREATER_THAN(runs, WakeModule::runs);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, stats.by_source[0]);  // PORTAL_WAKE_WIFI
+    TEST_ASSERT_FALSE(portal->isWiFiConnected());
+
+    // Reconnected from events, then back to sleep
+    runLoopFor(5000);
+    TEST_ASSERT_TRUE(portal->isWiFiConnected());
+    stats = portal->getLoopStats();
+    TEST_ASSERT_LESS_THAN(20, stats.wakeups);
+    TEST_ASSERT_EQUAL(0, fake::powerConfig().calls);
+}
+
+static void test_power_save_follows_portal() {
+    fake::addNetwork("home", "password1");
+    makePortal();
+    portal->setPowerSave(true);
+    TEST_ASSERT_EQUAL((int)PortalStatus::PORTAL_ACTIVE, (int)portal->begin(PortalMode::ASYNC));
+
+    // Portal up: full speed for its clients
+    fake::PowerConfig power = fake::powerConfig();
+    TEST_ASSERT_EQUAL(PORTAL_CPU_MAX_MHZ, power.min_freq_mhz);
+    TEST_ASSERT_FALSE(power.light_sleep);
+
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=password1").code);
+    TEST_ASSERT_TRUE(portal->waitForSetup(20000));
+    power = fake::powerConfig();
+    TEST_ASSERT_EQUAL(PORTAL_CPU_MIN_MHZ, power.min_freq_mhz);
+    TEST_ASSERT_EQUAL(PORTAL_CPU_MAX_MHZ, power.max_freq_mhz);
+    TEST_ASSERT_TRUE(power.light_sleep);
+    TEST_ASSERT_EQUAL(PORTAL_WIFI_PS, WiFi.getSleep());
+
+    // The button wakes it from light-sleep, on a press and on the release.
+    // The edge interrupt leaves the wake level alone; the debounce timer
+    // re-arms it, outside the ISR.
+    TEST_ASSERT_TRUE(power.gpio_wakeup);
+    TEST_ASSERT_EQUAL(LOW, fake::wakeLevel(0));
+    fake::setPin(0, LOW);
+    TEST_ASSERT_EQUAL(LOW, fake::wakeLevel(0));
+    fake::advance(BUTTON_DEBOUNCE_MS + 1);
+    TEST_ASSERT_EQUAL(HIGH, fake::wakeLevel(0));
+    fake::setPin(0, HIGH);
+    TEST_ASSERT_EQUAL(HIGH, fake::wakeLevel(0));
+    fake::advance(BUTTON_DEBOUNCE_MS + 1);
+    TEST_ASSERT_EQUAL(LOW, fake::wakeLevel(0));
+    runLoopFor(100);
+
+    // Not repeated while nothing changes
+    uint32_t calls = power.calls;
+    runLoopFor(60000);
+    TEST_ASSERT_EQUAL(calls, fake::powerConfig().calls);
+
+    // A core without tickless idle still scales the clock
+    portal->forceConfigMode();
+    TEST_ASSERT_FALSE(fake::powerConfig().light_sleep);
+    TEST_ASSERT_EQUAL(PORTAL_CPU_MAX_MHZ, fake::powerConfig().min_freq_mhz);
+    TEST_ASSERT_EQUAL(WIFI_PS_NONE, WiFi.getSleep());
+    fake::setLightSleepSupported(false);
+    fake::advance(1000);  // Filling in the form
+    TEST_ASSERT_EQUAL(200, fake::postForm("/save", "wifi_ssid=home&wifi_password=password1").code);
+    TEST_ASSERT_TRUE(portal->waitForSetup(20000));
+    power = fake::powerConfig();
+    TEST_ASSERT_EQUAL(PORTAL_CPU_MIN_MHZ, power.min_freq_mhz);
+    TEST_ASSERT_FALSE(power.light_sleep);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_boot_provisioning);
+    RUN_TEST(test_reboot_uses_saved_config);
+    RUN_TEST(test_reconnects_with_backoff);
+    RUN_TEST(test_wrong_password_falls_through);
+    RUN_TEST(test_handle_does_not_allocate);
+    RUN_TEST(test_async_setup);
+    RUN_TEST(test_metrics_when_connected);
+    RUN_TEST(test_portal_stays_up_while_retrying);
+    RUN_TEST(test_force_config_mode_while_connecting);
+    RUN_TEST(test_reconfiguration_applied_live);
+    RUN_TEST(test_success_page_follows_connection);
+    RUN_TEST(test_reset_without_restart);
+    RUN_TEST(test_modules_follow_enable_flag);
+    RUN_TEST(test_idle_loop_sleeps_until_work);
+    RUN_TEST(test_power_save_follows_portal);
+    return UNITY_END();
+}
@@ -0,0 +1,201 @@
+#include <PortalFixture.h>
+#include <ArduinoJson.h>
+#include <deque>
+#include "TelegramModule.h"
+
+// Telegram notifications against a Bot API stand-in, connected mode
+
+// sendMessage calls the stand-in received
+struct Post {
+    uint64_t at;
+    std::string path;
+    std::string chat;
+    std::string text;
+};
+static std::vector<Post> posts;
+
+// Status codes for the next replies, then 200
+static std::deque<int> replies;
+
+static void serveBotApi() {
+    fake::serveHttp(TELEGRAM_HOST, TELEGRAM_PORT, [](const fake::ServerRequest& request) {
+        JsonDocument doc;
+        deserializeJson(doc, request.body.c_str());
+        const char* chat = doc["chat_id"];
+        const char* text = doc["text"];
+        Post post = { fake::now(), request.path, chat ? chat : "", text ? text : "" };
+        posts.push_back(post);
+        int code = 200;
+        if (!replies.empty()) {
+            code = replies.front();
+            replies.pop_front();
+        }
+        if (code == 429) {
+            return fake::ServerReply(429, "{\"ok\":false,\"error_code\":429,\"parameters\":{\"retry_after\":5}}");
+        }
+        return fake::ServerReply(code, code == 200 ? "{\"ok\":true}" : "{\"ok\":false}");
+    });
+}
+
+// Connected device with the Telegram module registered, enabled or not
+static void startTelegram(bool enabled) {
+    ConfigData config;
+    config.tg_active = enabled;
+    strlcpy(config.tg_token, "123:abc", sizeof(config.tg_token));
+    strlcpy(config.tg_chat, "42", sizeof(config.tg_chat));
+    startDevice(config, true, [] { portal->addModule<TelegramModule>(ConfigSection::telegram); });
+}
+
+void setUp() {
+    resetDevice();
+    posts.clear();
+    replies.clear();
+}
+
+void tearDown() {
+    stopDevice();
+}
+
+static void test_burst_goes_out_as_one_message() {
+    serveBotApi();
+    startTelegram(true);
+    uint32_t delivered = counter(MetricCounter::TELEGRAM_MESSAGES);
+
+    char text[16];
+    for (int i = 0; i < 10; i++) {
+        snprintf(text, sizeof(text), "event %d", i);
+        TEST_ASSERT_TRUE(TelegramModule::send(text));
+    }
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 1; }, 5000));
+    TEST_ASSERT_EQUAL_STRING("/bot123:abc/sendMessage", posts[0].path.c_str());
+    TEST_ASSERT_EQUAL_STRING("42", posts[0].chat.c_str());
+    TEST_ASSERT_EQUAL_STRING("event 0\nevent 1\nevent 2\nevent 3\nevent 4\n"
+                             "event 5\nevent 6\nevent 7\nevent 8\nevent 9", posts[0].text.c_str());
+
+    // The next one reuses the connection: no second handshake
+    loopFor(3000);
+    TEST_ASSERT_TRUE(TelegramModule::send("quote \" and\ttab"));
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 2; }, 2000));
+    TEST_ASSERT_EQUAL_STRING("quote \" and\ttab", posts[1].text.c_str());
+    TEST_ASSERT_EQUAL(1, fake::clientStats().handshakes);
+    TEST_ASSERT_EQUAL(delivered + 11, counter(MetricCounter::TELEGRAM_MESSAGES));
+}
+
+static void test_pacing_and_retry_after() {
+    serveBotApi();
+    startTelegram(true);
+    replies.push_back(429);
+
+    TelegramModule::send("first");
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 1; }, 5000));
+    TelegramModule::send("second");
+
+    // The rejected message waits out retry_after, the next one a second more
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 3; }, 10000));
+    TEST_ASSERT_EQUAL_STRING("first", posts[1].text.c_str());
+    TEST_ASSERT_EQUAL_STRING("second", posts[2].text.c_str());
+    TEST_ASSERT_GREATER_OR_EQUAL(5000, posts[1].at - posts[0].at);
+    TEST_ASSERT_GREATER_OR_EQUAL(TELEGRAM_MIN_INTERVAL_MS, posts[2].at - posts[1].at);
+
+    // A steady trickle stays within 20 sends in any minute; what the limit
+    // holds back goes out together
+    uint32_t dropped = counter(MetricCounter::TELEGRAM_DROPPED);
+    char text[16];
+    for (int i = 0; i < 30; i++) {
+        snprintf(text, sizeof(text), "tick %d", i);
+        TelegramModule::send(text);
+        loopFor(1500);
+    }
+    loopFor(60000);
+    std::string delivered;
+    for (size_t i = 0; i < posts.size(); i++) {
+        delivered += posts[i].text + "\n";
+        if (i >= TELEGRAM_RATE_PER_MIN) {
+            TEST_ASSERT_GREATER_OR_EQUAL(60000, posts[i].at - posts[i - TELEGRAM_RATE_PER_MIN].at);
+        }
+    }
+    TEST_ASSERT_LESS_THAN(3 + 30, posts.size());
+    TEST_ASSERT_EQUAL(dropped, counter(MetricCounter::TELEGRAM_DROPPED));
+    for (int i = 0; i < 30; i++) {
+        snprintf(text, sizeof(text), "tick %d\n", i);
+        TEST_ASSERT_TRUE(delivered.find(text) != std::string::npos);
+    }
+}
+
+static void test_full_queue_drops_oldest() {
+    startTelegram(true);  // Bot API unreachable
+    uint32_t dropped = counter(MetricCounter::TELEGRAM_DROPPED);
+
+    char text[16];
+    for (int i = 0; i < TELEGRAM_QUEUE_SLOTS + 4; i++) {
+        snprintf(text, sizeof(text), "event %d", i);
+        TelegramModule::send(text);
+    }
+    TEST_ASSERT_EQUAL(dropped + 4, counter(MetricCounter::TELEGRAM_DROPPED));
+
+    // Kept while retrying, delivered once the API is back
+    loopFor(1000);
+    serveBotApi();
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 1; }, 10000));
+    TEST_ASSERT_EQUAL(0, posts[0].text.find("event 4\n"));
+    TEST_ASSERT_TRUE(posts[0].text.find("event 19") != std::string::npos);
+}
+
+static void test_connection_lifecycle() {
+    serveBotApi();
+    startTelegram(true);
+
+    // Open connection holds the TLS session heap until it idles out
+    int64_t before = fake::heapStats().live_bytes;
+    TelegramModule::send("hello");
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 1; }, 5000));
+    TEST_ASSERT_EQUAL(1, fake::clientStats().open);
+    TEST_ASSERT_GREATER_OR_EQUAL(before + 40000, fake::heapStats().live_bytes);
+    loopFor(TELEGRAM_IDLE_CLOSE_MS + 100);
+    TEST_ASSERT_EQUAL(0, fake::clientStats().open);
+    TEST_ASSERT_LESS_THAN(before + 40000, fake::heapStats().live_bytes);
+
+    // A connection the server closed is replaced without losing the message
+    TelegramModule::send("again");
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 2; }, 5000));
+    fake::closeConnections(TELEGRAM_HOST);
+    loopFor(1000);
+    TelegramModule::send("after close");
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 3; }, 5000));
+    TEST_ASSERT_EQUAL_STRING("after close", posts[2].text.c_str());
+    TEST_ASSERT_EQUAL(3, fake::clientStats().handshakes);
+}
+
+static void test_rejected_messages_are_not_retried() {
+    serveBotApi();
+    startTelegram(true);
+    uint32_t dropped = counter(MetricCounter::TELEGRAM_DROPPED);
+    replies.push_back(400);
+
+    TelegramModule::send("bad");
+    TEST_ASSERT_TRUE(loopUntil([] { return posts.size() == 1; }, 5000));
+    loopFor(10000);
+    TEST_ASSERT_EQUAL(1, posts.size());
+    TEST_ASSERT_EQUAL(dropped + 1, counter(MetricCounter::TELEGRAM_DROPPED));
+}
+
+static void test_disabled_costs_nothing() {
+    serveBotApi();
+    startTelegram(false);
+    TEST_ASSERT_FALSE(TelegramModule::send("nobody listens"));
+    TEST_ASSERT_EQUAL(0, portal->runningModules());
+    TEST_ASSERT_EQUAL(1, fake::taskCount());  // Log drain only
+    loopFor(1000);
+    TEST_ASSERT_EQUAL(0, fake::clientStats().connects);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_goes_out_as_one_message);
+    RUN_TEST(test_pacing_and_retry_after);
+    RUN_TEST(test_full_queue_drops_oldest);
+    RUN_TEST(test_connection_lifecycle);
+    RUN_TEST(test_rejected_messages_are_not_retried);
+    RUN_TEST(test_disabled_costs_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,240 @@
+#include <PortalFixture.h>
+#include <esp_ota_ops.h>
+
+// Firmware updates through /update into the inactive OTA slot, and the
+// first boot of the new image
+
+static const size_t IMAGE_SIZE = 600000;
+
+// Runs handle() until the device restarts; false if it did not within ms
+static bool loopUntilRestart(uint32_t ms) {
+    uint64_t end = fake::now() + ms;
+    while (fake::now() < end) {
+        try {
+            portal->handle();
+        } catch (const fake::Restart&) {
+            return true;
+        }
+        fake::advance(10);
+    }
+    return false;
+}
+
+// Basic credentials for FIRMWARE_UPDATE_PASSWORD, set in platformio.ini
+static fake::Headers credentials() {
+    fake::Headers headers;
+    headers.push_back(std::make_pair(std::string("Authorization"), std::string("Basic YWRtaW46dXBkYXRlLXNlY3JldA==")));
+    return headers;
+}
+
+static fake::HttpResponse upload(const std::string& image, const std::string& sha = std::string(),
+                                 size_t disconnectAt = 0) {
+    fake::Headers headers = credentials();
+    if (!sha.empty()) {
+        headers.push_back(std::make_pair(std::string("X-Firmware-SHA256"), sha));
+    }
+    return fake::upload("/update", "firmware.bin", image, headers, 1436, disconnectAt);
+}
+
+void setUp() {
+    resetDevice();
+}
+
+void tearDown() {
+    stopDevice();
+}
+
+static void test_upload_streams_into_the_other_slot() {
+    startDevice(ConfigData());
+    std::vector<size_t> progress;
+    portal->onUpdateProgress([&progress](size_t written, size_t total) {
+        TEST_ASSERT_GREATER_THAN(0, total);
+        progress.push_back(written);
+    });
+    TEST_ASSERT_EQUAL(401, fake::get("/update").code);
+    TEST_ASSERT_EQUAL(200, fake::get("/update", credentials()).code);
+
+    std::string image = fake::makeFirmwareImage(IMAGE_SIZE, 1);
+    uint32_t updates = counter(MetricCounter::FIRMWARE_UPDATES);
+    size_t used = fake::heapModel().used;
+    fake::resetHeapPeaks();
+    uint64_t started = fake::now();
+    fake::HttpResponse response = upload(image, fake::sha256Hex(image));
+    uint64_t elapsed = fake::now() - started;
+    TEST_ASSERT_EQUAL(200, response.code);
+    TEST_ASSERT_TRUE(response.body.find("restarting") != std::string::npos);
+    TEST_ASSERT_EQUAL(FirmwareState::DONE, portal->getUpdateState());
+    TEST_ASSERT_EQUAL(updates + 1, counter(MetricCounter::FIRMWARE_UPDATES));
+
+    // Byte for byte in the other slot, written once in whole sectors
+    TEST_ASSERT_TRUE(fake::firmwareImage() == image);
+    fake::FirmwareStats stats = fake::firmwareStats();
+    TEST_ASSERT_EQUAL(1, stats.updates);
+    TEST_ASSERT_EQUAL(IMAGE_SIZE, stats.bytes_written);
+    TEST_ASSERT_EQUAL((IMAGE_SIZE + 4095) / 4096, stats.sectors);
+
+    // Flash is the bottleneck: erase and write time, little else
+    uint64_t flash_ms = stats.sectors * 45 + IMAGE_SIZE * 1500 / 1000000 + stats.sectors * 50 / 1000;
+    TEST_ASSERT_LESS_OR_EQUAL(flash_ms + flash_ms / 20, elapsed);
+
+    // One sector buffer, not the image
+    TEST_ASSERT_LESS_THAN(6144, fake::heapModel().peak_used - used);
+
+    // Every FIRMWARE_PROGRESS_STEP percent, then done
+    TEST_ASSERT_GREATER_OR_EQUAL(100 / FIRMWARE_PROGRESS_STEP - 1, progress.size());
+    for (size_t i = 1; i < progress.size(); i++) {
+        TEST_ASSERT_GREATER_THAN(progress[i - 1], progress[i]);
+    }
+    TEST_ASSERT_EQUAL(IMAGE_SIZE, progress.back());
+
+    // Restarts once the response had time to go out, not before
+    fake::advance(FIRMWARE_RESTART_DELAY_MS / 2);
+    portal->handle();
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS));
+    TEST_ASSERT_EQUAL(0, fake::runningFirmwareSlot());
+}
+
+static void test_new_image_confirmed_once_online() {
+    startDevice(ConfigData());
+    std::string image = fake::makeFirmwareImage(IMAGE_SIZE, 2);
+    TEST_ASSERT_EQUAL(200, upload(image).code);
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS + 100));
+
+    reboot();
+    TEST_ASSERT_EQUAL(1, fake::runningFirmwareSlot());
+    TEST_ASSERT_EQUAL(ESP_OTA_IMG_PENDING_VERIFY, fake::firmwareState());
+    startDevice(ConfigData());
+    TEST_ASSERT_EQUAL(ESP_OTA_IMG_VALID, fake::firmwareState());
+
+    // Kept from now on
+    reboot();
+    TEST_ASSERT_EQUAL(1, fake::runningFirmwareSlot());
+    TEST_ASSERT_EQUAL(0, fake::firmwareStats().rollbacks);
+}
+
+static void test_unconfirmed_image_rolls_back() {
+    startDevice(ConfigData());
+    TEST_ASSERT_EQUAL(200, upload(fake::makeFirmwareImage(IMAGE_SIZE, 3)).code);
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS + 100));
+
+    // Crashes before it gets online: the bootloader goes back
+    reboot();
+    TEST_ASSERT_EQUAL(1, fake::runningFirmwareSlot());
+    reboot();
+    TEST_ASSERT_EQUAL(0, fake::runningFirmwareSlot());
+    TEST_ASSERT_EQUAL(ESP_OTA_IMG_VALID, fake::firmwareState());
+    TEST_ASSERT_EQUAL(1, fake::firmwareStats().rollbacks);
+
+    // Starts, but its saved network is out of range: the link is to blame,
+    // the image is kept once the portal serves
+    startDevice(ConfigData());
+    TEST_ASSERT_EQUAL(200, upload(fake::makeFirmwareImage(IMAGE_SIZE, 4)).code);
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS + 100));
+    reboot();
+    startDevice(ConfigData(), false);
+    TEST_ASSERT_EQUAL(ESP_OTA_IMG_PENDING_VERIFY, fake::firmwareState());
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return portal->getPortalStatus() == PortalStatus::PORTAL_ACTIVE; }, 60000));
+    TEST_ASSERT_EQUAL(ESP_OTA_IMG_VALID, fake::firmwareState());
+    fake::advance(FIRMWARE_VERIFY_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(0, fake::taskRestarts());
+    reboot();
+    TEST_ASSERT_EQUAL(1, fake::runningFirmwareSlot());
+    TEST_ASSERT_EQUAL(1, fake::firmwareStats().rollbacks);
+}
+
+static void test_corrupt_uploads_are_not_activated() {
+    startDevice(ConfigData());
+    std::string image = fake::makeFirmwareImage(IMAGE_SIZE, 5);
+    uint32_t failures = counter(MetricCounter::FIRMWARE_FAILURES);
+
+    // Test data, not device heap
+    std::string damaged;
+    std::string text;
+    {
+        fake::HeapPause pause;
+        damaged = image;
+        damaged[IMAGE_SIZE / 2] ^= 0x01;
+        text.assign(IMAGE_SIZE, 'x');
+    }
+
+    // Expected hash does not match what arrived
+    fake::HttpResponse response = upload(damaged, fake::sha256Hex(image));
+    TEST_ASSERT_EQUAL(400, response.code);
+    TEST_ASSERT_TRUE(response.body.find("SHA-256 mismatch") != std::string::npos);
+
+    // No hash given: the image's own appended one catches it
+    response = upload(damaged);
+    TEST_ASSERT_EQUAL(400, response.code);
+    TEST_ASSERT_TRUE(response.body.find("Activate") != std::string::npos);
+
+    // Not an app image: refused at the first sector, nothing more written
+    uint32_t sectors = fake::firmwareStats().sectors;
+    response = upload(text);
+    TEST_ASSERT_EQUAL(400, response.code);
+    TEST_ASSERT_TRUE(response.body.find("Magic") != std::string::npos);
+    TEST_ASSERT_EQUAL(sectors, fake::firmwareStats().sectors);
+
+    TEST_ASSERT_EQUAL(400, upload(image, "not-a-hash").code);
+
+    // Client gone halfway: aborted, and the next upload may start
+    TEST_ASSERT_EQUAL(0, upload(image, std::string(), IMAGE_SIZE / 2).code);
+    TEST_ASSERT_EQUAL(FirmwareState::FAILED, portal->getUpdateState());
+
+    // Refused at the start and gone before the answer: not left holding it
+    TEST_ASSERT_EQUAL(0, upload(image, "not-a-hash", IMAGE_SIZE / 2).code);
+
+    TEST_ASSERT_EQUAL(0, fake::firmwareStats().updates);
+    TEST_ASSERT_EQUAL(failures + 6, counter(MetricCounter::FIRMWARE_FAILURES));
+    TEST_ASSERT_FALSE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS * 2));
+
+    TEST_ASSERT_EQUAL(200, upload(image, fake::sha256Hex(image)).code);
+    TEST_ASSERT_TRUE(fake::firmwareImage() == image);
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS + 100));
+}
+
+static void test_one_upload_at_a_time() {
+    startDevice(ConfigData());
+    std::string image = fake::makeFirmwareImage(IMAGE_SIZE, 6);
+    std::string other = fake::makeFirmwareImage(IMAGE_SIZE, 7);
+    int second = -1;
+    portal->onUpdateProgress([&](size_t, size_t) {
+        if (second < 0) {
+            second = upload(other).code;
+        }
+    });
+    TEST_ASSERT_EQUAL(200, upload(image).code);
+    TEST_ASSERT_EQUAL(409, second);
+    TEST_ASSERT_TRUE(fake::firmwareImage() == image);
+
+    // Restarting into it: later ones wait for the new image
+    TEST_ASSERT_EQUAL(409, upload(other).code);
+    TEST_ASSERT_TRUE(loopUntilRestart(FIRMWARE_RESTART_DELAY_MS + 100));
+}
+
+static void test_served_by_the_portal_too() {
+    startDevice(ConfigData(), false);
+    TEST_ASSERT_TRUE(fake::advanceUntil([] { return portal->getPortalStatus() == PortalStatus::PORTAL_ACTIVE; }, 60000));
+    fake::HttpResponse status = fake::get("/api/status");
+    TEST_ASSERT_TRUE(status.body.find("\"update\":\"idle\"") != std::string::npos);
+    TEST_ASSERT_EQUAL(200, fake::get("/update", credentials()).code);
+
+    // A POST without a file part
+    TEST_ASSERT_EQUAL(400, fake::http("POST", "/update", std::string(), credentials()).code);
+
+    std::string image = fake::makeFirmwareImage(IMAGE_SIZE, 8);
+    TEST_ASSERT_EQUAL(200, upload(image).code);
+    TEST_ASSERT_TRUE(fake::firmwareImage() == image);
+    status = fake::get("/api/status");
+    TEST_ASSERT_TRUE(status.body.find("\"update\":\"done\"") != std::string::npos);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_upload_streams_into_the_other_slot);
+    RUN_TEST(test_new_image_confirmed_once_online);
+    RUN_TEST(test_unconfirmed_image_rolls_back);
+    RUN_TEST(test_corrupt_uploads_are_not_activated);
+    RUN_TEST(test_one_upload_at_a_time);
+    RUN_TEST(test_served_by_the_portal_too);
+    return UNITY_END();
+}